@@ -1,8 +1,29 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec2 in_texcoord;
+layout(location = 1) flat in uint in_material_index;
 
 layout(location = 0) out vec4 out_color;
 
+struct material_data {
+  vec4 diffuse_color;
+  uint diffuse_texture_index;
+};
+
+// Every texture and material, indexed per draw
+layout(std430, set = 1, binding = 0) readonly buffer material_buffer {
+  material_data materials[];
+};
+layout(set = 1, binding = 1) uniform sampler texture_sampler;
+layout(set = 1, binding = 2) uniform texture2D textures[1024];
+
 void main() {
-  out_color = vec4(1.0);
+  material_data material = materials[in_material_index];
+  vec4 diffuse = texture(
+      sampler2D(textures[nonuniformEXT(material.diffuse_texture_index)],
+                texture_sampler),
+      in_texcoord);
+  out_color = material.diffuse_color * diffuse;
 }
\ No newline at end of file
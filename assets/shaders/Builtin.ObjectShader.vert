@@ -2,7 +2,34 @@
 #extension GL_ARB_separate_shader_objects : enable
 
 layout(location = 0) in vec3 in_position;
+// Per instance, takes locations 1 to 4
+layout(location = 1) in mat4 in_model;
+layout(location = 5) in vec2 in_texcoord;
+// Per instance, slot in the frame's materials
+layout(location = 6) in uint in_material_index;
+
+layout(set = 0, binding = 0) uniform global_uniform_object {
+  mat4 projection;
+  mat4 view;
+  uint material_base;
+} global_ubo;
+
+// Small frames push each draw's model instead of using the instance buffer
+layout(push_constant) uniform push_constants {
+  mat4 model;
+  uint use_push_model;
+  uint material_index;
+} push;
+
+layout(location = 0) out vec2 out_texcoord;
+layout(location = 1) flat out uint out_material_index;
 
 void main() {
-  gl_Position = vec4(in_position, 1.0f);
-}
\ No newline at end of file
+  mat4 model = push.use_push_model != 0 ? push.model : in_model;
+  uint material_index =
+      push.use_push_model != 0 ? push.material_index : in_material_index;
+  out_texcoord = in_texcoord;
+  out_material_index = global_ubo.material_base + material_index;
+  gl_Position = global_ubo.projection * global_ubo.view * model *
+                vec4(in_position, 1.0f);
+}
@@ -27,6 +27,7 @@ project "core"
 		postbuildcommands {
 			"%{wks.location}/bin/glslc/glslc_macosx %{wks.location}/assets/shaders/Builtin.ObjectShader.vert -o %{wks.location}/assets/shaders/Builtin.ObjectShader.vert.spv",
 			"%{wks.location}/bin/glslc/glslc_macosx %{wks.location}/assets/shaders/Builtin.ObjectShader.frag -o %{wks.location}/assets/shaders/Builtin.ObjectShader.frag.spv",
+			"%{wks.location}/bin/glslc/glslc_macosx %{wks.location}/assets/shaders/Builtin.CullShader.comp -o %{wks.location}/assets/shaders/Builtin.CullShader.comp.spv",
 		}
 
 		defines
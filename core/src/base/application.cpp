@@ -1,6 +1,7 @@
 #include "base/application.h"
 #include "base/clock.h"
 #include "base/event.h"
+#include "base/frame_stats.h"
 #include "base/input.h"
 #include "base/lai_memory.h"
 #include "base/log.h"
@@ -9,9 +10,33 @@
 #include "platform/platform.h"
 
 #include "renderer/renderer_frontend.h"
+#include "systems/geometry_system.h"
+#include "systems/material_system.h"
+#include "systems/texture_system.h"
 
+#include "containers/darray.h"
+
+#include "math/lai_math.h"
+
+#include <atomic>
 #include <cstdlib>
 
+#define APPLICATION_FRAME_SLOT_COUNT 2
+
+// A frame handed from the simulation thread to the render thread
+struct application_frame_slot {
+  render_packet packet;
+  // Resize to apply on the render thread before drawing this frame
+  bool resized;
+  u16 width;
+  u16 height;
+  // Written by the render thread once the frame was drawn
+  f64 draw_time;
+  // The renderer's latest gpu timings after drawing, if it had any
+  bool has_gpu_timings;
+  gpu_timings timings;
+};
+
 struct application_state {
   game *game_inst;
   bool is_running;
@@ -20,6 +45,32 @@ struct application_state {
   i16 height;
   clock clock;
   f64 last_time;
+  f64 target_frame_time;
+  bool fixed_timestep;
+  f64 fixed_step;
+  f64 accumulator;
+  frame_stats_recorder frame_stats;
+  // Copied after each frame, so the main thread never waits on the renderer
+  // for them
+  bool has_gpu_timings;
+  gpu_timings latest_gpu_timings;
+
+  bool pipelined_rendering;
+  std::atomic<bool> render_thread_running;
+  platform_thread render_thread;
+  // Counts slots the simulation thread may fill and slots ready to draw
+  platform_semaphore free_slots;
+  platform_semaphore ready_slots;
+  application_frame_slot frame_slots[APPLICATION_FRAME_SLOT_COUNT];
+  u32 simulation_slot;
+  // Slots taken from free_slots by the main thread and frames drawn by the
+  // render thread, which gives them back. The difference is returned on
+  // stop, the semaphore may not be destroyed below its initial count.
+  u64 taken_slots;
+  u64 drawn_slots;
+  bool resize_pending;
+  // Packet filled by the game when rendering on the main thread
+  render_packet packet;
   linear_allocator systems_allocator;
 
   u64 memory_system_memory_requirement;
@@ -39,10 +90,30 @@ struct application_state {
 
   u64 renderer_system_memory_requirement;
   void *renderer_system_state;
+
+  u64 geometry_system_memory_requirement;
+  void *geometry_system_state;
+
+  u64 texture_system_memory_requirement;
+  void *texture_system_state;
+
+  u64 material_system_memory_requirement;
+  void *material_system_state;
 };
 
 static application_state *app_state;
 
+// Remaining time below which the frame limiter busy waits instead of sleeping
+#define APPLICATION_FRAME_SPIN_THRESHOLD 0.002
+#define APPLICATION_MAX_FIXED_STEPS_PER_FRAME 8
+#define APPLICATION_DEFAULT_FIXED_UPDATE_RATE 60.0f
+
+void application_wait_until(f64 target_time);
+
+bool application_start_render_thread();
+void application_stop_render_thread();
+u32 application_render_thread_main(void *params);
+
 bool application_on_event(u16 code, void *sender, void *listener,
                           event_context context);
 bool application_on_key(u16 code, void *sender, void *listener,
@@ -65,6 +136,15 @@ bool application_create(game *game_inst) {
   app_state->is_running = false;
   app_state->is_suspended = false;
 
+  application_set_target_frame_rate(game_inst->app_config.target_frame_rate);
+
+  f32 fixed_update_rate = game_inst->app_config.fixed_update_rate > 0
+                              ? game_inst->app_config.fixed_update_rate
+                              : APPLICATION_DEFAULT_FIXED_UPDATE_RATE;
+  app_state->fixed_timestep = game_inst->app_config.fixed_timestep;
+  app_state->fixed_step = 1.0 / fixed_update_rate;
+  app_state->accumulator = 0;
+
   u64 systems_allocator_total_size = 64 * 1024 * 1024; // 64mb
   linear_allocator_create(systems_allocator_total_size, nullptr,
                           &app_state->systems_allocator);
@@ -119,7 +199,7 @@ bool application_create(game *game_inst) {
 
   // Initialize Platform State
   platform_startup(&app_state->platform_system_memory_requirement, nullptr,
-                   nullptr, 0, 0, 0, 0);
+                   nullptr, 0, 0, 0, 0, false);
   app_state->platform_system_state =
       linear_allocator_allocate(&app_state->systems_allocator,
                                 app_state->platform_system_memory_requirement);
@@ -128,12 +208,19 @@ bool application_create(game *game_inst) {
           app_state->platform_system_state, game_inst->app_config.name,
           game_inst->app_config.start_pos_x, game_inst->app_config.start_pos_y,
           game_inst->app_config.start_width,
-          game_inst->app_config.start_height)) {
+          game_inst->app_config.start_height,
+          game_inst->app_config.headless)) {
     LAI_LOG_FATAL("Platform system failed to initialize!");
     return false;
   }
 
   // Initialize Renderer State
+  renderer_config renderer_config;
+  renderer_config.application_name = game_inst->app_config.name;
+  renderer_config.gpu_culling = game_inst->app_config.gpu_culling;
+  renderer_config.headless = game_inst->app_config.headless;
+  renderer_config.readback = game_inst->app_config.headless_readback;
+  renderer_config.frames_in_flight = game_inst->app_config.frames_in_flight;
   renderer_initialize(&app_state->renderer_system_memory_requirement, nullptr,
                       nullptr);
   app_state->renderer_system_state =
@@ -141,16 +228,71 @@ bool application_create(game *game_inst) {
                                 app_state->renderer_system_memory_requirement);
   if (!renderer_initialize(&app_state->renderer_system_memory_requirement,
                            app_state->renderer_system_state,
-                           game_inst->app_config.name)) {
+                           &renderer_config)) {
     LAI_LOG_FATAL("Renderer system failed to initialize!");
     return false;
   }
 
+  geometry_system_config geometry_config;
+  geometry_config.max_geometry_count = 4096;
+  geometry_system_initialize(&app_state->geometry_system_memory_requirement,
+                             nullptr, geometry_config);
+  app_state->geometry_system_state =
+      linear_allocator_allocate(&app_state->systems_allocator,
+                                app_state->geometry_system_memory_requirement);
+  if (!geometry_system_initialize(
+          &app_state->geometry_system_memory_requirement,
+          app_state->geometry_system_state, geometry_config)) {
+    LAI_LOG_FATAL("Geometry system failed to initialize!");
+    return false;
+  }
+
+  texture_system_config texture_config;
+  texture_config.max_texture_count = 1024;
+  texture_config.streaming_budget = 256ull * 1024 * 1024;
+  texture_config.max_uploads_per_frame = 4;
+  texture_system_initialize(&app_state->texture_system_memory_requirement,
+                            nullptr, texture_config);
+  app_state->texture_system_state =
+      linear_allocator_allocate(&app_state->systems_allocator,
+                                app_state->texture_system_memory_requirement);
+  if (!texture_system_initialize(&app_state->texture_system_memory_requirement,
+                                 app_state->texture_system_state,
+                                 texture_config)) {
+    LAI_LOG_FATAL("Texture system failed to initialize!");
+    return false;
+  }
+
+  material_system_config material_config;
+  material_config.max_material_count = 1024;
+  material_system_initialize(&app_state->material_system_memory_requirement,
+                             nullptr, material_config);
+  app_state->material_system_state =
+      linear_allocator_allocate(&app_state->systems_allocator,
+                                app_state->material_system_memory_requirement);
+  if (!material_system_initialize(
+          &app_state->material_system_memory_requirement,
+          app_state->material_system_state, material_config)) {
+    LAI_LOG_FATAL("Material system failed to initialize!");
+    return false;
+  }
+
+  app_state->packet.geometries = darray_create(geometry_render_data);
+
   if (!app_state->game_inst->initialize(app_state->game_inst)) {
     LAI_LOG_FATAL("Game failed to initialize!");
     return false;
   }
 
+  frame_stats_create(game_inst->app_config.frame_stats_window,
+                     &app_state->frame_stats);
+
+  app_state->pipelined_rendering = game_inst->app_config.pipelined_rendering;
+  if (app_state->pipelined_rendering && !application_start_render_thread()) {
+    LAI_LOG_WARN("Failed to start render thread, rendering on main thread");
+    app_state->pipelined_rendering = false;
+  }
+
   return true;
 }
 
@@ -162,8 +304,7 @@ bool application_run() {
   app_state->last_time = app_state->clock.elapsed;
 
   f64 running_time = 0;
-  f64 target_fps = 1.0f / 60;
-  u8 frame_count = 0;
+  f64 next_frame_time = platform_get_absolute_time();
 
   LAI_LOG_INFO(get_memory_usage());
 
@@ -173,43 +314,165 @@ bool application_run() {
     f64 delta = (current_time - app_state->last_time);
     f64 frame_start_time = platform_get_absolute_time();
 
+    f64 phase_times[FRAME_PHASE_MAX_PHASES] = {};
+    f64 phase_start_time = frame_start_time;
+    f64 phase_end_time = 0;
+
     if (!platform_pump_messages(app_state->platform_system_state)) {
       app_state->is_running = false;
     }
 
+    phase_end_time = platform_get_absolute_time();
+    phase_times[FRAME_PHASE_PUMP_MESSAGES] = phase_end_time - phase_start_time;
+    phase_start_time = phase_end_time;
+
     if (!app_state->is_suspended) {
-      if (!app_state->game_inst->update(app_state->game_inst, (f32)delta)) {
+      f32 interpolation_alpha = 1.0f;
+
+      if (app_state->fixed_timestep) {
+        // Never try to catch up more than a few steps, otherwise a slow frame
+        // makes the next one even slower.
+        f64 max_accumulated =
+            app_state->fixed_step * APPLICATION_MAX_FIXED_STEPS_PER_FRAME;
+        app_state->accumulator += delta;
+        if (app_state->accumulator > max_accumulated) {
+          app_state->accumulator = max_accumulated;
+        }
+
+        bool update_failed = false;
+        while (app_state->accumulator >= app_state->fixed_step) {
+          if (!app_state->game_inst->update(app_state->game_inst,
+                                            (f32)app_state->fixed_step)) {
+            update_failed = true;
+            break;
+          }
+          app_state->accumulator -= app_state->fixed_step;
+
+          // Input edges are consumed by the step that saw them, and kept
+          // for the next frame if no step ran.
+          f64 input_start_time = platform_get_absolute_time();
+          input_update(app_state->fixed_step);
+          phase_times[FRAME_PHASE_INPUT_UPDATE] +=
+              platform_get_absolute_time() - input_start_time;
+        }
+
+        if (update_failed) {
+          LAI_LOG_FATAL("Game update failed, shutting down!");
+          app_state->is_running = true;
+          break;
+        }
+
+        interpolation_alpha =
+            (f32)(app_state->accumulator / app_state->fixed_step);
+      } else if (!app_state->game_inst->update(app_state->game_inst,
+                                               (f32)delta)) {
         LAI_LOG_FATAL("Game update failed, shutting down!");
         app_state->is_running = true;
         break;
       }
 
-      if (!app_state->game_inst->render(app_state->game_inst, (f32)delta)) {
+      phase_end_time = platform_get_absolute_time();
+      phase_times[FRAME_PHASE_GAME_UPDATE] =
+          phase_end_time - phase_start_time -
+          phase_times[FRAME_PHASE_INPUT_UPDATE];
+      phase_start_time = phase_end_time;
+
+      // The game fills the packet of the slot it renders into, so with a
+      // render thread it first waits for a free slot. That blocks only when
+      // the render thread is a full frame behind.
+      application_frame_slot *slot = nullptr;
+      render_packet *packet = &app_state->packet;
+      if (app_state->pipelined_rendering) {
+        platform_semaphore_wait(&app_state->free_slots);
+        app_state->taken_slots++;
+
+        slot = &app_state->frame_slots[app_state->simulation_slot];
+        app_state->simulation_slot =
+            (app_state->simulation_slot + 1) % APPLICATION_FRAME_SLOT_COUNT;
+        packet = &slot->packet;
+      }
+      packet->delta_time = delta;
+      packet->projection = mat4_identity();
+      packet->view = mat4_identity();
+      darray_clear(packet->geometries);
+
+      if (!app_state->game_inst->render(app_state->game_inst, (f32)delta,
+                                        interpolation_alpha, packet)) {
         LAI_LOG_FATAL("Game render failed, shutting down!");
         app_state->is_running = true;
         break;
       }
 
-      render_packet packet;
-      packet.delta_time = delta;
-      renderer_draw_frame(&packet);
+      // Textures are streamed at the sizes they are drawn at in the frame.
+      material_system_mark_texture_usage(packet, app_state->height);
+      texture_system_update();
+
+      phase_end_time = platform_get_absolute_time();
+      phase_times[FRAME_PHASE_GAME_RENDER] = phase_end_time - phase_start_time;
+      phase_start_time = phase_end_time;
+
+      if (slot) {
+        // The draw time of the frame previously drawn from this slot, the
+        // one for this frame is not known yet. Same for the gpu timings.
+        phase_times[FRAME_PHASE_RENDERER_DRAW_FRAME] = slot->draw_time;
+        if (slot->has_gpu_timings) {
+          app_state->latest_gpu_timings = slot->timings;
+          app_state->has_gpu_timings = true;
+        }
 
-      f64 frame_end_time = platform_get_absolute_time();
-      f64 frame_elapsed_time = frame_end_time - frame_start_time;
-      running_time += frame_elapsed_time;
-      f64 remaining_seconds = target_fps - frame_elapsed_time;
+        slot->resized = app_state->resize_pending;
+        slot->width = app_state->width;
+        slot->height = app_state->height;
+        app_state->resize_pending = false;
+
+        platform_semaphore_signal(&app_state->ready_slots);
+      } else {
+        renderer_draw_frame(packet);
 
-      if (remaining_seconds > 0) {
-        u64 remaining_milliseconds = remaining_seconds * 1000;
-        bool limit_frames = false;
-        if (remaining_milliseconds > 0 && limit_frames) {
-          platform_sleep(remaining_milliseconds - 1);
+        phase_end_time = platform_get_absolute_time();
+        phase_times[FRAME_PHASE_RENDERER_DRAW_FRAME] =
+            phase_end_time - phase_start_time;
+
+        gpu_timings timings;
+        if (renderer_get_gpu_timings(&timings)) {
+          app_state->latest_gpu_timings = timings;
+          app_state->has_gpu_timings = true;
         }
+      }
+
+      phase_end_time = platform_get_absolute_time();
+      phase_start_time = phase_end_time;
+
+      if (!app_state->fixed_timestep) {
+        input_update(delta);
+
+        phase_end_time = platform_get_absolute_time();
+        phase_times[FRAME_PHASE_INPUT_UPDATE] =
+            phase_end_time - phase_start_time;
+      }
+
+      f64 frame_end_time = phase_end_time;
+      f64 frame_elapsed_time = frame_end_time - frame_start_time;
+      running_time += frame_elapsed_time;
 
-        frame_count++;
+      // Lags by the frames in flight, the distribution is what matters.
+      if (app_state->has_gpu_timings) {
+        phase_times[FRAME_PHASE_GPU_FRAME] =
+            app_state->latest_gpu_timings.frame_time;
       }
 
-      input_update(delta);
+      frame_stats_record(&app_state->frame_stats, frame_elapsed_time,
+                         phase_times);
+
+      if (app_state->target_frame_time > 0) {
+        // Pace against a schedule instead of the frame duration so sleep
+        // overshoot doesn't accumulate. Reset it after a long stall.
+        next_frame_time += app_state->target_frame_time;
+        if (next_frame_time < frame_end_time) {
+          next_frame_time = frame_end_time;
+        }
+        application_wait_until(next_frame_time);
+      }
 
       app_state->last_time = current_time;
     }
@@ -217,12 +480,26 @@ bool application_run() {
 
   app_state->is_running = false;
 
+  if (app_state->pipelined_rendering) {
+    application_stop_render_thread();
+  }
+
   event_unregister(EVENT_CODE_APPLICATION_QUIT, 0, application_on_event);
   event_unregister(EVENT_CODE_RESIZED, 0, application_on_resized);
   event_unregister(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
   event_unregister(EVENT_CODE_KEY_RELEASED, 0, application_on_key);
 
+  frame_stats_destroy(&app_state->frame_stats);
+
+  darray_destroy(app_state->packet.geometries);
+
+  app_state->game_inst->shutdown(app_state->game_inst);
+
   input_shutdown(app_state->input_system_state);
+  geometry_system_shutdown(app_state->geometry_system_state);
+  // Materials release their textures.
+  material_system_shutdown(app_state->material_system_state);
+  texture_system_shutdown(app_state->texture_system_state);
   renderer_shutdown(app_state->renderer_system_state);
   platform_shutdown(app_state->platform_system_state);
   shutdown_memory(app_state->memory_system_state);
@@ -233,10 +510,143 @@ bool application_run() {
 }
 
 void application_get_framebuffer_size(u32 *width, u32 *height) {
+  // Renderers may be created without an application, e.g. by tests.
+  if (!app_state) {
+    *width = 0;
+    *height = 0;
+    return;
+  }
   *width = app_state->width;
   *height = app_state->height;
 }
 
+void application_set_target_frame_rate(f32 frames_per_second) {
+  app_state->target_frame_time =
+      frames_per_second > 0 ? 1.0 / frames_per_second : 0;
+}
+
+void application_wait_until(f64 target_time) {
+  // Sleep is only millisecond accurate and may overshoot, so sleep until
+  // close to the target and spin for the rest.
+  for (;;) {
+    f64 remaining = target_time - platform_get_absolute_time();
+    if (remaining <= 0) {
+      return;
+    }
+
+    if (remaining > APPLICATION_FRAME_SPIN_THRESHOLD) {
+      u64 sleep_milliseconds =
+          (u64)((remaining - APPLICATION_FRAME_SPIN_THRESHOLD) * 1000);
+      if (sleep_milliseconds > 0) {
+        platform_sleep(sleep_milliseconds);
+      }
+    }
+  }
+}
+
+bool application_start_render_thread() {
+  lai_zero_memory(app_state->frame_slots, sizeof(app_state->frame_slots));
+  for (u32 i = 0; i < APPLICATION_FRAME_SLOT_COUNT; ++i) {
+    app_state->frame_slots[i].packet.geometries =
+        darray_create(geometry_render_data);
+  }
+  app_state->simulation_slot = 0;
+  app_state->taken_slots = 0;
+  app_state->drawn_slots = 0;
+  app_state->resize_pending = false;
+
+  if (!platform_semaphore_create(APPLICATION_FRAME_SLOT_COUNT,
+                                 &app_state->free_slots)) {
+    return false;
+  }
+  if (!platform_semaphore_create(0, &app_state->ready_slots)) {
+    platform_semaphore_destroy(&app_state->free_slots);
+    return false;
+  }
+
+  app_state->render_thread_running = true;
+  if (!platform_thread_create(application_render_thread_main, nullptr,
+                              &app_state->render_thread)) {
+    app_state->render_thread_running = false;
+    platform_semaphore_destroy(&app_state->ready_slots);
+    platform_semaphore_destroy(&app_state->free_slots);
+    return false;
+  }
+
+  LAI_LOG_INFO("Pipelined rendering enabled");
+  return true;
+}
+
+void application_stop_render_thread() {
+  // Frames still queued are dropped, the extra signal wakes the render
+  // thread if it is waiting for one.
+  app_state->render_thread_running = false;
+  platform_semaphore_signal(&app_state->ready_slots);
+  platform_thread_join(&app_state->render_thread);
+
+  // Slots of frames dropped or never queued, the render thread is gone.
+  u64 held_slots = app_state->taken_slots - app_state->drawn_slots;
+  for (u64 i = 0; i < held_slots; ++i) {
+    platform_semaphore_signal(&app_state->free_slots);
+  }
+
+  platform_semaphore_destroy(&app_state->ready_slots);
+  platform_semaphore_destroy(&app_state->free_slots);
+
+  for (u32 i = 0; i < APPLICATION_FRAME_SLOT_COUNT; ++i) {
+    darray_destroy(app_state->frame_slots[i].packet.geometries);
+    app_state->frame_slots[i].packet.geometries = nullptr;
+  }
+}
+
+u32 application_render_thread_main(void *params) {
+  u32 render_slot = 0;
+
+  for (;;) {
+    platform_semaphore_wait(&app_state->ready_slots);
+    if (!app_state->render_thread_running) {
+      break;
+    }
+
+    application_frame_slot *slot = &app_state->frame_slots[render_slot];
+    render_slot = (render_slot + 1) % APPLICATION_FRAME_SLOT_COUNT;
+
+    f64 draw_start_time = platform_get_absolute_time();
+
+    // The renderer is only touched from this thread while it runs.
+    if (slot->resized) {
+      renderer_on_resized(slot->width, slot->height);
+    }
+    renderer_draw_frame(&slot->packet);
+
+    slot->draw_time = platform_get_absolute_time() - draw_start_time;
+    slot->has_gpu_timings = renderer_get_gpu_timings(&slot->timings);
+
+    app_state->drawn_slots++;
+    platform_semaphore_signal(&app_state->free_slots);
+  }
+
+  return 0;
+}
+
+bool application_get_frame_stats(frame_stats *out_stats) {
+  if (!app_state || !out_stats) {
+    return false;
+  }
+
+  frame_stats_compute(&app_state->frame_stats, out_stats);
+  return true;
+}
+
+bool application_get_gpu_timings(gpu_timings *out_timings) {
+  if (!app_state || !out_timings || !app_state->has_gpu_timings) {
+    return false;
+  }
+
+  *out_timings = app_state->latest_gpu_timings;
+  return true;
+}
+
 bool application_on_event(u16 code, void *sender, void *listener,
                           event_context context) {
   switch (code) {
@@ -289,7 +699,12 @@ bool application_on_resized(u16 code, void *sender, void *listener,
           app_state->is_suspended = false;
         }
         app_state->game_inst->on_resize(app_state->game_inst, width, height);
-        renderer_on_resized(width, height);
+        if (app_state->pipelined_rendering) {
+          // Applied by the render thread with the next frame
+          app_state->resize_pending = true;
+        } else {
+          renderer_on_resized(width, height);
+        }
       }
     }
   }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "base/frame_stats.h"
 #include "defines.h"
+#include "renderer/renderer_types.inl"
 
 struct game;
 
@@ -10,9 +12,36 @@ struct application_config {
   i16 start_width;
   i16 start_height;
   char *name;
+  // Number of frames frame stats are computed over, 0 for the default
+  u32 frame_stats_window;
+  // Frame cap in frames per second, 0 for uncapped
+  f32 target_frame_rate;
+  // Update at a fixed rate and pass an interpolation alpha to render
+  bool fixed_timestep;
+  // Fixed updates per second, 0 for the default
+  f32 fixed_update_rate;
+  // Draw frames on a render thread while the next frame is simulated
+  bool pipelined_rendering;
+  // Frustum cull on the gpu and draw everything with one indirect call
+  bool gpu_culling;
+  // Render offscreen and never present, for servers and performance tests
+  bool headless;
+  // Keep a host copy of each headless frame, see renderer_read_frame
+  bool headless_readback;
+  // Frames recorded ahead of the gpu, 0 for the default. More hides stalls
+  // at the cost of latency.
+  u32 frames_in_flight;
 };
 
 bool application_create(struct game *game_inst);
 bool application_run();
 
-void application_get_framebuffer_size(u32 *width, u32 *height);
\ No newline at end of file
+void application_get_framebuffer_size(u32 *width, u32 *height);
+
+void application_set_target_frame_rate(f32 frames_per_second);
+
+bool application_get_frame_stats(frame_stats *out_stats);
+
+// The renderer's gpu timings as of the last frame the main thread handed
+// over, without waiting on the renderer. False until there are any.
+bool application_get_gpu_timings(gpu_timings *out_timings);
\ No newline at end of file
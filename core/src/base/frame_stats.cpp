@@ -0,0 +1,141 @@
+#include "base/frame_stats.h"
+#include "base/lai_memory.h"
+
+#include <stdlib.h>
+
+static const char *frame_phase_strings[FRAME_PHASE_MAX_PHASES] = {
+    "pump_messages", "game_update", "game_render", "renderer_draw_frame",
+    "input_update", "gpu_frame"};
+
+// frame times + one series per phase + sort scratch
+#define FRAME_STATS_SERIES_COUNT (FRAME_PHASE_MAX_PHASES + 2)
+
+static int compare_f64(const void *a, const void *b) {
+  f64 left = *(const f64 *)a;
+  f64 right = *(const f64 *)b;
+  return (left > right) - (left < right);
+}
+
+static f64 percentile(const f64 *sorted, u32 count, f64 fraction) {
+  // Nearest-rank
+  f64 exact_rank = fraction * count;
+  u32 rank = (u32)exact_rank;
+  if (rank < exact_rank) {
+    rank++;
+  }
+  if (rank < 1) {
+    rank = 1;
+  }
+  if (rank > count) {
+    rank = count;
+  }
+  return sorted[rank - 1];
+}
+
+static void summarize(const f64 *samples, u32 count, f64 *scratch,
+                      frame_time_summary *out_summary) {
+  lai_zero_memory(out_summary, sizeof(frame_time_summary));
+  if (count == 0) {
+    return;
+  }
+
+  // The ring is only partially filled until it wraps once, and the filled
+  // part always starts at index 0.
+  f64 sum = 0;
+  for (u32 i = 0; i < count; ++i) {
+    scratch[i] = samples[i];
+    sum += samples[i];
+  }
+  qsort(scratch, count, sizeof(f64), compare_f64);
+
+  out_summary->average = sum / count;
+  out_summary->min = scratch[0];
+  out_summary->max = scratch[count - 1];
+  out_summary->p50 = percentile(scratch, count, 0.50);
+  out_summary->p95 = percentile(scratch, count, 0.95);
+  out_summary->p99 = percentile(scratch, count, 0.99);
+}
+
+void frame_stats_create(u32 window, frame_stats_recorder *out_recorder) {
+  if (!out_recorder) {
+    return;
+  }
+
+  if (window == 0) {
+    window = FRAME_STATS_DEFAULT_WINDOW;
+  }
+  window = LAI_CLAMP(window, 1, FRAME_STATS_MAX_WINDOW);
+
+  lai_zero_memory(out_recorder, sizeof(frame_stats_recorder));
+  out_recorder->window = window;
+
+  f64 *block = (f64 *)lai_allocate(
+      sizeof(f64) * window * FRAME_STATS_SERIES_COUNT, MEMORY_TAG_APPLICATION);
+  out_recorder->frame_times = block;
+  for (u32 i = 0; i < FRAME_PHASE_MAX_PHASES; ++i) {
+    out_recorder->phase_times[i] = block + window * (i + 1);
+  }
+  out_recorder->scratch = block + window * (FRAME_PHASE_MAX_PHASES + 1);
+}
+
+void frame_stats_destroy(frame_stats_recorder *recorder) {
+  if (recorder && recorder->frame_times) {
+    lai_free(recorder->frame_times,
+             sizeof(f64) * recorder->window * FRAME_STATS_SERIES_COUNT,
+             MEMORY_TAG_APPLICATION);
+    lai_zero_memory(recorder, sizeof(frame_stats_recorder));
+  }
+}
+
+void frame_stats_record(frame_stats_recorder *recorder, f64 frame_time,
+                        const f64 *phase_times) {
+  if (!recorder || !recorder->frame_times) {
+    return;
+  }
+
+  u32 index = recorder->head;
+  recorder->frame_times[index] = frame_time;
+  for (u32 i = 0; i < FRAME_PHASE_MAX_PHASES; ++i) {
+    recorder->phase_times[i][index] = phase_times ? phase_times[i] : 0;
+  }
+
+  recorder->head = (index + 1) % recorder->window;
+  if (recorder->sample_count < recorder->window) {
+    recorder->sample_count++;
+  }
+  recorder->frame_count++;
+}
+
+void frame_stats_reset(frame_stats_recorder *recorder) {
+  if (recorder) {
+    recorder->head = 0;
+    recorder->sample_count = 0;
+    recorder->frame_count = 0;
+  }
+}
+
+void frame_stats_compute(frame_stats_recorder *recorder,
+                         frame_stats *out_stats) {
+  lai_zero_memory(out_stats, sizeof(frame_stats));
+  if (!recorder || !recorder->frame_times) {
+    return;
+  }
+
+  out_stats->frame_count = recorder->frame_count;
+  out_stats->window = recorder->window;
+  out_stats->sample_count = recorder->sample_count;
+
+  summarize(recorder->frame_times, recorder->sample_count, recorder->scratch,
+            &out_stats->frame_time);
+  for (u32 i = 0; i < FRAME_PHASE_MAX_PHASES; ++i) {
+    summarize(recorder->phase_times[i], recorder->sample_count,
+              recorder->scratch, &out_stats->phases[i]);
+  }
+}
+
+const char *frame_phase_name(frame_phase phase) {
+  if (phase < FRAME_PHASE_MAX_PHASES) {
+    return frame_phase_strings[phase];
+  }
+  return "unknown";
+}
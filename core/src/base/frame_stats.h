@@ -0,0 +1,63 @@
+#pragma once
+
+#include "defines.h"
+
+#define FRAME_STATS_DEFAULT_WINDOW 120
+#define FRAME_STATS_MAX_WINDOW 4096
+
+enum frame_phase {
+  FRAME_PHASE_PUMP_MESSAGES,
+  FRAME_PHASE_GAME_UPDATE,
+  FRAME_PHASE_GAME_RENDER,
+  FRAME_PHASE_RENDERER_DRAW_FRAME,
+  FRAME_PHASE_INPUT_UPDATE,
+  // Gpu time of the latest completed frame, not part of the frame time
+  FRAME_PHASE_GPU_FRAME,
+  FRAME_PHASE_MAX_PHASES
+};
+
+// All times are in seconds
+struct frame_time_summary {
+  f64 average;
+  f64 min;
+  f64 max;
+  f64 p50;
+  f64 p95;
+  f64 p99;
+};
+
+struct frame_stats {
+  u64 frame_count;
+  u32 window;
+  u32 sample_count;
+  frame_time_summary frame_time;
+  frame_time_summary phases[FRAME_PHASE_MAX_PHASES];
+};
+
+/*
+ * Fixed size ring of per frame samples. Recording is O(1) so it can stay
+ * enabled in release builds, min/max and percentiles are only computed when
+ * frame_stats_compute is called.
+ * */
+struct frame_stats_recorder {
+  u32 window;
+  u32 head;
+  u32 sample_count;
+  u64 frame_count;
+
+  f64 *frame_times;
+  f64 *phase_times[FRAME_PHASE_MAX_PHASES];
+  f64 *scratch;
+};
+
+void frame_stats_create(u32 window, frame_stats_recorder *out_recorder);
+void frame_stats_destroy(frame_stats_recorder *recorder);
+
+void frame_stats_record(frame_stats_recorder *recorder, f64 frame_time,
+                        const f64 *phase_times);
+void frame_stats_reset(frame_stats_recorder *recorder);
+
+void frame_stats_compute(frame_stats_recorder *recorder,
+                         frame_stats *out_stats);
+
+const char *frame_phase_name(frame_phase phase);
@@ -17,9 +17,16 @@ static const char *memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
     "RENDERER    ", "GAME        ", "TRANSFORM   ", "ENTITY      ",
     "ENTITY_MODE ", "SCENE       "};
 
+struct device_heap_stats {
+  u64 used;
+  u64 reserved;
+  u64 heap_size;
+};
+
 struct memory_system_state {
   memory_stats stats;
   u64 alloc_count;
+  device_heap_stats device_heaps[MEMORY_MAX_DEVICE_HEAPS];
 };
 static memory_system_state *state_ptr;
 
@@ -33,6 +40,8 @@ bool initialize_memory(u64 *memory_requirement, void *state) {
   state_ptr->alloc_count = 0;
   ;
   platform_zero_memory(&state_ptr->stats, sizeof(state_ptr->stats));
+  platform_zero_memory(state_ptr->device_heaps,
+                       sizeof(state_ptr->device_heaps));
 
   return true;
 }
@@ -83,36 +92,73 @@ void *lai_set_memory(void *destination, i32 value, u64 size) {
   return platform_set_memory(destination, value, size);
 }
 
-char *get_memory_usage() {
+void report_device_memory_usage(u32 heap_index, u64 used, u64 reserved,
+                                u64 heap_size) {
+  if (state_ptr && heap_index < MEMORY_MAX_DEVICE_HEAPS) {
+    state_ptr->device_heaps[heap_index].used = used;
+    state_ptr->device_heaps[heap_index].reserved = reserved;
+    state_ptr->device_heaps[heap_index].heap_size = heap_size;
+  }
+}
+
+static float size_in_unit(u64 size, char unit[4]) {
   const u64 gib = 1024 * 1024 * 1024;
   const u64 mib = 1024 * 1024;
   const u64 kib = 1024;
 
+  unit[1] = 'i';
+  unit[2] = 'B';
+  unit[3] = 0;
+  if (size >= gib) {
+    unit[0] = 'G';
+    return size / (float)gib;
+  } else if (size >= mib) {
+    unit[0] = 'M';
+    return size / (float)mib;
+  } else if (size >= kib) {
+    unit[0] = 'K';
+    return size / (float)kib;
+  }
+  unit[0] = 'B';
+  unit[1] = 0;
+  return (float)size;
+}
+
+char *get_memory_usage() {
   char buffer[8000] = "System memory use (tagged):\n";
   u64 offset = string_length(buffer);
   for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
-    char unit[4] = "XiB";
-    float amount = 1.0f;
-
-    if (state_ptr->stats.tagged_allocations[i] >= gib) {
-      unit[0] = 'G';
-      amount = state_ptr->stats.tagged_allocations[i] / (float)gib;
-    } else if (state_ptr->stats.tagged_allocations[i] >= mib) {
-      unit[0] = 'M';
-      amount = state_ptr->stats.tagged_allocations[i] / (float)mib;
-    } else if (state_ptr->stats.tagged_allocations[i] >= kib) {
-      unit[0] = 'K';
-      amount = state_ptr->stats.tagged_allocations[i] / (float)kib;
-    } else {
-      unit[0] = 'B';
-      unit[1] = 0;
-      amount = (float)state_ptr->stats.tagged_allocations[i];
+    char unit[4];
+    float amount =
+        size_in_unit(state_ptr->stats.tagged_allocations[i], unit);
+
+    i32 length = snprintf(buffer + offset, sizeof(buffer) - offset,
+                          "  %s: %.2f%s\n", memory_tag_strings[i], amount,
+                          unit);
+    offset += length;
+  }
+
+  for (u32 i = 0; i < MEMORY_MAX_DEVICE_HEAPS; ++i) {
+    device_heap_stats *heap = &state_ptr->device_heaps[i];
+    if (heap->heap_size == 0) {
+      continue;
     }
 
-    i32 length = snprintf(buffer + offset, 8000, "  %s: %.2f%s\n",
-                          memory_tag_strings[i], amount, unit);
+    char used_unit[4];
+    char reserved_unit[4];
+    char size_unit[4];
+    float used = size_in_unit(heap->used, used_unit);
+    float reserved = size_in_unit(heap->reserved, reserved_unit);
+    float size = size_in_unit(heap->heap_size, size_unit);
+
+    i32 length = snprintf(
+        buffer + offset, sizeof(buffer) - offset,
+        "  %s: heap %u %.2f%s used, %.2f%s reserved of %.2f%s\n",
+        memory_tag_strings[MEMORY_TAG_RENDERER], i, used, used_unit, reserved,
+        reserved_unit, size, size_unit);
     offset += length;
   }
+
   char *out_string = string_duplicate(buffer);
   return out_string;
 }
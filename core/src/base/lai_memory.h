@@ -33,6 +33,12 @@ void *lai_zero_memory(void *block, u64 size);
 void *lai_copy_memory(void *destination, const void *source, u64 size);
 void *lai_set_memory(void *destination, i32 value, u64 size);
 
+// Device memory is not allocated through lai_allocate, the renderer reports
+// its heaps so they show up in get_memory_usage.
+#define MEMORY_MAX_DEVICE_HEAPS 16
+void report_device_memory_usage(u32 heap_index, u64 used, u64 reserved,
+                                u64 heap_size);
+
 char *get_memory_usage();
 
 u64 get_memory_alloc_count();
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "base/lai_string.h"
 #include "base/lai_memory.h"
 
+#include <cerrno>
+#include <cstdlib>
 #include <string>
 
 u64 string_length(const char *str) { return strlen(str); }
@@ -16,6 +18,55 @@ bool strings_equal(const char *str0, const char *str1) {
   return strcmp(str0, str1) == 0;
 }
 
+bool string_contains(const char *str, const char *substring) {
+  return strstr(str, substring) != nullptr;
+}
+
+char *string_ncopy(char *dest, const char *source, u64 length) {
+  if (length == 0) {
+    return dest;
+  }
+  u64 count = source ? string_length(source) : 0;
+  if (count > length - 1) {
+    count = length - 1;
+  }
+  lai_copy_memory(dest, source, count);
+  dest[count] = 0;
+  return dest;
+}
+
+bool string_to_u32(const char *str, u32 *out_value) {
+  if (!str || !out_value || *str == 0 || *str == '-') {
+    return false;
+  }
+
+  char *end = nullptr;
+  errno = 0;
+  unsigned long long value = strtoull(str, &end, 10);
+  if (errno != 0 || *end != 0 || value > 0xFFFFFFFFull) {
+    return false;
+  }
+
+  *out_value = (u32)value;
+  return true;
+}
+
+bool string_to_f64(const char *str, f64 *out_value) {
+  if (!str || !out_value || *str == 0) {
+    return false;
+  }
+
+  char *end = nullptr;
+  errno = 0;
+  f64 value = strtod(str, &end);
+  if (errno != 0 || *end != 0) {
+    return false;
+  }
+
+  *out_value = value;
+  return true;
+}
+
 i32 string_format(char *dest, const char *format, ...) {
   if (dest) {
     __builtin_va_list arg_ptr;
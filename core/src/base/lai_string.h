@@ -6,4 +6,11 @@ u64 string_length(const char *str);
 char *string_duplicate(const char *str);
 bool strings_equal(const char *str0, const char *str1);
 i32 string_format(char *dest, const char *format, ...);
-i32 string_format_v(char *dest, const char *format, void *va_list);
\ No newline at end of file
+i32 string_format_v(char *dest, const char *format, void *va_list);
+bool string_contains(const char *str, const char *substring);
+// Copies at most length - 1 characters, dest is always terminated
+char *string_ncopy(char *dest, const char *source, u64 length);
+
+// Return false if str is not entirely a number
+bool string_to_u32(const char *str, u32 *out_value);
+bool string_to_f64(const char *str, f64 *out_value);
\ No newline at end of file
@@ -18,6 +18,7 @@ struct log_system_state {
   file_handle log_file_handle;
 };
 static log_system_state *state_ptr;
+static bool console_output_enabled = true;
 
 void append_to_log_file(const char *message) {
   if (state_ptr && state_ptr->log_file_handle.is_valid) {
@@ -55,6 +56,10 @@ void shutdown_logging(void *state) {
   state_ptr = nullptr;
 }
 
+void log_set_console_output(bool enabled) {
+  console_output_enabled = enabled;
+}
+
 void log_output(log_level level, const char *message, ...) {
   const char *level_strings[6] = {"[FATAL]", "[ERROR]", "[WARN]",
                                   "[INFO]",  "[DEBUG]", "[TRACE]"};
@@ -71,10 +76,12 @@ void log_output(log_level level, const char *message, ...) {
 
   string_format(out_message, "%s%s\n", level_strings[level], out_message);
 
-  if (is_error) {
-    platform_console_write_error(out_message, level);
-  } else {
-    platform_console_write(out_message, level);
+  if (console_output_enabled) {
+    if (is_error) {
+      platform_console_write_error(out_message, level);
+    } else {
+      platform_console_write(out_message, level);
+    }
   }
 
   append_to_log_file(out_message);
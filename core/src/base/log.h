@@ -27,6 +27,9 @@ void shutdown_logging(void *state);
 
 void log_output(log_level level, const char *message, ...);
 
+// Messages are still appended to the log file when console output is off
+void log_set_console_output(bool enabled);
+
 #define LAI_LOG_FATAL(message, ...)                                            \
   log_output(LOG_LEVEL_FATAL, message, ##__VA_ARGS__)
 #define LAI_LOG_ERROR(message, ...)                                            \
@@ -33,4 +33,7 @@ STATIC_ASSERT(sizeof(f32) == 4, "Expected f32 to be 4 bytes.");
 STATIC_ASSERT(sizeof(f64) == 8, "Expected f64 to be 8 bytes.");
 
 #define LAI_CLAMP(value, min, max)                                             \
-  ((value <= min) ? min : (value >= max) ? max : value)
\ No newline at end of file
+  ((value <= min) ? min : (value >= max) ? max : value)
+
+// Marks an unused id or slot
+#define INVALID_ID 4294967295U
\ No newline at end of file
@@ -15,7 +15,7 @@ int main() {
   }
 
   if (!game_inst.render || !game_inst.update || !game_inst.initialize ||
-      !game_inst.on_resize) {
+      !game_inst.on_resize || !game_inst.shutdown) {
     LAI_LOG_FATAL("The game's function pointers must be assigned!");
     return -2;
   }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "base/application.h"
+#include "renderer/renderer_types.inl"
 
 struct game {
   application_config app_config;
@@ -8,6 +9,12 @@ struct game {
   void *application_state;
   bool (*initialize)(struct game *game_inst);
   bool (*update)(struct game *game_inst, f32 delta_time);
-  bool (*render)(struct game *game_inst, f32 delta_time);
+  // interpolation_alpha is how far rendering is between the last two fixed
+  // updates, always 1 when fixed timestep is off. The game adds what it wants
+  // drawn this frame to packet->geometries.
+  bool (*render)(struct game *game_inst, f32 delta_time,
+                 f32 interpolation_alpha, render_packet *packet);
   void (*on_resize)(struct game *game_inst, u32 width, u32 height);
+  // Releases what the game acquired, before the systems shut down
+  void (*shutdown)(struct game *game_inst);
 };
\ No newline at end of file
@@ -329,8 +329,9 @@ static inline mat4 mat4_mul(mat4 matrix_0, mat4 matrix_1) {
     for (i32 j = 0; j < 4; ++j) {
       *dst_ptr = m0_ptr[0] * m1_ptr[0 + j] + m0_ptr[1] * m1_ptr[4 + j] +
                  m0_ptr[2] * m1_ptr[8 + j] + m0_ptr[3] * m1_ptr[12 + j];
+      dst_ptr++;
     }
-    m1_ptr += 4;
+    m0_ptr += 4;
   }
   return out_matrix;
 }
@@ -592,6 +593,85 @@ static inline vec3 mat4_right(mat4 matrix) {
   return right;
 }
 
+// Extracts the planes of the clip volume of a view projection matrix, with
+// Vulkan's 0 to 1 depth range. Order: left, right, bottom, top, near, far.
+static inline frustum frustum_from_matrix(mat4 matrix) {
+  const f32 *m = matrix.data;
+  vec4 row_x = vec4_create(m[0], m[4], m[8], m[12]);
+  vec4 row_y = vec4_create(m[1], m[5], m[9], m[13]);
+  vec4 row_z = vec4_create(m[2], m[6], m[10], m[14]);
+  vec4 row_w = vec4_create(m[3], m[7], m[11], m[15]);
+
+  frustum out_frustum;
+  out_frustum.planes[0] = vec4_add(row_w, row_x);
+  out_frustum.planes[1] = vec4_sub(row_w, row_x);
+  out_frustum.planes[2] = vec4_add(row_w, row_y);
+  out_frustum.planes[3] = vec4_sub(row_w, row_y);
+  out_frustum.planes[4] = row_z;
+  out_frustum.planes[5] = vec4_sub(row_w, row_z);
+
+  for (u32 i = 0; i < 6; ++i) {
+    vec4 *plane = &out_frustum.planes[i];
+    f32 length = lai_sqrt(plane->x * plane->x + plane->y * plane->y +
+                          plane->z * plane->z);
+    if (length > 0.0f) {
+      plane->x /= length;
+      plane->y /= length;
+      plane->z /= length;
+      plane->w /= length;
+    }
+  }
+  return out_frustum;
+}
+
+static inline bool frustum_intersects_sphere(const frustum *f, vec3 center,
+                                             f32 radius) {
+  for (u32 i = 0; i < 6; ++i) {
+    const vec4 *plane = &f->planes[i];
+    f32 distance = plane->x * center.x + plane->y * center.y +
+                   plane->z * center.z + plane->w;
+    if (distance < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Sphere around the center of the bounding box of count vertices, or of the
+// ones vertex_indices lists when it is not null. Center in xyz, radius in w.
+static inline vec4 vertices_bounding_sphere(const vertex_3d *vertices,
+                                            const u32 *vertex_indices,
+                                            u32 count) {
+  if (count == 0) {
+    return vec4_create(0.0f, 0.0f, 0.0f, 0.0f);
+  }
+
+  vec3 min = vertices[vertex_indices ? vertex_indices[0] : 0].position;
+  vec3 max = min;
+  for (u32 i = 1; i < count; ++i) {
+    vec3 p = vertices[vertex_indices ? vertex_indices[i] : i].position;
+    for (u32 axis = 0; axis < 3; ++axis) {
+      if (p.elements[axis] < min.elements[axis]) {
+        min.elements[axis] = p.elements[axis];
+      }
+      if (p.elements[axis] > max.elements[axis]) {
+        max.elements[axis] = p.elements[axis];
+      }
+    }
+  }
+
+  vec3 center = vec3_mul_scalar(vec3_add(min, max), 0.5f);
+  f32 radius_squared = 0.0f;
+  for (u32 i = 0; i < count; ++i) {
+    vec3 p = vertices[vertex_indices ? vertex_indices[i] : i].position;
+    f32 distance_squared = vec3_length_squared(vec3_sub(p, center));
+    if (distance_squared > radius_squared) {
+      radius_squared = distance_squared;
+    }
+  }
+  return vec4_create(center.x, center.y, center.z, lai_sqrt(radius_squared));
+}
+
 static inline quat quat_identity() { return (quat){0, 0, 0, 1.0f}; }
 
 static inline f32 quat_normal(quat q) {
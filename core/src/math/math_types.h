@@ -66,4 +66,11 @@ typedef union mat4_u {
 
 struct vertex_3d {
   vec3 position;
+  vec2 texcoord;
+};
+
+// Planes as (normal, distance) with normals pointing inside, a point p is
+// inside a plane when dot(normal, p) + distance >= 0.
+struct frustum {
+  vec4 planes[6];
 };
\ No newline at end of file
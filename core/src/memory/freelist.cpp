@@ -0,0 +1,181 @@
+#include "memory/freelist.h"
+#include "base/lai_memory.h"
+#include "base/log.h"
+
+#define FREELIST_DEFAULT_NODE_CAPACITY 16
+
+static void insert_node(freelist *list, u32 index, u64 offset, u64 size) {
+  if (list->node_count == list->node_capacity) {
+    u32 new_capacity = list->node_capacity * 2;
+    freelist_node *new_nodes = (freelist_node *)lai_allocate(
+        sizeof(freelist_node) * new_capacity, MEMORY_TAG_ARRAY);
+    lai_copy_memory(new_nodes, list->nodes,
+                    sizeof(freelist_node) * list->node_count);
+    lai_free(list->nodes, sizeof(freelist_node) * list->node_capacity,
+             MEMORY_TAG_ARRAY);
+    list->nodes = new_nodes;
+    list->node_capacity = new_capacity;
+  }
+
+  // Ranges overlap, so shift one at a time from the back.
+  for (u32 i = list->node_count; i > index; --i) {
+    list->nodes[i] = list->nodes[i - 1];
+  }
+  list->nodes[index].offset = offset;
+  list->nodes[index].size = size;
+  list->node_count++;
+}
+
+static void remove_node(freelist *list, u32 index) {
+  for (u32 i = index; i + 1 < list->node_count; ++i) {
+    list->nodes[i] = list->nodes[i + 1];
+  }
+  list->node_count--;
+}
+
+void freelist_create(u64 total_size, freelist *out_list) {
+  if (out_list) {
+    out_list->node_capacity = FREELIST_DEFAULT_NODE_CAPACITY;
+    out_list->nodes = (freelist_node *)lai_allocate(
+        sizeof(freelist_node) * out_list->node_capacity, MEMORY_TAG_ARRAY);
+    out_list->total_size = total_size;
+    freelist_clear(out_list);
+  }
+}
+
+void freelist_destroy(freelist *list) {
+  if (list && list->nodes) {
+    lai_free(list->nodes, sizeof(freelist_node) * list->node_capacity,
+             MEMORY_TAG_ARRAY);
+    lai_zero_memory(list, sizeof(freelist));
+  }
+}
+
+bool freelist_allocate(freelist *list, u64 size, u64 *out_offset) {
+  return freelist_allocate_aligned(list, size, 1, out_offset);
+}
+
+bool freelist_allocate_aligned(freelist *list, u64 size, u64 alignment,
+                               u64 *out_offset) {
+  if (!list || !list->nodes || !out_offset || size == 0) {
+    return false;
+  }
+  if (alignment == 0) {
+    alignment = 1;
+  }
+
+  // First fit, the padding in front of an aligned offset stays free.
+  for (u32 i = 0; i < list->node_count; ++i) {
+    freelist_node node = list->nodes[i];
+    u64 aligned_offset = (node.offset + alignment - 1) & ~(alignment - 1);
+    u64 padding = aligned_offset - node.offset;
+    if (padding + size > node.size) {
+      continue;
+    }
+
+    u64 remaining = node.size - padding - size;
+    if (padding > 0 && remaining > 0) {
+      list->nodes[i].size = padding;
+      insert_node(list, i + 1, aligned_offset + size, remaining);
+    } else if (padding > 0) {
+      list->nodes[i].size = padding;
+    } else if (remaining > 0) {
+      list->nodes[i].offset = aligned_offset + size;
+      list->nodes[i].size = remaining;
+    } else {
+      remove_node(list, i);
+    }
+
+    list->free_space -= size;
+    *out_offset = aligned_offset;
+    return true;
+  }
+
+  return false;
+}
+
+bool freelist_free(freelist *list, u64 size, u64 offset) {
+  if (!list || !list->nodes || size == 0) {
+    return false;
+  }
+  if (offset + size > list->total_size) {
+    LAI_LOG_ERROR("freelist_free - Range %llu+%llu is outside of the list",
+                  offset, size);
+    return false;
+  }
+
+  // First free range after the one being freed
+  u32 next = 0;
+  while (next < list->node_count && list->nodes[next].offset < offset) {
+    ++next;
+  }
+
+  bool overlaps_previous =
+      next > 0 && list->nodes[next - 1].offset + list->nodes[next - 1].size >
+                      offset;
+  bool overlaps_next =
+      next < list->node_count && offset + size > list->nodes[next].offset;
+  if (overlaps_previous || overlaps_next) {
+    LAI_LOG_ERROR("freelist_free - Range %llu+%llu is already free", offset,
+                  size);
+    return false;
+  }
+
+  bool merge_previous =
+      next > 0 &&
+      list->nodes[next - 1].offset + list->nodes[next - 1].size == offset;
+  bool merge_next =
+      next < list->node_count && offset + size == list->nodes[next].offset;
+
+  if (merge_previous && merge_next) {
+    list->nodes[next - 1].size += size + list->nodes[next].size;
+    remove_node(list, next);
+  } else if (merge_previous) {
+    list->nodes[next - 1].size += size;
+  } else if (merge_next) {
+    list->nodes[next].offset = offset;
+    list->nodes[next].size += size;
+  } else {
+    insert_node(list, next, offset, size);
+  }
+
+  list->free_space += size;
+  return true;
+}
+
+void freelist_clear(freelist *list) {
+  if (list && list->nodes) {
+    list->nodes[0].offset = 0;
+    list->nodes[0].size = list->total_size;
+    list->node_count = list->total_size > 0 ? 1 : 0;
+    list->free_space = list->total_size;
+  }
+}
+
+bool freelist_resize(freelist *list, u64 new_size) {
+  if (!list || !list->nodes || new_size < list->total_size) {
+    return false;
+  }
+
+  u64 old_size = list->total_size;
+  u64 added = new_size - old_size;
+  list->total_size = new_size;
+  if (added == 0) {
+    return true;
+  }
+
+  freelist_node *last =
+      list->node_count > 0 ? &list->nodes[list->node_count - 1] : nullptr;
+  if (last && last->offset + last->size == old_size) {
+    last->size += added;
+  } else {
+    insert_node(list, list->node_count, old_size, added);
+  }
+
+  list->free_space += added;
+  return true;
+}
+
+u64 freelist_free_space(freelist *list) {
+  return list ? list->free_space : 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "defines.h"
+
+struct freelist_node {
+  u64 offset;
+  u64 size;
+};
+
+/*
+ * Tracks the free ranges of a block of total_size bytes that lives elsewhere,
+ * e.g. GPU memory or a range of a vertex buffer. Only offsets are handed out.
+ * Free ranges are kept sorted by offset and are merged with their neighbours
+ * when freed.
+ * */
+struct freelist {
+  u64 total_size;
+  u64 free_space;
+
+  u32 node_count;
+  u32 node_capacity;
+  freelist_node *nodes;
+};
+
+void freelist_create(u64 total_size, freelist *out_list);
+void freelist_destroy(freelist *list);
+
+bool freelist_allocate(freelist *list, u64 size, u64 *out_offset);
+// alignment must be a power of two
+bool freelist_allocate_aligned(freelist *list, u64 size, u64 alignment,
+                               u64 *out_offset);
+bool freelist_free(freelist *list, u64 size, u64 offset);
+void freelist_clear(freelist *list);
+
+// Grow the tracked range, new_size must not be smaller than total_size
+bool freelist_resize(freelist *list, u64 new_size);
+
+u64 freelist_free_space(freelist *list);
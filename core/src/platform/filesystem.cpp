@@ -5,6 +5,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 
 bool filesystem_exists(const char *path) {
@@ -12,6 +13,8 @@ bool filesystem_exists(const char *path) {
   return stat(path, &buffer) == 0;
 }
 
+bool filesystem_delete(const char *path) { return remove(path) == 0; }
+
 bool filesystem_open(const char *path, file_modes mode, bool binary,
                      file_handle *out_handle) {
   out_handle->is_valid = false;
@@ -117,4 +120,45 @@ bool filesystem_write(file_handle *handle, u64 data_size, const void *data,
     return true;
   }
   return false;
-}
\ No newline at end of file
+}
+
+bool filesystem_map(const char *path, file_mapping *out_mapping) {
+  out_mapping->data = nullptr;
+  out_mapping->size = 0;
+
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    LAI_LOG_ERROR("Error opening file: %s", path);
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fileno(file), &info) != 0 || info.st_size == 0) {
+    LAI_LOG_ERROR("Cannot map empty or unreadable file: %s", path);
+    fclose(file);
+    return false;
+  }
+
+  void *data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE,
+                    fileno(file), 0);
+  // The mapping keeps the file alive.
+  fclose(file);
+  if (data == MAP_FAILED) {
+    LAI_LOG_ERROR("Error mapping file: %s", path);
+    return false;
+  }
+  // Loading reads mappings front to back, once.
+  madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+  out_mapping->data = data;
+  out_mapping->size = (u64)info.st_size;
+  return true;
+}
+
+void filesystem_unmap(file_mapping *mapping) {
+  if (mapping->data) {
+    munmap((void *)mapping->data, (size_t)mapping->size);
+    mapping->data = nullptr;
+    mapping->size = 0;
+  }
+}
@@ -9,8 +9,16 @@ struct file_handle {
   bool is_valid;
 };
 
+// A whole file mapped read only into memory
+struct file_mapping {
+  const void *data;
+  u64 size;
+};
+
 bool filesystem_exists(const char *path);
 
+bool filesystem_delete(const char *path);
+
 bool filesystem_open(const char *path, file_modes mode, bool binary,
                      file_handle *out_handle);
 
@@ -27,4 +35,9 @@ bool filesystem_read_all_bytes(file_handle *handle, u8 **out_bytes,
                                u64 *out_bytes_read);
 
 bool filesystem_write(file_handle *handle, u64 data_size, const void *data,
-                      u64 *out_bytes_written);
\ No newline at end of file
+                      u64 *out_bytes_written);
+
+// Pages of the file are read on first access, sequentially ahead of it
+bool filesystem_map(const char *path, file_mapping *out_mapping);
+
+void filesystem_unmap(file_mapping *mapping);
@@ -2,8 +2,9 @@
 
 #include "defines.h"
 
+// Headless creates no window, there are no input or window events then.
 bool platform_startup(u64 *memory_requirement, void *state, const char *name,
-                      i32 x, i32 y, i32 width, i32 height);
+                      i32 x, i32 y, i32 width, i32 height, bool headless);
 bool platform_pump_messages(void *state);
 void platform_shutdown(void *state);
 
@@ -19,3 +20,34 @@ void platform_console_write_error(const char *message, u8 color);
 f64 platform_get_absolute_time();
 
 void platform_sleep(u64 milliseconds);
+
+typedef u32 (*PFN_thread_start)(void *params);
+
+struct platform_thread {
+  void *internal_data;
+};
+
+struct platform_mutex {
+  void *internal_data;
+};
+
+struct platform_semaphore {
+  void *internal_data;
+};
+
+bool platform_thread_create(PFN_thread_start start_function, void *params,
+                            platform_thread *out_thread);
+void platform_thread_join(platform_thread *thread);
+
+bool platform_mutex_create(platform_mutex *out_mutex);
+void platform_mutex_destroy(platform_mutex *mutex);
+void platform_mutex_lock(platform_mutex *mutex);
+void platform_mutex_unlock(platform_mutex *mutex);
+
+bool platform_semaphore_create(u32 initial_count,
+                               platform_semaphore *out_semaphore);
+void platform_semaphore_destroy(platform_semaphore *semaphore);
+void platform_semaphore_signal(platform_semaphore *semaphore);
+void platform_semaphore_wait(platform_semaphore *semaphore);
+
+u32 platform_get_processor_count();
\ No newline at end of file
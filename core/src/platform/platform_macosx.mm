@@ -15,6 +15,10 @@
 
 #include <mach/mach_time.h>
 #include <crt_externs.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <dispatch/dispatch.h>
 
 #import <Foundation/Foundation.h>
 #import <Cocoa/Cocoa.h>
@@ -37,6 +41,7 @@ struct platform_system_state {
   CAMetalLayer* layer;
   VkSurfaceKHR surface;
   bool quit_flagged;
+  bool headless;
 };
 static platform_system_state* state_ptr;
 
@@ -255,13 +260,19 @@ static const NSRange kEmptyRange = { NSNotFound, 0 };
 
 @end // ApplicationDelegate
 
-bool platform_startup(u64 *memory_requirement, void *state, const char* name, i32 x, i32 y, i32 width, i32 height) {
+bool platform_startup(u64 *memory_requirement, void *state, const char* name, i32 x, i32 y, i32 width, i32 height, bool headless) {
     *memory_requirement = sizeof(platform_system_state);
     if (state == nullptr) {
         return true;
     }
 
     state_ptr = (platform_system_state *)state;
+    platform_zero_memory(state_ptr, sizeof(platform_system_state));
+    state_ptr->headless = headless;
+    if (headless) {
+        // No NSApplication either, runs without a window server.
+        return true;
+    }
 
   @autoreleasepool {
     [NSApplication sharedApplication];
@@ -329,27 +340,32 @@ bool platform_startup(u64 *memory_requirement, void *state, const char* name, i3
 
 void platform_shutdown(void* state) {
   if (state_ptr != nullptr) {
-    @autoreleasepool {
-      [state_ptr->window orderOut:nil];
+    if (!state_ptr->headless) {
+      @autoreleasepool {
+        [state_ptr->window orderOut:nil];
 
-      [state_ptr->window setDelegate:nil];
-      [state_ptr->window_delegate release];
+        [state_ptr->window setDelegate:nil];
+        [state_ptr->window_delegate release];
 
-      [state_ptr->view release];
-      state_ptr->view = nil;
+        [state_ptr->view release];
+        state_ptr->view = nil;
 
-      [state_ptr->window close];
-      state_ptr->window = nil;
+        [state_ptr->window close];
+        state_ptr->window = nil;
 
-      [NSApp setDelegate:nil];
-      [state_ptr->app_delegate release];
-      state_ptr->app_delegate = nil;
-    } // autoreleasepool
+        [NSApp setDelegate:nil];
+        [state_ptr->app_delegate release];
+        state_ptr->app_delegate = nil;
+      } // autoreleasepool
+    }
     state_ptr = nullptr;
   }
 }
 
 bool platform_pump_messages(void *state) {
+    if (state_ptr && state_ptr->headless) {
+        return !state_ptr->quit_flagged;
+    }
     if (state_ptr) {
         @autoreleasepool {
         NSEvent* event;
@@ -402,7 +418,13 @@ void platform_console_write_error(const char *message, u8 color) {
 }
 
 f64 platform_get_absolute_time() {
-    return mach_absolute_time();
+    // mach_absolute_time is in ticks, convert to seconds
+    static mach_timebase_info_data_t timebase = {};
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    u64 ticks = mach_absolute_time();
+    return (f64)ticks * (f64)timebase.numer / (f64)timebase.denom * 0.000000001;
 }
 
 void platform_sleep(u64 milliseconds) {
@@ -419,6 +441,110 @@ void platform_sleep(u64 milliseconds) {
 #endif
 }
 
+struct platform_thread_start_info {
+    PFN_thread_start start_function;
+    void* params;
+};
+
+static void* platform_thread_trampoline(void* data) {
+    platform_thread_start_info info = *(platform_thread_start_info*)data;
+    platform_free(data, false);
+    info.start_function(info.params);
+    return nullptr;
+}
+
+bool platform_thread_create(PFN_thread_start start_function, void *params, platform_thread *out_thread) {
+    if (!start_function || !out_thread) {
+        return false;
+    }
+
+    platform_thread_start_info* info = (platform_thread_start_info*)platform_allocate(sizeof(platform_thread_start_info), false);
+    info->start_function = start_function;
+    info->params = params;
+
+    pthread_t* handle = (pthread_t*)platform_allocate(sizeof(pthread_t), false);
+    if (pthread_create(handle, nullptr, platform_thread_trampoline, info) != 0) {
+        LAI_LOG_ERROR("Failed to create thread");
+        platform_free(info, false);
+        platform_free(handle, false);
+        out_thread->internal_data = nullptr;
+        return false;
+    }
+
+    out_thread->internal_data = handle;
+    return true;
+}
+
+void platform_thread_join(platform_thread *thread) {
+    if (thread && thread->internal_data) {
+        pthread_join(*(pthread_t*)thread->internal_data, nullptr);
+        platform_free(thread->internal_data, false);
+        thread->internal_data = nullptr;
+    }
+}
+
+bool platform_mutex_create(platform_mutex *out_mutex) {
+    pthread_mutex_t* handle = (pthread_mutex_t*)platform_allocate(sizeof(pthread_mutex_t), false);
+    if (pthread_mutex_init(handle, nullptr) != 0) {
+        LAI_LOG_ERROR("Failed to create mutex");
+        platform_free(handle, false);
+        out_mutex->internal_data = nullptr;
+        return false;
+    }
+
+    out_mutex->internal_data = handle;
+    return true;
+}
+
+void platform_mutex_destroy(platform_mutex *mutex) {
+    if (mutex && mutex->internal_data) {
+        pthread_mutex_destroy((pthread_mutex_t*)mutex->internal_data);
+        platform_free(mutex->internal_data, false);
+        mutex->internal_data = nullptr;
+    }
+}
+
+void platform_mutex_lock(platform_mutex *mutex) {
+    pthread_mutex_lock((pthread_mutex_t*)mutex->internal_data);
+}
+
+void platform_mutex_unlock(platform_mutex *mutex) {
+    pthread_mutex_unlock((pthread_mutex_t*)mutex->internal_data);
+}
+
+bool platform_semaphore_create(u32 initial_count, platform_semaphore *out_semaphore) {
+    // Unnamed POSIX semaphores are not supported on macOS
+    dispatch_semaphore_t handle = dispatch_semaphore_create(initial_count);
+    if (!handle) {
+        LAI_LOG_ERROR("Failed to create semaphore");
+        out_semaphore->internal_data = nullptr;
+        return false;
+    }
+
+    out_semaphore->internal_data = (void*)handle;
+    return true;
+}
+
+void platform_semaphore_destroy(platform_semaphore *semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        dispatch_release((dispatch_semaphore_t)semaphore->internal_data);
+        semaphore->internal_data = nullptr;
+    }
+}
+
+void platform_semaphore_signal(platform_semaphore *semaphore) {
+    dispatch_semaphore_signal((dispatch_semaphore_t)semaphore->internal_data);
+}
+
+void platform_semaphore_wait(platform_semaphore *semaphore) {
+    dispatch_semaphore_wait((dispatch_semaphore_t)semaphore->internal_data, DISPATCH_TIME_FOREVER);
+}
+
+u32 platform_get_processor_count() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32)count : 1;
+}
+
 bool platform_create_vulkan_surface(struct vulkan_context *context) {
   VkMetalSurfaceCreateInfoEXT create_info = {};
   create_info.sType = VK_STRUCTURE_TYPE_METAL_SURFACE_CREATE_INFO_EXT;
@@ -0,0 +1,53 @@
+#include "renderer/geometry_ranges.h"
+
+void geometry_range_allocator_create(u64 vertex_capacity, u64 index_capacity,
+                                     geometry_range_allocator *out_allocator) {
+  freelist_create(vertex_capacity, &out_allocator->vertices);
+  freelist_create(index_capacity, &out_allocator->indices);
+}
+
+void geometry_range_allocator_destroy(geometry_range_allocator *allocator) {
+  freelist_destroy(&allocator->vertices);
+  freelist_destroy(&allocator->indices);
+}
+
+bool geometry_range_allocate(geometry_range_allocator *allocator,
+                             geometry_range *range) {
+  u64 vertex_offset = 0;
+  u64 index_offset = 0;
+  if (!freelist_allocate(&allocator->vertices, range->vertex_count,
+                         &vertex_offset)) {
+    return false;
+  }
+  if (range->index_count > 0 &&
+      !freelist_allocate(&allocator->indices, range->index_count,
+                         &index_offset)) {
+    freelist_free(&allocator->vertices, range->vertex_count, vertex_offset);
+    return false;
+  }
+
+  range->vertex_offset = (u32)vertex_offset;
+  range->index_offset = (u32)index_offset;
+  return true;
+}
+
+void geometry_range_free(geometry_range_allocator *allocator,
+                         const geometry_range *range) {
+  freelist_free(&allocator->vertices, range->vertex_count,
+                range->vertex_offset);
+  if (range->index_count > 0) {
+    freelist_free(&allocator->indices, range->index_count,
+                  range->index_offset);
+  }
+}
+
+bool geometry_range_fits_compacted(geometry_range_allocator *allocator,
+                                   u32 vertex_count, u32 index_count) {
+  return freelist_free_space(&allocator->vertices) >= vertex_count &&
+         freelist_free_space(&allocator->indices) >= index_count;
+}
+
+void geometry_range_allocator_clear(geometry_range_allocator *allocator) {
+  freelist_clear(&allocator->vertices);
+  freelist_clear(&allocator->indices);
+}
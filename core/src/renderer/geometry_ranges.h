@@ -0,0 +1,42 @@
+#pragma once
+
+#include "defines.h"
+#include "memory/freelist.h"
+
+// A geometry's part of the shared vertex and index buffers, in elements
+struct geometry_range {
+  u32 vertex_count;
+  u32 vertex_offset;
+  u32 index_count;
+  u32 index_offset;
+};
+
+/*
+ * Hands out the ranges of the shared vertex and index buffers, a freelist
+ * for each. Freed ranges are reused first fit. When the free space is only
+ * fragmented the owner compacts: it clears the allocator, allocates every
+ * live range again in order, which packs them back to back, and moves the
+ * data to the new offsets.
+ * */
+struct geometry_range_allocator {
+  freelist vertices;
+  freelist indices;
+};
+
+void geometry_range_allocator_create(u64 vertex_capacity, u64 index_capacity,
+                                     geometry_range_allocator *out_allocator);
+void geometry_range_allocator_destroy(geometry_range_allocator *allocator);
+
+// Sets the offsets of range from its counts, a range without indices only
+// takes vertices. False when either doesn't fit, nothing is taken then.
+bool geometry_range_allocate(geometry_range_allocator *allocator,
+                             geometry_range *range);
+void geometry_range_free(geometry_range_allocator *allocator,
+                         const geometry_range *range);
+
+// Whether the counts fit in the free space once the live ranges are packed
+bool geometry_range_fits_compacted(geometry_range_allocator *allocator,
+                                   u32 vertex_count, u32 index_count);
+
+// Frees every range, the first step of compacting
+void geometry_range_allocator_clear(geometry_range_allocator *allocator);
@@ -0,0 +1,605 @@
+#include "renderer/mesh_cook.h"
+
+#include "base/lai_memory.h"
+#include "base/log.h"
+#include "containers/darray.h"
+#include "math/lai_math.h"
+
+#include <cstdlib>
+
+// Grid cells along each axis are counted in 21 bits of the cell key
+#define MESH_COOK_MAX_GRID_CELLS (1u << 21)
+
+// Cells across the mesh of the first grid lods are tried with
+#define MESH_COOK_INITIAL_RESOLUTION 1024
+
+static bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Copies the next token of the line into out, false at the end of the line
+static bool next_token(const char **cursor, const char *line_end, char *out,
+                       u32 out_size) {
+  const char *c = *cursor;
+  while (c < line_end && is_blank(*c)) {
+    c++;
+  }
+  if (c >= line_end) {
+    *cursor = c;
+    return false;
+  }
+
+  u32 length = 0;
+  while (c < line_end && !is_blank(*c)) {
+    if (length + 1 < out_size) {
+      out[length++] = *c;
+    }
+    c++;
+  }
+  out[length] = 0;
+  *cursor = c;
+  return true;
+}
+
+static bool parse_floats(const char **cursor, const char *line_end,
+                         u32 count, f32 *out_values) {
+  char token[64];
+  for (u32 i = 0; i < count; ++i) {
+    if (!next_token(cursor, line_end, token, sizeof(token))) {
+      return false;
+    }
+    char *end;
+    out_values[i] = strtof(token, &end);
+    if (end == token) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Turns a 1 based or, counting back from the end, negative OBJ index into
+// one of count elements
+static bool resolve_index(const char *text, char **out_end, u32 count,
+                          u32 *out_index) {
+  long value = strtol(text, out_end, 10);
+  if (*out_end == text || value == 0) {
+    return false;
+  }
+  value = value < 0 ? value + (long)count : value - 1;
+  if (value < 0 || value >= (long)count) {
+    return false;
+  }
+  *out_index = (u32)value;
+  return true;
+}
+
+struct obj_parser {
+  vec3 *positions;
+  vec2 *texcoords;
+  vertex_3d *vertices;
+  u32 *indices;
+  // Per position, the first vertex made from it
+  u32 *first_vertex;
+  // Per vertex, the next one made from the same position and its texcoord
+  u32 *next_vertex;
+  u32 *vertex_texcoords;
+  // Vertices of the face being parsed
+  u32 *face;
+};
+
+// The vertex of a corner, made on its first use
+static u32 corner_vertex(obj_parser *parser, u32 position, u32 texcoord) {
+  while (darray_length(parser->first_vertex) <
+         darray_length(parser->positions)) {
+    darray_push(parser->first_vertex, INVALID_ID);
+  }
+
+  u32 last = INVALID_ID;
+  for (u32 v = parser->first_vertex[position]; v != INVALID_ID;
+       v = parser->next_vertex[v]) {
+    if (parser->vertex_texcoords[v] == texcoord) {
+      return v;
+    }
+    last = v;
+  }
+
+  u32 index = (u32)darray_length(parser->vertices);
+  if (last == INVALID_ID) {
+    parser->first_vertex[position] = index;
+  } else {
+    parser->next_vertex[last] = index;
+  }
+
+  vertex_3d vertex;
+  vertex.position = parser->positions[position];
+  vertex.texcoord = vec2_create(0.0f, 0.0f);
+  if (texcoord != INVALID_ID) {
+    // OBJ texcoords start at the bottom, the renderer's at the top.
+    vertex.texcoord = vec2_create(parser->texcoords[texcoord].x,
+                                  1.0f - parser->texcoords[texcoord].y);
+  }
+  darray_push(parser->vertices, vertex);
+  darray_push(parser->next_vertex, INVALID_ID);
+  darray_push(parser->vertex_texcoords, texcoord);
+  return index;
+}
+
+static bool parse_face(obj_parser *parser, const char **cursor,
+                       const char *line_end) {
+  darray_clear(parser->face);
+  u32 position_count = (u32)darray_length(parser->positions);
+  u32 texcoord_count = (u32)darray_length(parser->texcoords);
+
+  char token[64];
+  while (next_token(cursor, line_end, token, sizeof(token))) {
+    // v, v/vt, v//vn or v/vt/vn
+    char *end;
+    u32 position;
+    if (!resolve_index(token, &end, position_count, &position)) {
+      return false;
+    }
+    u32 texcoord = INVALID_ID;
+    if (*end == '/' && end[1] != '/' && end[1] != 0) {
+      const char *texcoord_text = end + 1;
+      if (!resolve_index(texcoord_text, &end, texcoord_count, &texcoord)) {
+        return false;
+      }
+    }
+    darray_push(parser->face, corner_vertex(parser, position, texcoord));
+  }
+
+  u32 corner_count = (u32)darray_length(parser->face);
+  if (corner_count < 3) {
+    return false;
+  }
+  // Polygons are fanned out from their first corner.
+  for (u32 i = 1; i + 1 < corner_count; ++i) {
+    darray_push(parser->indices, parser->face[0]);
+    darray_push(parser->indices, parser->face[i]);
+    darray_push(parser->indices, parser->face[i + 1]);
+  }
+  return true;
+}
+
+bool mesh_cook_parse_obj(const char *text, u64 length, vertex_3d **out_vertices,
+                         u32 **out_indices) {
+  obj_parser parser;
+  parser.positions = darray_create(vec3);
+  parser.texcoords = darray_create(vec2);
+  parser.vertices = darray_create(vertex_3d);
+  parser.indices = darray_create(u32);
+  parser.first_vertex = darray_create(u32);
+  parser.next_vertex = darray_create(u32);
+  parser.vertex_texcoords = darray_create(u32);
+  parser.face = darray_create(u32);
+
+  bool success = true;
+  const char *end = text + length;
+  const char *line = text;
+  u32 line_number = 0;
+  while (line < end && success) {
+    const char *line_end = line;
+    while (line_end < end && *line_end != '\n') {
+      line_end++;
+    }
+    line_number++;
+
+    const char *cursor = line;
+    char keyword[8];
+    if (next_token(&cursor, line_end, keyword, sizeof(keyword))) {
+      if (keyword[0] == 'v' && keyword[1] == 0) {
+        vec3 position;
+        success = parse_floats(&cursor, line_end, 3, position.elements);
+        if (success) {
+          darray_push(parser.positions, position);
+        }
+      } else if (keyword[0] == 'v' && keyword[1] == 't' && keyword[2] == 0) {
+        // v is 0 when left out, a w after it is ignored.
+        vec2 texcoord = vec2_create(0.0f, 0.0f);
+        success = parse_floats(&cursor, line_end, 1, &texcoord.x);
+        char token[64];
+        const char *rest = cursor;
+        if (success && next_token(&rest, line_end, token, sizeof(token))) {
+          success = parse_floats(&cursor, line_end, 1, &texcoord.y);
+        }
+        if (success) {
+          darray_push(parser.texcoords, texcoord);
+        }
+      } else if (keyword[0] == 'f' && keyword[1] == 0) {
+        success = parse_face(&parser, &cursor, line_end);
+      }
+    }
+    if (!success) {
+      LAI_LOG_ERROR("Malformed OBJ line %u", line_number);
+    }
+    line = line_end + 1;
+  }
+
+  darray_destroy(parser.positions);
+  darray_destroy(parser.texcoords);
+  darray_destroy(parser.first_vertex);
+  darray_destroy(parser.next_vertex);
+  darray_destroy(parser.vertex_texcoords);
+  darray_destroy(parser.face);
+
+  if (!success || darray_length(parser.indices) == 0) {
+    if (success) {
+      LAI_LOG_ERROR("OBJ has no faces");
+    }
+    darray_destroy(parser.vertices);
+    darray_destroy(parser.indices);
+    return false;
+  }
+
+  *out_vertices = parser.vertices;
+  *out_indices = parser.indices;
+  return true;
+}
+
+struct cell_vertex {
+  u64 key;
+  u32 vertex;
+};
+
+static int compare_cell_vertices(const void *a, const void *b) {
+  const cell_vertex *left = (const cell_vertex *)a;
+  const cell_vertex *right = (const cell_vertex *)b;
+  if (left->key != right->key) {
+    return left->key < right->key ? -1 : 1;
+  }
+  if (left->vertex != right->vertex) {
+    return left->vertex < right->vertex ? -1 : 1;
+  }
+  return 0;
+}
+
+static u64 grid_coordinate(f32 offset, f32 cell_size) {
+  f32 cell = offset / cell_size;
+  if (cell <= 0.0f) {
+    return 0;
+  }
+  if (cell >= (f32)(MESH_COOK_MAX_GRID_CELLS - 1)) {
+    return MESH_COOK_MAX_GRID_CELLS - 1;
+  }
+  return (u64)cell;
+}
+
+void mesh_cook_simplify(const vertex_3d *vertices, u32 vertex_count,
+                        const u32 *indices, u32 index_count, f32 cell_size,
+                        vertex_3d **out_vertices, u32 **out_indices,
+                        f32 *out_error) {
+  *out_vertices = darray_create(vertex_3d);
+  *out_indices = darray_create(u32);
+  *out_error = 0.0f;
+  if (vertex_count == 0) {
+    return;
+  }
+
+  vec4 bounds = vertices_bounding_sphere(vertices, nullptr, vertex_count);
+  vec3 origin = vec3_create(bounds.x - bounds.w, bounds.y - bounds.w,
+                            bounds.z - bounds.w);
+
+  // Vertices are sorted by cell, each run of a cell becomes a cluster.
+  cell_vertex *cells = (cell_vertex *)lai_allocate(
+      sizeof(cell_vertex) * vertex_count, MEMORY_TAG_ARRAY);
+  for (u32 i = 0; i < vertex_count; ++i) {
+    vec3 offset = vec3_sub(vertices[i].position, origin);
+    cells[i].key = grid_coordinate(offset.x, cell_size) |
+                   grid_coordinate(offset.y, cell_size) << 21 |
+                   grid_coordinate(offset.z, cell_size) << 42;
+    cells[i].vertex = i;
+  }
+  qsort(cells, vertex_count, sizeof(cell_vertex), compare_cell_vertices);
+
+  u32 *vertex_clusters =
+      (u32 *)lai_allocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+  // Per cluster, the vertex closest to the cluster's average stands for it
+  u32 *cluster_vertices =
+      (u32 *)lai_allocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+  u32 cluster_count = 0;
+  u32 run_start = 0;
+  while (run_start < vertex_count) {
+    u32 run_end = run_start + 1;
+    while (run_end < vertex_count &&
+           cells[run_end].key == cells[run_start].key) {
+      run_end++;
+    }
+
+    vec3 average = vec3_zero();
+    for (u32 i = run_start; i < run_end; ++i) {
+      average = vec3_add(average, vertices[cells[i].vertex].position);
+    }
+    average = vec3_mul_scalar(average, 1.0f / (f32)(run_end - run_start));
+
+    u32 representative = cells[run_start].vertex;
+    f32 closest = vec3_distance(vertices[representative].position, average);
+    for (u32 i = run_start + 1; i < run_end; ++i) {
+      f32 distance = vec3_distance(vertices[cells[i].vertex].position, average);
+      if (distance < closest) {
+        closest = distance;
+        representative = cells[i].vertex;
+      }
+    }
+
+    for (u32 i = run_start; i < run_end; ++i) {
+      vertex_clusters[cells[i].vertex] = cluster_count;
+      f32 moved = vec3_distance(vertices[cells[i].vertex].position,
+                                vertices[representative].position);
+      if (moved > *out_error) {
+        *out_error = moved;
+      }
+    }
+    cluster_vertices[cluster_count++] = representative;
+    run_start = run_end;
+  }
+
+  // Clusters are numbered again in the order the kept triangles use them.
+  u32 *cluster_outputs =
+      (u32 *)lai_allocate(sizeof(u32) * cluster_count, MEMORY_TAG_ARRAY);
+  for (u32 i = 0; i < cluster_count; ++i) {
+    cluster_outputs[i] = INVALID_ID;
+  }
+  for (u32 i = 0; i + 2 < index_count; i += 3) {
+    u32 a = vertex_clusters[indices[i]];
+    u32 b = vertex_clusters[indices[i + 1]];
+    u32 c = vertex_clusters[indices[i + 2]];
+    if (a == b || b == c || a == c) {
+      continue;
+    }
+    u32 corners[3] = {a, b, c};
+    for (u32 k = 0; k < 3; ++k) {
+      u32 cluster = corners[k];
+      if (cluster_outputs[cluster] == INVALID_ID) {
+        cluster_outputs[cluster] = (u32)darray_length(*out_vertices);
+        darray_push(*out_vertices, vertices[cluster_vertices[cluster]]);
+      }
+      darray_push(*out_indices, cluster_outputs[cluster]);
+    }
+  }
+
+  lai_free(cluster_outputs, sizeof(u32) * cluster_count, MEMORY_TAG_ARRAY);
+  lai_free(cluster_vertices, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+  lai_free(vertex_clusters, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+  lai_free(cells, sizeof(cell_vertex) * vertex_count, MEMORY_TAG_ARRAY);
+}
+
+// Marks a vertex as not part of the meshlet being built
+#define MESHLET_NO_VERTEX 0xFF
+
+static void finish_meshlet(const vertex_3d *vertices, u8 *local_vertices,
+                           const u32 *meshlet_vertices,
+                           mesh_file_meshlet *meshlet) {
+  const u32 *own_vertices = meshlet_vertices + meshlet->vertex_offset;
+  vec4 bounds =
+      vertices_bounding_sphere(vertices, own_vertices, meshlet->vertex_count);
+  meshlet->bounds[0] = bounds.x;
+  meshlet->bounds[1] = bounds.y;
+  meshlet->bounds[2] = bounds.z;
+  meshlet->bounds[3] = bounds.w;
+  for (u32 i = 0; i < meshlet->vertex_count; ++i) {
+    local_vertices[own_vertices[i]] = MESHLET_NO_VERTEX;
+  }
+}
+
+void mesh_cook_build_meshlets(const vertex_3d *vertices, u32 vertex_count,
+                              const u32 *indices, u32 index_count,
+                              mesh_file_meshlet **out_meshlets,
+                              u32 **out_meshlet_vertices,
+                              u8 **out_meshlet_triangles) {
+  *out_meshlets = darray_create(mesh_file_meshlet);
+  *out_meshlet_vertices = darray_create(u32);
+  *out_meshlet_triangles = darray_create(u8);
+
+  // Per vertex, its index in the meshlet being built
+  u8 *local_vertices = (u8 *)lai_allocate(vertex_count, MEMORY_TAG_ARRAY);
+  lai_set_memory(local_vertices, MESHLET_NO_VERTEX, vertex_count);
+
+  mesh_file_meshlet meshlet;
+  lai_zero_memory(&meshlet, sizeof(mesh_file_meshlet));
+  for (u32 i = 0; i + 2 < index_count; i += 3) {
+    u32 new_vertex_count = 0;
+    for (u32 k = 0; k < 3; ++k) {
+      u32 vertex = indices[i + k];
+      bool repeated = (k > 0 && indices[i] == vertex) ||
+                      (k > 1 && indices[i + 1] == vertex);
+      if (local_vertices[vertex] == MESHLET_NO_VERTEX && !repeated) {
+        new_vertex_count++;
+      }
+    }
+
+    if (meshlet.vertex_count + new_vertex_count >
+            MESH_FILE_MAX_MESHLET_VERTICES ||
+        meshlet.triangle_count == MESH_FILE_MAX_MESHLET_TRIANGLES) {
+      finish_meshlet(vertices, local_vertices, *out_meshlet_vertices,
+                     &meshlet);
+      darray_push(*out_meshlets, meshlet);
+      lai_zero_memory(&meshlet, sizeof(mesh_file_meshlet));
+      meshlet.vertex_offset = (u32)darray_length(*out_meshlet_vertices);
+      meshlet.triangle_offset =
+          (u32)(darray_length(*out_meshlet_triangles) / 3);
+    }
+
+    for (u32 k = 0; k < 3; ++k) {
+      u32 vertex = indices[i + k];
+      if (local_vertices[vertex] == MESHLET_NO_VERTEX) {
+        local_vertices[vertex] = (u8)meshlet.vertex_count++;
+        darray_push(*out_meshlet_vertices, vertex);
+      }
+      darray_push(*out_meshlet_triangles, local_vertices[vertex]);
+    }
+    meshlet.triangle_count++;
+  }
+
+  if (meshlet.triangle_count > 0) {
+    finish_meshlet(vertices, local_vertices, *out_meshlet_vertices, &meshlet);
+    darray_push(*out_meshlets, meshlet);
+  }
+
+  lai_free(local_vertices, vertex_count, MEMORY_TAG_ARRAY);
+}
+
+struct cooked_lod {
+  f32 error;
+  // darrays
+  vertex_3d *vertices;
+  u32 *indices;
+  mesh_file_meshlet *meshlets;
+  u32 *meshlet_vertices;
+  u8 *meshlet_triangles;
+};
+
+// Places count elements of element_size bytes at offset, returning the
+// offset of what follows
+static u64 place_array(u64 offset, u64 count, u64 element_size,
+                       u64 *out_offset) {
+  *out_offset = offset;
+  return mesh_file_align(offset + count * element_size);
+}
+
+static void copy_array(u8 *data, u64 offset, const void *array, u64 size) {
+  if (size > 0) {
+    lai_copy_memory(data + offset, array, size);
+  }
+}
+
+bool mesh_cook(const vertex_3d *vertices, u32 vertex_count,
+               const u32 *indices, u32 index_count, u32 max_lod_count,
+               u8 **out_data, u64 *out_size) {
+  if (vertex_count == 0 || index_count == 0 || index_count % 3 != 0) {
+    LAI_LOG_ERROR("mesh_cook requires vertices and whole triangles");
+    return false;
+  }
+  for (u32 i = 0; i < index_count; ++i) {
+    if (indices[i] >= vertex_count) {
+      LAI_LOG_ERROR("Index %u refers to vertex %u of %u", i, indices[i],
+                    vertex_count);
+      return false;
+    }
+  }
+  if (max_lod_count == 0) {
+    max_lod_count = 1;
+  }
+  if (max_lod_count > MESH_FILE_MAX_LODS) {
+    max_lod_count = MESH_FILE_MAX_LODS;
+  }
+
+  cooked_lod lods[MESH_FILE_MAX_LODS];
+  u32 lod_count = 1;
+  lods[0].error = 0.0f;
+  lods[0].vertices = darray_reserve(vertex_3d, vertex_count);
+  lai_copy_memory(lods[0].vertices, vertices, sizeof(vertex_3d) * vertex_count);
+  darray_length_set(lods[0].vertices, vertex_count);
+  lods[0].indices = darray_reserve(u32, index_count);
+  lai_copy_memory(lods[0].indices, indices, sizeof(u32) * index_count);
+  darray_length_set(lods[0].indices, index_count);
+
+  // Every lod is simplified from the source mesh, on ever coarser grids
+  // until it has at most half the triangles of the one before.
+  vec4 bounds = vertices_bounding_sphere(vertices, nullptr, vertex_count);
+  f32 extent = bounds.w * 2.0f;
+  u32 resolution = MESH_COOK_INITIAL_RESOLUTION;
+  while (lod_count < max_lod_count && extent > 0.0f && resolution > 0) {
+    u64 target_triangles = darray_length(lods[lod_count - 1].indices) / 6;
+    if (target_triangles == 0) {
+      break;
+    }
+
+    bool found = false;
+    for (; resolution > 0 && !found; resolution = resolution * 3 / 4) {
+      cooked_lod *lod = &lods[lod_count];
+      mesh_cook_simplify(vertices, vertex_count, indices, index_count,
+                         extent / (f32)resolution, &lod->vertices,
+                         &lod->indices, &lod->error);
+      u64 triangle_count = darray_length(lod->indices) / 3;
+      if (triangle_count > 0 && triangle_count <= target_triangles) {
+        found = true;
+        continue;
+      }
+      darray_destroy(lod->vertices);
+      darray_destroy(lod->indices);
+      if (triangle_count == 0) {
+        // Coarser grids collapse everything as well.
+        resolution = 0;
+        break;
+      }
+    }
+    if (!found) {
+      break;
+    }
+    lod_count++;
+  }
+
+  for (u32 i = 0; i < lod_count; ++i) {
+    cooked_lod *lod = &lods[i];
+    mesh_cook_build_meshlets(
+        lod->vertices, (u32)darray_length(lod->vertices), lod->indices,
+        (u32)darray_length(lod->indices), &lod->meshlets,
+        &lod->meshlet_vertices, &lod->meshlet_triangles);
+  }
+
+  mesh_file_header header;
+  lai_zero_memory(&header, sizeof(mesh_file_header));
+  header.magic = MESH_FILE_MAGIC;
+  header.version = MESH_FILE_VERSION;
+  header.vertex_stride = sizeof(vertex_3d);
+  header.lod_count = lod_count;
+  header.bounds[0] = bounds.x;
+  header.bounds[1] = bounds.y;
+  header.bounds[2] = bounds.z;
+  header.bounds[3] = bounds.w;
+
+  u64 offset = mesh_file_data_offset();
+  for (u32 i = 0; i < lod_count; ++i) {
+    const cooked_lod *lod = &lods[i];
+    mesh_file_lod *file_lod = &header.lods[i];
+    file_lod->error = lod->error;
+    file_lod->vertex_count = (u32)darray_length(lod->vertices);
+    file_lod->index_count = (u32)darray_length(lod->indices);
+    file_lod->meshlet_count = (u32)darray_length(lod->meshlets);
+    file_lod->meshlet_vertex_count = (u32)darray_length(lod->meshlet_vertices);
+    file_lod->meshlet_triangle_count =
+        (u32)(darray_length(lod->meshlet_triangles) / 3);
+    offset = place_array(offset, file_lod->vertex_count, sizeof(vertex_3d),
+                         &file_lod->vertices_offset);
+    offset = place_array(offset, file_lod->index_count, sizeof(u32),
+                         &file_lod->indices_offset);
+    offset = place_array(offset, file_lod->meshlet_count,
+                         sizeof(mesh_file_meshlet), &file_lod->meshlets_offset);
+    offset = place_array(offset, file_lod->meshlet_vertex_count, sizeof(u32),
+                         &file_lod->meshlet_vertices_offset);
+    offset = place_array(offset, file_lod->meshlet_triangle_count, 3,
+                         &file_lod->meshlet_triangles_offset);
+  }
+  header.file_size = offset;
+
+  u8 *data = (u8 *)lai_allocate(offset, MEMORY_TAG_ARRAY);
+  lai_zero_memory(data, offset);
+  lai_copy_memory(data, &header, sizeof(mesh_file_header));
+  for (u32 i = 0; i < lod_count; ++i) {
+    cooked_lod *lod = &lods[i];
+    const mesh_file_lod *file_lod = &header.lods[i];
+    copy_array(data, file_lod->vertices_offset, lod->vertices,
+               sizeof(vertex_3d) * file_lod->vertex_count);
+    copy_array(data, file_lod->indices_offset, lod->indices,
+               sizeof(u32) * file_lod->index_count);
+    copy_array(data, file_lod->meshlets_offset, lod->meshlets,
+               sizeof(mesh_file_meshlet) * file_lod->meshlet_count);
+    copy_array(data, file_lod->meshlet_vertices_offset,
+               lod->meshlet_vertices,
+               sizeof(u32) * file_lod->meshlet_vertex_count);
+    copy_array(data, file_lod->meshlet_triangles_offset,
+               lod->meshlet_triangles, 3 * file_lod->meshlet_triangle_count);
+
+    darray_destroy(lod->vertices);
+    darray_destroy(lod->indices);
+    darray_destroy(lod->meshlets);
+    darray_destroy(lod->meshlet_vertices);
+    darray_destroy(lod->meshlet_triangles);
+  }
+
+  *out_data = data;
+  *out_size = offset;
+  return true;
+}
+
+void mesh_cook_free(u8 *data, u64 size) {
+  lai_free(data, size, MEMORY_TAG_ARRAY);
+}
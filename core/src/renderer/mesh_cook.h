@@ -0,0 +1,42 @@
+#pragma once
+
+#include "renderer/mesh_format.h"
+
+/*
+ * Offline half of the mesh file format, used by the mesh_cooker tool. Turns
+ * source meshes into the layout of mesh_format.h so loading them is a matter
+ * of mapping the file and copying its arrays to the gpu.
+ * */
+
+// Triangulates the faces of length bytes of OBJ text into vertices with a
+// position and texcoord, corners with the same ones sharing a vertex.
+// Normals, groups and materials are skipped. out_vertices and out_indices
+// are new darrays.
+bool mesh_cook_parse_obj(const char *text, u64 length, vertex_3d **out_vertices,
+                         u32 **out_indices);
+
+// Merges the vertices within each cell of a grid cell_size wide into one,
+// dropping the triangles that collapse. out_vertices and out_indices are new
+// darrays, out_error is the farthest a vertex moved.
+void mesh_cook_simplify(const vertex_3d *vertices, u32 vertex_count,
+                        const u32 *indices, u32 index_count, f32 cell_size,
+                        vertex_3d **out_vertices, u32 **out_indices,
+                        f32 *out_error);
+
+// Splits the triangles in order into meshlets of at most
+// MESH_FILE_MAX_MESHLET_VERTICES vertices and MESH_FILE_MAX_MESHLET_TRIANGLES
+// triangles. The outputs are new darrays.
+void mesh_cook_build_meshlets(const vertex_3d *vertices, u32 vertex_count,
+                              const u32 *indices, u32 index_count,
+                              mesh_file_meshlet **out_meshlets,
+                              u32 **out_meshlet_vertices,
+                              u8 **out_meshlet_triangles);
+
+// Cooks the mesh and up to max_lod_count - 1 coarser lods, each with at most
+// half the triangles of the one before, into a file image of out_size bytes.
+// Free it with mesh_cook_free.
+bool mesh_cook(const vertex_3d *vertices, u32 vertex_count,
+               const u32 *indices, u32 index_count, u32 max_lod_count,
+               u8 **out_data, u64 *out_size);
+
+void mesh_cook_free(u8 *data, u64 size);
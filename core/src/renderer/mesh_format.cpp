@@ -0,0 +1,91 @@
+#include "renderer/mesh_format.h"
+
+#include "base/log.h"
+
+u64 mesh_file_align(u64 offset) {
+  return (offset + MESH_FILE_ALIGNMENT - 1) & ~(u64)(MESH_FILE_ALIGNMENT - 1);
+}
+
+u64 mesh_file_data_offset() {
+  return mesh_file_align(sizeof(mesh_file_header));
+}
+
+// Whether count elements of element_size bytes at offset lie in the data
+// part of a file of file_size bytes
+static bool array_fits(u64 offset, u64 count, u64 element_size,
+                       u64 file_size) {
+  if (offset % MESH_FILE_ALIGNMENT != 0 || offset < mesh_file_data_offset() ||
+      offset > file_size) {
+    return false;
+  }
+  // Counts are u32, so the product cannot overflow.
+  return count * element_size <= file_size - offset;
+}
+
+bool mesh_file_validate(const void *data, u64 size) {
+  if (size < sizeof(mesh_file_header)) {
+    LAI_LOG_ERROR("Mesh file of %llu bytes is too small for its header",
+                  size);
+    return false;
+  }
+
+  const mesh_file_header *header = (const mesh_file_header *)data;
+  if (header->magic != MESH_FILE_MAGIC) {
+    LAI_LOG_ERROR("Not a mesh file");
+    return false;
+  }
+  if (header->version != MESH_FILE_VERSION) {
+    LAI_LOG_ERROR("Mesh file version %u is not %u, cook it again",
+                  header->version, MESH_FILE_VERSION);
+    return false;
+  }
+  if (header->vertex_stride != sizeof(vertex_3d)) {
+    LAI_LOG_ERROR("Mesh file vertices are %u bytes instead of %u, cook it "
+                  "again",
+                  header->vertex_stride, (u32)sizeof(vertex_3d));
+    return false;
+  }
+  if (header->file_size != size) {
+    LAI_LOG_ERROR("Mesh file is %llu bytes instead of %llu", size,
+                  header->file_size);
+    return false;
+  }
+  if (header->lod_count == 0 || header->lod_count > MESH_FILE_MAX_LODS) {
+    LAI_LOG_ERROR("Mesh file has %u lods", header->lod_count);
+    return false;
+  }
+
+  for (u32 i = 0; i < header->lod_count; ++i) {
+    const mesh_file_lod *lod = &header->lods[i];
+    if (lod->index_count % 3 != 0 ||
+        !array_fits(lod->vertices_offset, lod->vertex_count,
+                    sizeof(vertex_3d), size) ||
+        !array_fits(lod->indices_offset, lod->index_count, sizeof(u32),
+                    size) ||
+        !array_fits(lod->meshlets_offset, lod->meshlet_count,
+                    sizeof(mesh_file_meshlet), size) ||
+        !array_fits(lod->meshlet_vertices_offset, lod->meshlet_vertex_count,
+                    sizeof(u32), size) ||
+        !array_fits(lod->meshlet_triangles_offset,
+                    lod->meshlet_triangle_count, 3, size)) {
+      LAI_LOG_ERROR("Mesh file lod %u does not fit in the file", i);
+      return false;
+    }
+  }
+  return true;
+}
+
+void mesh_file_get_lod(const void *data, u32 lod,
+                       mesh_file_lod_view *out_view) {
+  const mesh_file_header *header = (const mesh_file_header *)data;
+  const u8 *bytes = (const u8 *)data;
+  const mesh_file_lod *l = &header->lods[lod];
+  out_view->lod = l;
+  out_view->vertices = (const vertex_3d *)(bytes + l->vertices_offset);
+  out_view->indices = (const u32 *)(bytes + l->indices_offset);
+  out_view->meshlets =
+      (const mesh_file_meshlet *)(bytes + l->meshlets_offset);
+  out_view->meshlet_vertices =
+      (const u32 *)(bytes + l->meshlet_vertices_offset);
+  out_view->meshlet_triangles = bytes + l->meshlet_triangles_offset;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "renderer/renderer_types.inl"
+
+/*
+ * Layout of cooked mesh files, written by the mesh_cooker tool and loaded by
+ * mapping them into memory. Everything is little endian. The arrays are used
+ * in place, each starts at an offset from the start of the file aligned to
+ * MESH_FILE_ALIGNMENT, so loading only checks that they fit in the file.
+ * */
+
+// "MESH" read as a little endian u32
+#define MESH_FILE_MAGIC 0x4853454DU
+#define MESH_FILE_VERSION 1
+#define MESH_FILE_ALIGNMENT 16
+#define MESH_FILE_MAX_LODS 8
+#define MESH_FILE_MAX_MESHLET_VERTICES 64
+#define MESH_FILE_MAX_MESHLET_TRIANGLES 124
+
+struct mesh_file_meshlet {
+  // Bounding sphere, center in xyz and radius in w
+  f32 bounds[4];
+  // Into the lod's meshlet vertices, which index the lod's vertices
+  u32 vertex_offset;
+  u32 vertex_count;
+  // Into the lod's meshlet triangles, each 3 bytes indexing the meshlet's
+  // vertices
+  u32 triangle_offset;
+  u32 triangle_count;
+};
+
+struct mesh_file_lod {
+  // Farthest a vertex moved from the source mesh, 0 for lod 0
+  f32 error;
+  u32 vertex_count;
+  u32 index_count;
+  u32 meshlet_count;
+  u32 meshlet_vertex_count;
+  u32 meshlet_triangle_count;
+  // vertex_3d array
+  u64 vertices_offset;
+  // u32 array, 3 per triangle
+  u64 indices_offset;
+  // mesh_file_meshlet array
+  u64 meshlets_offset;
+  // u32 array
+  u64 meshlet_vertices_offset;
+  // u8 array, 3 per triangle
+  u64 meshlet_triangles_offset;
+};
+
+struct mesh_file_header {
+  u32 magic;
+  u32 version;
+  // sizeof(vertex_3d) of the build that cooked the file, files of another
+  // vertex layout are refused
+  u32 vertex_stride;
+  u32 lod_count;
+  // Bounding sphere of lod 0, center in xyz and radius in w
+  f32 bounds[4];
+  u64 file_size;
+  // The finest first
+  mesh_file_lod lods[MESH_FILE_MAX_LODS];
+};
+
+STATIC_ASSERT(sizeof(mesh_file_meshlet) == 32,
+              "mesh_file_meshlet is part of the file format");
+STATIC_ASSERT(sizeof(mesh_file_lod) == 64,
+              "mesh_file_lod is part of the file format");
+STATIC_ASSERT(sizeof(mesh_file_header) == 40 + 64 * MESH_FILE_MAX_LODS,
+              "mesh_file_header is part of the file format");
+
+// Arrays of one lod of a mapped file
+struct mesh_file_lod_view {
+  const mesh_file_lod *lod;
+  const vertex_3d *vertices;
+  const u32 *indices;
+  const mesh_file_meshlet *meshlets;
+  const u32 *meshlet_vertices;
+  const u8 *meshlet_triangles;
+};
+
+// Offset of the first array, right after the header
+u64 mesh_file_data_offset();
+
+// Rounds offset up to MESH_FILE_ALIGNMENT
+u64 mesh_file_align(u64 offset);
+
+// Checks that size bytes of data hold a mesh file of this build's vertex
+// layout whose arrays all fit. Index values are not checked, cooked files
+// are trusted past their layout.
+bool mesh_file_validate(const void *data, u64 size);
+
+// data must have been validated
+void mesh_file_get_lod(const void *data, u32 lod,
+                       mesh_file_lod_view *out_view);
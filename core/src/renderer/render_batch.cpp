@@ -0,0 +1,90 @@
+#include "renderer/render_batch.h"
+
+#include "containers/darray.h"
+
+#include <cstdlib>
+
+static int compare_sort_entries(const void *a, const void *b) {
+  const render_sort_entry *left = (const render_sort_entry *)a;
+  const render_sort_entry *right = (const render_sort_entry *)b;
+  if (left->key != right->key) {
+    return left->key < right->key ? -1 : 1;
+  }
+  // Keeps the submission order within a batch, qsort is not stable.
+  if (left->index != right->index) {
+    return left->index < right->index ? -1 : 1;
+  }
+  return 0;
+}
+
+void render_batch_list_create(render_batch_list *out_list) {
+  out_list->transforms = darray_create(mat4);
+  out_list->batches = darray_create(render_batch);
+  out_list->sort_entries = darray_create(render_sort_entry);
+}
+
+void render_batch_list_destroy(render_batch_list *list) {
+  if (list->transforms) {
+    darray_destroy(list->transforms);
+    list->transforms = nullptr;
+  }
+  if (list->batches) {
+    darray_destroy(list->batches);
+    list->batches = nullptr;
+  }
+  if (list->sort_entries) {
+    darray_destroy(list->sort_entries);
+    list->sort_entries = nullptr;
+  }
+}
+
+u64 render_batch_sort_key(u32 pipeline_id, u32 material_id, u32 geometry_id) {
+  // 8 bits of pipeline, 24 of material and 32 of geometry.
+  return ((u64)(pipeline_id & 0xFF) << 56) |
+         ((u64)(material_id & 0xFFFFFF) << 32) | (u64)geometry_id;
+}
+
+void render_batch_list_build(render_batch_list *list,
+                             const geometry_render_data *draws,
+                             u32 draw_count) {
+  darray_clear(list->transforms);
+  darray_clear(list->batches);
+  darray_clear(list->sort_entries);
+
+  for (u32 i = 0; i < draw_count; ++i) {
+    const geometry *g = draws[i].geometry;
+    if (!g || g->id == INVALID_ID || g->internal_id == INVALID_ID) {
+      continue;
+    }
+    // Only the object pipeline exists for now.
+    render_sort_entry entry;
+    entry.key = render_batch_sort_key(0, draws[i].material_id, g->id);
+    entry.index = i;
+    darray_push(list->sort_entries, entry);
+  }
+
+  u32 entry_count = darray_length(list->sort_entries);
+  qsort(list->sort_entries, entry_count, sizeof(render_sort_entry),
+        compare_sort_entries);
+
+  render_batch *current = nullptr;
+  u64 current_key = 0;
+  for (u32 i = 0; i < entry_count; ++i) {
+    const render_sort_entry *entry = &list->sort_entries[i];
+    const geometry_render_data *draw = &draws[entry->index];
+
+    if (!current || entry->key != current_key) {
+      render_batch batch;
+      batch.geometry = draw->geometry;
+      batch.material_id = draw->material_id;
+      batch.first_instance = i;
+      batch.instance_count = 0;
+      darray_push(list->batches, batch);
+      current = &list->batches[darray_length(list->batches) - 1];
+      current_key = entry->key;
+    }
+
+    darray_push(list->transforms, draw->model);
+    current->instance_count++;
+  }
+}
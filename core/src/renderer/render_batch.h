@@ -0,0 +1,35 @@
+#pragma once
+
+#include "renderer/renderer_types.inl"
+
+struct render_sort_entry {
+  u64 key;
+  // Index into the packet's geometry list
+  u32 index;
+};
+
+/*
+ * Turns the unordered draw list of a frame into instanced batches. Draws are
+ * sorted by pipeline, material and geometry so state changes are minimal, and
+ * every run of the same geometry and material becomes one instanced draw.
+ * The arrays are kept between frames to avoid reallocating them.
+ * */
+struct render_batch_list {
+  // darray, the model matrix of every instance, grouped by batch
+  mat4 *transforms;
+  // darray
+  render_batch *batches;
+  // darray, sort scratch
+  render_sort_entry *sort_entries;
+};
+
+void render_batch_list_create(render_batch_list *out_list);
+void render_batch_list_destroy(render_batch_list *list);
+
+// Draws with a lower key are recorded first
+u64 render_batch_sort_key(u32 pipeline_id, u32 material_id, u32 geometry_id);
+
+// Replaces the contents of list, draws without a loaded geometry are skipped.
+void render_batch_list_build(render_batch_list *list,
+                             const geometry_render_data *draws,
+                             u32 draw_count);
@@ -11,6 +11,24 @@ bool renderer_backend_create(renderer_backend_type type,
     out_renderer_backend->resized = vulkan_renderer_backend_on_resized;
     out_renderer_backend->begin_frame = vulkan_renderer_backend_begin_frame;
     out_renderer_backend->end_frame = vulkan_renderer_backend_end_frame;
+    out_renderer_backend->update_global_state =
+        vulkan_renderer_backend_update_global_state;
+    out_renderer_backend->create_geometry =
+        vulkan_renderer_backend_create_geometry;
+    out_renderer_backend->destroy_geometry =
+        vulkan_renderer_backend_destroy_geometry;
+    out_renderer_backend->create_texture =
+        vulkan_renderer_backend_create_texture;
+    out_renderer_backend->upload_texture_levels =
+        vulkan_renderer_backend_upload_texture_levels;
+    out_renderer_backend->destroy_texture =
+        vulkan_renderer_backend_destroy_texture;
+    out_renderer_backend->update_material =
+        vulkan_renderer_backend_update_material;
+    out_renderer_backend->draw_batches = vulkan_renderer_backend_draw_batches;
+    out_renderer_backend->read_frame = vulkan_renderer_backend_read_frame;
+    out_renderer_backend->get_gpu_timings =
+        vulkan_renderer_backend_get_gpu_timings;
     return true;
   }
 
@@ -23,4 +41,14 @@ void renderer_backend_destroy(renderer_backend *renderer_backend) {
   renderer_backend->resized = nullptr;
   renderer_backend->begin_frame = nullptr;
   renderer_backend->end_frame = nullptr;
+  renderer_backend->update_global_state = nullptr;
+  renderer_backend->create_geometry = nullptr;
+  renderer_backend->destroy_geometry = nullptr;
+  renderer_backend->create_texture = nullptr;
+  renderer_backend->upload_texture_levels = nullptr;
+  renderer_backend->destroy_texture = nullptr;
+  renderer_backend->update_material = nullptr;
+  renderer_backend->draw_batches = nullptr;
+  renderer_backend->read_frame = nullptr;
+  renderer_backend->get_gpu_timings = nullptr;
 }
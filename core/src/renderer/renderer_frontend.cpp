@@ -1,15 +1,33 @@
 #include "renderer/renderer_frontend.h"
 #include "base/lai_memory.h"
 #include "base/log.h"
+#include "containers/darray.h"
+#include "platform/platform.h"
+#include "renderer/render_batch.h"
 #include "renderer/renderer_backend.h"
 
+struct texture_upload {
+  struct texture *texture;
+  u32 first_mip;
+  const u8 *const *mip_pixels;
+};
+
 struct renderer_system_state {
   renderer_backend *backend;
+  // Frames may be drawn on the render thread while the game creates
+  // geometry, the backend is only entered by one of them at a time.
+  platform_mutex backend_mutex;
+  render_batch_list batches;
+  // darrays of the uploads for the next frame and of the failed ones not
+  // taken yet. Their mutex is taken after the backend's when both are held.
+  platform_mutex upload_mutex;
+  texture_upload *pending_uploads;
+  texture_upload_failure *upload_failures;
 };
 static renderer_system_state *state_ptr;
 
 bool renderer_initialize(u64 *memory_requirement, void *state,
-                         const char *application_name) {
+                         const renderer_config *config) {
 
   *memory_requirement = sizeof(renderer_system_state);
   if (state == nullptr) {
@@ -22,7 +40,16 @@ bool renderer_initialize(u64 *memory_requirement, void *state,
   renderer_backend_create(RENDERER_BACKEND_TYPE_VULKAN, state_ptr->backend);
   state_ptr->backend->frame_number = 0;
 
-  if (!state_ptr->backend->initialize(state_ptr->backend, application_name)) {
+  if (!platform_mutex_create(&state_ptr->backend_mutex) ||
+      !platform_mutex_create(&state_ptr->upload_mutex)) {
+    LAI_LOG_FATAL("Failed to create the renderer mutex!");
+    return false;
+  }
+  state_ptr->pending_uploads = darray_create(texture_upload);
+  state_ptr->upload_failures = darray_create(texture_upload_failure);
+  render_batch_list_create(&state_ptr->batches);
+
+  if (!state_ptr->backend->initialize(state_ptr->backend, config)) {
     LAI_LOG_FATAL("Renderer backend failed, shutting down!");
     return false;
   }
@@ -34,6 +61,11 @@ void renderer_shutdown(void *state) {
   if (state_ptr) {
     state_ptr->backend->shutdown(state_ptr->backend);
     lai_free(state_ptr->backend, sizeof(renderer_backend), MEMORY_TAG_RENDERER);
+    platform_mutex_destroy(&state_ptr->backend_mutex);
+    platform_mutex_destroy(&state_ptr->upload_mutex);
+    darray_destroy(state_ptr->pending_uploads);
+    darray_destroy(state_ptr->upload_failures);
+    render_batch_list_destroy(&state_ptr->batches);
 
     state_ptr = nullptr;
   }
@@ -57,14 +89,177 @@ bool renderer_end_frame(f32 delta_time) {
   return result;
 }
 
+// Drops the failure of texture not taken yet, if any. Called with the
+// upload mutex held.
+static void remove_upload_failure(texture *texture) {
+  u32 failure_count = darray_length(state_ptr->upload_failures);
+  for (u32 i = 0; i < failure_count; ++i) {
+    if (state_ptr->upload_failures[i].texture == texture) {
+      texture_upload_failure removed;
+      darray_pop_at(state_ptr->upload_failures, i, &removed);
+      return;
+    }
+  }
+}
+
+// Hands the queued uploads to the backend, which submits them with the
+// frame. Called with the backend mutex held.
+static void apply_texture_uploads() {
+  platform_mutex_lock(&state_ptr->upload_mutex);
+  u32 upload_count = darray_length(state_ptr->pending_uploads);
+  for (u32 i = 0; i < upload_count; ++i) {
+    texture_upload *upload = &state_ptr->pending_uploads[i];
+    // Only the latest upload of a texture tells what the gpu holds.
+    remove_upload_failure(upload->texture);
+    if (state_ptr->backend->upload_texture_levels(
+            state_ptr->backend, upload->texture, upload->first_mip,
+            upload->mip_pixels)) {
+      upload->texture->uploaded_mip = upload->first_mip;
+    } else {
+      LAI_LOG_ERROR("Failed to upload the levels of texture '%s'",
+                    upload->texture->name);
+      texture_upload_failure failure = {upload->texture,
+                                        upload->texture->uploaded_mip};
+      darray_push(state_ptr->upload_failures, failure);
+    }
+  }
+  darray_clear(state_ptr->pending_uploads);
+  platform_mutex_unlock(&state_ptr->upload_mutex);
+}
+
 bool renderer_draw_frame(render_packet *packet) {
+  bool result = true;
+  platform_mutex_lock(&state_ptr->backend_mutex);
+  apply_texture_uploads();
+
+  // Sorted before waiting on the gpu in begin_frame.
+  u32 draw_count = packet->geometries ? darray_length(packet->geometries) : 0;
+  render_batch_list *batches = &state_ptr->batches;
+  render_batch_list_build(batches, packet->geometries, draw_count);
+
   if (renderer_begin_frame(packet->delta_time)) {
-    bool result = renderer_end_frame(packet->delta_time);
+    state_ptr->backend->update_global_state(
+        state_ptr->backend, packet->projection, packet->view);
+
+    u32 batch_count = darray_length(batches->batches);
+    if (batch_count > 0) {
+      state_ptr->backend->draw_batches(
+          state_ptr->backend, batch_count, batches->batches,
+          darray_length(batches->transforms), batches->transforms);
+    }
+
+    result = renderer_end_frame(packet->delta_time);
     if (!result) {
       LAI_LOG_FATAL("Renderer end frame failed, shutting down!");
-      return false;
     }
   }
 
-  return true;
+  platform_mutex_unlock(&state_ptr->backend_mutex);
+  return result;
+}
+
+bool renderer_create_geometry(geometry *geometry, u32 vertex_count,
+                              const vertex_3d *vertices, u32 index_count,
+                              const u32 *indices) {
+  platform_mutex_lock(&state_ptr->backend_mutex);
+  bool result = state_ptr->backend->create_geometry(
+      state_ptr->backend, geometry, vertex_count, vertices, index_count,
+      indices);
+  platform_mutex_unlock(&state_ptr->backend_mutex);
+  return result;
+}
+
+bool renderer_read_frame(u32 *out_width, u32 *out_height,
+                         const void **out_pixels) {
+  platform_mutex_lock(&state_ptr->backend_mutex);
+  bool result = state_ptr->backend->read_frame(state_ptr->backend, out_width,
+                                               out_height, out_pixels);
+  platform_mutex_unlock(&state_ptr->backend_mutex);
+  return result;
+}
+
+bool renderer_get_gpu_timings(gpu_timings *out_timings) {
+  platform_mutex_lock(&state_ptr->backend_mutex);
+  bool result =
+      state_ptr->backend->get_gpu_timings(state_ptr->backend, out_timings);
+  platform_mutex_unlock(&state_ptr->backend_mutex);
+  return result;
+}
+
+void renderer_destroy_geometry(geometry *geometry) {
+  platform_mutex_lock(&state_ptr->backend_mutex);
+  state_ptr->backend->destroy_geometry(state_ptr->backend, geometry);
+  platform_mutex_unlock(&state_ptr->backend_mutex);
+}
+
+bool renderer_create_texture(texture *texture) {
+  platform_mutex_lock(&state_ptr->backend_mutex);
+  texture->uploaded_mip = texture->mip_count;
+  bool result = state_ptr->backend->create_texture(state_ptr->backend, texture);
+  platform_mutex_unlock(&state_ptr->backend_mutex);
+  return result;
+}
+
+void renderer_upload_texture_levels(texture *texture, u32 first_mip,
+                                    const u8 *const *mip_pixels) {
+  platform_mutex_lock(&state_ptr->upload_mutex);
+  // A later upload of the same texture replaces the one still queued.
+  u32 upload_count = darray_length(state_ptr->pending_uploads);
+  u32 index = 0;
+  while (index < upload_count &&
+         state_ptr->pending_uploads[index].texture != texture) {
+    index++;
+  }
+  if (index < upload_count) {
+    state_ptr->pending_uploads[index].first_mip = first_mip;
+    state_ptr->pending_uploads[index].mip_pixels = mip_pixels;
+  } else {
+    texture_upload upload = {texture, first_mip, mip_pixels};
+    darray_push(state_ptr->pending_uploads, upload);
+  }
+  platform_mutex_unlock(&state_ptr->upload_mutex);
+}
+
+u32 renderer_take_texture_upload_failures(
+    u32 max_count, texture_upload_failure *out_failures) {
+  platform_mutex_lock(&state_ptr->upload_mutex);
+  u32 failure_count = darray_length(state_ptr->upload_failures);
+  u32 count = failure_count < max_count ? failure_count : max_count;
+  for (u32 i = 0; i < count; ++i) {
+    out_failures[i] = state_ptr->upload_failures[i];
+  }
+  // Keeps the order of what is left.
+  for (u32 i = count; i < failure_count; ++i) {
+    state_ptr->upload_failures[i - count] = state_ptr->upload_failures[i];
+  }
+  darray_length_set(state_ptr->upload_failures, failure_count - count);
+  platform_mutex_unlock(&state_ptr->upload_mutex);
+  return count;
+}
+
+void renderer_destroy_texture(texture *texture) {
+  platform_mutex_lock(&state_ptr->backend_mutex);
+  // Its pixels may be freed as soon as this returns.
+  platform_mutex_lock(&state_ptr->upload_mutex);
+  u32 upload_count = darray_length(state_ptr->pending_uploads);
+  for (u32 i = 0; i < upload_count; ++i) {
+    if (state_ptr->pending_uploads[i].texture == texture) {
+      texture_upload removed;
+      darray_pop_at(state_ptr->pending_uploads, i, &removed);
+      break;
+    }
+  }
+  remove_upload_failure(texture);
+  platform_mutex_unlock(&state_ptr->upload_mutex);
+
+  state_ptr->backend->destroy_texture(state_ptr->backend, texture);
+  platform_mutex_unlock(&state_ptr->backend_mutex);
+}
+
+bool renderer_update_material(const material *material) {
+  platform_mutex_lock(&state_ptr->backend_mutex);
+  bool result =
+      state_ptr->backend->update_material(state_ptr->backend, material);
+  platform_mutex_unlock(&state_ptr->backend_mutex);
+  return result;
 }
@@ -4,8 +4,45 @@
 
 struct static_mesh_data;
 
+struct texture_upload_failure {
+  struct texture *texture;
+  // First level the gpu still holds, the failed upload changed nothing
+  u32 uploaded_mip;
+};
+
 bool renderer_initialize(u64 *memory_requirement, void *state,
-                         const char *application_name);
+                         const renderer_config *config);
 void renderer_shutdown(void *state);
 void renderer_on_resized(u16 width, u16 height);
 bool renderer_draw_frame(render_packet *packet);
+
+// May be called from any thread, the data is uploaded before the next frame.
+bool renderer_create_geometry(geometry *geometry, u32 vertex_count,
+                              const vertex_3d *vertices, u32 index_count,
+                              const u32 *indices);
+void renderer_destroy_geometry(geometry *geometry);
+
+// May be called from any thread like the geometry functions. mip_pixels
+// holds the texture's mip_count levels, see renderer_backend.
+bool renderer_create_texture(texture *texture);
+// Queued and handed to the backend by the next renderer_draw_frame, on the
+// thread drawing frames. mip_pixels must stay valid until then or until the
+// texture is destroyed.
+void renderer_upload_texture_levels(texture *texture, u32 first_mip,
+                                    const u8 *const *mip_pixels);
+// Moves up to max_count textures whose latest upload failed into
+// out_failures, each reported once. Returns how many were moved.
+u32 renderer_take_texture_upload_failures(u32 max_count,
+                                          texture_upload_failure *out_failures);
+void renderer_destroy_texture(texture *texture);
+bool renderer_update_material(const material *material);
+
+// Headless renderers created with readback only. Waits for the last drawn
+// frame and returns its pixels, 4 bytes each in the BGRA order of the
+// offscreen format and tightly packed rows. Valid until the next frame.
+bool renderer_read_frame(u32 *out_width, u32 *out_height,
+                         const void **out_pixels);
+
+// Gpu timings of the latest frame the gpu has completed, which trails the
+// frame being drawn by the frames in flight. False until one is available.
+bool renderer_get_gpu_timings(gpu_timings *out_timings);
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "defines.h"
+#include "math/math_types.h"
+
+#define GEOMETRY_NAME_MAX_LENGTH 256
+#define TEXTURE_NAME_MAX_LENGTH 256
+#define MATERIAL_NAME_MAX_LENGTH 256
 
 enum renderer_backend_type {
   RENDERER_BACKEND_TYPE_VULKAN,
@@ -8,17 +13,146 @@ enum renderer_backend_type {
   RENDERER_BACKEND_TYPE_DIRECTX
 };
 
+struct renderer_config {
+  const char *application_name;
+  // Cull objects and build the draw commands in a compute pass, when the
+  // device supports it
+  bool gpu_culling;
+  // Render into offscreen images without a surface or presenting
+  bool headless;
+  // Copy every headless frame to host memory for renderer_read_frame
+  bool readback;
+  // Frames the cpu may record ahead of the gpu, 0 for the backend's default
+  u32 frames_in_flight;
+};
+
+// Upper bound of the gpu scopes timed in a frame
+#define GPU_TIMINGS_MAX_SCOPES 32
+
+// All times are in seconds
+struct gpu_scope_timing {
+  // The string literal the scope was named with
+  const char *name;
+  // Number of enclosing scopes
+  u32 depth;
+  f64 time;
+};
+
+// Gpu time of a completed frame, some frames behind the one being drawn
+struct gpu_timings {
+  u64 frame_number;
+  f64 frame_time;
+  u32 scope_count;
+  // In the order the scopes began
+  gpu_scope_timing scopes[GPU_TIMINGS_MAX_SCOPES];
+};
+
+struct geometry {
+  u32 id;
+  // Slot of the backend's data for this geometry
+  u32 internal_id;
+  u32 generation;
+  // Bounding sphere in local space, center in xyz and radius in w. Set by
+  // the backend on creation.
+  vec4 bounds;
+  char name[GEOMETRY_NAME_MAX_LENGTH];
+};
+
+// 4 channels of 8 bits per texel
+struct texture {
+  u32 id;
+  u32 width;
+  u32 height;
+  // Levels of the full mip chain, down to 1 * 1
+  u32 mip_count;
+  bool has_transparency;
+  u32 generation;
+  // Handle of the backend's data
+  u32 internal_id;
+  // First level the gpu holds, mip_count before the first upload. Kept by
+  // the renderer on the thread drawing frames.
+  u32 uploaded_mip;
+  char name[TEXTURE_NAME_MAX_LENGTH];
+};
+
+struct material {
+  u32 id;
+  u32 generation;
+  char name[MATERIAL_NAME_MAX_LENGTH];
+  vec4 diffuse_color;
+  // Null for a plain color
+  struct texture *diffuse_map;
+};
+
+struct geometry_render_data {
+  mat4 model;
+  struct geometry *geometry;
+  // Id of a material of the material system, INVALID_ID when the geometry
+  // has none
+  u32 material_id;
+};
+
+// Instances of one geometry and material drawn with a single command
+struct render_batch {
+  struct geometry *geometry;
+  u32 material_id;
+  // Range of the frame's instance transforms
+  u32 first_instance;
+  u32 instance_count;
+};
+
 struct renderer_backend {
   u64 frame_number;
 
   bool (*initialize)(struct renderer_backend *backend,
-                     const char *application_name);
+                     const renderer_config *config);
   void (*shutdown)(struct renderer_backend *backend);
   void (*resized)(struct renderer_backend *backend, u16 width, u16 height);
   bool (*begin_frame)(struct renderer_backend *backend, f32 delta_time);
   bool (*end_frame)(struct renderer_backend *backend, f32 delta_time);
+  // Camera of the frame, after begin_frame and before any draws
+  void (*update_global_state)(struct renderer_backend *backend,
+                              mat4 projection, mat4 view);
+
+  bool (*create_geometry)(struct renderer_backend *backend, geometry *geometry,
+                          u32 vertex_count, const vertex_3d *vertices,
+                          u32 index_count, const u32 *indices);
+  void (*destroy_geometry)(struct renderer_backend *backend,
+                           geometry *geometry);
+  // Samples as plain white until levels are uploaded
+  bool (*create_texture)(struct renderer_backend *backend, texture *texture);
+  // mip_pixels holds the texture's mip_count levels of 4 byte texels, level
+  // i being (width >> i) * (height >> i) and at least 1 * 1. Levels from
+  // first_mip on become resident, replacing the ones resident before, the
+  // others may be null.
+  bool (*upload_texture_levels)(struct renderer_backend *backend,
+                                texture *texture, u32 first_mip,
+                                const u8 *const *mip_pixels);
+  void (*destroy_texture)(struct renderer_backend *backend, texture *texture);
+  // Writes the material's gpu data under its id, again after every change.
+  // The material's texture has to be created already.
+  bool (*update_material)(struct renderer_backend *backend,
+                          const material *material);
+  // transforms holds instance_count model matrices indexed by the batches'
+  // instance ranges
+  void (*draw_batches)(struct renderer_backend *backend, u32 batch_count,
+                       const render_batch *batches, u32 instance_count,
+                       const mat4 *transforms);
+  // Pixels of the last submitted frame, waits for it to complete
+  bool (*read_frame)(struct renderer_backend *backend, u32 *out_width,
+                     u32 *out_height, const void **out_pixels);
+  // Latest resolved gpu timings, never waits
+  bool (*get_gpu_timings)(struct renderer_backend *backend,
+                          gpu_timings *out_timings);
 };
 
 struct render_packet {
   f32 delta_time;
+
+  // Camera of the frame, identity unless the game sets them
+  mat4 projection;
+  mat4 view;
+
+  // darray of the geometries to draw this frame
+  geometry_render_data *geometries;
 };
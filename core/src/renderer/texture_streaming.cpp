@@ -0,0 +1,290 @@
+#include "renderer/texture_streaming.h"
+
+#include "math/lai_math.h"
+
+u32 texture_mip_count(u32 width, u32 height) {
+  u32 size = width > height ? width : height;
+  u32 count = 1;
+  while (size > 1) {
+    size >>= 1;
+    count++;
+  }
+  return count;
+}
+
+u64 texture_mip_size(u32 width, u32 height, u32 level) {
+  u64 level_width = width >> level;
+  u64 level_height = height >> level;
+  if (level_width == 0) {
+    level_width = 1;
+  }
+  if (level_height == 0) {
+    level_height = 1;
+  }
+  return level_width * level_height * 4;
+}
+
+u64 texture_levels_size(u32 width, u32 height, u32 mip_count, u32 first_mip) {
+  u64 size = 0;
+  for (u32 level = first_mip; level < mip_count; ++level) {
+    size += texture_mip_size(width, height, level);
+  }
+  return size;
+}
+
+u32 texture_tail_mip(u32 width, u32 height, u32 mip_count) {
+  u32 level = 0;
+  while (level + 1 < mip_count &&
+         ((width >> level) > TEXTURE_STREAMING_TAIL_SIZE ||
+          (height >> level) > TEXTURE_STREAMING_TAIL_SIZE)) {
+    level++;
+  }
+  return level;
+}
+
+void texture_generate_mip(u32 width, u32 height, const u8 *src, u8 *dst) {
+  u32 dst_width = width > 1 ? width / 2 : 1;
+  u32 dst_height = height > 1 ? height / 2 : 1;
+  for (u32 y = 0; y < dst_height; ++y) {
+    // A side of 1 is not halved, its texels are averaged with themselves.
+    u32 y0 = height > 1 ? y * 2 : 0;
+    u32 y1 = height > 1 ? y * 2 + 1 : 0;
+    for (u32 x = 0; x < dst_width; ++x) {
+      u32 x0 = width > 1 ? x * 2 : 0;
+      u32 x1 = width > 1 ? x * 2 + 1 : 0;
+      for (u32 c = 0; c < 4; ++c) {
+        u32 sum = src[((u64)y0 * width + x0) * 4 + c] +
+                  src[((u64)y0 * width + x1) * 4 + c] +
+                  src[((u64)y1 * width + x0) * 4 + c] +
+                  src[((u64)y1 * width + x1) * 4 + c];
+        dst[((u64)y * dst_width + x) * 4 + c] = (u8)((sum + 2) / 4);
+      }
+    }
+  }
+}
+
+f32 texture_streaming_screen_size(vec4 bounds, mat4 model, mat4 view,
+                                  mat4 projection, u32 viewport_height) {
+  mat4 model_view = mat4_mul(model, view);
+  const f32 *m = model_view.data;
+
+  // The radius grows with the largest scale of the transform.
+  f32 scale = 0.0f;
+  for (u32 axis = 0; axis < 3; ++axis) {
+    vec3 basis = vec3_create(m[axis * 4], m[axis * 4 + 1], m[axis * 4 + 2]);
+    f32 length = vec3_length(basis);
+    if (length > scale) {
+      scale = length;
+    }
+  }
+  f32 radius = bounds.w * scale;
+
+  vec3 center;
+  center.x = bounds.x * m[0] + bounds.y * m[4] + bounds.z * m[8] + m[12];
+  center.y = bounds.x * m[1] + bounds.y * m[5] + bounds.z * m[9] + m[13];
+  center.z = bounds.x * m[2] + bounds.y * m[6] + bounds.z * m[10] + m[14];
+
+  // Clip space w, the distance along the view direction for a perspective
+  // projection and constant for an orthographic one.
+  const f32 *p = projection.data;
+  f32 w = center.x * p[3] + center.y * p[7] + center.z * p[11] + p[15];
+  if (w + radius <= 0.0f) {
+    return 0.0f;
+  }
+  if (w < radius) {
+    w = radius;
+  }
+  // p[5] maps view space heights to ndc, which spans 2 units of the viewport.
+  return radius * lai_abs(p[5]) / w * (f32)viewport_height;
+}
+
+u32 texture_streaming_desired_mip(u32 width, u32 height, u32 mip_count,
+                                  f32 screen_size) {
+  u32 size = width > height ? width : height;
+  u32 level = 0;
+  while (level + 1 < mip_count && (f32)(size >> (level + 1)) >= screen_size) {
+    level++;
+  }
+  return level;
+}
+
+static u32 entry_tail_mip(const texture_streaming_entry *entry) {
+  return texture_tail_mip(entry->width, entry->height, entry->mip_count);
+}
+
+static u64 entry_resident_size(const texture_streaming_entry *entry) {
+  return texture_levels_size(entry->width, entry->height, entry->mip_count,
+                             entry->resident_mip);
+}
+
+// Whether entry may lose its finest level so candidate can gain one,
+// candidate being INVALID_ID when nothing is gained
+static bool is_evictable(const texture_streaming_entry *entries, u32 index,
+                         u32 candidate) {
+  const texture_streaming_entry *entry = &entries[index];
+  if (index == candidate || !entry->streamable ||
+      entry->resident_mip >= entry_tail_mip(entry)) {
+    return false;
+  }
+  if (candidate == INVALID_ID || entry->resident_mip < entry->desired_mip) {
+    return true;
+  }
+  return entry->last_used_frame < entries[candidate].last_used_frame;
+}
+
+// Bytes that could be freed for candidate
+static u64 evictable_size(const texture_streaming_entry *entries,
+                          u32 entry_count, u32 candidate) {
+  u64 size = 0;
+  for (u32 i = 0; i < entry_count; ++i) {
+    if (!is_evictable(entries, i, candidate)) {
+      continue;
+    }
+    const texture_streaming_entry *entry = &entries[i];
+    u32 last_mip = entry_tail_mip(entry);
+    // Entries used as late as the candidate only give up surplus levels.
+    if (entry->last_used_frame >= entries[candidate].last_used_frame &&
+        entry->desired_mip < last_mip) {
+      last_mip = entry->desired_mip;
+    }
+    for (u32 level = entry->resident_mip; level < last_mip; ++level) {
+      size += texture_mip_size(entry->width, entry->height, level);
+    }
+  }
+  return size;
+}
+
+// Entry to lose its finest level next, INVALID_ID when there is none.
+// Surplus levels go before needed ones, the least recently used first.
+static u32 pick_victim(const texture_streaming_entry *entries,
+                       u32 entry_count, u32 candidate) {
+  u32 victim = INVALID_ID;
+  bool victim_surplus = false;
+  for (u32 i = 0; i < entry_count; ++i) {
+    if (!is_evictable(entries, i, candidate)) {
+      continue;
+    }
+    const texture_streaming_entry *entry = &entries[i];
+    bool surplus = entry->resident_mip < entry->desired_mip;
+    if (victim == INVALID_ID || (surplus && !victim_surplus) ||
+        (surplus == victim_surplus &&
+         entry->last_used_frame < entries[victim].last_used_frame)) {
+      victim = i;
+      victim_surplus = surplus;
+    }
+  }
+  return victim;
+}
+
+// Entry to gain a level next, the one whose next level is smallest
+static u32 pick_upgrade(const texture_streaming_entry *entries,
+                        u32 entry_count) {
+  u32 best = INVALID_ID;
+  u64 best_size = 0;
+  for (u32 i = 0; i < entry_count; ++i) {
+    const texture_streaming_entry *entry = &entries[i];
+    if (!entry->streamable || entry->resident_mip > entry_tail_mip(entry) ||
+        entry->desired_mip >= entry->resident_mip) {
+      continue;
+    }
+    u64 size =
+        texture_mip_size(entry->width, entry->height, entry->resident_mip - 1);
+    if (best == INVALID_ID || size < best_size ||
+        (size == best_size &&
+         entry->last_used_frame > entries[best].last_used_frame)) {
+      best = i;
+      best_size = size;
+    }
+  }
+  return best;
+}
+
+// Adds index to the changed entries, false when it is new and max_changes
+// entries changed already
+static bool mark_changed(u32 index, u32 max_changes, u32 *changed,
+                         u32 *changed_count) {
+  for (u32 i = 0; i < *changed_count; ++i) {
+    if (changed[i] == index) {
+      return true;
+    }
+  }
+  if (*changed_count >= max_changes) {
+    return false;
+  }
+  changed[(*changed_count)++] = index;
+  return true;
+}
+
+static void evict_level(texture_streaming_entry *entry, u64 *resident) {
+  *resident -=
+      texture_mip_size(entry->width, entry->height, entry->resident_mip);
+  entry->resident_mip++;
+}
+
+u32 texture_streaming_plan(texture_streaming_entry *entries, u32 entry_count,
+                           u64 budget, u32 max_changes, u32 *out_changed) {
+  u32 changed_count = 0;
+  u64 resident = 0;
+  for (u32 i = 0; i < entry_count; ++i) {
+    if (entries[i].streamable) {
+      resident += entry_resident_size(&entries[i]);
+    }
+  }
+
+  // Tails of textures that just finished loading
+  for (u32 i = 0; i < entry_count; ++i) {
+    texture_streaming_entry *entry = &entries[i];
+    u32 tail_mip = entry_tail_mip(entry);
+    if (!entry->streamable || entry->resident_mip <= tail_mip) {
+      continue;
+    }
+    if (!mark_changed(i, max_changes, out_changed, &changed_count)) {
+      return changed_count;
+    }
+    resident -= entry_resident_size(entry);
+    entry->resident_mip = tail_mip;
+    resident += entry_resident_size(entry);
+  }
+
+  // The budget may have shrunk, or the tails pushed it over.
+  while (resident > budget) {
+    u32 victim = pick_victim(entries, entry_count, INVALID_ID);
+    if (victim == INVALID_ID ||
+        !mark_changed(victim, max_changes, out_changed, &changed_count)) {
+      return changed_count;
+    }
+    evict_level(&entries[victim], &resident);
+  }
+
+  for (;;) {
+    u32 candidate = pick_upgrade(entries, entry_count);
+    if (candidate == INVALID_ID) {
+      break;
+    }
+    texture_streaming_entry *entry = &entries[candidate];
+    u64 size =
+        texture_mip_size(entry->width, entry->height, entry->resident_mip - 1);
+    // Nothing is evicted for a level that would not fit anyway, the finer
+    // levels of other entries wait for it.
+    if (resident + size >
+        budget + evictable_size(entries, entry_count, candidate)) {
+      break;
+    }
+
+    while (resident + size > budget) {
+      u32 victim = pick_victim(entries, entry_count, candidate);
+      if (victim == INVALID_ID ||
+          !mark_changed(victim, max_changes, out_changed, &changed_count)) {
+        return changed_count;
+      }
+      evict_level(&entries[victim], &resident);
+    }
+    if (!mark_changed(candidate, max_changes, out_changed, &changed_count)) {
+      break;
+    }
+    entry->resident_mip--;
+    resident += size;
+  }
+
+  return changed_count;
+}
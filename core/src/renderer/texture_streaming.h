@@ -0,0 +1,65 @@
+#pragma once
+
+#include "defines.h"
+#include "math/math_types.h"
+
+// Levels no larger than this along either side are the tail of a texture,
+// resident from the moment it is loaded until it is destroyed.
+#define TEXTURE_STREAMING_TAIL_SIZE 64
+
+// A texture side fits in a u32, so no chain is longer
+#define TEXTURE_MAX_MIP_COUNT 32
+
+// Levels of the full chain of a texture, down to 1 * 1
+u32 texture_mip_count(u32 width, u32 height);
+
+// Bytes of one level of 4 byte texels
+u64 texture_mip_size(u32 width, u32 height, u32 level);
+
+// Bytes of the levels from first_mip to the last one, 0 when first_mip is
+// mip_count
+u64 texture_levels_size(u32 width, u32 height, u32 mip_count, u32 first_mip);
+
+// Finest level of the tail
+u32 texture_tail_mip(u32 width, u32 height, u32 mip_count);
+
+// Writes the level below src, max(width / 2, 1) * max(height / 2, 1) texels
+// each averaging the up to 2 * 2 texels of src it covers.
+void texture_generate_mip(u32 width, u32 height, const u8 *src, u8 *dst);
+
+// Height in pixels the bounding sphere (center in xyz, radius in w) covers
+// once projected, 0 when it is behind the camera. The camera being inside of
+// it counts as the sphere filling the viewport.
+f32 texture_streaming_screen_size(vec4 bounds, mat4 model, mat4 view,
+                                  mat4 projection, u32 viewport_height);
+
+// Finest level worth having for a texture drawn screen_size pixels across,
+// the one with about a texel per pixel.
+u32 texture_streaming_desired_mip(u32 width, u32 height, u32 mip_count,
+                                  f32 screen_size);
+
+struct texture_streaming_entry {
+  u32 width;
+  u32 height;
+  u32 mip_count;
+  // Finest resident level, mip_count while none is
+  u32 resident_mip;
+  // Finest level the texture was drawn at lately
+  u32 desired_mip;
+  u64 last_used_frame;
+  // False for free entries and textures whose levels are not loaded yet
+  bool streamable;
+};
+
+/*
+ * Moves the resident levels of the entries toward their desired ones, keeping
+ * them within budget bytes. Tails are made resident first regardless of the
+ * budget. Finer levels then come one at a time, coarsest first and the most
+ * recently used on ties, making room by dropping the finest level of the
+ * least recently used entries. An entry only loses levels to one used later
+ * than it, unless it has more than it desires. At most max_changes entries
+ * change, their new resident_mip is set and their indices written to
+ * out_changed. Returns how many.
+ * */
+u32 texture_streaming_plan(texture_streaming_entry *entries, u32 entry_count,
+                           u64 budget, u32 max_changes, u32 *out_changed);
@@ -0,0 +1,197 @@
+#include "renderer/vulkan/shaders/vulkan_cull_shader.h"
+#include "renderer/vulkan/shaders/vulkan_shader_utils.h"
+#include "renderer/vulkan/vulkan_buffer.h"
+#include "renderer/vulkan/vulkan_descriptor.h"
+#include "renderer/vulkan/vulkan_pipeline.h"
+
+#include "base/lai_memory.h"
+#include "base/log.h"
+
+#define BUILTIN_SHADER_NAME_CULL "Builtin.CullShader"
+
+// Matches local_size_x in the shader
+#define CULL_SHADER_GROUP_SIZE 64
+
+// objects, instance transforms, draw commands, draw count
+#define CULL_SHADER_BINDING_COUNT 4
+
+struct cull_push_constants {
+  vec4 planes[6];
+  u32 object_count;
+};
+
+// Points a set from the current frame's allocator at the frame's region of
+// every buffer. The allocator is reset once the frame has completed.
+static bool write_frame_set(vulkan_context *context,
+                            vulkan_cull_shader *shader,
+                            VkDescriptorSet *out_set) {
+  u32 frame = context->current_frame;
+  if (!vulkan_descriptor_allocator_allocate(
+          context, &context->frame_descriptor_allocators[frame],
+          shader->descriptor_set_layout, out_set)) {
+    return false;
+  }
+
+  VkDescriptorBufferInfo buffer_infos[CULL_SHADER_BINDING_COUNT];
+  buffer_infos[0].buffer = shader->object_buffer.handle;
+  buffer_infos[0].range =
+      sizeof(vulkan_cull_object) * VULKAN_MAX_INSTANCES_PER_FRAME;
+  buffer_infos[1].buffer = context->instance_buffer.handle;
+  buffer_infos[1].range = sizeof(mat4) * VULKAN_MAX_INSTANCES_PER_FRAME;
+  buffer_infos[2].buffer = context->indirect_buffer.handle;
+  buffer_infos[2].range =
+      sizeof(VkDrawIndexedIndirectCommand) * VULKAN_MAX_INSTANCES_PER_FRAME;
+  buffer_infos[3].buffer = shader->draw_count_buffer.handle;
+  buffer_infos[3].range = sizeof(u32);
+  for (u32 i = 0; i < 3; ++i) {
+    buffer_infos[i].offset = buffer_infos[i].range * frame;
+  }
+  buffer_infos[3].offset = shader->draw_count_stride * frame;
+
+  VkWriteDescriptorSet writes[CULL_SHADER_BINDING_COUNT];
+  lai_zero_memory(writes, sizeof(writes));
+  for (u32 i = 0; i < CULL_SHADER_BINDING_COUNT; ++i) {
+    writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[i].dstSet = *out_set;
+    writes[i].dstBinding = i;
+    writes[i].descriptorCount = 1;
+    writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[i].pBufferInfo = &buffer_infos[i];
+  }
+  vkUpdateDescriptorSets(context->device.logical_device,
+                         CULL_SHADER_BINDING_COUNT, writes, 0, nullptr);
+  return true;
+}
+
+bool vulkan_cull_shader_create(vulkan_context *context,
+                               vulkan_cull_shader *shader) {
+  lai_zero_memory(shader, sizeof(vulkan_cull_shader));
+
+  if (!create_shader_module(context, BUILTIN_SHADER_NAME_CULL, "comp",
+                            VK_SHADER_STAGE_COMPUTE_BIT, 0, &shader->stage)) {
+    LAI_LOG_ERROR("Unable to create comp shader module for %s",
+                  BUILTIN_SHADER_NAME_CULL);
+    return false;
+  }
+
+  u32 frame_count = context->swapchain.max_frames_in_flight;
+  u32 host_memory_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  u64 object_region_size =
+      sizeof(vulkan_cull_object) * VULKAN_MAX_INSTANCES_PER_FRAME;
+  if (!vulkan_buffer_create(context, object_region_size * frame_count,
+                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                            host_memory_flags, true, &shader->object_buffer)) {
+    LAI_LOG_ERROR("Error creating cull object buffer");
+    return false;
+  }
+
+  // Each frame's count has to start at a valid storage buffer offset.
+  u64 alignment =
+      context->device.properties.limits.minStorageBufferOffsetAlignment;
+  shader->draw_count_stride = alignment > sizeof(u32) ? alignment : sizeof(u32);
+  if (!vulkan_buffer_create(
+          context, shader->draw_count_stride * frame_count,
+          (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                  VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT),
+          host_memory_flags, true, &shader->draw_count_buffer)) {
+    LAI_LOG_ERROR("Error creating cull draw count buffer");
+    return false;
+  }
+
+  // Descriptors
+  VkDescriptorSetLayoutBinding bindings[CULL_SHADER_BINDING_COUNT];
+  lai_zero_memory(bindings, sizeof(bindings));
+  for (u32 i = 0; i < CULL_SHADER_BINDING_COUNT; ++i) {
+    bindings[i].binding = i;
+    bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[i].descriptorCount = 1;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+
+  if (!vulkan_descriptor_layout_cache_get(
+          context, &context->descriptor_layout_cache,
+          CULL_SHADER_BINDING_COUNT, bindings, nullptr,
+          &shader->descriptor_set_layout)) {
+    LAI_LOG_ERROR("Unable to create the descriptor set layout for %s",
+                  BUILTIN_SHADER_NAME_CULL);
+    return false;
+  }
+
+  if (!vulkan_compute_pipeline_create(
+          context, 1, &shader->descriptor_set_layout,
+          sizeof(cull_push_constants), shader->stage.stage_create_info,
+          &shader->pipeline)) {
+    LAI_LOG_ERROR("Failed to load compute pipeline for cull shader");
+    return false;
+  }
+
+  return true;
+}
+
+void vulkan_cull_shader_destroy(vulkan_context *context,
+                                vulkan_cull_shader *shader) {
+  vulkan_pipeline_destroy(context, &shader->pipeline);
+
+  // The sets go back with the frame allocators' pools, the layout with the
+  // cache.
+  shader->descriptor_set_layout = nullptr;
+
+  vulkan_buffer_destroy(context, &shader->object_buffer);
+  vulkan_buffer_destroy(context, &shader->draw_count_buffer);
+
+  if (shader->stage.handle) {
+    vkDestroyShaderModule(context->device.logical_device, shader->stage.handle,
+                          context->allocator);
+    shader->stage.handle = nullptr;
+  }
+}
+
+void vulkan_cull_shader_dispatch(vulkan_context *context,
+                                 vulkan_cull_shader *shader,
+                                 vulkan_command_buffer *command_buffer,
+                                 u32 object_count, const frustum *frustum) {
+  // The frame was waited on, nothing reads its count any more.
+  u8 *draw_count = (u8 *)shader->draw_count_buffer.allocation.mapped +
+                   shader->draw_count_stride * context->current_frame;
+  *(u32 *)draw_count = 0;
+
+  if (object_count == 0) {
+    return;
+  }
+
+  VkDescriptorSet descriptor_set;
+  if (!write_frame_set(context, shader, &descriptor_set)) {
+    LAI_LOG_ERROR("Unable to allocate the descriptor set for %s",
+                  BUILTIN_SHADER_NAME_CULL);
+    return;
+  }
+
+  cull_push_constants push_constants;
+  for (u32 i = 0; i < 6; ++i) {
+    push_constants.planes[i] = frustum->planes[i];
+  }
+  push_constants.object_count = object_count;
+
+  vulkan_pipeline_bind(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                       &shader->pipeline);
+  vkCmdBindDescriptorSets(
+      command_buffer->handle, VK_PIPELINE_BIND_POINT_COMPUTE,
+      shader->pipeline.layout, 0, 1, &descriptor_set, 0, nullptr);
+  vkCmdPushConstants(command_buffer->handle, shader->pipeline.layout,
+                     VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                     sizeof(cull_push_constants), &push_constants);
+  vkCmdDispatch(command_buffer->handle,
+                (object_count + CULL_SHADER_GROUP_SIZE - 1) /
+                    CULL_SHADER_GROUP_SIZE,
+                1, 1);
+
+  // The draws read the commands and the count as indirect arguments.
+  VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  vkCmdPipelineBarrier(command_buffer->handle,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0,
+                       nullptr, 0, nullptr);
+}
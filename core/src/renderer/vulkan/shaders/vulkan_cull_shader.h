@@ -0,0 +1,18 @@
+#pragma once
+
+#include "renderer/vulkan/vulkan_types.inl"
+
+// Needs the instance and indirect buffers, the descriptor layout cache and
+// the frame descriptor allocators of the context
+bool vulkan_cull_shader_create(vulkan_context *context,
+                               vulkan_cull_shader *shader);
+void vulkan_cull_shader_destroy(vulkan_context *context,
+                                vulkan_cull_shader *shader);
+
+// Culls the first object_count objects of the current frame's region and
+// writes the draws of the visible ones to the frame's indirect region, with
+// their number in the draw count buffer. Recorded outside of a render pass.
+void vulkan_cull_shader_dispatch(vulkan_context *context,
+                                 vulkan_cull_shader *shader,
+                                 vulkan_command_buffer *command_buffer,
+                                 u32 object_count, const frustum *frustum);
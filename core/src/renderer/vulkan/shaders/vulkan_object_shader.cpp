@@ -1,5 +1,6 @@
 #include "renderer/vulkan/shaders/vulkan_object_shader.h"
 #include "renderer/vulkan/shaders/vulkan_shader_utils.h"
+#include "renderer/vulkan/vulkan_descriptor.h"
 #include "renderer/vulkan/vulkan_pipeline.h"
 
 #include "math/math_types.h"
@@ -25,38 +26,86 @@ bool vulkan_object_shader_create(vulkan_context *context,
     }
   }
 
-  // TODO: Descriptors
-
-  // Pipeline creation
-  VkViewport viewport;
-  viewport.x = 0.0f;
-  viewport.y = (f32)context->framebuffer_height;
-  viewport.width = (f32)context->framebuffer_width;
-  viewport.height = -(f32)context->framebuffer_height;
-  viewport.minDepth = 0.0f;
-  viewport.maxDepth = 1.0f;
+  // Descriptors, the global uniform in binding 0. It is dynamic, so the set
+  // is written once and frames only change the offset. Materials and textures
+  // come from the bindless set.
+  VkDescriptorSetLayoutBinding descriptor_binding;
+  lai_zero_memory(&descriptor_binding, sizeof(descriptor_binding));
+  descriptor_binding.binding = 0;
+  descriptor_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+  descriptor_binding.descriptorCount = 1;
+  descriptor_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+  if (!vulkan_descriptor_layout_cache_get(
+          context, &context->descriptor_layout_cache, 1, &descriptor_binding,
+          nullptr, &shader->descriptor_set_layout) ||
+      !vulkan_descriptor_allocator_allocate(
+          context, &context->descriptor_allocator,
+          shader->descriptor_set_layout, &shader->descriptor_set)) {
+    LAI_LOG_ERROR("Unable to create the descriptor set for %s",
+                  BUILTIN_SHADER_NAME_OBJECT);
+    return false;
+  }
 
-  // Scissor
-  VkRect2D scissor;
-  scissor.offset.x = scissor.offset.y = 0;
-  scissor.extent.width = context->framebuffer_width;
-  scissor.extent.height = context->framebuffer_height;
+  VkDescriptorBufferInfo buffer_info;
+  buffer_info.buffer = context->uniform_ring.buffer.handle;
+  buffer_info.offset = 0;
+  buffer_info.range = sizeof(vulkan_global_uniform);
+
+  VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+  write.dstSet = shader->descriptor_set;
+  write.dstBinding = 0;
+  write.descriptorCount = 1;
+  write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+  write.pBufferInfo = &buffer_info;
+  vkUpdateDescriptorSets(context->device.logical_device, 1, &write, 0,
+                         nullptr);
+
+  // Pipeline creation, viewport and scissor are set at draw time.
+
+  // Vertex data in binding 0, the model matrix of each instance in binding 1
+  // and its material slot in binding 2
+  const u32 binding_count = 3;
+  VkVertexInputBindingDescription binding_descriptions[binding_count];
+  binding_descriptions[0].binding = 0;
+  binding_descriptions[0].stride = sizeof(vertex_3d);
+  binding_descriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+  binding_descriptions[1].binding = 1;
+  binding_descriptions[1].stride = sizeof(mat4);
+  binding_descriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+  binding_descriptions[2].binding = 2;
+  binding_descriptions[2].stride = sizeof(u32);
+  binding_descriptions[2].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
 
   // Attributes
-  u32 offset = 0;
-  const i32 attribute_count = 1;
+  const i32 attribute_count = 7;
   VkVertexInputAttributeDescription attribute_descriptions[attribute_count];
   // Position
-  VkFormat formats[attribute_count] = {VK_FORMAT_R32G32B32_SFLOAT};
-  u64 sizes[attribute_count] = {sizeof(vec3)};
-  for (u32 i = 0; i < attribute_count; ++i) {
-    attribute_descriptions[i].binding = 0;
+  attribute_descriptions[0].binding = 0;
+  attribute_descriptions[0].location = 0;
+  attribute_descriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+  attribute_descriptions[0].offset = 0;
+  // Model matrix, one location per column
+  for (u32 i = 1; i < 5; ++i) {
+    attribute_descriptions[i].binding = 1;
     attribute_descriptions[i].location = i;
-    attribute_descriptions[i].format = formats[i];
-    attribute_descriptions[i].offset = offset;
-
-    offset += sizes[i];
+    attribute_descriptions[i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    attribute_descriptions[i].offset = sizeof(vec4) * (i - 1);
   }
+  // Texture coordinate
+  attribute_descriptions[5].binding = 0;
+  attribute_descriptions[5].location = 5;
+  attribute_descriptions[5].format = VK_FORMAT_R32G32_SFLOAT;
+  attribute_descriptions[5].offset = offsetof(vertex_3d, texcoord);
+  // Material slot
+  attribute_descriptions[6].binding = 2;
+  attribute_descriptions[6].location = 6;
+  attribute_descriptions[6].format = VK_FORMAT_R32_UINT;
+  attribute_descriptions[6].offset = 0;
+
+  VkDescriptorSetLayout set_layouts[2] = {
+      shader->descriptor_set_layout,
+      context->bindless.descriptor_set_layout};
 
   // Stages
   VkPipelineShaderStageCreateInfo stage_create_infos[OBJECT_SHADER_STAGE_COUNT];
@@ -68,9 +117,11 @@ bool vulkan_object_shader_create(vulkan_context *context,
   }
 
   if (!vulkan_graphics_pipeline_create(
-          context, &context->main_renderpass, attribute_count,
-          attribute_descriptions, 0, nullptr, OBJECT_SHADER_STAGE_COUNT,
-          stage_create_infos, viewport, scissor, false, &shader->pipeline)) {
+          context, &context->main_renderpass, binding_count,
+          binding_descriptions, attribute_count, attribute_descriptions, 2,
+          set_layouts, VULKAN_MAX_PUSH_CONSTANT_SIZE,
+          OBJECT_SHADER_STAGE_COUNT, stage_create_infos, false,
+          &shader->pipeline)) {
     LAI_LOG_ERROR("Failed to load graphics pipeline for object shader");
     return false;
   }
@@ -90,9 +141,27 @@ void vulkan_object_shader_destroy(vulkan_context *context,
 }
 
 void vulkan_object_shader_use(vulkan_context *context,
-                              vulkan_object_shader *shader) {
+                              vulkan_object_shader *shader,
+                              vulkan_command_buffer *command_buffer) {
+  vulkan_pipeline_bind(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                       &shader->pipeline);
+}
+
+void vulkan_object_shader_bind_descriptor_sets(
+    vulkan_context *context, vulkan_object_shader *shader,
+    vulkan_command_buffer *command_buffer) {
+  VkDescriptorSet sets[2] = {shader->descriptor_set,
+                             context->bindless.descriptor_set};
+  vkCmdBindDescriptorSets(command_buffer->handle,
+                          VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          shader->pipeline.layout, 0, 2, sets, 1,
+                          &context->global_uniform_offset);
+}
 
-  u32 image_index = context->image_index;
-  vulkan_pipeline_bind(&context->graphics_command_buffers[image_index],
-                       VK_PIPELINE_BIND_POINT_GRAPHICS, &shader->pipeline);
+void vulkan_object_shader_push_constants(
+    vulkan_object_shader *shader, vulkan_command_buffer *command_buffer,
+    const vulkan_object_push_constants *push_constants) {
+  vkCmdPushConstants(command_buffer->handle, shader->pipeline.layout,
+                     VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                     0, sizeof(vulkan_object_push_constants), push_constants);
 }
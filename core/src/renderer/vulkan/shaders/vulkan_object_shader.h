@@ -3,9 +3,23 @@
 #include "renderer/renderer_types.inl"
 #include "renderer/vulkan/vulkan_types.inl"
 
+// Needs the context's uniform ring, descriptor layout cache, allocator and
+// bindless set
 bool vulkan_object_shader_create(vulkan_context *context,
                                  vulkan_object_shader *shader);
 void vulkan_object_shader_destroy(vulkan_context *context,
                                   vulkan_object_shader *shader);
 void vulkan_object_shader_use(vulkan_context *context,
-                              vulkan_object_shader *shader);
\ No newline at end of file
+                              vulkan_object_shader *shader,
+                              vulkan_command_buffer *command_buffer);
+
+// Binds the frame's global uniform and the bindless set, which stay bound
+// for every draw of the command buffer
+void vulkan_object_shader_bind_descriptor_sets(
+    vulkan_context *context, vulkan_object_shader *shader,
+    vulkan_command_buffer *command_buffer);
+
+// Used by the draws recorded after it, until the next push
+void vulkan_object_shader_push_constants(
+    vulkan_object_shader *shader, vulkan_command_buffer *command_buffer,
+    const vulkan_object_push_constants *push_constants);
@@ -1,20 +1,31 @@
 #include "renderer/vulkan/vulkan_backend.h"
+#include "renderer/vulkan/vulkan_bindless.h"
 #include "renderer/vulkan/vulkan_buffer.h"
 #include "renderer/vulkan/vulkan_command_buffer.h"
+#include "renderer/vulkan/vulkan_deletion_queue.h"
+#include "renderer/vulkan/vulkan_descriptor.h"
 #include "renderer/vulkan/vulkan_device.h"
-#include "renderer/vulkan/vulkan_fence.h"
 #include "renderer/vulkan/vulkan_framebuffer.h"
+#include "renderer/vulkan/vulkan_gpu_profiler.h"
+#include "renderer/vulkan/vulkan_memory_allocator.h"
 #include "renderer/vulkan/vulkan_platform.h"
+#include "renderer/vulkan/vulkan_pipeline_cache.h"
+#include "renderer/vulkan/vulkan_record_workers.h"
 #include "renderer/vulkan/vulkan_renderpass.h"
+#include "renderer/vulkan/vulkan_staging.h"
 #include "renderer/vulkan/vulkan_swapchain.h"
 #include "renderer/vulkan/vulkan_types.inl"
+#include "renderer/vulkan/vulkan_uniform_ring.h"
 #include "renderer/vulkan/vulkan_utils.h"
 
+#include "renderer/vulkan/shaders/vulkan_cull_shader.h"
 #include "renderer/vulkan/shaders/vulkan_object_shader.h"
 
+#include "math/lai_math.h"
 #include "math/math_types.h"
 
 #include "base/application.h"
+#include "base/lai_memory.h"
 #include "base/lai_string.h"
 #include "base/log.h"
 
@@ -26,6 +37,13 @@ static vulkan_context context;
 static u32 cached_framebuffer_width = 0;
 static u32 cached_framebuffer_height = 0;
 
+// Capacity of the shared geometry buffers
+#define VULKAN_GEOMETRY_VERTEX_CAPACITY (1024 * 1024)
+#define VULKAN_GEOMETRY_INDEX_CAPACITY (3 * 1024 * 1024)
+
+// Staging memory available to each frame in flight
+#define VULKAN_STAGING_REGION_SIZE (8ull * 1024 * 1024)
+
 VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
     VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
     VkDebugUtilsMessageTypeFlagsEXT message_types,
@@ -41,25 +59,81 @@ void regenerate_framebuffers(renderer_backend *backend,
                              vulkan_renderpass *renderpass);
 bool recreate_swapchain(renderer_backend *backend);
 
-void upload_data_range(vulkan_context *context, VkCommandPool pool,
-                       VkFence fence, VkQueue queue, vulkan_buffer *buffer,
-                       u64 offset, u64 size, void *data) {
-  VkBufferUsageFlags flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-  vulkan_buffer staging;
-  vulkan_buffer_create(context, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, flags,
-                       true, &staging);
-  vulkan_buffer_load_data(context, &staging, 0, size, 0, data);
-  vulkan_buffer_copy_to(context, pool, fence, queue, staging.handle, 0,
-                        buffer->handle, offset, size);
-  vulkan_buffer_destroy(context, &staging);
+bool compact_geometry_buffers(vulkan_context *context);
+
+bool create_readback_buffer(vulkan_context *context);
+
+// Waits for the frame numbered frame_number and updates
+// context.completed_frame_number
+static bool wait_for_frame(u64 frame_number);
+
+static void begin_main_renderpass(vulkan_command_buffer *command_buffer,
+                                  VkSubpassContents contents);
+
+void upload_data_range(vulkan_context *context, vulkan_buffer *buffer,
+                       u64 offset, u64 size, const void *data) {
+  // Executed with the next frame's staging flush
+  if (!vulkan_staging_upload(context, &context->staging, buffer, offset, size,
+                             data)) {
+    LAI_LOG_ERROR("Failed to stage %llu bytes for upload", size);
+  }
+}
+
+// Copies the frame's image into the frame's readback region. The render pass
+// leaves it in TRANSFER_SRC_OPTIMAL and orders the copy after its writes.
+static void record_readback(vulkan_command_buffer *command_buffer) {
+  VkBufferImageCopy region = {};
+  region.bufferOffset = context.readback_region_size * context.current_frame;
+  // Tightly packed
+  region.bufferRowLength = 0;
+  region.bufferImageHeight = 0;
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount = 1;
+  region.imageExtent.width = context.framebuffer_width;
+  region.imageExtent.height = context.framebuffer_height;
+  region.imageExtent.depth = 1;
+  vkCmdCopyImageToBuffer(
+      command_buffer->handle, context.swapchain.images[context.image_index],
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, context.readback_buffer.handle, 1,
+      &region);
+
+  // Made visible to the host once the frame has completed.
+  VkBufferMemoryBarrier barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer = context.readback_buffer.handle;
+  barrier.offset = region.bufferOffset;
+  barrier.size = context.readback_region_size;
+  vkCmdPipelineBarrier(command_buffer->handle, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier,
+                       0, nullptr);
 }
 
 bool vulkan_renderer_backend_initialize(renderer_backend *backend,
-                                        const char *application_name) {
+                                        const renderer_config *config) {
   context.find_memory_index = find_memory_index;
   context.allocator = nullptr;
 
+  context.headless = config->headless;
+  context.readback = config->headless && config->readback;
+  context.readback_frame = -1;
+  if (config->readback && !config->headless) {
+    LAI_LOG_WARN("Frame readback is only supported by headless renderers");
+  }
+
+  // 0 lets the swapchain pick from its image count
+  u32 frames_in_flight = config->frames_in_flight;
+  if (frames_in_flight > VULKAN_MAX_FRAMES_IN_FLIGHT) {
+    LAI_LOG_WARN("%u frames in flight requested, clamping to %u",
+                 frames_in_flight, VULKAN_MAX_FRAMES_IN_FLIGHT);
+    frames_in_flight = VULKAN_MAX_FRAMES_IN_FLIGHT;
+  }
+  context.swapchain.max_frames_in_flight = (u8)frames_in_flight;
+
   application_get_framebuffer_size(&cached_framebuffer_width,
                                    &cached_framebuffer_height);
   context.framebuffer_width =
@@ -72,7 +146,7 @@ bool vulkan_renderer_backend_initialize(renderer_backend *backend,
   VkApplicationInfo app_info = {};
   app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
   app_info.apiVersion = VK_API_VERSION_1_2;
-  app_info.pApplicationName = application_name;
+  app_info.pApplicationName = config->application_name;
   app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   app_info.pEngineName = "Lai Engine";
   app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
@@ -83,10 +157,18 @@ bool vulkan_renderer_backend_initialize(renderer_backend *backend,
   create_info.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
 
   const char **required_extensions = darray_create(const char *);
-  darray_push(required_extensions,
-              VK_KHR_SURFACE_EXTENSION_NAME); // Generic surface extension
-  platform_get_required_extension_names(
-      &required_extensions); // Platform specific extension such as metal
+  if (!context.headless) {
+    darray_push(required_extensions,
+                VK_KHR_SURFACE_EXTENSION_NAME); // Generic surface extension
+    platform_get_required_extension_names(
+        &required_extensions); // Platform specific extension such as metal
+  } else if (vulkan_instance_supports_extension(
+                 "VK_KHR_portability_enumeration")) {
+    // The platform is not asked, portability drivers still have to be listed.
+    darray_push(required_extensions, "VK_KHR_portability_enumeration");
+  } else {
+    create_info.flags &= ~VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+  }
 
 #ifdef LAI_DEBUG
   darray_push(required_extensions, VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -168,10 +250,12 @@ bool vulkan_renderer_backend_initialize(renderer_backend *backend,
   LAI_LOG_DEBUG("Vulkan debugger created!");
 #endif
 
-  LAI_LOG_DEBUG("Creating vulkan surface");
-  if (!platform_create_vulkan_surface(&context)) {
-    LAI_LOG_FATAL("Failed to create vulkan surface!");
-    return false;
+  if (!context.headless) {
+    LAI_LOG_DEBUG("Creating vulkan surface");
+    if (!platform_create_vulkan_surface(&context)) {
+      LAI_LOG_FATAL("Failed to create vulkan surface!");
+      return false;
+    }
   }
 
   if (!vulkan_device_create(&context)) {
@@ -179,6 +263,18 @@ bool vulkan_renderer_backend_initialize(renderer_backend *backend,
     return false;
   }
 
+  if (!vulkan_memory_allocator_create(&context, &context.memory_allocator)) {
+    LAI_LOG_FATAL("Failed to create vulkan memory allocator!");
+    return false;
+  }
+
+  vulkan_deletion_queue_create(&context.deletion_queue);
+
+  if (!vulkan_pipeline_cache_create(&context, VULKAN_PIPELINE_CACHE_PATH,
+                                    &context.pipeline_cache)) {
+    LAI_LOG_WARN("Creating pipelines without a pipeline cache");
+  }
+
   vulkan_swapchain_create(&context, context.framebuffer_width,
                           context.framebuffer_height, &context.swapchain);
 
@@ -195,13 +291,18 @@ bool vulkan_renderer_backend_initialize(renderer_backend *backend,
   // Create command buffers
   create_command_buffers(backend);
 
+  if (!vulkan_gpu_profiler_create(&context,
+                                  context.swapchain.max_frames_in_flight,
+                                  &context.gpu_profiler)) {
+    LAI_LOG_WARN("Could not create the gpu profiler, gpu timings disabled");
+  }
+  context.main_pass_scope = INVALID_ID;
+
   // Create sync objects
   context.image_available_semaphores =
       darray_reserve(VkSemaphore, context.swapchain.max_frames_in_flight);
   context.queue_complete_semaphores =
       darray_reserve(VkSemaphore, context.swapchain.max_frames_in_flight);
-  context.in_flight_fences =
-      darray_reserve(vulkan_fence, context.swapchain.max_frames_in_flight);
 
   for (u8 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
     VkSemaphoreCreateInfo semaphore_create_info = {};
@@ -211,14 +312,59 @@ bool vulkan_renderer_backend_initialize(renderer_backend *backend,
                       &context.image_available_semaphores[i]);
     vkCreateSemaphore(context.device.logical_device, &semaphore_create_info,
                       context.allocator, &context.queue_complete_semaphores[i]);
+  }
 
-    vulkan_fence_create(&context, true, &context.in_flight_fences[i]);
+  // Replaces a fence per frame in flight, a single wait covers any frame.
+  VkSemaphoreTypeCreateInfo timeline_type_info = {
+      VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+  timeline_type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  timeline_type_info.initialValue = 0;
+  VkSemaphoreCreateInfo timeline_create_info = {
+      VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+  timeline_create_info.pNext = &timeline_type_info;
+  VK_CHECK(vkCreateSemaphore(context.device.logical_device,
+                             &timeline_create_info, context.allocator,
+                             &context.frame_timeline));
+
+  context.submitted_frame_number = 0;
+  context.completed_frame_number = 0;
+  context.in_flight_frame_numbers =
+      darray_reserve(u64, context.swapchain.max_frames_in_flight);
+  darray_length_set(context.in_flight_frame_numbers,
+                    context.swapchain.max_frames_in_flight);
+
+  // Textures are uploaded while the backend is created.
+  if (!vulkan_staging_create(&context, VULKAN_STAGING_REGION_SIZE,
+                             context.swapchain.max_frames_in_flight,
+                             &context.staging)) {
+    LAI_LOG_FATAL("Could not create the staging ring");
+    return false;
   }
 
-  context.images_in_flight =
-      darray_reserve(vulkan_fence *, context.swapchain.image_count);
-  for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-    context.images_in_flight[i] = nullptr;
+  vulkan_descriptor_layout_cache_create(&context.descriptor_layout_cache);
+  vulkan_descriptor_allocator_create(16, &context.descriptor_allocator);
+  context.frame_descriptor_allocators =
+      (vulkan_descriptor_allocator *)lai_allocate(
+          sizeof(vulkan_descriptor_allocator) *
+              context.swapchain.max_frames_in_flight,
+          MEMORY_TAG_RENDERER);
+  for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+    vulkan_descriptor_allocator_create(
+        16, &context.frame_descriptor_allocators[i]);
+  }
+
+  if (!vulkan_uniform_ring_create(&context, VULKAN_UNIFORM_RING_REGION_SIZE,
+                                  context.swapchain.max_frames_in_flight,
+                                  &context.uniform_ring)) {
+    LAI_LOG_FATAL("Could not create the uniform ring");
+    return false;
+  }
+  context.view_frustum = frustum_from_matrix(mat4_identity());
+
+  if (!vulkan_bindless_create(&context, context.swapchain.max_frames_in_flight,
+                              &context.bindless)) {
+    LAI_LOG_FATAL("Could not create the bindless descriptor set");
+    return false;
   }
 
   if (!vulkan_object_shader_create(&context, &context.object_shader)) {
@@ -231,34 +377,32 @@ bool vulkan_renderer_backend_initialize(renderer_backend *backend,
     return false;
   }
 
-  // TODO: temp code
-  const u32 vert_count = 4;
-  vertex_3d verts[vert_count];
-  lai_zero_memory(verts, sizeof(vertex_3d) * vert_count);
-
-  verts[0].position.x = 0.0;
-  verts[0].position.y = -0.5;
-
-  verts[1].position.x = 0.5;
-  verts[1].position.y = 0.5;
-
-  verts[2].position.x = 0.0;
-  verts[2].position.y = 0.5;
-
-  verts[3].position.x = 0.5;
-  verts[3].position.y = -0.5;
-
-  const u32 index_count = 6;
-  u32 indices[index_count] = {0, 1, 2, 0, 3, 1};
+  if (context.readback && !create_readback_buffer(&context)) {
+    LAI_LOG_FATAL("Could not create the readback buffer");
+    return false;
+  }
 
-  upload_data_range(&context, context.device.graphics_command_pool, 0,
-                    context.device.graphics_queue,
-                    &context.object_vertex_buffer, 0,
-                    sizeof(vertex_3d) * vert_count, verts);
+  // The main and render threads are busy already.
+  u32 processor_count = platform_get_processor_count();
+  u32 worker_count = processor_count > 2 ? processor_count - 2 : 0;
+  if (!vulkan_record_workers_create(&context, worker_count,
+                                    &context.record_workers)) {
+    LAI_LOG_WARN("Could not start the record workers, recording inline");
+  }
 
-  upload_data_range(&context, context.device.graphics_command_pool, 0,
-                    context.device.graphics_queue, &context.object_index_buffer,
-                    0, sizeof(u32) * index_count, indices);
+  context.gpu_culling = false;
+  if (config->gpu_culling) {
+    VkPhysicalDeviceFeatures *features = &context.device.features;
+    if (!context.device.supports_draw_indirect_count ||
+        !features->multiDrawIndirect || !features->drawIndirectFirstInstance) {
+      LAI_LOG_WARN("Device does not support gpu culling, drawing unculled");
+    } else if (!vulkan_cull_shader_create(&context, &context.cull_shader)) {
+      LAI_LOG_WARN("Could not create the cull shader, drawing unculled");
+      vulkan_cull_shader_destroy(&context, &context.cull_shader);
+    } else {
+      context.gpu_culling = true;
+    }
+  }
 
   LAI_LOG_INFO("Vulkan renderer created!");
   return true;
@@ -267,11 +411,48 @@ bool vulkan_renderer_backend_initialize(renderer_backend *backend,
 void vulkan_renderer_backend_shutdown(renderer_backend *backend) {
   vkDeviceWaitIdle(context.device.logical_device);
 
+  vulkan_record_workers_destroy(&context, &context.record_workers);
+  vulkan_staging_destroy(&context, &context.staging);
+
+  // The device is idle, nothing queued is in use anymore.
+  vulkan_deletion_queue_destroy(&context, &context.deletion_queue);
+
   vulkan_buffer_destroy(&context, &context.object_vertex_buffer);
   vulkan_buffer_destroy(&context, &context.object_index_buffer);
+  vulkan_buffer_destroy(&context, &context.instance_buffer);
+  vulkan_buffer_destroy(&context, &context.indirect_buffer);
+  vulkan_buffer_destroy(&context, &context.instance_material_buffer);
+  if (context.readback) {
+    vulkan_buffer_destroy(&context, &context.readback_buffer);
+  }
+  geometry_range_allocator_destroy(&context.geometry_ranges);
 
+  vulkan_cull_shader_destroy(&context, &context.cull_shader);
   vulkan_object_shader_destroy(&context, &context.object_shader);
 
+  vulkan_uniform_ring_destroy(&context, &context.uniform_ring);
+  vulkan_bindless_destroy(&context, &context.bindless);
+
+  // Frees every set, then the layouts they were made with.
+  vulkan_descriptor_allocator_destroy(&context, &context.descriptor_allocator);
+  for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+    vulkan_descriptor_allocator_destroy(
+        &context, &context.frame_descriptor_allocators[i]);
+  }
+  lai_free(context.frame_descriptor_allocators,
+           sizeof(vulkan_descriptor_allocator) *
+               context.swapchain.max_frames_in_flight,
+           MEMORY_TAG_RENDERER);
+  context.frame_descriptor_allocators = nullptr;
+  vulkan_descriptor_layout_cache_destroy(&context,
+                                         &context.descriptor_layout_cache);
+
+  vulkan_gpu_profiler_destroy(&context, &context.gpu_profiler);
+
+  vulkan_pipeline_cache_save(&context, VULKAN_PIPELINE_CACHE_PATH,
+                             context.pipeline_cache);
+  vulkan_pipeline_cache_destroy(&context, &context.pipeline_cache);
+
   for (u8 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
     if (context.image_available_semaphores[i]) {
       vkDestroySemaphore(context.device.logical_device,
@@ -286,9 +467,10 @@ void vulkan_renderer_backend_shutdown(renderer_backend *backend) {
                          context.allocator);
       context.queue_complete_semaphores[i] = nullptr;
     }
-
-    vulkan_fence_destroy(&context, &context.in_flight_fences[i]);
   }
+  vkDestroySemaphore(context.device.logical_device, context.frame_timeline,
+                     context.allocator);
+  context.frame_timeline = nullptr;
 
   {
     darray_destroy(context.image_available_semaphores);
@@ -297,22 +479,16 @@ void vulkan_renderer_backend_shutdown(renderer_backend *backend) {
     darray_destroy(context.queue_complete_semaphores);
     context.queue_complete_semaphores = nullptr;
 
-    darray_destroy(context.in_flight_fences);
-    context.in_flight_fences = nullptr;
-
-    darray_destroy(context.images_in_flight);
-    context.images_in_flight = nullptr;
+    darray_destroy(context.in_flight_frame_numbers);
+    context.in_flight_frame_numbers = nullptr;
   }
 
-  // Destroy command buffers
-  for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-    if (context.graphics_command_buffers[i].handle) {
-      vulkan_command_buffer_free(&context, context.device.graphics_command_pool,
-                                 &context.graphics_command_buffers[i]);
-
-      context.graphics_command_buffers[i].handle = nullptr;
-    }
+  // Destroying the pools frees their command buffers.
+  for (u8 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+    vulkan_command_pool_destroy(&context, &context.graphics_command_pools[i]);
   }
+  darray_destroy(context.graphics_command_pools);
+  context.graphics_command_pools = nullptr;
   darray_destroy(context.graphics_command_buffers);
   context.graphics_command_buffers = nullptr;
 
@@ -325,6 +501,8 @@ void vulkan_renderer_backend_shutdown(renderer_backend *backend) {
 
   vulkan_swapchain_destroy(&context, &context.swapchain);
 
+  vulkan_memory_allocator_destroy(&context, &context.memory_allocator);
+
   vulkan_device_destroy(&context);
 
   LAI_LOG_DEBUG("Destroying vulkan surface");
@@ -360,29 +538,16 @@ void vulkan_renderer_backend_on_resized(renderer_backend *backend, u16 width,
 
 bool vulkan_renderer_backend_begin_frame(renderer_backend *backend,
                                          f32 delta_time) {
-  vulkan_device *device = &context.device;
-
   if (context.recreating_swapchain) {
-    VkResult result = vkDeviceWaitIdle(device->logical_device);
-    if (!vulkan_result_is_success(result)) {
-      LAI_LOG_ERROR("vulkan_renderer_backend_begin_frame vkDeviceWaitIdle (1) "
-                    "failed: '%s'",
-                    vulkan_result_string(result, true));
-    }
     LAI_LOG_INFO("Recreationg swapchain, booting...");
     return false;
   }
 
-  if (context.framebuffer_size_generation !=
-      context.framebuffer_size_last_generation) {
-    VkResult result = vkDeviceWaitIdle(device->logical_device);
-    if (!vulkan_result_is_success(result)) {
-      LAI_LOG_ERROR("vulkan_renderer_backend_begin_frame vkDeviceWaitIdle (2) "
-                    "failed: '%s'",
-                    vulkan_result_string(result, true));
-      return false;
-    }
-
+  // Frames in flight keep using the old swapchain, it is retired rather than
+  // waited on.
+  if (context.swapchain_out_of_date ||
+      context.framebuffer_size_generation !=
+          context.framebuffer_size_last_generation) {
     if (!recreate_swapchain(backend)) {
       return false;
     }
@@ -391,10 +556,24 @@ bool vulkan_renderer_backend_begin_frame(renderer_backend *backend,
     return false;
   }
 
-  if (!vulkan_fence_wait(&context,
-                         &context.in_flight_fences[context.current_frame],
-                         UINT64_MAX)) {
-    LAI_LOG_WARN("In-flight fence wait failure!");
+  // The only host wait of the frame, for the frame last submitted from this
+  // slot. The gpu may be further along than that.
+  if (!wait_for_frame(context.in_flight_frame_numbers[context.current_frame])) {
+    LAI_LOG_WARN("In-flight frame wait failure!");
+    return false;
+  }
+  vulkan_deletion_queue_flush(&context, &context.deletion_queue);
+
+  // Nothing the frame in flight wrote last time is read anymore.
+  vulkan_descriptor_allocator_reset(
+      &context, &context.frame_descriptor_allocators[context.current_frame]);
+  vulkan_uniform_ring_begin_frame(&context.uniform_ring,
+                                  context.current_frame);
+  vulkan_bindless_begin_frame(&context.bindless, context.current_frame);
+
+  // Uploads queued since the last frame are submitted to the transfer queue,
+  // this frame's draws wait for them on the gpu.
+  if (!vulkan_staging_flush(&context, &context.staging)) {
     return false;
   }
 
@@ -405,71 +584,51 @@ bool vulkan_renderer_backend_begin_frame(renderer_backend *backend,
     return false;
   }
 
+  // The wait above means nothing recorded from the frame's pool is pending
+  // anymore.
+  vulkan_command_pool_reset(
+      &context, context.graphics_command_pools[context.current_frame]);
   vulkan_command_buffer *command_buffer =
-      &context.graphics_command_buffers[context.image_index];
+      &context.graphics_command_buffers[context.current_frame];
   vulkan_command_buffer_reset(command_buffer);
-  vulkan_command_buffer_begin(command_buffer, false, false, false);
-
-  VkViewport viewport;
-  viewport.x = 0.0f;
-  viewport.y = (f32)context.framebuffer_height;
-  viewport.width = (f32)context.framebuffer_width;
-  viewport.height = -(f32)context.framebuffer_height;
-  viewport.minDepth = 0.0f;
-  viewport.maxDepth = 1.0f;
+  vulkan_command_buffer_begin(command_buffer, true, false, false);
 
-  VkRect2D scissor;
-  scissor.offset.x = scissor.offset.y = 0;
-  scissor.extent.width = context.framebuffer_width;
-  scissor.extent.height = context.framebuffer_height;
+  // This frame in flight's previous results are ready, the wait above covers
+  // them.
+  vulkan_gpu_profiler_begin_frame(&context, command_buffer,
+                                  context.current_frame);
 
-  vkCmdSetViewport(command_buffer->handle, 0, 1, &viewport);
-  vkCmdSetScissor(command_buffer->handle, 0, 1, &scissor);
+  vulkan_staging_acquire(&context.staging, command_buffer,
+                         &context.upload_wait_value);
 
   context.main_renderpass.w = context.framebuffer_width;
   context.main_renderpass.h = context.framebuffer_height;
 
-  vulkan_renderpass_begin(
-      command_buffer, &context.main_renderpass,
-      context.swapchain.framebuffers[context.image_index].handle);
-
-  // TODO: temp code
-  vulkan_object_shader_use(&context, &context.object_shader);
-
-  VkDeviceSize offsets[1] = {0};
-  vkCmdBindVertexBuffers(command_buffer->handle, 0, 1,
-                         &context.object_vertex_buffer.handle,
-                         (VkDeviceSize *)offsets);
-  vkCmdBindIndexBuffer(command_buffer->handle,
-                       context.object_index_buffer.handle, 0,
-                       VK_INDEX_TYPE_UINT32);
-  vkCmdDrawIndexed(command_buffer->handle, 6, 1, 0, 0, 0);
-
+  // The render pass is begun by the draws, compute work goes before it.
   return true;
 }
 
 bool vulkan_renderer_backend_end_frame(renderer_backend *backend,
                                        f32 delta_time) {
   vulkan_command_buffer *commandbuffer =
-      &context.graphics_command_buffers[context.image_index];
+      &context.graphics_command_buffers[context.current_frame];
 
+  // Nothing was drawn, the pass still clears the image.
+  begin_main_renderpass(commandbuffer, VK_SUBPASS_CONTENTS_INLINE);
   vulkan_renderpass_end(commandbuffer, &context.main_renderpass);
+  vulkan_gpu_profiler_end_scope(&context, commandbuffer,
+                                context.main_pass_scope);
 
-  vulkan_command_buffer_end(commandbuffer);
-
-  // make sure prev frame is not using this image
-  if (context.images_in_flight[context.image_index] != VK_NULL_HANDLE) {
-    vulkan_fence_wait(&context, context.images_in_flight[context.image_index],
-                      UINT64_MAX);
+  if (context.readback) {
+    record_readback(commandbuffer);
   }
 
-  // mark the image fence in-use by this frame
-  context.images_in_flight[context.image_index] =
-      &context.in_flight_fences[context.current_frame];
+  vulkan_gpu_profiler_end_frame(&context, commandbuffer);
+  vulkan_command_buffer_end(commandbuffer);
 
-  // reset the fence for use on the next frame
-  vulkan_fence_reset(&context,
-                     &context.in_flight_fences[context.current_frame]);
+  // A previous frame rendering to the same image is ordered before this one
+  // by the acquire semaphore, there is nothing to wait for on the host.
+  u64 frame_number = context.submitted_frame_number + 1;
 
   VkSubmitInfo submit_info = {};
   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -478,24 +637,48 @@ bool vulkan_renderer_backend_end_frame(renderer_backend *backend,
   submit_info.commandBufferCount = 1;
   submit_info.pCommandBuffers = &commandbuffer->handle;
 
-  // semaphores to be signaled when the queue is complete
-  submit_info.signalSemaphoreCount = 1;
-  submit_info.pSignalSemaphores =
-      &context.queue_complete_semaphores[context.current_frame];
+  // The frame timeline is signaled with the frame number, the binary
+  // semaphore is for present, headless frames are not presented
+  VkSemaphore signal_semaphores[2] = {
+      context.frame_timeline,
+      context.queue_complete_semaphores[context.current_frame]};
+  u64 signal_values[2] = {frame_number, 0};
+  submit_info.signalSemaphoreCount = context.headless ? 1 : 2;
+  submit_info.pSignalSemaphores = signal_semaphores;
 
   // wait semaphore ensures that the op cannot begin until the image is
-  // available
-  submit_info.waitSemaphoreCount = 1;
-  submit_info.pWaitSemaphores =
-      &context.image_available_semaphores[context.current_frame];
+  // available, and until the uploads it consumes are done
+  VkSemaphore wait_semaphores[2];
+  VkPipelineStageFlags flags[2];
+  // Binary semaphores ignore their value
+  u64 wait_values[2];
+  u32 wait_count = 0;
+  if (!context.headless) {
+    wait_semaphores[wait_count] =
+        context.image_available_semaphores[context.current_frame];
+    flags[wait_count] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    wait_values[wait_count++] = 0;
+  }
+  if (context.upload_wait_value > 0) {
+    wait_semaphores[wait_count] = context.staging.timeline;
+    flags[wait_count] = VULKAN_STAGING_CONSUMER_STAGES;
+    wait_values[wait_count++] = context.upload_wait_value;
+  }
 
-  VkPipelineStageFlags flags[1] = {
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+  submit_info.waitSemaphoreCount = wait_count;
+  submit_info.pWaitSemaphores = wait_semaphores;
   submit_info.pWaitDstStageMask = flags;
 
+  VkTimelineSemaphoreSubmitInfo timeline_info = {
+      VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+  timeline_info.waitSemaphoreValueCount = submit_info.waitSemaphoreCount;
+  timeline_info.pWaitSemaphoreValues = wait_values;
+  timeline_info.signalSemaphoreValueCount = submit_info.signalSemaphoreCount;
+  timeline_info.pSignalSemaphoreValues = signal_values;
+  submit_info.pNext = &timeline_info;
+
   VkResult result =
-      vkQueueSubmit(context.device.graphics_queue, 1, &submit_info,
-                    context.in_flight_fences[context.current_frame].handle);
+      vkQueueSubmit(context.device.graphics_queue, 1, &submit_info, nullptr);
 
   if (result != VK_SUCCESS) {
     LAI_LOG_ERROR("vkQueueSubmit failed with result: '%s'",
@@ -504,6 +687,11 @@ bool vulkan_renderer_backend_end_frame(renderer_backend *backend,
   }
 
   vulkan_command_buffer_update_submitted(commandbuffer);
+  context.submitted_frame_number = frame_number;
+  context.in_flight_frame_numbers[context.current_frame] = frame_number;
+  if (context.readback) {
+    context.readback_frame = context.current_frame;
+  }
 
   vulkan_swapchain_present(
       &context, &context.swapchain, context.device.graphics_queue,
@@ -514,6 +702,600 @@ bool vulkan_renderer_backend_end_frame(renderer_backend *backend,
   return true;
 }
 
+void vulkan_renderer_backend_update_global_state(renderer_backend *backend,
+                                                 mat4 projection, mat4 view) {
+  vulkan_global_uniform global_uniform;
+  global_uniform.projection = projection;
+  global_uniform.view = view;
+  global_uniform.material_base = context.bindless.frame_material_base;
+  // The ring starts empty each frame, the global uniform is its first entry.
+  vulkan_uniform_ring_push(&context.uniform_ring,
+                           sizeof(vulkan_global_uniform), &global_uniform,
+                           &context.global_uniform_offset);
+
+  context.view_frustum = frustum_from_matrix(mat4_mul(view, projection));
+}
+
+// Everything draws need, secondary command buffers inherit none of it.
+static void bind_draw_state(vulkan_command_buffer *command_buffer) {
+  VkViewport viewport;
+  viewport.x = 0.0f;
+  viewport.y = (f32)context.framebuffer_height;
+  viewport.width = (f32)context.framebuffer_width;
+  viewport.height = -(f32)context.framebuffer_height;
+  viewport.minDepth = 0.0f;
+  viewport.maxDepth = 1.0f;
+
+  VkRect2D scissor;
+  scissor.offset.x = scissor.offset.y = 0;
+  scissor.extent.width = context.framebuffer_width;
+  scissor.extent.height = context.framebuffer_height;
+
+  vkCmdSetViewport(command_buffer->handle, 0, 1, &viewport);
+  vkCmdSetScissor(command_buffer->handle, 0, 1, &scissor);
+
+  vulkan_object_shader_use(&context, &context.object_shader, command_buffer);
+  vulkan_object_shader_bind_descriptor_sets(&context, &context.object_shader,
+                                            command_buffer);
+
+  // Instanced draws read their model matrix from the instance buffer.
+  vulkan_object_push_constants push_constants;
+  lai_zero_memory(&push_constants, sizeof(vulkan_object_push_constants));
+  push_constants.material_index = INVALID_ID;
+  vulkan_object_shader_push_constants(&context.object_shader, command_buffer,
+                                      &push_constants);
+
+  // All geometries share these, draws select their range with offsets.
+  VkDeviceSize offsets[1] = {0};
+  vkCmdBindVertexBuffers(command_buffer->handle, 0, 1,
+                         &context.object_vertex_buffer.handle,
+                         (VkDeviceSize *)offsets);
+  vkCmdBindIndexBuffer(command_buffer->handle,
+                       context.object_index_buffer.handle, 0,
+                       VK_INDEX_TYPE_UINT32);
+
+  // Instances are addressed relative to the frame's region.
+  VkDeviceSize first_frame_instance =
+      (VkDeviceSize)context.current_frame * VULKAN_MAX_INSTANCES_PER_FRAME;
+  VkBuffer instance_buffers[2] = {context.instance_buffer.handle,
+                                  context.instance_material_buffer.handle};
+  VkDeviceSize instance_offsets[2] = {first_frame_instance * sizeof(mat4),
+                                      first_frame_instance * sizeof(u32)};
+  vkCmdBindVertexBuffers(command_buffer->handle, 1, 2, instance_buffers,
+                         instance_offsets);
+}
+
+// Does nothing when the pass was already begun this frame
+static void begin_main_renderpass(vulkan_command_buffer *command_buffer,
+                                  VkSubpassContents contents) {
+  if (command_buffer->state == COMMAND_BUFFER_STATE_IN_RENDERPASS) {
+    return;
+  }
+
+  // Outside of the pass, a pass with secondary contents takes no other
+  // commands. Ended in end_frame.
+  context.main_pass_scope =
+      vulkan_gpu_profiler_begin_scope(&context, command_buffer, "main_pass");
+  vulkan_renderpass_begin(
+      command_buffer, &context.main_renderpass,
+      context.swapchain.framebuffers[context.image_index].handle, contents);
+
+  if (contents == VK_SUBPASS_CONTENTS_INLINE) {
+    bind_draw_state(command_buffer);
+  }
+}
+
+static bool allocate_geometry_range(geometry_range *range) {
+  if (geometry_range_allocate(&context.geometry_ranges, range)) {
+    return true;
+  }
+
+  // If there is enough space in total it is just fragmented, pack the live
+  // ranges together and try once more.
+  return geometry_range_fits_compacted(&context.geometry_ranges,
+                                       range->vertex_count,
+                                       range->index_count) &&
+         compact_geometry_buffers(&context) &&
+         geometry_range_allocate(&context.geometry_ranges, range);
+}
+
+bool vulkan_renderer_backend_create_geometry(renderer_backend *backend,
+                                             geometry *geometry,
+                                             u32 vertex_count,
+                                             const vertex_3d *vertices,
+                                             u32 index_count,
+                                             const u32 *indices) {
+  if (!vertex_count || !vertices) {
+    LAI_LOG_ERROR("vulkan_renderer_backend_create_geometry requires vertex "
+                  "data, none was supplied");
+    return false;
+  }
+
+  // Uploading again replaces the old data.
+  if (geometry->internal_id != INVALID_ID) {
+    vulkan_renderer_backend_destroy_geometry(backend, geometry);
+  }
+
+  vulkan_geometry_data *internal_data = nullptr;
+  u32 internal_id = INVALID_ID;
+  for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_COUNT; ++i) {
+    if (context.geometries[i].id == INVALID_ID) {
+      internal_id = i;
+      internal_data = &context.geometries[i];
+      break;
+    }
+  }
+  if (!internal_data) {
+    LAI_LOG_ERROR("vulkan_renderer_backend_create_geometry failed to find a "
+                  "free slot, increase VULKAN_MAX_GEOMETRY_COUNT");
+    return false;
+  }
+
+  geometry_range range = {};
+  range.vertex_count = vertex_count;
+  range.index_count = indices ? index_count : 0;
+  if (!allocate_geometry_range(&range)) {
+    LAI_LOG_ERROR("Out of geometry buffer space for '%s': %u vertices, %u "
+                  "indices",
+                  geometry->name, vertex_count, index_count);
+    return false;
+  }
+
+  upload_data_range(&context, &context.object_vertex_buffer,
+                    range.vertex_offset * sizeof(vertex_3d),
+                    vertex_count * sizeof(vertex_3d), vertices);
+  if (indices && index_count > 0) {
+    upload_data_range(&context, &context.object_index_buffer,
+                      range.index_offset * sizeof(u32),
+                      index_count * sizeof(u32), indices);
+  }
+
+  internal_data->id = internal_id;
+  internal_data->generation++;
+  internal_data->vertex_count = range.vertex_count;
+  internal_data->vertex_offset = range.vertex_offset;
+  internal_data->index_count = range.index_count;
+  internal_data->index_offset = range.index_offset;
+  internal_data->bounds =
+      vertices_bounding_sphere(vertices, nullptr, vertex_count);
+
+  geometry->internal_id = internal_id;
+  geometry->bounds = internal_data->bounds;
+  return true;
+}
+
+void vulkan_renderer_backend_destroy_geometry(renderer_backend *backend,
+                                              geometry *geometry) {
+  if (!geometry || geometry->internal_id == INVALID_ID) {
+    return;
+  }
+
+  vulkan_geometry_data *internal_data =
+      &context.geometries[geometry->internal_id];
+
+  // Frames in flight may still read the ranges, they are freed once those
+  // complete.
+  geometry_range ranges;
+  ranges.vertex_count = internal_data->vertex_count;
+  ranges.vertex_offset = internal_data->vertex_offset;
+  ranges.index_count = internal_data->index_count;
+  ranges.index_offset = internal_data->index_offset;
+  vulkan_deletion_queue_push_geometry_ranges(&context, &context.deletion_queue,
+                                             &ranges);
+
+  // The generation is kept so a reused slot can be told apart.
+  internal_data->id = INVALID_ID;
+  internal_data->vertex_count = 0;
+  internal_data->index_count = 0;
+
+  geometry->internal_id = INVALID_ID;
+}
+
+bool vulkan_renderer_backend_create_texture(renderer_backend *backend,
+                                            texture *texture) {
+  // Creating again drops the resident levels.
+  if (texture->internal_id != INVALID_ID) {
+    vulkan_renderer_backend_destroy_texture(backend, texture);
+  }
+
+  u32 handle;
+  if (!vulkan_bindless_create_texture(&context.bindless, &handle)) {
+    LAI_LOG_ERROR("Could not create texture '%s'", texture->name);
+    return false;
+  }
+  texture->internal_id = handle;
+  return true;
+}
+
+bool vulkan_renderer_backend_upload_texture_levels(
+    renderer_backend *backend, texture *texture, u32 first_mip,
+    const u8 *const *mip_pixels) {
+  if (texture->internal_id == INVALID_ID || first_mip >= texture->mip_count ||
+      !mip_pixels) {
+    LAI_LOG_ERROR("vulkan_renderer_backend_upload_texture_levels requires a "
+                  "created texture and its levels");
+    return false;
+  }
+
+  u32 width = texture->width >> first_mip;
+  u32 height = texture->height >> first_mip;
+  if (!vulkan_bindless_upload_texture(
+          &context, &context.bindless, texture->internal_id, width ? width : 1,
+          height ? height : 1, texture->mip_count - first_mip,
+          mip_pixels + first_mip)) {
+    LAI_LOG_ERROR("Could not upload mips %u to %u of texture '%s'", first_mip,
+                  texture->mip_count - 1, texture->name);
+    return false;
+  }
+  return true;
+}
+
+void vulkan_renderer_backend_destroy_texture(renderer_backend *backend,
+                                             texture *texture) {
+  if (!texture || texture->internal_id == INVALID_ID) {
+    return;
+  }
+  vulkan_bindless_destroy_texture(&context, &context.bindless,
+                                  texture->internal_id);
+  texture->internal_id = INVALID_ID;
+}
+
+bool vulkan_renderer_backend_update_material(renderer_backend *backend,
+                                             const material *material) {
+  if (material->id >= VULKAN_MAX_MATERIAL_COUNT) {
+    LAI_LOG_ERROR("Material id %u is past VULKAN_MAX_MATERIAL_COUNT",
+                  material->id);
+    return false;
+  }
+
+  vulkan_material_data data;
+  lai_zero_memory(&data, sizeof(vulkan_material_data));
+  data.diffuse_color = material->diffuse_color;
+  // Resolved to the texture's current slot every time it changes
+  data.diffuse_texture_index = INVALID_ID;
+  if (material->diffuse_map) {
+    data.diffuse_texture_index = material->diffuse_map->internal_id;
+  }
+  vulkan_bindless_write_material(&context.bindless, material->id, &data);
+  return true;
+}
+
+// Records count commands of the frame's indirect region starting at first
+static void draw_indexed_indirect(VkCommandBuffer command_buffer,
+                                  u64 region_offset, u32 first, u32 count) {
+  const u32 stride = sizeof(VkDrawIndexedIndirectCommand);
+  u32 max_draw_count = 1;
+  if (context.device.features.multiDrawIndirect) {
+    max_draw_count = context.device.properties.limits.maxDrawIndirectCount;
+  }
+
+  while (count > 0) {
+    u32 draw_count = count < max_draw_count ? count : max_draw_count;
+    vkCmdDrawIndexedIndirect(command_buffer, context.indirect_buffer.handle,
+                             region_offset + (u64)first * stride, draw_count,
+                             stride);
+    first += draw_count;
+    count -= draw_count;
+  }
+}
+
+// Fills the frame's cull objects with every instance of the indexed batches
+static u32 write_cull_objects(u64 first_frame_instance, u32 batch_count,
+                              const render_batch *batches,
+                              u32 instance_count) {
+  vulkan_cull_object *objects =
+      (vulkan_cull_object *)context.cull_shader.object_buffer.allocation
+          .mapped +
+      first_frame_instance;
+  u32 object_count = 0;
+
+  for (u32 i = 0; i < batch_count; ++i) {
+    const render_batch *batch = &batches[i];
+    if (!batch->geometry || batch->geometry->internal_id == INVALID_ID) {
+      continue;
+    }
+    vulkan_geometry_data *data =
+        &context.geometries[batch->geometry->internal_id];
+    if (data->index_count == 0) {
+      continue;
+    }
+
+    u32 end = batch->first_instance + batch->instance_count;
+    end = end < instance_count ? end : instance_count;
+    for (u32 instance = batch->first_instance; instance < end; ++instance) {
+      vulkan_cull_object *object = &objects[object_count++];
+      object->bounds = data->bounds;
+      object->index_count = data->index_count;
+      object->first_index = data->index_offset;
+      object->vertex_offset = (i32)data->vertex_offset;
+      object->instance_index = instance;
+    }
+  }
+  return object_count;
+}
+
+struct batch_record_job {
+  const render_batch *batches;
+  u32 instance_count;
+  const mat4 *transforms;
+  u64 first_frame_instance;
+};
+
+// Slot of the material buffer the material is drawn with
+static u32 material_slot(u32 material_id) {
+  if (material_id >= VULKAN_MAX_MATERIAL_COUNT) {
+    return VULKAN_DEFAULT_MATERIAL_SLOT;
+  }
+  return material_id;
+}
+
+// The material slot of every instance, read by the vertex shader next to
+// the instance's model matrix.
+static void write_instance_materials(u64 first_frame_instance,
+                                     u32 batch_count,
+                                     const render_batch *batches,
+                                     u32 instance_count) {
+  u32 *slots = (u32 *)context.instance_material_buffer.allocation.mapped +
+               first_frame_instance;
+  for (u32 i = 0; i < batch_count; ++i) {
+    const render_batch *batch = &batches[i];
+    u32 slot = material_slot(batch->material_id);
+    u32 end = batch->first_instance + batch->instance_count;
+    end = end < instance_count ? end : instance_count;
+    for (u32 instance = batch->first_instance; instance < end; ++instance) {
+      slots[instance] = slot;
+    }
+  }
+}
+
+// Records a range of batches, the indirect command of batch i goes to slot i
+// of the frame's region so ranges can be recorded in parallel.
+static void record_batch_draws(vulkan_command_buffer *command_buffer,
+                               u32 first_batch, u32 batch_count,
+                               void *user_data) {
+  const batch_record_job *job = (const batch_record_job *)user_data;
+  VkCommandBuffer handle = command_buffer->handle;
+
+  // A non-zero firstInstance in an indirect command needs
+  // drawIndirectFirstInstance, without it every batch is drawn directly.
+  bool use_indirect = context.device.features.drawIndirectFirstInstance;
+  VkDrawIndexedIndirectCommand *commands =
+      (VkDrawIndexedIndirectCommand *)
+          context.indirect_buffer.allocation.mapped +
+      job->first_frame_instance;
+  u64 commands_offset =
+      job->first_frame_instance * sizeof(VkDrawIndexedIndirectCommand);
+  u32 pending_first = first_batch;
+  u32 pending_count = 0;
+
+  u32 end = first_batch + batch_count;
+  for (u32 i = first_batch; i < end; ++i) {
+    const render_batch *batch = &job->batches[i];
+    if (!batch->geometry || batch->geometry->internal_id == INVALID_ID ||
+        batch->first_instance >= job->instance_count) {
+      continue;
+    }
+    u32 instance_count = batch->instance_count;
+    if (batch->first_instance + instance_count > job->instance_count) {
+      instance_count = job->instance_count - batch->first_instance;
+    }
+
+    vulkan_geometry_data *data =
+        &context.geometries[batch->geometry->internal_id];
+    if (data->index_count > 0 && use_indirect) {
+      if (pending_count > 0 && pending_first + pending_count != i) {
+        draw_indexed_indirect(handle, commands_offset, pending_first,
+                              pending_count);
+        pending_count = 0;
+      }
+      if (pending_count == 0) {
+        pending_first = i;
+      }
+      VkDrawIndexedIndirectCommand *command = &commands[i];
+      command->indexCount = data->index_count;
+      command->instanceCount = instance_count;
+      command->firstIndex = data->index_offset;
+      command->vertexOffset = (i32)data->vertex_offset;
+      command->firstInstance = batch->first_instance;
+      pending_count++;
+      continue;
+    }
+
+    // Keeps the recorded order, pending indirect draws go first.
+    draw_indexed_indirect(handle, commands_offset, pending_first,
+                          pending_count);
+    pending_count = 0;
+    if (data->index_count > 0) {
+      vkCmdDrawIndexed(handle, data->index_count, instance_count,
+                       data->index_offset, data->vertex_offset,
+                       batch->first_instance);
+    } else {
+      vkCmdDraw(handle, data->vertex_count, instance_count,
+                data->vertex_offset, batch->first_instance);
+    }
+  }
+
+  draw_indexed_indirect(handle, commands_offset, pending_first, pending_count);
+}
+
+// Draws every instance on its own with its model matrix pushed, for frames
+// small enough that this beats filling the instance buffer.
+static void record_batch_pushes(vulkan_command_buffer *command_buffer,
+                                u32 batch_count,
+                                const batch_record_job *job) {
+  VkCommandBuffer handle = command_buffer->handle;
+  vulkan_object_push_constants push_constants;
+  lai_zero_memory(&push_constants, sizeof(vulkan_object_push_constants));
+  push_constants.use_push_model = 1;
+
+  for (u32 i = 0; i < batch_count; ++i) {
+    const render_batch *batch = &job->batches[i];
+    if (!batch->geometry || batch->geometry->internal_id == INVALID_ID ||
+        batch->first_instance >= job->instance_count) {
+      continue;
+    }
+    u32 end = batch->first_instance + batch->instance_count;
+    end = end < job->instance_count ? end : job->instance_count;
+
+    vulkan_geometry_data *data =
+        &context.geometries[batch->geometry->internal_id];
+    push_constants.material_index = material_slot(batch->material_id);
+    for (u32 instance = batch->first_instance; instance < end; ++instance) {
+      push_constants.model = job->transforms[instance];
+      vulkan_object_shader_push_constants(&context.object_shader,
+                                          command_buffer, &push_constants);
+      if (data->index_count > 0) {
+        vkCmdDrawIndexed(handle, data->index_count, 1, data->index_offset,
+                         data->vertex_offset, 0);
+      } else {
+        vkCmdDraw(handle, data->vertex_count, 1, data->vertex_offset, 0);
+      }
+    }
+  }
+}
+
+// Runs on a record worker
+static void record_batch_share(vulkan_command_buffer *command_buffer,
+                               u32 first_batch, u32 batch_count,
+                               void *user_data) {
+  bind_draw_state(command_buffer);
+  record_batch_draws(command_buffer, first_batch, batch_count, user_data);
+}
+
+void vulkan_renderer_backend_draw_batches(renderer_backend *backend,
+                                          u32 batch_count,
+                                          const render_batch *batches,
+                                          u32 instance_count,
+                                          const mat4 *transforms) {
+  if (instance_count > VULKAN_MAX_INSTANCES_PER_FRAME) {
+    LAI_LOG_WARN("Frame has %u instances, only the first %u are drawn",
+                 instance_count, VULKAN_MAX_INSTANCES_PER_FRAME);
+    instance_count = VULKAN_MAX_INSTANCES_PER_FRAME;
+  }
+
+  vulkan_command_buffer *command_buffer =
+      &context.graphics_command_buffers[context.current_frame];
+
+  batch_record_job job;
+  job.batches = batches;
+  job.instance_count = instance_count;
+  job.transforms = transforms;
+  job.first_frame_instance =
+      (u64)context.current_frame * VULKAN_MAX_INSTANCES_PER_FRAME;
+
+  // Few instances are cheaper to push than to go through the instance
+  // buffer. Culling needs every instance in the buffer.
+  if (!context.gpu_culling &&
+      instance_count <= VULKAN_PUSH_CONSTANT_MAX_INSTANCES) {
+    begin_main_renderpass(command_buffer, VK_SUBPASS_CONTENTS_INLINE);
+    LAI_GPU_PROFILE_SCOPE(&context, command_buffer, "draws");
+    record_batch_pushes(command_buffer, batch_count, &job);
+    return;
+  }
+
+  u64 first_frame_instance = job.first_frame_instance;
+  mat4 *instance_data =
+      (mat4 *)context.instance_buffer.allocation.mapped + first_frame_instance;
+  lai_copy_memory(instance_data, transforms, sizeof(mat4) * instance_count);
+  write_instance_materials(first_frame_instance, batch_count, batches,
+                           instance_count);
+
+  if (context.gpu_culling) {
+    // The compute pass has to be recorded before the render pass begins.
+    u32 cull_object_count = write_cull_objects(
+        first_frame_instance, batch_count, batches, instance_count);
+    {
+      LAI_GPU_PROFILE_SCOPE(&context, command_buffer, "cull");
+      vulkan_cull_shader_dispatch(&context, &context.cull_shader,
+                                  command_buffer, cull_object_count,
+                                  &context.view_frustum);
+    }
+
+    begin_main_renderpass(command_buffer, VK_SUBPASS_CONTENTS_INLINE);
+    LAI_GPU_PROFILE_SCOPE(&context, command_buffer, "draws");
+    // The culled draws are a single command, each instance still finds its
+    // own material.
+    if (cull_object_count > 0) {
+      vulkan_cull_shader *cull_shader = &context.cull_shader;
+      vkCmdDrawIndexedIndirectCount(
+          command_buffer->handle, context.indirect_buffer.handle,
+          first_frame_instance * sizeof(VkDrawIndexedIndirectCommand),
+          cull_shader->draw_count_buffer.handle,
+          cull_shader->draw_count_stride * context.current_frame,
+          cull_object_count, sizeof(VkDrawIndexedIndirectCommand));
+    }
+
+    // Non-indexed geometry is not culled.
+    for (u32 i = 0; i < batch_count; ++i) {
+      const render_batch *batch = &batches[i];
+      if (!batch->geometry || batch->geometry->internal_id == INVALID_ID ||
+          batch->first_instance >= instance_count) {
+        continue;
+      }
+      vulkan_geometry_data *data =
+          &context.geometries[batch->geometry->internal_id];
+      if (data->index_count == 0) {
+        u32 end = batch->first_instance + batch->instance_count;
+        end = end < instance_count ? end : instance_count;
+        vkCmdDraw(command_buffer->handle, data->vertex_count,
+                  end - batch->first_instance, data->vertex_offset,
+                  batch->first_instance);
+      }
+    }
+    return;
+  }
+
+  // Large frames are split across the record workers.
+  if (vulkan_record_workers_worker_count_for(&context.record_workers,
+                                             batch_count) > 0) {
+    begin_main_renderpass(command_buffer,
+                          VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+    VkCommandBuffer secondary_command_buffers[VULKAN_MAX_RECORD_WORKERS];
+    u32 secondary_count = vulkan_record_workers_record(
+        &context, &context.record_workers, context.main_renderpass.handle,
+        context.swapchain.framebuffers[context.image_index].handle,
+        batch_count, record_batch_share, &job, secondary_command_buffers);
+    vkCmdExecuteCommands(command_buffer->handle, secondary_count,
+                         secondary_command_buffers);
+    return;
+  }
+
+  begin_main_renderpass(command_buffer, VK_SUBPASS_CONTENTS_INLINE);
+  LAI_GPU_PROFILE_SCOPE(&context, command_buffer, "draws");
+  record_batch_draws(command_buffer, 0, batch_count, &job);
+}
+
+bool vulkan_renderer_backend_read_frame(renderer_backend *backend,
+                                        u32 *out_width, u32 *out_height,
+                                        const void **out_pixels) {
+  if (!context.readback) {
+    LAI_LOG_WARN("Frame readback needs a headless renderer created with "
+                 "readback enabled");
+    return false;
+  }
+  if (context.readback_frame < 0) {
+    return false;
+  }
+
+  if (!wait_for_frame(
+          context.in_flight_frame_numbers[context.readback_frame])) {
+    LAI_LOG_WARN("Readback frame wait failure!");
+    return false;
+  }
+
+  *out_width = context.framebuffer_width;
+  *out_height = context.framebuffer_height;
+  *out_pixels = (u8 *)context.readback_buffer.allocation.mapped +
+                context.readback_region_size * context.readback_frame;
+  return true;
+}
+
+bool vulkan_renderer_backend_get_gpu_timings(renderer_backend *backend,
+                                             gpu_timings *out_timings) {
+  return vulkan_gpu_profiler_get_timings(&context.gpu_profiler, out_timings);
+}
+
 VKAPI_ATTR VkBool32 VKAPI_CALL
 vk_debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
                   VkDebugUtilsMessageTypeFlagsEXT message_types,
@@ -553,28 +1335,20 @@ i32 find_memory_index(u32 type_filter, u32 property_flags) {
   return -1;
 }
 
+// Allocated once, they do not depend on the swapchain.
 void create_command_buffers(renderer_backend *backend) {
-  if (!context.graphics_command_buffers) {
-    context.graphics_command_buffers =
-        darray_reserve(vulkan_command_buffer, context.swapchain.image_count);
-    for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-      lai_zero_memory(&context.graphics_command_buffers[i],
-                      sizeof(vulkan_command_buffer));
-    }
-  }
-
-  for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-    if (context.graphics_command_buffers[i].handle) {
-      vulkan_command_buffer_free(&context, context.device.graphics_command_pool,
-                                 &context.graphics_command_buffers[i]);
-    }
-
-    lai_zero_memory(&context.graphics_command_buffers[i],
-                    sizeof(vulkan_command_buffer));
-
-    vulkan_command_buffer_allocate(&context,
-                                   context.device.graphics_command_pool, true,
-                                   &context.graphics_command_buffers[i]);
+  u32 frame_count = context.swapchain.max_frames_in_flight;
+  context.graphics_command_pools = darray_reserve(VkCommandPool, frame_count);
+  context.graphics_command_buffers =
+      darray_reserve(vulkan_command_buffer, frame_count);
+
+  for (u32 i = 0; i < frame_count; ++i) {
+    // Recorded once per frame and reset with the pool.
+    vulkan_command_pool_create(&context, context.device.graphics_queue_index,
+                               VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                               &context.graphics_command_pools[i]);
+    vulkan_command_buffer_allocate(&context, context.graphics_command_pools[i],
+                                   true, &context.graphics_command_buffers[i]);
   }
 
   LAI_LOG_INFO("Vulkan command buffers created!");
@@ -601,7 +1375,13 @@ bool recreate_swapchain(renderer_backend *backend) {
     return false;
   }
 
-  if (context.framebuffer_width == 0 || context.framebuffer_height == 0) {
+  // Out of date without a resize event keeps the current size.
+  bool resized = context.framebuffer_size_generation !=
+                 context.framebuffer_size_last_generation;
+  u32 width = resized ? cached_framebuffer_width : context.framebuffer_width;
+  u32 height = resized ? cached_framebuffer_height : context.framebuffer_height;
+
+  if (width == 0 || height == 0) {
     LAI_LOG_DEBUG("recreate_swapchain called when window is < 1 in a "
                   "dimension. Booting.");
     return false;
@@ -609,41 +1389,38 @@ bool recreate_swapchain(renderer_backend *backend) {
 
   context.recreating_swapchain = true;
 
-  vkDeviceWaitIdle(context.device.logical_device);
-
-  for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-    context.images_in_flight[i] = nullptr;
+  // Recorded frames may still reference the framebuffers, they are retired
+  // with the images they point to.
+  u32 old_image_count = context.swapchain.image_count;
+  for (u32 i = 0; i < old_image_count; ++i) {
+    vulkan_framebuffer_retire(&context, &context.swapchain.framebuffers[i]);
   }
 
-  vulkan_device_query_swapchain_support(context.device.physical_device,
-                                        context.surface,
-                                        &context.device.swapchain_support);
+  if (!context.headless) {
+    vulkan_device_query_swapchain_support(context.device.physical_device,
+                                          context.surface,
+                                          &context.device.swapchain_support);
+  }
 
   vulkan_device_detect_depth_format(&context.device);
 
-  vulkan_swapchain_recreate(&context, cached_framebuffer_width,
-                            cached_framebuffer_height, &context.swapchain);
+  vulkan_swapchain_recreate(&context, width, height, &context.swapchain);
 
-  context.framebuffer_width = cached_framebuffer_width;
-  context.framebuffer_height = cached_framebuffer_height;
+  if (context.swapchain.image_count != old_image_count) {
+    darray_destroy(context.swapchain.framebuffers);
+    context.swapchain.framebuffers =
+        darray_reserve(vulkan_framebuffer, context.swapchain.image_count);
+  }
 
-  context.main_renderpass.w = context.framebuffer_width;
-  context.main_renderpass.h = context.framebuffer_height;
+  context.framebuffer_width = width;
+  context.framebuffer_height = height;
 
   cached_framebuffer_width = 0;
   cached_framebuffer_height = 0;
 
   context.framebuffer_size_last_generation =
       context.framebuffer_size_generation;
-
-  for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-    vulkan_command_buffer_free(&context, context.device.graphics_command_pool,
-                               &context.graphics_command_buffers[i]);
-  }
-
-  for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-    vulkan_framebuffer_destroy(&context, &context.swapchain.framebuffers[i]);
-  }
+  context.swapchain_out_of_date = false;
 
   context.main_renderpass.x = 0;
   context.main_renderpass.y = 0;
@@ -653,7 +1430,16 @@ bool recreate_swapchain(renderer_backend *backend) {
   regenerate_framebuffers(backend, &context.swapchain,
                           &context.main_renderpass);
 
-  create_command_buffers(backend);
+  if (context.readback) {
+    // The regions are sized for the old extent.
+    vulkan_deletion_queue_push_buffer(&context, &context.deletion_queue,
+                                      &context.readback_buffer);
+    context.readback_frame = -1;
+    if (!create_readback_buffer(&context)) {
+      LAI_LOG_ERROR("Could not recreate the readback buffer");
+      context.readback = false;
+    }
+  }
 
   context.recreating_swapchain = false;
 
@@ -668,27 +1454,216 @@ bool create_buffers(vulkan_context *context) {
       (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
                               VK_BUFFER_USAGE_TRANSFER_DST_BIT |
                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-  const u64 vertex_buffer_size = sizeof(vertex_3d) * 1024 * 1024;
+  const u64 vertex_buffer_size =
+      sizeof(vertex_3d) * VULKAN_GEOMETRY_VERTEX_CAPACITY;
   if (!vulkan_buffer_create(context, vertex_buffer_size,
                             vertex_buffer_usage_bits, memory_property_flags,
                             true, &context->object_vertex_buffer)) {
     LAI_LOG_ERROR("Error creating vertex buffer");
     return false;
   }
-  context->geometry_vertex_offset = 0;
 
   VkBufferUsageFlagBits index_buffer_usage_bits =
       (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
                               VK_BUFFER_USAGE_TRANSFER_DST_BIT |
                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-  const u64 index_buffer_size = sizeof(vertex_3d) * 1024 * 1024;
+  const u64 index_buffer_size = sizeof(u32) * VULKAN_GEOMETRY_INDEX_CAPACITY;
   if (!vulkan_buffer_create(context, index_buffer_size, index_buffer_usage_bits,
                             memory_property_flags, true,
                             &context->object_index_buffer)) {
     LAI_LOG_ERROR("Error creating index buffer");
     return false;
   }
-  context->geometry_index_offset = 0;
+  geometry_range_allocator_create(VULKAN_GEOMETRY_VERTEX_CAPACITY,
+                                  VULKAN_GEOMETRY_INDEX_CAPACITY,
+                                  &context->geometry_ranges);
+
+  for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_COUNT; ++i) {
+    context->geometries[i].id = INVALID_ID;
+  }
+
+  // Written by the cpu every frame, the frame's wait guards its region.
+  u32 frame_count = context->swapchain.max_frames_in_flight;
+  u32 host_memory_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  if (!vulkan_buffer_create(
+          context, sizeof(mat4) * VULKAN_MAX_INSTANCES_PER_FRAME * frame_count,
+          (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT),
+          host_memory_flags, true, &context->instance_buffer)) {
+    LAI_LOG_ERROR("Error creating instance buffer");
+    return false;
+  }
+  if (!vulkan_buffer_create(context,
+                            sizeof(VkDrawIndexedIndirectCommand) *
+                                VULKAN_MAX_INSTANCES_PER_FRAME * frame_count,
+                            (VkBufferUsageFlagBits)(
+                                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT),
+                            host_memory_flags, true,
+                            &context->indirect_buffer)) {
+    LAI_LOG_ERROR("Error creating indirect buffer");
+    return false;
+  }
+  if (!vulkan_buffer_create(
+          context, sizeof(u32) * VULKAN_MAX_INSTANCES_PER_FRAME * frame_count,
+          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, host_memory_flags, true,
+          &context->instance_material_buffer)) {
+    LAI_LOG_ERROR("Error creating instance material buffer");
+    return false;
+  }
 
   return true;
-}
\ No newline at end of file
+}
+
+static bool wait_for_frame(u64 frame_number) {
+  if (frame_number > context.completed_frame_number) {
+    VkSemaphoreWaitInfo wait_info = {VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &context.frame_timeline;
+    wait_info.pValues = &frame_number;
+    VkResult result = vkWaitSemaphores(context.device.logical_device,
+                                       &wait_info, UINT64_MAX);
+    if (!vulkan_result_is_success(result)) {
+      LAI_LOG_ERROR("Frame wait failed with result: '%s'",
+                    vulkan_result_string(result, true));
+      return false;
+    }
+  }
+
+  // Frames complete in submission order, later ones may be done as well.
+  u64 completed = 0;
+  VK_CHECK(vkGetSemaphoreCounterValue(context.device.logical_device,
+                                      context.frame_timeline, &completed));
+  if (completed > context.completed_frame_number) {
+    context.completed_frame_number = completed;
+  }
+  return true;
+}
+
+bool create_readback_buffer(vulkan_context *context) {
+  // 4 bytes per texel of the offscreen format
+  context->readback_region_size =
+      (u64)context->framebuffer_width * context->framebuffer_height * 4;
+  u32 frame_count = context->swapchain.max_frames_in_flight;
+  if (!vulkan_buffer_create(
+          context, context->readback_region_size * frame_count,
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+              VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+          true, &context->readback_buffer)) {
+    LAI_LOG_ERROR("Error creating readback buffer");
+    return false;
+  }
+  return true;
+}
+
+bool compact_geometry_buffers(vulkan_context *context) {
+  LAI_LOG_INFO("Geometry buffers are fragmented, compacting...");
+
+  // Copies recorded against the old buffers have to land first. Frames in
+  // flight only read the old buffers, they can keep running: the copies are
+  // submitted behind them on the graphics queue and nothing waits for them
+  // on the cpu.
+  if (!vulkan_staging_flush(context, &context->staging) ||
+      !vulkan_staging_wait_idle(context, &context->staging)) {
+    return false;
+  }
+
+  vulkan_buffer *vertex_buffer = &context->object_vertex_buffer;
+  vulkan_buffer *index_buffer = &context->object_index_buffer;
+
+  vulkan_buffer new_vertex_buffer;
+  if (!vulkan_buffer_create(context, vertex_buffer->total_size,
+                            vertex_buffer->usage,
+                            vertex_buffer->memory_property_flags, true,
+                            &new_vertex_buffer)) {
+    LAI_LOG_ERROR("Failed to create vertex buffer for compaction");
+    return false;
+  }
+  vulkan_buffer new_index_buffer;
+  if (!vulkan_buffer_create(context, index_buffer->total_size,
+                            index_buffer->usage,
+                            index_buffer->memory_property_flags, true,
+                            &new_index_buffer)) {
+    LAI_LOG_ERROR("Failed to create index buffer for compaction");
+    vulkan_buffer_destroy(context, &new_vertex_buffer);
+    return false;
+  }
+
+  vulkan_command_buffer command_buffer;
+  vulkan_command_buffer_allocate_and_begin_single_use(
+      context, context->device.graphics_command_pool, &command_buffer);
+
+  // Anything released by the transfer queue is acquired before being read,
+  // the uploads have completed so there is nothing to wait for.
+  u64 upload_wait_value = 0;
+  vulkan_staging_acquire(&context->staging, &command_buffer,
+                         &upload_wait_value);
+
+  // Allocating again packs the live ranges back to back. Ranges still
+  // waiting on frames in flight belong to the old buffers.
+  vulkan_deletion_queue_drop_geometry_ranges(&context->deletion_queue);
+  geometry_range_allocator_clear(&context->geometry_ranges);
+  for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_COUNT; ++i) {
+    vulkan_geometry_data *data = &context->geometries[i];
+    if (data->id == INVALID_ID) {
+      continue;
+    }
+
+    geometry_range range = {};
+    range.vertex_count = data->vertex_count;
+    range.index_count = data->index_count;
+    geometry_range_allocate(&context->geometry_ranges, &range);
+
+    VkBufferCopy vertex_copy;
+    vertex_copy.srcOffset = data->vertex_offset * sizeof(vertex_3d);
+    vertex_copy.dstOffset = range.vertex_offset * sizeof(vertex_3d);
+    vertex_copy.size = data->vertex_count * sizeof(vertex_3d);
+    vkCmdCopyBuffer(command_buffer.handle, vertex_buffer->handle,
+                    new_vertex_buffer.handle, 1, &vertex_copy);
+    data->vertex_offset = range.vertex_offset;
+
+    if (data->index_count > 0) {
+      VkBufferCopy index_copy;
+      index_copy.srcOffset = data->index_offset * sizeof(u32);
+      index_copy.dstOffset = range.index_offset * sizeof(u32);
+      index_copy.size = data->index_count * sizeof(u32);
+      vkCmdCopyBuffer(command_buffer.handle, index_buffer->handle,
+                      new_index_buffer.handle, 1, &index_copy);
+      data->index_offset = range.index_offset;
+    }
+  }
+
+  // Commands submitted later to the queue, the draws and the copies of the
+  // next compaction, see the copies done.
+  VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                          VK_ACCESS_INDEX_READ_BIT |
+                          VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(
+      command_buffer.handle, VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+      1, &barrier, 0, nullptr, 0, nullptr);
+  vulkan_command_buffer_end(&command_buffer);
+
+  VkSubmitInfo submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &command_buffer.handle;
+  VK_CHECK(vkQueueSubmit(context->device.graphics_queue, 1, &submit_info,
+                         VK_NULL_HANDLE));
+  // The next frame is submitted after the copies, so they are done once it
+  // has completed, and so are the reads of the old buffers.
+  vulkan_deletion_queue_push_command_buffer(context, &context->deletion_queue,
+                                            command_buffer.handle);
+
+  vulkan_deletion_queue_push_buffer(context, &context->deletion_queue,
+                                    vertex_buffer);
+  vulkan_deletion_queue_push_buffer(context, &context->deletion_queue,
+                                    index_buffer);
+  *vertex_buffer = new_vertex_buffer;
+  *index_buffer = new_index_buffer;
+
+  return true;
+}
@@ -3,11 +3,41 @@
 #include "renderer/renderer_backend.h"
 
 bool vulkan_renderer_backend_initialize(renderer_backend *backend,
-                                        const char *application_name);
+                                        const renderer_config *config);
 void vulkan_renderer_backend_shutdown(renderer_backend *backend);
 void vulkan_renderer_backend_on_resized(renderer_backend *backend, u16 width,
                                         u16 height);
 bool vulkan_renderer_backend_begin_frame(renderer_backend *backend,
                                          f32 delta_time);
 bool vulkan_renderer_backend_end_frame(renderer_backend *backend,
-                                       f32 delta_time);
\ No newline at end of file
+                                       f32 delta_time);
+void vulkan_renderer_backend_update_global_state(renderer_backend *backend,
+                                                 mat4 projection, mat4 view);
+
+bool vulkan_renderer_backend_create_geometry(renderer_backend *backend,
+                                             geometry *geometry,
+                                             u32 vertex_count,
+                                             const vertex_3d *vertices,
+                                             u32 index_count,
+                                             const u32 *indices);
+void vulkan_renderer_backend_destroy_geometry(renderer_backend *backend,
+                                              geometry *geometry);
+bool vulkan_renderer_backend_create_texture(renderer_backend *backend,
+                                            texture *texture);
+bool vulkan_renderer_backend_upload_texture_levels(
+    renderer_backend *backend, texture *texture, u32 first_mip,
+    const u8 *const *mip_pixels);
+void vulkan_renderer_backend_destroy_texture(renderer_backend *backend,
+                                             texture *texture);
+bool vulkan_renderer_backend_update_material(renderer_backend *backend,
+                                             const material *material);
+void vulkan_renderer_backend_draw_batches(renderer_backend *backend,
+                                          u32 batch_count,
+                                          const render_batch *batches,
+                                          u32 instance_count,
+                                          const mat4 *transforms);
+bool vulkan_renderer_backend_read_frame(renderer_backend *backend,
+                                        u32 *out_width, u32 *out_height,
+                                        const void **out_pixels);
+bool vulkan_renderer_backend_get_gpu_timings(renderer_backend *backend,
+                                             gpu_timings *out_timings);
@@ -0,0 +1,359 @@
+#include "renderer/vulkan/vulkan_bindless.h"
+#include "renderer/vulkan/vulkan_buffer.h"
+#include "renderer/vulkan/vulkan_deletion_queue.h"
+#include "renderer/vulkan/vulkan_descriptor.h"
+#include "renderer/vulkan/vulkan_image.h"
+#include "renderer/vulkan/vulkan_staging.h"
+#include "renderer/vulkan/vulkan_utils.h"
+
+#include "base/lai_memory.h"
+#include "base/log.h"
+
+#include "math/lai_math.h"
+
+#define BINDLESS_BINDING_MATERIALS 0
+#define BINDLESS_BINDING_SAMPLER 1
+#define BINDLESS_BINDING_TEXTURES 2
+#define BINDLESS_BINDING_COUNT 3
+
+#define MATERIAL_REGION_SIZE                                                   \
+  (sizeof(vulkan_material_data) * (VULKAN_MAX_MATERIAL_COUNT + 1))
+
+static bool create_descriptor_set(vulkan_context *context,
+                                  vulkan_bindless *bindless) {
+  VkDescriptorSetLayoutBinding bindings[BINDLESS_BINDING_COUNT];
+  lai_zero_memory(bindings, sizeof(bindings));
+  bindings[0].binding = BINDLESS_BINDING_MATERIALS;
+  bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  bindings[0].descriptorCount = 1;
+  bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+  bindings[1].binding = BINDLESS_BINDING_SAMPLER;
+  bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+  bindings[1].descriptorCount = 1;
+  bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+  bindings[2].binding = BINDLESS_BINDING_TEXTURES;
+  bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  bindings[2].descriptorCount = VULKAN_MAX_TEXTURE_COUNT;
+  bindings[2].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+  // Free slots are never written, slots are written while frames are
+  // pending that don't sample them.
+  VkDescriptorBindingFlags binding_flags[BINDLESS_BINDING_COUNT] = {
+      0, 0,
+      VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+          VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+          VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT};
+
+  if (!vulkan_descriptor_layout_cache_get(
+          context, &context->descriptor_layout_cache, BINDLESS_BINDING_COUNT,
+          bindings, binding_flags, &bindless->descriptor_set_layout)) {
+    return false;
+  }
+
+  // The set never comes from the shared allocator, its layout needs a pool
+  // created for update after bind.
+  VkDescriptorPoolSize pool_sizes[BINDLESS_BINDING_COUNT];
+  pool_sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  pool_sizes[0].descriptorCount = 1;
+  pool_sizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+  pool_sizes[1].descriptorCount = 1;
+  pool_sizes[2].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  pool_sizes[2].descriptorCount = VULKAN_MAX_TEXTURE_COUNT;
+
+  VkDescriptorPoolCreateInfo pool_info = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+  pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+  pool_info.maxSets = 1;
+  pool_info.poolSizeCount = BINDLESS_BINDING_COUNT;
+  pool_info.pPoolSizes = pool_sizes;
+  VkResult result =
+      vkCreateDescriptorPool(context->device.logical_device, &pool_info,
+                             context->allocator, &bindless->descriptor_pool);
+  if (!vulkan_result_is_success(result)) {
+    LAI_LOG_ERROR("vkCreateDescriptorPool failed with %s.",
+                  vulkan_result_string(result, true));
+    return false;
+  }
+
+  VkDescriptorSetAllocateInfo allocate_info = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+  allocate_info.descriptorPool = bindless->descriptor_pool;
+  allocate_info.descriptorSetCount = 1;
+  allocate_info.pSetLayouts = &bindless->descriptor_set_layout;
+  result = vkAllocateDescriptorSets(context->device.logical_device,
+                                    &allocate_info, &bindless->descriptor_set);
+  if (!vulkan_result_is_success(result)) {
+    LAI_LOG_ERROR("vkAllocateDescriptorSets failed with %s.",
+                  vulkan_result_string(result, true));
+    return false;
+  }
+
+  VkDescriptorBufferInfo buffer_info;
+  buffer_info.buffer = bindless->material_buffer.handle;
+  buffer_info.offset = 0;
+  buffer_info.range = VK_WHOLE_SIZE;
+  VkDescriptorImageInfo sampler_info;
+  lai_zero_memory(&sampler_info, sizeof(VkDescriptorImageInfo));
+  sampler_info.sampler = bindless->sampler;
+
+  VkWriteDescriptorSet writes[2];
+  lai_zero_memory(writes, sizeof(writes));
+  writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  writes[0].dstSet = bindless->descriptor_set;
+  writes[0].dstBinding = BINDLESS_BINDING_MATERIALS;
+  writes[0].descriptorCount = 1;
+  writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  writes[0].pBufferInfo = &buffer_info;
+  writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  writes[1].dstSet = bindless->descriptor_set;
+  writes[1].dstBinding = BINDLESS_BINDING_SAMPLER;
+  writes[1].descriptorCount = 1;
+  writes[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+  writes[1].pImageInfo = &sampler_info;
+  vkUpdateDescriptorSets(context->device.logical_device, 2, writes, 0,
+                         nullptr);
+  return true;
+}
+
+static bool create_sampler(vulkan_context *context,
+                           vulkan_bindless *bindless) {
+  VkSamplerCreateInfo sampler_info = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+  sampler_info.magFilter = VK_FILTER_LINEAR;
+  sampler_info.minFilter = VK_FILTER_LINEAR;
+  sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  sampler_info.minLod = 0.0f;
+  sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+  sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+  VkResult result =
+      vkCreateSampler(context->device.logical_device, &sampler_info,
+                      context->allocator, &bindless->sampler);
+  if (!vulkan_result_is_success(result)) {
+    LAI_LOG_ERROR("vkCreateSampler failed with %s.",
+                  vulkan_result_string(result, true));
+    return false;
+  }
+  return true;
+}
+
+// Creates an image of the levels in a free slot of the texture array
+static bool create_slot(vulkan_context *context, vulkan_bindless *bindless,
+                        u32 width, u32 height, u32 mip_levels,
+                        const u8 *const *levels, u32 *out_slot) {
+  u32 slot = INVALID_ID;
+  for (u32 i = 0; i < VULKAN_MAX_TEXTURE_COUNT; ++i) {
+    if (!bindless->textures[i].in_use) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot == INVALID_ID) {
+    LAI_LOG_ERROR("No free slot in the texture array, increase "
+                  "VULKAN_MAX_TEXTURE_COUNT");
+    return false;
+  }
+
+  vulkan_texture_data *texture = &bindless->textures[slot];
+  vulkan_image_create(context, VK_IMAGE_TYPE_2D, width, height, mip_levels,
+                      VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+                      VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                          VK_IMAGE_USAGE_SAMPLED_BIT,
+                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true,
+                      VK_IMAGE_ASPECT_COLOR_BIT, &texture->image);
+  if (!texture->image.allocation.memory) {
+    vulkan_image_destroy(context, &texture->image);
+    return false;
+  }
+
+  // Sampled once the frame waits for the upload, which covers the layout
+  // transitions too. Coarse levels go first.
+  for (u32 i = mip_levels; i-- > 0;) {
+    u32 level_width = width >> i ? width >> i : 1;
+    u32 level_height = height >> i ? height >> i : 1;
+    if (!vulkan_staging_upload_image(context, &context->staging,
+                                     &texture->image, i, level_width,
+                                     level_height, 4, levels[i])) {
+      // Copies already recorded may still write it.
+      vulkan_deletion_queue_push_image(context, &context->deletion_queue,
+                                       &texture->image);
+      return false;
+    }
+  }
+
+  VkDescriptorImageInfo image_info;
+  image_info.sampler = nullptr;
+  image_info.imageView = texture->image.view;
+  image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+  write.dstSet = bindless->descriptor_set;
+  write.dstBinding = BINDLESS_BINDING_TEXTURES;
+  write.dstArrayElement = slot;
+  write.descriptorCount = 1;
+  write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  write.pImageInfo = &image_info;
+  vkUpdateDescriptorSets(context->device.logical_device, 1, &write, 0,
+                         nullptr);
+
+  texture->in_use = true;
+  *out_slot = slot;
+  return true;
+}
+
+// The image and the slot are released once no frame in flight samples them.
+static void retire_slot(vulkan_context *context, vulkan_bindless *bindless,
+                        u32 slot) {
+  if (slot == VULKAN_DEFAULT_TEXTURE_SLOT) {
+    return;
+  }
+  // The descriptor is left stale, nothing samples a free slot.
+  vulkan_deletion_queue_push_image(context, &context->deletion_queue,
+                                   &bindless->textures[slot].image);
+  vulkan_deletion_queue_push_texture_slot(context, &context->deletion_queue,
+                                          slot);
+}
+
+bool vulkan_bindless_create(vulkan_context *context, u32 frame_count,
+                            vulkan_bindless *out_bindless) {
+  lai_zero_memory(out_bindless, sizeof(vulkan_bindless));
+  for (u32 i = 0; i < VULKAN_MAX_TEXTURE_COUNT; ++i) {
+    out_bindless->handle_slots[i] = INVALID_ID;
+  }
+
+  out_bindless->region_count = frame_count;
+  if (!vulkan_buffer_create(context, MATERIAL_REGION_SIZE * frame_count,
+                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            true, &out_bindless->material_buffer)) {
+    LAI_LOG_ERROR("Error creating the material buffer");
+    return false;
+  }
+
+  if (!create_sampler(context, out_bindless) ||
+      !create_descriptor_set(context, out_bindless)) {
+    return false;
+  }
+
+  u32 white = 0xffffffff;
+  const u8 *white_level = (const u8 *)&white;
+  u32 default_slot;
+  if (!create_slot(context, out_bindless, 1, 1, 1, &white_level,
+                   &default_slot)) {
+    LAI_LOG_ERROR("Error creating the default texture");
+    return false;
+  }
+  LAI_ASSERT_MESSAGE(default_slot == VULKAN_DEFAULT_TEXTURE_SLOT,
+                     "The default texture takes the first slot");
+
+  vulkan_material_data default_material;
+  lai_zero_memory(&default_material, sizeof(vulkan_material_data));
+  default_material.diffuse_color = vec4_one();
+  default_material.diffuse_texture_index = INVALID_ID;
+  for (u32 i = 0; i <= VULKAN_MAX_MATERIAL_COUNT; ++i) {
+    vulkan_bindless_write_material(out_bindless, i, &default_material);
+  }
+  return true;
+}
+
+void vulkan_bindless_destroy(vulkan_context *context,
+                             vulkan_bindless *bindless) {
+  for (u32 i = 0; i < VULKAN_MAX_TEXTURE_COUNT; ++i) {
+    if (bindless->textures[i].image.handle) {
+      vulkan_image_destroy(context, &bindless->textures[i].image);
+    }
+  }
+  if (bindless->sampler) {
+    vkDestroySampler(context->device.logical_device, bindless->sampler,
+                     context->allocator);
+  }
+  // Frees the set too, the layout belongs to the cache.
+  if (bindless->descriptor_pool) {
+    vkDestroyDescriptorPool(context->device.logical_device,
+                            bindless->descriptor_pool, context->allocator);
+  }
+  vulkan_buffer_destroy(context, &bindless->material_buffer);
+  lai_zero_memory(bindless, sizeof(vulkan_bindless));
+}
+
+bool vulkan_bindless_create_texture(vulkan_bindless *bindless,
+                                    u32 *out_handle) {
+  for (u32 i = 0; i < VULKAN_MAX_TEXTURE_COUNT; ++i) {
+    if (bindless->handle_slots[i] == INVALID_ID) {
+      bindless->handle_slots[i] = VULKAN_DEFAULT_TEXTURE_SLOT;
+      *out_handle = i;
+      return true;
+    }
+  }
+  LAI_LOG_ERROR("vulkan_bindless_create_texture failed to find a free "
+                "handle, increase VULKAN_MAX_TEXTURE_COUNT");
+  return false;
+}
+
+bool vulkan_bindless_upload_texture(vulkan_context *context,
+                                    vulkan_bindless *bindless, u32 handle,
+                                    u32 width, u32 height, u32 mip_levels,
+                                    const u8 *const *levels) {
+  if (handle >= VULKAN_MAX_TEXTURE_COUNT ||
+      bindless->handle_slots[handle] == INVALID_ID) {
+    return false;
+  }
+
+  // Frames in flight keep sampling the old slot, materials move to the new
+  // one with the next refresh of their region.
+  u32 slot;
+  if (!create_slot(context, bindless, width, height, mip_levels, levels,
+                   &slot)) {
+    return false;
+  }
+  retire_slot(context, bindless, bindless->handle_slots[handle]);
+  bindless->handle_slots[handle] = slot;
+  bindless->stale_region_count = bindless->region_count;
+  return true;
+}
+
+void vulkan_bindless_destroy_texture(vulkan_context *context,
+                                     vulkan_bindless *bindless, u32 handle) {
+  if (handle >= VULKAN_MAX_TEXTURE_COUNT ||
+      bindless->handle_slots[handle] == INVALID_ID) {
+    return;
+  }
+  retire_slot(context, bindless, bindless->handle_slots[handle]);
+  bindless->handle_slots[handle] = INVALID_ID;
+  bindless->stale_region_count = bindless->region_count;
+}
+
+void vulkan_bindless_write_material(vulkan_bindless *bindless, u32 slot,
+                                    const vulkan_material_data *data) {
+  if (slot > VULKAN_MAX_MATERIAL_COUNT) {
+    return;
+  }
+  bindless->materials[slot] = *data;
+  bindless->stale_region_count = bindless->region_count;
+}
+
+void vulkan_bindless_begin_frame(vulkan_bindless *bindless, u32 frame_index) {
+  bindless->frame_material_base =
+      frame_index * (VULKAN_MAX_MATERIAL_COUNT + 1);
+  if (bindless->stale_region_count == 0) {
+    return;
+  }
+
+  // Frames in flight take turns, the next region_count frames refresh every
+  // region.
+  vulkan_material_data *region =
+      (vulkan_material_data *)bindless->material_buffer.allocation.mapped +
+      bindless->frame_material_base;
+  for (u32 i = 0; i <= VULKAN_MAX_MATERIAL_COUNT; ++i) {
+    u32 handle = bindless->materials[i].diffuse_texture_index;
+    u32 slot = VULKAN_DEFAULT_TEXTURE_SLOT;
+    if (handle < VULKAN_MAX_TEXTURE_COUNT &&
+        bindless->handle_slots[handle] != INVALID_ID) {
+      slot = bindless->handle_slots[handle];
+    }
+    region[i] = bindless->materials[i];
+    region[i].diffuse_texture_index = slot;
+  }
+  bindless->stale_region_count--;
+}
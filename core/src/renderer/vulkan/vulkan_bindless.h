@@ -0,0 +1,39 @@
+#pragma once
+
+#include "renderer/vulkan/vulkan_types.inl"
+
+// Needs the context's staging ring and descriptor layout cache. Creates the
+// default texture and material.
+bool vulkan_bindless_create(vulkan_context *context, u32 frame_count,
+                            vulkan_bindless *out_bindless);
+
+// The device must be idle
+void vulkan_bindless_destroy(vulkan_context *context,
+                             vulkan_bindless *bindless);
+
+// Reserves a texture handle, which samples the default texture until levels
+// are uploaded for it.
+bool vulkan_bindless_create_texture(vulkan_bindless *bindless,
+                                    u32 *out_handle);
+
+// Makes levels, RGBA8 from width * height down, the handle's resident
+// levels. They replace the previous ones in the frames recorded after the
+// next flush of the staging ring.
+bool vulkan_bindless_upload_texture(vulkan_context *context,
+                                    vulkan_bindless *bindless, u32 handle,
+                                    u32 width, u32 height, u32 mip_levels,
+                                    const u8 *const *levels);
+
+// The handle is free right away, its levels are released once no frame in
+// flight samples them.
+void vulkan_bindless_destroy_texture(vulkan_context *context,
+                                     vulkan_bindless *bindless, u32 handle);
+
+// Seen by the frames begun after it. diffuse_texture_index is a texture
+// handle, INVALID_ID for none.
+void vulkan_bindless_write_material(vulkan_bindless *bindless, u32 slot,
+                                    const vulkan_material_data *data);
+
+// Brings the frame's region of the material buffer up to date, the frame in
+// flight must have completed.
+void vulkan_bindless_begin_frame(vulkan_bindless *bindless, u32 frame_index);
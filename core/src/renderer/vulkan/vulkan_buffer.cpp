@@ -1,7 +1,7 @@
 #include "renderer/vulkan/vulkan_buffer.h"
 
-#include "renderer/vulkan/vulkan_command_buffer.h"
 #include "renderer/vulkan/vulkan_device.h"
+#include "renderer/vulkan/vulkan_memory_allocator.h"
 #include "renderer/vulkan/vulkan_utils.h"
 
 #include "base/lai_memory.h"
@@ -38,20 +38,12 @@ bool vulkan_buffer_create(vulkan_context *context, u64 size,
     return false;
   }
 
-  // Allocate memory info
-  VkMemoryAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-  allocate_info.allocationSize = requirements.size;
-  allocate_info.memoryTypeIndex = (u32)out_buffer->memory_index;
-
-  // Allocate the memory.
-  VkResult result =
-      vkAllocateMemory(context->device.logical_device, &allocate_info,
-                       context->allocator, &out_buffer->memory);
-
-  if (result != VK_SUCCESS) {
+  // Sub-allocate from a larger block.
+  if (!vulkan_memory_allocate(context, &requirements,
+                              out_buffer->memory_property_flags, true,
+                              &out_buffer->allocation)) {
     LAI_LOG_ERROR("Unable to create vulkan buffer because the required memory "
-                  "allocation failed. Error: %i",
-                  result);
+                  "allocation failed.");
     return false;
   }
 
@@ -63,11 +55,7 @@ bool vulkan_buffer_create(vulkan_context *context, u64 size,
 }
 
 void vulkan_buffer_destroy(vulkan_context *context, vulkan_buffer *buffer) {
-  if (buffer->memory) {
-    vkFreeMemory(context->device.logical_device, buffer->memory,
-                 context->allocator);
-    buffer->memory = 0;
-  }
+  vulkan_memory_free(context, &buffer->allocation);
   if (buffer->handle) {
     vkDestroyBuffer(context->device.logical_device, buffer->handle,
                     context->allocator);
@@ -78,130 +66,57 @@ void vulkan_buffer_destroy(vulkan_context *context, vulkan_buffer *buffer) {
   buffer->is_locked = false;
 }
 
-bool vulkan_buffer_resize(vulkan_context *context, u64 new_size,
-                          vulkan_buffer *buffer, VkQueue queue,
-                          VkCommandPool pool) {
-  // Sanity check.
-  if (new_size < buffer->total_size) {
-    LAI_LOG_ERROR("vulkan_buffer_resize requires that new size be larger than "
-                  "the old. Not doing this could lead to data loss.");
-    return false;
-  }
-
-  buffer->total_size = new_size;
-
-  // Create new buffer.
-  VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
-  buffer_info.size = new_size;
-  buffer_info.usage = buffer->usage;
-  buffer_info.sharingMode =
-      VK_SHARING_MODE_EXCLUSIVE; // NOTE: Only used in one queue.
-
-  VkBuffer new_buffer;
-  VK_CHECK(vkCreateBuffer(context->device.logical_device, &buffer_info,
-                          context->allocator, &new_buffer));
-
-  // Gather memory requirements.
-  VkMemoryRequirements requirements;
-  vkGetBufferMemoryRequirements(context->device.logical_device, new_buffer,
-                                &requirements);
-
-  // Allocate memory info
-  VkMemoryAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-  allocate_info.allocationSize = requirements.size;
-  allocate_info.memoryTypeIndex = (u32)buffer->memory_index;
-
-  // Allocate the memory.
-  VkDeviceMemory new_memory;
-  VkResult result =
-      vkAllocateMemory(context->device.logical_device, &allocate_info,
-                       context->allocator, &new_memory);
-  if (result != VK_SUCCESS) {
-    LAI_LOG_ERROR("Unable to resize vulkan buffer because the required memory "
-                  "allocation failed. Error: %i",
-                  result);
-    return false;
-  }
-
-  // Bind the new buffer's memory
-  VK_CHECK(vkBindBufferMemory(context->device.logical_device, new_buffer,
-                              new_memory, 0));
-
-  // Copy over the data
-  vulkan_buffer_copy_to(context, pool, 0, queue, buffer->handle, 0, new_buffer,
-                        0, buffer->total_size);
-
-  // Make sure anything potentially using these is finished.
-  vkDeviceWaitIdle(context->device.logical_device);
-
-  // Destroy the old
-  if (buffer->memory) {
-    vkFreeMemory(context->device.logical_device, buffer->memory,
-                 context->allocator);
-    buffer->memory = 0;
-  }
-  if (buffer->handle) {
-    vkDestroyBuffer(context->device.logical_device, buffer->handle,
-                    context->allocator);
-    buffer->handle = 0;
-  }
-
-  // Set new properties
-  buffer->total_size = new_size;
-  buffer->memory = new_memory;
-  buffer->handle = new_buffer;
-
-  return true;
-}
-
 void vulkan_buffer_bind(vulkan_context *context, vulkan_buffer *buffer,
                         u64 offset) {
   VK_CHECK(vkBindBufferMemory(context->device.logical_device, buffer->handle,
-                              buffer->memory, offset));
+                              buffer->allocation.memory,
+                              buffer->allocation.offset + offset));
 }
 
 void *vulkan_buffer_lock_memory(vulkan_context *context, vulkan_buffer *buffer,
                                 u64 offset, u64 size, u32 flags) {
-  void *data;
-  VK_CHECK(vkMapMemory(context->device.logical_device, buffer->memory, offset,
-                       size, flags, &data));
-  return data;
+  // Host visible blocks are mapped once when they are created.
+  if (!buffer->allocation.mapped) {
+    LAI_LOG_ERROR("vulkan_buffer_lock_memory called on a buffer that is not "
+                  "host visible");
+    return nullptr;
+  }
+  if (offset > buffer->total_size || size > buffer->total_size - offset) {
+    LAI_LOG_ERROR("vulkan_buffer_lock_memory range %llu+%llu is outside the "
+                  "%llu byte buffer",
+                  offset, size, buffer->total_size);
+    return nullptr;
+  }
+  // Reserved like the flags of vkMapMemory
+  if (flags != 0) {
+    LAI_LOG_ERROR("vulkan_buffer_lock_memory flags must be 0, got %u", flags);
+    return nullptr;
+  }
+  buffer->is_locked = true;
+  return (u8 *)buffer->allocation.mapped + offset;
 }
 
 void vulkan_buffer_unlock_memory(vulkan_context *context,
                                  vulkan_buffer *buffer) {
-  vkUnmapMemory(context->device.logical_device, buffer->memory);
+  if (!(buffer->memory_property_flags &
+        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+    VkMappedMemoryRange range = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE};
+    range.memory = buffer->allocation.memory;
+    range.offset = buffer->allocation.offset;
+    range.size = buffer->allocation.size;
+    VK_CHECK(vkFlushMappedMemoryRanges(context->device.logical_device, 1,
+                                       &range));
+  }
+  buffer->is_locked = false;
 }
 
 void vulkan_buffer_load_data(vulkan_context *context, vulkan_buffer *buffer,
                              u64 offset, u64 size, u32 flags,
                              const void *data) {
-  void *data_ptr;
-  VK_CHECK(vkMapMemory(context->device.logical_device, buffer->memory, offset,
-                       size, flags, &data_ptr));
-  lai_copy_memory(data_ptr, data, size);
-  vkUnmapMemory(context->device.logical_device, buffer->memory);
+  void *data_ptr =
+      vulkan_buffer_lock_memory(context, buffer, offset, size, flags);
+  if (data_ptr) {
+    lai_copy_memory(data_ptr, data, size);
+    vulkan_buffer_unlock_memory(context, buffer);
+  }
 }
-
-void vulkan_buffer_copy_to(vulkan_context *context, VkCommandPool pool,
-                           VkFence fence, VkQueue queue, VkBuffer source,
-                           u64 source_offset, VkBuffer dest, u64 dest_offset,
-                           u64 size) {
-  vkQueueWaitIdle(queue);
-  // Create a one-time-use command buffer.
-  vulkan_command_buffer temp_command_buffer;
-  vulkan_command_buffer_allocate_and_begin_single_use(context, pool,
-                                                      &temp_command_buffer);
-
-  // Prepare the copy command and add it to the command buffer.
-  VkBufferCopy copy_region;
-  copy_region.srcOffset = source_offset;
-  copy_region.dstOffset = dest_offset;
-  copy_region.size = size;
-
-  vkCmdCopyBuffer(temp_command_buffer.handle, source, dest, 1, &copy_region);
-
-  // Submit the buffer for execution and wait for it to complete.
-  vulkan_command_buffer_end_single_use(context, pool, &temp_command_buffer,
-                                       queue);
-}
\ No newline at end of file
@@ -9,10 +9,6 @@ bool vulkan_buffer_create(vulkan_context *context, u64 size,
 
 void vulkan_buffer_destroy(vulkan_context *context, vulkan_buffer *buffer);
 
-bool vulkan_buffer_resize(vulkan_context *context, u64 new_size,
-                          vulkan_buffer *buffer, VkQueue queue,
-                          VkCommandPool pool);
-
 void vulkan_buffer_bind(vulkan_context *context, vulkan_buffer *buffer,
                         u64 offset);
 
@@ -23,9 +19,4 @@ void vulkan_buffer_unlock_memory(vulkan_context *context,
                                  vulkan_buffer *buffer);
 
 void vulkan_buffer_load_data(vulkan_context *context, vulkan_buffer *buffer,
-                             u64 offset, u64 size, u32 flags, const void *data);
-
-void vulkan_buffer_copy_to(vulkan_context *context, VkCommandPool pool,
-                           VkFence fence, VkQueue queue, VkBuffer source,
-                           u64 source_offset, VkBuffer dest, u64 dest_offset,
-                           u64 size);
\ No newline at end of file
+                             u64 offset, u64 size, u32 flags, const void *data);
\ No newline at end of file
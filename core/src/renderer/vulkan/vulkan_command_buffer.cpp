@@ -1,6 +1,31 @@
 #include "renderer/vulkan/vulkan_command_buffer.h"
 #include "base/lai_memory.h"
 
+void vulkan_command_pool_create(vulkan_context *context, u32 queue_family_index,
+                                VkCommandPoolCreateFlags flags,
+                                VkCommandPool *out_pool) {
+  VkCommandPoolCreateInfo pool_create_info = {
+      VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+  pool_create_info.queueFamilyIndex = queue_family_index;
+  pool_create_info.flags = flags;
+  VK_CHECK(vkCreateCommandPool(context->device.logical_device,
+                               &pool_create_info, context->allocator,
+                               out_pool));
+}
+
+void vulkan_command_pool_destroy(vulkan_context *context, VkCommandPool *pool) {
+  // Frees its command buffers as well.
+  if (*pool) {
+    vkDestroyCommandPool(context->device.logical_device, *pool,
+                         context->allocator);
+    *pool = nullptr;
+  }
+}
+
+void vulkan_command_pool_reset(vulkan_context *context, VkCommandPool pool) {
+  VK_CHECK(vkResetCommandPool(context->device.logical_device, pool, 0));
+}
+
 void vulkan_command_buffer_allocate(vulkan_context *context, VkCommandPool pool,
                                     bool is_primary,
                                     vulkan_command_buffer *out_command_buffer) {
@@ -57,6 +82,25 @@ void vulkan_command_buffer_begin(vulkan_command_buffer *out_command_buffer,
   out_command_buffer->state = COMMAND_BUFFER_STATE_RECORDING;
 }
 
+void vulkan_command_buffer_begin_secondary(
+    vulkan_command_buffer *out_command_buffer, VkRenderPass renderpass,
+    VkFramebuffer framebuffer) {
+  VkCommandBufferInheritanceInfo inheritance_info = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+  inheritance_info.renderPass = renderpass;
+  inheritance_info.subpass = 0;
+  inheritance_info.framebuffer = framebuffer;
+
+  VkCommandBufferBeginInfo begin_info = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                     VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+  begin_info.pInheritanceInfo = &inheritance_info;
+
+  VK_CHECK(vkBeginCommandBuffer(out_command_buffer->handle, &begin_info));
+  out_command_buffer->state = COMMAND_BUFFER_STATE_IN_RENDERPASS;
+}
+
 void vulkan_command_buffer_end(vulkan_command_buffer *command_buffer) {
   VK_CHECK(vkEndCommandBuffer(command_buffer->handle));
   command_buffer->state = COMMAND_BUFFER_STATE_RECORDING_ENDED;
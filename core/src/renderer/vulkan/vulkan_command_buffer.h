@@ -2,6 +2,17 @@
 
 #include "renderer/vulkan/vulkan_types.inl"
 
+void vulkan_command_pool_create(vulkan_context *context, u32 queue_family_index,
+                                VkCommandPoolCreateFlags flags,
+                                VkCommandPool *out_pool);
+
+void vulkan_command_pool_destroy(vulkan_context *context, VkCommandPool *pool);
+
+// Resets every buffer allocated from the pool at once, none of them may be
+// pending on the gpu. Their vulkan_command_buffer_reset is still up to the
+// caller.
+void vulkan_command_pool_reset(vulkan_context *context, VkCommandPool pool);
+
 void vulkan_command_buffer_allocate(vulkan_context *context, VkCommandPool pool,
                                     bool is_primary,
                                     vulkan_command_buffer *out_command_buffer);
@@ -14,11 +25,17 @@ void vulkan_command_buffer_begin(vulkan_command_buffer *out_command_buffer,
                                  bool is_renderpass_continue,
                                  bool is_simultaneous_use);
 
+// Begins a secondary command buffer that continues subpass 0 of renderpass
+void vulkan_command_buffer_begin_secondary(
+    vulkan_command_buffer *out_command_buffer, VkRenderPass renderpass,
+    VkFramebuffer framebuffer);
+
 void vulkan_command_buffer_end(vulkan_command_buffer *command_buffer);
 
 void vulkan_command_buffer_update_submitted(
     vulkan_command_buffer *command_buffer);
 
+// Only tracks the state, the buffer itself is reset with its pool
 void vulkan_command_buffer_reset(vulkan_command_buffer *command_buffer);
 
 void vulkan_command_buffer_allocate_and_begin_single_use(
@@ -0,0 +1,170 @@
+#include "renderer/vulkan/vulkan_deletion_queue.h"
+#include "renderer/vulkan/vulkan_buffer.h"
+#include "renderer/vulkan/vulkan_image.h"
+
+#include "base/lai_memory.h"
+
+#include "containers/darray.h"
+
+static void push_entry(vulkan_context *context, vulkan_deletion_queue *queue,
+                       vulkan_deletion_entry *entry) {
+  // The frame being recorded, or the next one, may still use the handle.
+  entry->frame_number = context->submitted_frame_number + 1;
+  darray_push(queue->entries, *entry);
+}
+
+static void destroy_entry(vulkan_context *context,
+                          vulkan_deletion_entry *entry) {
+  VkDevice device = context->device.logical_device;
+  switch (entry->type) {
+  case VULKAN_DELETION_TYPE_SWAPCHAIN:
+    vkDestroySwapchainKHR(device, entry->swapchain, context->allocator);
+    break;
+  case VULKAN_DELETION_TYPE_FRAMEBUFFER:
+    vkDestroyFramebuffer(device, entry->framebuffer, context->allocator);
+    break;
+  case VULKAN_DELETION_TYPE_IMAGE_VIEW:
+    vkDestroyImageView(device, entry->image_view, context->allocator);
+    break;
+  case VULKAN_DELETION_TYPE_IMAGE:
+    vulkan_image_destroy(context, &entry->image);
+    break;
+  case VULKAN_DELETION_TYPE_BUFFER:
+    vulkan_buffer_destroy(context, &entry->buffer);
+    break;
+  case VULKAN_DELETION_TYPE_GEOMETRY_RANGES:
+    geometry_range_free(&context->geometry_ranges, &entry->geometry_ranges);
+    break;
+  case VULKAN_DELETION_TYPE_TEXTURE_SLOT:
+    context->bindless.textures[entry->texture_slot].in_use = false;
+    break;
+  case VULKAN_DELETION_TYPE_COMMAND_BUFFER:
+    vkFreeCommandBuffers(device, context->device.graphics_command_pool, 1,
+                         &entry->command_buffer);
+    break;
+  }
+}
+
+void vulkan_deletion_queue_create(vulkan_deletion_queue *out_queue) {
+  out_queue->entries = darray_create(vulkan_deletion_entry);
+}
+
+void vulkan_deletion_queue_destroy(vulkan_context *context,
+                                   vulkan_deletion_queue *queue) {
+  if (!queue->entries) {
+    return;
+  }
+
+  u32 entry_count = darray_length(queue->entries);
+  for (u32 i = 0; i < entry_count; ++i) {
+    destroy_entry(context, &queue->entries[i]);
+  }
+  darray_destroy(queue->entries);
+  queue->entries = nullptr;
+}
+
+void vulkan_deletion_queue_push_swapchain(vulkan_context *context,
+                                          vulkan_deletion_queue *queue,
+                                          VkSwapchainKHR swapchain) {
+  vulkan_deletion_entry entry;
+  entry.type = VULKAN_DELETION_TYPE_SWAPCHAIN;
+  entry.swapchain = swapchain;
+  push_entry(context, queue, &entry);
+}
+
+void vulkan_deletion_queue_push_framebuffer(vulkan_context *context,
+                                            vulkan_deletion_queue *queue,
+                                            VkFramebuffer framebuffer) {
+  vulkan_deletion_entry entry;
+  entry.type = VULKAN_DELETION_TYPE_FRAMEBUFFER;
+  entry.framebuffer = framebuffer;
+  push_entry(context, queue, &entry);
+}
+
+void vulkan_deletion_queue_push_image_view(vulkan_context *context,
+                                           vulkan_deletion_queue *queue,
+                                           VkImageView image_view) {
+  vulkan_deletion_entry entry;
+  entry.type = VULKAN_DELETION_TYPE_IMAGE_VIEW;
+  entry.image_view = image_view;
+  push_entry(context, queue, &entry);
+}
+
+void vulkan_deletion_queue_push_image(vulkan_context *context,
+                                      vulkan_deletion_queue *queue,
+                                      vulkan_image *image) {
+  vulkan_deletion_entry entry;
+  entry.type = VULKAN_DELETION_TYPE_IMAGE;
+  entry.image = *image;
+  push_entry(context, queue, &entry);
+  lai_zero_memory(image, sizeof(vulkan_image));
+}
+
+void vulkan_deletion_queue_push_buffer(vulkan_context *context,
+                                       vulkan_deletion_queue *queue,
+                                       vulkan_buffer *buffer) {
+  vulkan_deletion_entry entry;
+  entry.type = VULKAN_DELETION_TYPE_BUFFER;
+  entry.buffer = *buffer;
+  push_entry(context, queue, &entry);
+  lai_zero_memory(buffer, sizeof(vulkan_buffer));
+}
+
+void vulkan_deletion_queue_push_geometry_ranges(
+    vulkan_context *context, vulkan_deletion_queue *queue,
+    const geometry_range *ranges) {
+  vulkan_deletion_entry entry;
+  entry.type = VULKAN_DELETION_TYPE_GEOMETRY_RANGES;
+  entry.geometry_ranges = *ranges;
+  push_entry(context, queue, &entry);
+}
+
+void vulkan_deletion_queue_push_texture_slot(vulkan_context *context,
+                                             vulkan_deletion_queue *queue,
+                                             u32 texture_slot) {
+  vulkan_deletion_entry entry;
+  entry.type = VULKAN_DELETION_TYPE_TEXTURE_SLOT;
+  entry.texture_slot = texture_slot;
+  push_entry(context, queue, &entry);
+}
+
+void vulkan_deletion_queue_push_command_buffer(
+    vulkan_context *context, vulkan_deletion_queue *queue,
+    VkCommandBuffer command_buffer) {
+  vulkan_deletion_entry entry;
+  entry.type = VULKAN_DELETION_TYPE_COMMAND_BUFFER;
+  entry.command_buffer = command_buffer;
+  push_entry(context, queue, &entry);
+}
+
+void vulkan_deletion_queue_drop_geometry_ranges(vulkan_deletion_queue *queue) {
+  u32 entry_count = darray_length(queue->entries);
+  u32 kept_count = 0;
+  for (u32 i = 0; i < entry_count; ++i) {
+    if (queue->entries[i].type != VULKAN_DELETION_TYPE_GEOMETRY_RANGES) {
+      queue->entries[kept_count++] = queue->entries[i];
+    }
+  }
+  darray_length_set(queue->entries, kept_count);
+}
+
+void vulkan_deletion_queue_flush(vulkan_context *context,
+                                 vulkan_deletion_queue *queue) {
+  u32 entry_count = darray_length(queue->entries);
+  u32 done_count = 0;
+  while (done_count < entry_count &&
+         queue->entries[done_count].frame_number <=
+             context->completed_frame_number) {
+    destroy_entry(context, &queue->entries[done_count]);
+    done_count++;
+  }
+  if (done_count == 0) {
+    return;
+  }
+
+  // Keeps the order of what is left.
+  for (u32 i = done_count; i < entry_count; ++i) {
+    queue->entries[i - done_count] = queue->entries[i];
+  }
+  darray_length_set(queue->entries, entry_count - done_count);
+}
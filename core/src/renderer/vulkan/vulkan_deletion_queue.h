@@ -0,0 +1,54 @@
+#pragma once
+
+#include "renderer/vulkan/vulkan_types.inl"
+
+void vulkan_deletion_queue_create(vulkan_deletion_queue *out_queue);
+
+// Destroys everything still queued, the device must be idle
+void vulkan_deletion_queue_destroy(vulkan_context *context,
+                                   vulkan_deletion_queue *queue);
+
+// Handles are kept until the frame being recorded, or the next one when none
+// is, has completed. Frames submitted before it complete first.
+void vulkan_deletion_queue_push_swapchain(vulkan_context *context,
+                                          vulkan_deletion_queue *queue,
+                                          VkSwapchainKHR swapchain);
+void vulkan_deletion_queue_push_framebuffer(vulkan_context *context,
+                                            vulkan_deletion_queue *queue,
+                                            VkFramebuffer framebuffer);
+void vulkan_deletion_queue_push_image_view(vulkan_context *context,
+                                           vulkan_deletion_queue *queue,
+                                           VkImageView image_view);
+// Takes over the image, its view and its memory
+void vulkan_deletion_queue_push_image(vulkan_context *context,
+                                      vulkan_deletion_queue *queue,
+                                      vulkan_image *image);
+// Takes over the buffer and its memory
+void vulkan_deletion_queue_push_buffer(vulkan_context *context,
+                                       vulkan_deletion_queue *queue,
+                                       vulkan_buffer *buffer);
+// The ranges stay allocated, so new uploads can't overwrite vertices that
+// frames in flight still draw.
+void vulkan_deletion_queue_push_geometry_ranges(
+    vulkan_context *context, vulkan_deletion_queue *queue,
+    const geometry_range *ranges);
+
+// The slot's texture has to be pushed as an image, the slot is only handed
+// out again once no frame in flight can sample it.
+void vulkan_deletion_queue_push_texture_slot(vulkan_context *context,
+                                             vulkan_deletion_queue *queue,
+                                             u32 texture_slot);
+
+// A command buffer of the device's graphics command pool submitted to the
+// graphics queue ahead of the next frame, which completes after it
+void vulkan_deletion_queue_push_command_buffer(
+    vulkan_context *context, vulkan_deletion_queue *queue,
+    VkCommandBuffer command_buffer);
+
+// Forgets the queued geometry ranges without freeing them, for when the
+// freelists are rebuilt from the live geometries.
+void vulkan_deletion_queue_drop_geometry_ranges(vulkan_deletion_queue *queue);
+
+// Destroys the handles of every frame up to context->completed_frame_number
+void vulkan_deletion_queue_flush(vulkan_context *context,
+                                 vulkan_deletion_queue *queue);
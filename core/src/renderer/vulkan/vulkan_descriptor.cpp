@@ -0,0 +1,267 @@
+#include "renderer/vulkan/vulkan_descriptor.h"
+#include "renderer/vulkan/vulkan_utils.h"
+
+#include "base/lai_memory.h"
+#include "base/log.h"
+
+#include "containers/darray.h"
+
+// Pools never grow past this many sets
+#define VULKAN_DESCRIPTOR_MAX_SETS_PER_POOL 4096
+
+struct descriptor_pool_ratio {
+  VkDescriptorType type;
+  // Descriptors of the type per set in the pool
+  f32 ratio;
+};
+
+static const descriptor_pool_ratio pool_ratios[] = {
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2.0f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4.0f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f},
+    {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+};
+
+#define POOL_RATIO_COUNT (sizeof(pool_ratios) / sizeof(pool_ratios[0]))
+
+static u64 hash_bindings(u32 binding_count,
+                         const VkDescriptorSetLayoutBinding *bindings,
+                         const VkDescriptorBindingFlags *binding_flags) {
+  // FNV-1a over the fields that make bindings equal
+  u64 hash = 14695981039346656037ull;
+  for (u32 i = 0; i < binding_count; ++i) {
+    u32 fields[5] = {bindings[i].binding, (u32)bindings[i].descriptorType,
+                     bindings[i].descriptorCount, bindings[i].stageFlags,
+                     binding_flags ? binding_flags[i] : 0};
+    const u8 *bytes = (const u8 *)fields;
+    for (u32 j = 0; j < sizeof(fields); ++j) {
+      hash ^= bytes[j];
+      hash *= 1099511628211ull;
+    }
+  }
+  return hash;
+}
+
+static bool bindings_equal(const vulkan_descriptor_layout_entry *entry,
+                           u32 binding_count,
+                           const VkDescriptorSetLayoutBinding *bindings,
+                           const VkDescriptorBindingFlags *binding_flags) {
+  if (entry->binding_count != binding_count) {
+    return false;
+  }
+  for (u32 i = 0; i < binding_count; ++i) {
+    const VkDescriptorSetLayoutBinding *a = &entry->bindings[i];
+    const VkDescriptorSetLayoutBinding *b = &bindings[i];
+    VkDescriptorBindingFlags flags = binding_flags ? binding_flags[i] : 0;
+    if (a->binding != b->binding || a->descriptorType != b->descriptorType ||
+        a->descriptorCount != b->descriptorCount ||
+        a->stageFlags != b->stageFlags || entry->binding_flags[i] != flags) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void vulkan_descriptor_layout_cache_create(
+    vulkan_descriptor_layout_cache *out_cache) {
+  out_cache->entries = darray_create(vulkan_descriptor_layout_entry);
+}
+
+void vulkan_descriptor_layout_cache_destroy(
+    vulkan_context *context, vulkan_descriptor_layout_cache *cache) {
+  if (!cache->entries) {
+    return;
+  }
+
+  u32 entry_count = darray_length(cache->entries);
+  for (u32 i = 0; i < entry_count; ++i) {
+    vkDestroyDescriptorSetLayout(context->device.logical_device,
+                                 cache->entries[i].layout, context->allocator);
+  }
+  darray_destroy(cache->entries);
+  cache->entries = nullptr;
+}
+
+bool vulkan_descriptor_layout_cache_get(
+    vulkan_context *context, vulkan_descriptor_layout_cache *cache,
+    u32 binding_count, const VkDescriptorSetLayoutBinding *bindings,
+    const VkDescriptorBindingFlags *binding_flags,
+    VkDescriptorSetLayout *out_layout) {
+  if (binding_count > VULKAN_MAX_DESCRIPTOR_BINDINGS) {
+    LAI_LOG_ERROR("Descriptor set layouts can have at most %u bindings, %u "
+                  "requested",
+                  VULKAN_MAX_DESCRIPTOR_BINDINGS, binding_count);
+    return false;
+  }
+
+  u64 hash = hash_bindings(binding_count, bindings, binding_flags);
+  u32 entry_count = darray_length(cache->entries);
+  for (u32 i = 0; i < entry_count; ++i) {
+    vulkan_descriptor_layout_entry *entry = &cache->entries[i];
+    if (entry->hash == hash &&
+        bindings_equal(entry, binding_count, bindings, binding_flags)) {
+      *out_layout = entry->layout;
+      return true;
+    }
+  }
+
+  vulkan_descriptor_layout_entry entry;
+  lai_zero_memory(&entry, sizeof(vulkan_descriptor_layout_entry));
+  entry.hash = hash;
+  entry.binding_count = binding_count;
+  bool update_after_bind = false;
+  for (u32 i = 0; i < binding_count; ++i) {
+    LAI_ASSERT_MESSAGE(!bindings[i].pImmutableSamplers,
+                       "Immutable samplers are not cached");
+    entry.bindings[i] = bindings[i];
+    entry.binding_flags[i] = binding_flags ? binding_flags[i] : 0;
+    if (entry.binding_flags[i] &
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) {
+      update_after_bind = true;
+    }
+  }
+
+  VkDescriptorSetLayoutBindingFlagsCreateInfo flags_create_info = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO};
+  flags_create_info.bindingCount = binding_count;
+  flags_create_info.pBindingFlags = entry.binding_flags;
+
+  VkDescriptorSetLayoutCreateInfo create_info = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+  create_info.pNext = binding_flags ? &flags_create_info : nullptr;
+  if (update_after_bind) {
+    create_info.flags =
+        VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+  }
+  create_info.bindingCount = binding_count;
+  create_info.pBindings = entry.bindings;
+  VkResult result = vkCreateDescriptorSetLayout(context->device.logical_device,
+                                                &create_info,
+                                                context->allocator,
+                                                &entry.layout);
+  if (!vulkan_result_is_success(result)) {
+    LAI_LOG_ERROR("vkCreateDescriptorSetLayout failed with %s.",
+                  vulkan_result_string(result, true));
+    return false;
+  }
+
+  darray_push(cache->entries, entry);
+  *out_layout = entry.layout;
+  return true;
+}
+
+static bool create_pool(vulkan_context *context, u32 set_count,
+                        VkDescriptorPool *out_pool) {
+  VkDescriptorPoolSize pool_sizes[POOL_RATIO_COUNT];
+  for (u32 i = 0; i < POOL_RATIO_COUNT; ++i) {
+    pool_sizes[i].type = pool_ratios[i].type;
+    pool_sizes[i].descriptorCount = (u32)(pool_ratios[i].ratio * set_count);
+  }
+
+  VkDescriptorPoolCreateInfo create_info = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+  create_info.maxSets = set_count;
+  create_info.poolSizeCount = POOL_RATIO_COUNT;
+  create_info.pPoolSizes = pool_sizes;
+  VkResult result =
+      vkCreateDescriptorPool(context->device.logical_device, &create_info,
+                             context->allocator, out_pool);
+  if (!vulkan_result_is_success(result)) {
+    LAI_LOG_ERROR("vkCreateDescriptorPool failed with %s.",
+                  vulkan_result_string(result, true));
+    return false;
+  }
+  return true;
+}
+
+// Makes a free pool, or a new larger one, the pool allocated from
+static bool next_pool(vulkan_context *context,
+                      vulkan_descriptor_allocator *allocator) {
+  VkDescriptorPool pool;
+  if (darray_length(allocator->free_pools) > 0) {
+    darray_pop(allocator->free_pools, &pool);
+  } else {
+    if (!create_pool(context, allocator->sets_per_pool, &pool)) {
+      return false;
+    }
+    if (allocator->sets_per_pool < VULKAN_DESCRIPTOR_MAX_SETS_PER_POOL) {
+      allocator->sets_per_pool *= 2;
+    }
+  }
+  darray_push(allocator->used_pools, pool);
+  return true;
+}
+
+void vulkan_descriptor_allocator_create(
+    u32 initial_set_count, vulkan_descriptor_allocator *out_allocator) {
+  out_allocator->used_pools = darray_create(VkDescriptorPool);
+  out_allocator->free_pools = darray_create(VkDescriptorPool);
+  out_allocator->sets_per_pool = initial_set_count > 0 ? initial_set_count : 1;
+}
+
+void vulkan_descriptor_allocator_destroy(
+    vulkan_context *context, vulkan_descriptor_allocator *allocator) {
+  VkDescriptorPool *pool_lists[2] = {allocator->used_pools,
+                                     allocator->free_pools};
+  for (u32 list = 0; list < 2; ++list) {
+    if (!pool_lists[list]) {
+      continue;
+    }
+    u32 pool_count = darray_length(pool_lists[list]);
+    for (u32 i = 0; i < pool_count; ++i) {
+      vkDestroyDescriptorPool(context->device.logical_device,
+                              pool_lists[list][i], context->allocator);
+    }
+    darray_destroy(pool_lists[list]);
+  }
+  lai_zero_memory(allocator, sizeof(vulkan_descriptor_allocator));
+}
+
+bool vulkan_descriptor_allocator_allocate(
+    vulkan_context *context, vulkan_descriptor_allocator *allocator,
+    VkDescriptorSetLayout layout, VkDescriptorSet *out_set) {
+  if (darray_length(allocator->used_pools) == 0 &&
+      !next_pool(context, allocator)) {
+    return false;
+  }
+
+  VkDescriptorSetAllocateInfo allocate_info = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+  allocate_info.descriptorSetCount = 1;
+  allocate_info.pSetLayouts = &layout;
+
+  // A full pool is left behind, the set is retried once in a fresh one.
+  for (u32 attempt = 0; attempt < 2; ++attempt) {
+    u32 pool_count = darray_length(allocator->used_pools);
+    allocate_info.descriptorPool = allocator->used_pools[pool_count - 1];
+    VkResult result = vkAllocateDescriptorSets(
+        context->device.logical_device, &allocate_info, out_set);
+    if (result == VK_SUCCESS) {
+      return true;
+    }
+    if (result != VK_ERROR_OUT_OF_POOL_MEMORY &&
+        result != VK_ERROR_FRAGMENTED_POOL) {
+      LAI_LOG_ERROR("vkAllocateDescriptorSets failed with %s.",
+                    vulkan_result_string(result, true));
+      return false;
+    }
+    if (attempt == 0 && !next_pool(context, allocator)) {
+      return false;
+    }
+  }
+
+  LAI_LOG_ERROR("Descriptor set does not fit in an empty pool");
+  return false;
+}
+
+void vulkan_descriptor_allocator_reset(vulkan_context *context,
+                                       vulkan_descriptor_allocator *allocator) {
+  u32 pool_count = darray_length(allocator->used_pools);
+  for (u32 i = 0; i < pool_count; ++i) {
+    vkResetDescriptorPool(context->device.logical_device,
+                          allocator->used_pools[i], 0);
+    darray_push(allocator->free_pools, allocator->used_pools[i]);
+  }
+  darray_clear(allocator->used_pools);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "renderer/vulkan/vulkan_types.inl"
+
+void vulkan_descriptor_layout_cache_create(
+    vulkan_descriptor_layout_cache *out_cache);
+
+// Destroys every layout handed out, the device must be idle
+void vulkan_descriptor_layout_cache_destroy(
+    vulkan_context *context, vulkan_descriptor_layout_cache *cache);
+
+// Returns the layout of the bindings, created on the first request. Bindings
+// with immutable samplers are not supported. binding_flags has one entry per
+// binding or is null, layouts with update after bind bindings can only be
+// allocated from pools created for them.
+bool vulkan_descriptor_layout_cache_get(
+    vulkan_context *context, vulkan_descriptor_layout_cache *cache,
+    u32 binding_count, const VkDescriptorSetLayoutBinding *bindings,
+    const VkDescriptorBindingFlags *binding_flags,
+    VkDescriptorSetLayout *out_layout);
+
+// initial_set_count sets fit in the first pool
+void vulkan_descriptor_allocator_create(
+    u32 initial_set_count, vulkan_descriptor_allocator *out_allocator);
+
+// Frees every pool and the sets allocated from them, the device must be idle
+void vulkan_descriptor_allocator_destroy(
+    vulkan_context *context, vulkan_descriptor_allocator *allocator);
+
+// Moves on to a new pool when the current one is full or fragmented
+bool vulkan_descriptor_allocator_allocate(
+    vulkan_context *context, vulkan_descriptor_allocator *allocator,
+    VkDescriptorSetLayout layout, VkDescriptorSet *out_set);
+
+// Frees every set allocated so far and keeps the pools for reuse. None of the
+// sets may be in use by the gpu.
+void vulkan_descriptor_allocator_reset(vulkan_context *context,
+                                       vulkan_descriptor_allocator *allocator);
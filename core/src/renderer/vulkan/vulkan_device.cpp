@@ -1,4 +1,5 @@
 #include "renderer/vulkan/vulkan_device.h"
+#include "renderer/vulkan/vulkan_utils.h"
 
 #include "base/lai_memory.h"
 #include "base/lai_string.h"
@@ -13,6 +14,10 @@ struct vulkan_physical_device_requirements {
   bool transfer;
   const char **device_extension_names;
   bool sampler_anisotropy;
+  bool timeline_semaphore;
+  // Partially bound sampled image arrays updated after bind, indexed
+  // non-uniformly
+  bool descriptor_indexing;
   bool discrete_gpu;
 };
 
@@ -76,18 +81,44 @@ bool vulkan_device_create(vulkan_context *context) {
 
   VkPhysicalDeviceFeatures device_features = {};
   device_features.samplerAnisotropy = VK_TRUE; // Request this feature
+  // Optional, batches fall back to direct draws without them
+  device_features.multiDrawIndirect =
+      context->device.features.multiDrawIndirect;
+  device_features.drawIndirectFirstInstance =
+      context->device.features.drawIndirectFirstInstance;
+
+  // Uploads on the transfer queue are consumed through a timeline semaphore
+  VkPhysicalDeviceVulkan12Features device_features_12 = {};
+  device_features_12.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  device_features_12.timelineSemaphore = VK_TRUE;
+  device_features_12.drawIndirectCount =
+      context->device.supports_draw_indirect_count;
+  // The bindless texture array
+  device_features_12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+  device_features_12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+  device_features_12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+  device_features_12.descriptorBindingPartiallyBound = VK_TRUE;
 
   VkDeviceCreateInfo device_create_info = {};
   device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  device_create_info.pNext = &device_features_12;
   device_create_info.queueCreateInfoCount = index_count;
   device_create_info.pQueueCreateInfos = queue_create_infos;
   device_create_info.pEnabledFeatures = &device_features;
 
   const char *extension_names[2];
-  extension_names[0] = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
-  extension_names[1] = "VK_KHR_portability_subset";
-  // { VK_KHR_SWAPCHAIN_EXTENSION_NAME, &"VK_KHR_portability_subset" }
-  device_create_info.enabledExtensionCount = 2;
+  u32 extension_count = 0;
+  if (!context->headless) {
+    extension_names[extension_count++] = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+  }
+  // Has to be enabled on implementations that offer it, such as MoltenVK,
+  // and must not be elsewhere.
+  if (vulkan_device_supports_extension(context->device.physical_device,
+                                       "VK_KHR_portability_subset")) {
+    extension_names[extension_count++] = "VK_KHR_portability_subset";
+  }
+  device_create_info.enabledExtensionCount = extension_count;
   device_create_info.ppEnabledExtensionNames = extension_names;
 
   device_create_info.enabledLayerCount = 0;
@@ -112,11 +143,11 @@ bool vulkan_device_create(vulkan_context *context) {
 
   LAI_LOG_INFO("Queues obtained!");
 
-  // Create command pool
+  // One-shot work only, frames and uploads record into pools of their own.
   VkCommandPoolCreateInfo pool_create_info = {};
   pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
   pool_create_info.queueFamilyIndex = context->device.graphics_queue_index;
-  pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 
   VK_CHECK(vkCreateCommandPool(context->device.logical_device,
                                &pool_create_info, context->allocator,
@@ -255,13 +286,18 @@ bool select_physical_device(vulkan_context *context) {
 
     vulkan_physical_device_requirements requirements = {};
     requirements.graphics = true;
-    requirements.present = true;
+    // Headless devices need neither a present queue nor the swapchain
+    requirements.present = !context->headless;
     requirements.transfer = true;
     requirements.sampler_anisotropy = true;
+    requirements.timeline_semaphore = true;
+    requirements.descriptor_indexing = true;
     requirements.discrete_gpu = false;
     requirements.device_extension_names = darray_create(const char *);
-    darray_push(requirements.device_extension_names,
-                VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    if (!context->headless) {
+      darray_push(requirements.device_extension_names,
+                  VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
 
     vulkan_physical_device_queue_family_info queue_info = {};
     bool result = physical_device_meets_requirements(
@@ -282,12 +318,25 @@ bool select_physical_device(vulkan_context *context) {
       context->device.physical_device = physical_devices[i];
       context->device.graphics_queue_index = queue_info.graphics_family_index;
       context->device.present_queue_index = queue_info.present_family_index;
+      if (context->headless) {
+        // Nothing is presented, keeps the queue setup to the graphics family.
+        context->device.present_queue_index = queue_info.graphics_family_index;
+      }
       context->device.transfer_queue_index = queue_info.transfer_family_index;
 
       context->device.properties = properties;
       context->device.features = features;
       context->device.memory = memory;
 
+      VkPhysicalDeviceVulkan12Features features_12 = {};
+      features_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+      VkPhysicalDeviceFeatures2 features_2 = {};
+      features_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+      features_2.pNext = &features_12;
+      vkGetPhysicalDeviceFeatures2(physical_devices[i], &features_2);
+      context->device.supports_draw_indirect_count =
+          features_12.drawIndirectCount;
+
       break;
     }
   }
@@ -349,8 +398,10 @@ bool physical_device_meets_requirements(
     }
 
     VkBool32 supports_present = VK_FALSE;
-    VK_CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface,
-                                                  &supports_present));
+    if (surface) {
+      VK_CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface,
+                                                    &supports_present));
+    }
     if (supports_present) {
       out_queue_family_info->present_family_index = i;
     }
@@ -377,11 +428,13 @@ bool physical_device_meets_requirements(
         out_queue_family_info->transfer_family_index != -1))) {
     LAI_LOG_DEBUG("Device meets queue requirements");
 
-    vulkan_device_query_swapchain_support(device, surface,
-                                          out_swapchain_support);
+    if (surface) {
+      vulkan_device_query_swapchain_support(device, surface,
+                                            out_swapchain_support);
+    }
 
-    if (out_swapchain_support->format_count < 1 ||
-        out_swapchain_support->present_mode_count < 1) {
+    if (surface && (out_swapchain_support->format_count < 1 ||
+                    out_swapchain_support->present_mode_count < 1)) {
       if (out_swapchain_support->formats) {
         lai_free(out_swapchain_support->formats,
                  sizeof(VkSurfaceFormatKHR) *
@@ -441,6 +494,32 @@ bool physical_device_meets_requirements(
       return false;
     }
 
+    if (requirements->timeline_semaphore ||
+        requirements->descriptor_indexing) {
+      VkPhysicalDeviceVulkan12Features features_12 = {};
+      features_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+      VkPhysicalDeviceFeatures2 features_2 = {};
+      features_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+      features_2.pNext = &features_12;
+      vkGetPhysicalDeviceFeatures2(device, &features_2);
+
+      if (requirements->timeline_semaphore && !features_12.timelineSemaphore) {
+        LAI_LOG_INFO(
+            "Device does not support timelineSemaphore, skipping...");
+        return false;
+      }
+
+      if (requirements->descriptor_indexing &&
+          (!features_12.shaderSampledImageArrayNonUniformIndexing ||
+           !features_12.descriptorBindingSampledImageUpdateAfterBind ||
+           !features_12.descriptorBindingUpdateUnusedWhilePending ||
+           !features_12.descriptorBindingPartiallyBound)) {
+        LAI_LOG_INFO(
+            "Device does not support descriptor indexing, skipping...");
+        return false;
+      }
+    }
+
     return true;
   }
 
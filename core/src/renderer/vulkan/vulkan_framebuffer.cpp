@@ -1,4 +1,5 @@
 #include "renderer/vulkan/vulkan_framebuffer.h"
+#include "renderer/vulkan/vulkan_deletion_queue.h"
 #include "base/lai_memory.h"
 
 void vulkan_framebuffer_create(vulkan_context *context,
@@ -42,4 +43,13 @@ void vulkan_framebuffer_destroy(vulkan_context *context,
   framebuffer->handle = nullptr;
   framebuffer->attachment_count = 0;
   framebuffer->renderpass = nullptr;
+}
+
+void vulkan_framebuffer_retire(vulkan_context *context,
+                               vulkan_framebuffer *framebuffer) {
+  vulkan_deletion_queue_push_framebuffer(context, &context->deletion_queue,
+                                         framebuffer->handle);
+  // Only the host side is left to free.
+  framebuffer->handle = nullptr;
+  vulkan_framebuffer_destroy(context, framebuffer);
 }
\ No newline at end of file
@@ -9,4 +9,9 @@ void vulkan_framebuffer_create(vulkan_context *context,
                                vulkan_framebuffer *out_framebuffer);
 
 void vulkan_framebuffer_destroy(vulkan_context *context,
-                                vulkan_framebuffer *framebuffer);
\ No newline at end of file
+                                vulkan_framebuffer *framebuffer);
+
+// Like destroy, but the handle waits in the context's deletion queue until
+// no frame in flight uses it anymore.
+void vulkan_framebuffer_retire(vulkan_context *context,
+                               vulkan_framebuffer *framebuffer);
\ No newline at end of file
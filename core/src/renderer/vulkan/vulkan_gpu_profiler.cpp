@@ -0,0 +1,219 @@
+#include "renderer/vulkan/vulkan_gpu_profiler.h"
+#include "renderer/vulkan/vulkan_utils.h"
+
+#include "base/lai_memory.h"
+#include "base/log.h"
+
+#include "containers/darray.h"
+
+// A begin and an end timestamp per scope
+#define VULKAN_GPU_PROFILER_QUERY_COUNT (GPU_TIMINGS_MAX_SCOPES * 2)
+
+static void resolve_frame(vulkan_context *context,
+                          vulkan_gpu_profiler *profiler,
+                          vulkan_gpu_profiler_frame *frame,
+                          u64 frame_number) {
+  if (frame->scope_count == 0) {
+    return;
+  }
+
+  // The frame has completed, so this never blocks.
+  u64 results[VULKAN_GPU_PROFILER_QUERY_COUNT];
+  VkResult result = vkGetQueryPoolResults(
+      context->device.logical_device, frame->query_pool, 0,
+      frame->query_count, sizeof(u64) * frame->query_count, results,
+      sizeof(u64), VK_QUERY_RESULT_64_BIT);
+  if (result != VK_SUCCESS) {
+    return;
+  }
+
+  gpu_timings *timings = &profiler->timings;
+  timings->frame_number = frame_number;
+  timings->scope_count = frame->scope_count;
+  for (u32 i = 0; i < frame->scope_count; ++i) {
+    vulkan_gpu_scope *scope = &frame->scopes[i];
+    timings->scopes[i].name = scope->name;
+    timings->scopes[i].depth = scope->depth;
+    timings->scopes[i].time = 0;
+    if (scope->end_query != INVALID_ID) {
+      // Masked so a wrapped counter still gives the right difference
+      u64 ticks = (results[scope->end_query] - results[scope->begin_query]) &
+                  profiler->timestamp_mask;
+      timings->scopes[i].time = ticks * profiler->timestamp_period;
+    }
+  }
+  // The frame scope is always the first one
+  timings->frame_time = timings->scopes[0].time;
+}
+
+static void begin_label(vulkan_gpu_profiler *profiler,
+                        vulkan_command_buffer *command_buffer,
+                        const char *name) {
+  if (!profiler->cmd_begin_label) {
+    return;
+  }
+  VkDebugUtilsLabelEXT label = {VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
+  label.pLabelName = name;
+  profiler->cmd_begin_label(command_buffer->handle, &label);
+}
+
+bool vulkan_gpu_profiler_create(vulkan_context *context, u32 frame_count,
+                                vulkan_gpu_profiler *out_profiler) {
+  lai_zero_memory(out_profiler, sizeof(vulkan_gpu_profiler));
+  out_profiler->frame_scope = INVALID_ID;
+
+#ifdef LAI_DEBUG
+  out_profiler->cmd_begin_label =
+      (PFN_vkCmdBeginDebugUtilsLabelEXT)vkGetInstanceProcAddr(
+          context->instance, "vkCmdBeginDebugUtilsLabelEXT");
+  out_profiler->cmd_end_label =
+      (PFN_vkCmdEndDebugUtilsLabelEXT)vkGetInstanceProcAddr(
+          context->instance, "vkCmdEndDebugUtilsLabelEXT");
+  if (!out_profiler->cmd_begin_label || !out_profiler->cmd_end_label) {
+    out_profiler->cmd_begin_label = nullptr;
+    out_profiler->cmd_end_label = nullptr;
+  }
+#endif
+
+  u32 queue_family_count = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(context->device.physical_device,
+                                           &queue_family_count, 0);
+  VkQueueFamilyProperties queue_families[32];
+  vkGetPhysicalDeviceQueueFamilyProperties(context->device.physical_device,
+                                           &queue_family_count,
+                                           queue_families);
+  u32 valid_bits =
+      queue_families[context->device.graphics_queue_index].timestampValidBits;
+  f32 period = context->device.properties.limits.timestampPeriod;
+  if (valid_bits == 0 || period <= 0.0f) {
+    LAI_LOG_INFO("Graphics queue has no timestamps, gpu timings disabled");
+    return true;
+  }
+
+  out_profiler->timestamp_period = period * 1e-9;
+  out_profiler->timestamp_mask =
+      valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+
+  // Zeroed, so destroy skips the pools not created yet.
+  out_profiler->frames =
+      darray_reserve(vulkan_gpu_profiler_frame, frame_count);
+  darray_length_set(out_profiler->frames, frame_count);
+  VkQueryPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+  pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  pool_info.queryCount = VULKAN_GPU_PROFILER_QUERY_COUNT;
+  for (u32 i = 0; i < frame_count; ++i) {
+    VkResult result = vkCreateQueryPool(context->device.logical_device,
+                                        &pool_info, context->allocator,
+                                        &out_profiler->frames[i].query_pool);
+    if (!vulkan_result_is_success(result)) {
+      LAI_LOG_ERROR("vkCreateQueryPool failed with %s.",
+                    vulkan_result_string(result, true));
+      vulkan_gpu_profiler_destroy(context, out_profiler);
+      return false;
+    }
+  }
+
+  out_profiler->enabled = true;
+  return true;
+}
+
+void vulkan_gpu_profiler_destroy(vulkan_context *context,
+                                 vulkan_gpu_profiler *profiler) {
+  if (profiler->frames) {
+    u32 frame_count = darray_length(profiler->frames);
+    for (u32 i = 0; i < frame_count; ++i) {
+      if (profiler->frames[i].query_pool) {
+        vkDestroyQueryPool(context->device.logical_device,
+                           profiler->frames[i].query_pool,
+                           context->allocator);
+      }
+    }
+    darray_destroy(profiler->frames);
+  }
+  lai_zero_memory(profiler, sizeof(vulkan_gpu_profiler));
+}
+
+void vulkan_gpu_profiler_begin_frame(vulkan_context *context,
+                                     vulkan_command_buffer *command_buffer,
+                                     u32 frame_index) {
+  vulkan_gpu_profiler *profiler = &context->gpu_profiler;
+  profiler->depth = 0;
+  if (profiler->enabled) {
+    vulkan_gpu_profiler_frame *frame = &profiler->frames[frame_index];
+    resolve_frame(context, profiler, frame,
+                  context->in_flight_frame_numbers[frame_index]);
+
+    vkCmdResetQueryPool(command_buffer->handle, frame->query_pool, 0,
+                        VULKAN_GPU_PROFILER_QUERY_COUNT);
+    frame->query_count = 0;
+    frame->scope_count = 0;
+    profiler->recording = frame;
+  }
+
+  profiler->frame_scope =
+      vulkan_gpu_profiler_begin_scope(context, command_buffer, "frame");
+}
+
+void vulkan_gpu_profiler_end_frame(vulkan_context *context,
+                                   vulkan_command_buffer *command_buffer) {
+  vulkan_gpu_profiler *profiler = &context->gpu_profiler;
+  vulkan_gpu_profiler_end_scope(context, command_buffer,
+                                profiler->frame_scope);
+  profiler->recording = nullptr;
+}
+
+u32 vulkan_gpu_profiler_begin_scope(vulkan_context *context,
+                                    vulkan_command_buffer *command_buffer,
+                                    const char *name) {
+  vulkan_gpu_profiler *profiler = &context->gpu_profiler;
+  begin_label(profiler, command_buffer, name);
+
+  u32 depth = profiler->depth++;
+  vulkan_gpu_profiler_frame *frame = profiler->recording;
+  if (!frame || frame->scope_count == GPU_TIMINGS_MAX_SCOPES) {
+    return INVALID_ID;
+  }
+
+  u32 index = frame->scope_count++;
+  vulkan_gpu_scope *scope = &frame->scopes[index];
+  scope->name = name;
+  scope->depth = depth;
+  scope->begin_query = frame->query_count++;
+  scope->end_query = INVALID_ID;
+  vkCmdWriteTimestamp(command_buffer->handle,
+                      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame->query_pool,
+                      scope->begin_query);
+  return index;
+}
+
+void vulkan_gpu_profiler_end_scope(vulkan_context *context,
+                                   vulkan_command_buffer *command_buffer,
+                                   u32 scope) {
+  vulkan_gpu_profiler *profiler = &context->gpu_profiler;
+  if (profiler->depth > 0) {
+    profiler->depth--;
+  }
+
+  vulkan_gpu_profiler_frame *frame = profiler->recording;
+  if (frame && scope != INVALID_ID) {
+    vulkan_gpu_scope *gpu_scope = &frame->scopes[scope];
+    gpu_scope->end_query = frame->query_count++;
+    // Written once everything recorded before it has finished
+    vkCmdWriteTimestamp(command_buffer->handle,
+                        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                        frame->query_pool, gpu_scope->end_query);
+  }
+
+  if (profiler->cmd_end_label) {
+    profiler->cmd_end_label(command_buffer->handle);
+  }
+}
+
+bool vulkan_gpu_profiler_get_timings(vulkan_gpu_profiler *profiler,
+                                     gpu_timings *out_timings) {
+  if (profiler->timings.scope_count == 0) {
+    return false;
+  }
+  *out_timings = profiler->timings;
+  return true;
+}
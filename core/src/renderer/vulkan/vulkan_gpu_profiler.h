@@ -0,0 +1,63 @@
+#pragma once
+
+#include "renderer/vulkan/vulkan_types.inl"
+
+#define LAI_GPU_PROFILE_CONCAT_INNER(a, b) a##b
+#define LAI_GPU_PROFILE_CONCAT(a, b) LAI_GPU_PROFILE_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing block on the gpu and labels it for
+// debuggers. name has to be a string literal. Not allowed inside a render
+// pass with secondary command buffer contents.
+#define LAI_GPU_PROFILE_SCOPE(context, command_buffer, name)                   \
+  vulkan_gpu_profile_scope LAI_GPU_PROFILE_CONCAT(gpu_profile_scope_,          \
+                                                  __LINE__)(                   \
+      context, command_buffer, name)
+
+// One query pool per frame in flight. Disabled, but still usable, when the
+// graphics queue has no timestamp support.
+bool vulkan_gpu_profiler_create(vulkan_context *context, u32 frame_count,
+                                vulkan_gpu_profiler *out_profiler);
+
+// The device must be idle
+void vulkan_gpu_profiler_destroy(vulkan_context *context,
+                                 vulkan_gpu_profiler *profiler);
+
+// Resolves the results the frame in flight recorded last time, which has to
+// have completed, then resets its queries and opens the frame scope. Has to
+// be recorded outside of a render pass.
+void vulkan_gpu_profiler_begin_frame(vulkan_context *context,
+                                     vulkan_command_buffer *command_buffer,
+                                     u32 frame_index);
+
+// Closes the frame scope
+void vulkan_gpu_profiler_end_frame(vulkan_context *context,
+                                   vulkan_command_buffer *command_buffer);
+
+// Returns the scope to end, INVALID_ID when it is only labeled because
+// timestamps are unsupported or the frame ran out of scopes.
+u32 vulkan_gpu_profiler_begin_scope(vulkan_context *context,
+                                    vulkan_command_buffer *command_buffer,
+                                    const char *name);
+void vulkan_gpu_profiler_end_scope(vulkan_context *context,
+                                   vulkan_command_buffer *command_buffer,
+                                   u32 scope);
+
+// False until a frame has been resolved
+bool vulkan_gpu_profiler_get_timings(vulkan_gpu_profiler *profiler,
+                                     gpu_timings *out_timings);
+
+struct vulkan_gpu_profile_scope {
+  vulkan_context *context;
+  vulkan_command_buffer *command_buffer;
+  u32 scope;
+
+  vulkan_gpu_profile_scope(vulkan_context *context,
+                           vulkan_command_buffer *command_buffer,
+                           const char *name)
+      : context(context), command_buffer(command_buffer),
+        scope(vulkan_gpu_profiler_begin_scope(context, command_buffer, name)) {
+  }
+  ~vulkan_gpu_profile_scope() {
+    vulkan_gpu_profiler_end_scope(context, command_buffer, scope);
+  }
+};
@@ -1,17 +1,20 @@
 #include "renderer/vulkan/vulkan_image.h"
 #include "renderer/vulkan/vulkan_device.h"
+#include "renderer/vulkan/vulkan_memory_allocator.h"
 
 #include "base/lai_memory.h"
 #include "base/log.h"
 
 void vulkan_image_create(vulkan_context *context, VkImageType image_type,
-                         u32 width, u32 height, VkFormat format,
-                         VkImageTiling tiling, VkImageUsageFlags usage,
+                         u32 width, u32 height, u32 mip_levels,
+                         VkFormat format, VkImageTiling tiling,
+                         VkImageUsageFlags usage,
                          VkMemoryPropertyFlags memory_flags, bool create_view,
                          VkImageAspectFlags view_aspect_flags,
                          vulkan_image *out_image) {
   out_image->width = width;
   out_image->height = height;
+  out_image->mip_levels = mip_levels;
 
   VkImageCreateInfo image_create_info = {};
   image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -19,7 +22,7 @@ void vulkan_image_create(vulkan_context *context, VkImageType image_type,
   image_create_info.extent.width = width;
   image_create_info.extent.height = height;
   image_create_info.extent.depth = 1;
-  image_create_info.mipLevels = 4;
+  image_create_info.mipLevels = mip_levels;
   image_create_info.arrayLayers = 1;
   image_create_info.format = format;
   image_create_info.tiling = tiling;
@@ -35,21 +38,15 @@ void vulkan_image_create(vulkan_context *context, VkImageType image_type,
   vkGetImageMemoryRequirements(context->device.logical_device,
                                out_image->handle, &memory_requirements);
 
-  i32 memory_type = context->find_memory_index(
-      memory_requirements.memoryTypeBits, memory_flags);
-  if (memory_type == -1) {
+  if (!vulkan_memory_allocate(context, &memory_requirements, memory_flags,
+                              tiling == VK_IMAGE_TILING_LINEAR,
+                              &out_image->allocation)) {
     LAI_LOG_ERROR("Required memory type not found. Image is not valid");
+    return;
   }
-
-  VkMemoryAllocateInfo memory_allocate_info = {};
-  memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  memory_allocate_info.allocationSize = memory_requirements.size;
-  memory_allocate_info.memoryTypeIndex = memory_type;
-  VK_CHECK(vkAllocateMemory(context->device.logical_device,
-                            &memory_allocate_info, context->allocator,
-                            &out_image->memory));
   VK_CHECK(vkBindImageMemory(context->device.logical_device, out_image->handle,
-                             out_image->memory, 0));
+                             out_image->allocation.memory,
+                             out_image->allocation.offset));
 
   if (create_view) {
     out_image->view = nullptr;
@@ -68,7 +65,7 @@ void vulkan_image_view_create(vulkan_context *context, VkFormat format,
   view_create_info.subresourceRange.aspectMask = aspect_flags;
 
   view_create_info.subresourceRange.baseMipLevel = 0;
-  view_create_info.subresourceRange.levelCount = 1;
+  view_create_info.subresourceRange.levelCount = image->mip_levels;
   view_create_info.subresourceRange.baseArrayLayer = 0;
   view_create_info.subresourceRange.layerCount = 1;
 
@@ -83,11 +80,7 @@ void vulkan_image_destroy(vulkan_context *context, vulkan_image *image) {
     image->view = nullptr;
   }
 
-  if (image->memory) {
-    vkFreeMemory(context->device.logical_device, image->memory,
-                 context->allocator);
-    image->memory = nullptr;
-  }
+  vulkan_memory_free(context, &image->allocation);
 
   if (image->handle) {
     vkDestroyImage(context->device.logical_device, image->handle,
@@ -2,9 +2,11 @@
 
 #include "renderer/vulkan/vulkan_types.inl"
 
+// The view, when created, covers all mip_levels levels
 void vulkan_image_create(vulkan_context *context, VkImageType image_type,
-                         u32 width, u32 height, VkFormat format,
-                         VkImageTiling tiling, VkImageUsageFlags usage,
+                         u32 width, u32 height, u32 mip_levels,
+                         VkFormat format, VkImageTiling tiling,
+                         VkImageUsageFlags usage,
                          VkMemoryPropertyFlags memory_flags, bool create_view,
                          VkImageAspectFlags view_aspect_flags,
                          vulkan_image *out_image);
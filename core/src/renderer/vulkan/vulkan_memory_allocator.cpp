@@ -0,0 +1,254 @@
+#include "renderer/vulkan/vulkan_memory_allocator.h"
+#include "renderer/vulkan/vulkan_utils.h"
+
+#include "base/lai_memory.h"
+#include "base/log.h"
+
+#include "containers/darray.h"
+
+#define VULKAN_MEMORY_BLOCK_SIZE (64ull * 1024 * 1024)
+
+static u64 block_size_for_heap(vulkan_context *context, u32 heap_index) {
+  // Small heaps, e.g. the 256mb device local and host visible one, would be
+  // used up by a couple of blocks.
+  u64 heap_size = context->device.memory.memoryHeaps[heap_index].size;
+  u64 size = heap_size / 8;
+  return size < VULKAN_MEMORY_BLOCK_SIZE ? size : VULKAN_MEMORY_BLOCK_SIZE;
+}
+
+static void report_heap_usage(vulkan_context *context,
+                              vulkan_memory_allocator *allocator,
+                              u32 heap_index) {
+  report_device_memory_usage(
+      heap_index, allocator->heap_used[heap_index],
+      allocator->heap_reserved[heap_index],
+      context->device.memory.memoryHeaps[heap_index].size);
+}
+
+static vulkan_memory_block *create_block(vulkan_context *context,
+                                         vulkan_memory_allocator *allocator,
+                                         u32 memory_type_index, u64 size,
+                                         bool linear, bool dedicated) {
+  VkMemoryAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+  allocate_info.allocationSize = size;
+  allocate_info.memoryTypeIndex = memory_type_index;
+
+  VkDeviceMemory memory;
+  VkResult result =
+      vkAllocateMemory(context->device.logical_device, &allocate_info,
+                       context->allocator, &memory);
+  if (!vulkan_result_is_success(result)) {
+    LAI_LOG_ERROR("Failed to allocate a %llu byte memory block: '%s'", size,
+                  vulkan_result_string(result, true));
+    return nullptr;
+  }
+
+  vulkan_memory_block *block = (vulkan_memory_block *)lai_allocate(
+      sizeof(vulkan_memory_block), MEMORY_TAG_RENDERER);
+  block->memory = memory;
+  block->size = size;
+  block->memory_type_index = memory_type_index;
+  block->linear = linear;
+  block->dedicated = dedicated;
+  freelist_create(size, &block->free_ranges);
+
+  VkMemoryType type = context->device.memory.memoryTypes[memory_type_index];
+  if (type.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    VK_CHECK(vkMapMemory(context->device.logical_device, memory, 0,
+                         VK_WHOLE_SIZE, 0, &block->mapped));
+  }
+
+  darray_push(allocator->blocks, block);
+  allocator->heap_reserved[type.heapIndex] += size;
+
+  return block;
+}
+
+static void destroy_block(vulkan_context *context,
+                          vulkan_memory_allocator *allocator,
+                          vulkan_memory_block *block) {
+  u32 heap_index =
+      context->device.memory.memoryTypes[block->memory_type_index].heapIndex;
+  allocator->heap_reserved[heap_index] -= block->size;
+
+  if (block->mapped) {
+    vkUnmapMemory(context->device.logical_device, block->memory);
+  }
+  vkFreeMemory(context->device.logical_device, block->memory,
+               context->allocator);
+  freelist_destroy(&block->free_ranges);
+  lai_free(block, sizeof(vulkan_memory_block), MEMORY_TAG_RENDERER);
+}
+
+// Removes block from the allocator's blocks and destroys it
+static void release_block(vulkan_context *context,
+                          vulkan_memory_allocator *allocator,
+                          vulkan_memory_block *block) {
+  u64 count = darray_length(allocator->blocks);
+  for (u64 i = 0; i < count; ++i) {
+    if (allocator->blocks[i] == block) {
+      // Order doesn't matter, move the last one into the gap.
+      allocator->blocks[i] = allocator->blocks[count - 1];
+      darray_length_set(allocator->blocks, count - 1);
+      break;
+    }
+  }
+  destroy_block(context, allocator, block);
+}
+
+bool vulkan_memory_allocator_create(vulkan_context *context,
+                                    vulkan_memory_allocator *out_allocator) {
+  lai_zero_memory(out_allocator, sizeof(vulkan_memory_allocator));
+  out_allocator->blocks = darray_create(vulkan_memory_block *);
+
+  for (u32 i = 0; i < context->device.memory.memoryHeapCount; ++i) {
+    report_heap_usage(context, out_allocator, i);
+  }
+
+  LAI_LOG_INFO("Vulkan memory allocator created!");
+  return true;
+}
+
+void vulkan_memory_allocator_destroy(vulkan_context *context,
+                                     vulkan_memory_allocator *allocator) {
+  if (!allocator->blocks) {
+    return;
+  }
+
+  if (allocator->allocation_count > 0) {
+    LAI_LOG_WARN("Destroying vulkan memory allocator with %llu live "
+                 "allocations",
+                 allocator->allocation_count);
+  }
+
+  u64 count = darray_length(allocator->blocks);
+  for (u64 i = 0; i < count; ++i) {
+    destroy_block(context, allocator, allocator->blocks[i]);
+  }
+  darray_destroy(allocator->blocks);
+
+  for (u32 i = 0; i < context->device.memory.memoryHeapCount; ++i) {
+    allocator->heap_used[i] = 0;
+    report_heap_usage(context, allocator, i);
+  }
+
+  lai_zero_memory(allocator, sizeof(vulkan_memory_allocator));
+}
+
+bool vulkan_memory_allocate(vulkan_context *context,
+                            const VkMemoryRequirements *requirements,
+                            u32 memory_property_flags, bool linear,
+                            vulkan_allocation *out_allocation) {
+  vulkan_memory_allocator *allocator = &context->memory_allocator;
+  lai_zero_memory(out_allocation, sizeof(vulkan_allocation));
+
+  i32 memory_type_index = context->find_memory_index(
+      requirements->memoryTypeBits, memory_property_flags);
+  if (memory_type_index == -1) {
+    LAI_LOG_ERROR("Required memory type not found, flags: %u",
+                  memory_property_flags);
+    return false;
+  }
+
+  VkMemoryType type = context->device.memory.memoryTypes[memory_type_index];
+  u64 size = requirements->size;
+  u64 alignment = requirements->alignment > 0 ? requirements->alignment : 1;
+
+  // Ranges of non coherent memory are flushed in whole atoms, so allocations
+  // must not share one.
+  if ((type.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
+      !(type.propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+    u64 atom = context->device.properties.limits.nonCoherentAtomSize;
+    alignment = alignment > atom ? alignment : atom;
+    size = (size + atom - 1) & ~(atom - 1);
+  }
+
+  u64 block_size = block_size_for_heap(context, type.heapIndex);
+
+  vulkan_memory_block *block = nullptr;
+  u64 offset = 0;
+  if (size > block_size / 2) {
+    block = create_block(context, allocator, memory_type_index, size, linear,
+                         true);
+    if (block && !freelist_allocate(&block->free_ranges, size, &offset)) {
+      release_block(context, allocator, block);
+      block = nullptr;
+    }
+  } else {
+    u64 count = darray_length(allocator->blocks);
+    for (u64 i = 0; i < count; ++i) {
+      vulkan_memory_block *candidate = allocator->blocks[i];
+      if (candidate->memory_type_index == (u32)memory_type_index &&
+          candidate->linear == linear && !candidate->dedicated &&
+          freelist_allocate_aligned(&candidate->free_ranges, size, alignment,
+                                    &offset)) {
+        block = candidate;
+        break;
+      }
+    }
+
+    if (!block) {
+      block = create_block(context, allocator, memory_type_index, block_size,
+                           linear, false);
+      if (block && !freelist_allocate_aligned(&block->free_ranges, size,
+                                              alignment, &offset)) {
+        release_block(context, allocator, block);
+        block = nullptr;
+      }
+    }
+  }
+
+  if (!block) {
+    LAI_LOG_ERROR("Failed to allocate %llu bytes of device memory", size);
+    return false;
+  }
+
+  out_allocation->block = block;
+  out_allocation->memory = block->memory;
+  out_allocation->offset = offset;
+  out_allocation->size = size;
+  out_allocation->mapped =
+      block->mapped ? (u8 *)block->mapped + offset : nullptr;
+
+  allocator->allocation_count++;
+  allocator->heap_used[type.heapIndex] += size;
+  report_heap_usage(context, allocator, type.heapIndex);
+
+  return true;
+}
+
+void vulkan_memory_free(vulkan_context *context,
+                        vulkan_allocation *allocation) {
+  vulkan_memory_block *block = allocation->block;
+  if (!block) {
+    return;
+  }
+
+  vulkan_memory_allocator *allocator = &context->memory_allocator;
+  u32 heap_index =
+      context->device.memory.memoryTypes[block->memory_type_index].heapIndex;
+
+  freelist_free(&block->free_ranges, allocation->size, allocation->offset);
+  allocator->allocation_count--;
+  allocator->heap_used[heap_index] -= allocation->size;
+
+  // The last block of a kind is kept even when empty, so freeing and
+  // allocating again doesn't hit vkAllocateMemory every time.
+  bool release = block->dedicated;
+  if (!release && freelist_free_space(&block->free_ranges) == block->size) {
+    u64 count = darray_length(allocator->blocks);
+    for (u64 i = 0; i < count && !release; ++i) {
+      vulkan_memory_block *other = allocator->blocks[i];
+      release = other != block &&
+                other->memory_type_index == block->memory_type_index &&
+                other->linear == block->linear && !other->dedicated;
+    }
+  }
+
+  if (release) {
+    release_block(context, allocator, block);
+  }
+
+  report_heap_usage(context, allocator, heap_index);
+  lai_zero_memory(allocation, sizeof(vulkan_allocation));
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "renderer/vulkan/vulkan_types.inl"
+
+bool vulkan_memory_allocator_create(vulkan_context *context,
+                                    vulkan_memory_allocator *out_allocator);
+
+void vulkan_memory_allocator_destroy(vulkan_context *context,
+                                     vulkan_memory_allocator *allocator);
+
+// linear is true for buffers and linear tiled images
+bool vulkan_memory_allocate(vulkan_context *context,
+                            const VkMemoryRequirements *requirements,
+                            u32 memory_property_flags, bool linear,
+                            vulkan_allocation *out_allocation);
+
+void vulkan_memory_free(vulkan_context *context,
+                        vulkan_allocation *allocation);
@@ -7,20 +7,21 @@
 #include "base/log.h"
 
 bool vulkan_graphics_pipeline_create(
-    vulkan_context *context, vulkan_renderpass *renderpass, u32 attribute_count,
+    vulkan_context *context, vulkan_renderpass *renderpass, u32 binding_count,
+    VkVertexInputBindingDescription *bindings, u32 attribute_count,
     VkVertexInputAttributeDescription *attributes,
     u32 descriptor_set_layout_count,
-    VkDescriptorSetLayout *descriptor_set_layouts, u32 stage_count,
-    VkPipelineShaderStageCreateInfo *stages, VkViewport viewport,
-    VkRect2D scissor, bool is_wireframe, vulkan_pipeline *out_pipeline) {
+    VkDescriptorSetLayout *descriptor_set_layouts, u32 push_constant_size,
+    u32 stage_count, VkPipelineShaderStageCreateInfo *stages,
+    bool is_wireframe, vulkan_pipeline *out_pipeline) {
 
-  // Viewport state
+  // Viewport state, both are dynamic so the pipeline outlives resizes.
   VkPipelineViewportStateCreateInfo viewport_state = {};
   viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
   viewport_state.viewportCount = 1;
-  viewport_state.pViewports = &viewport;
+  viewport_state.pViewports = nullptr;
   viewport_state.scissorCount = 1;
-  viewport_state.pScissors = &scissor;
+  viewport_state.pScissors = nullptr;
 
   // Rasterizer
   VkPipelineRasterizationStateCreateInfo rasterized_create_info = {};
@@ -85,11 +86,10 @@ bool vulkan_graphics_pipeline_create(
   color_blend_state_create_info.attachmentCount = 1;
   color_blend_state_create_info.pAttachments = &color_blend_attachment_state;
 
-  // Dynamic state
-  const u32 dynamic_state_count = 3;
-  VkDynamicState dynamic_states[3] = {VK_DYNAMIC_STATE_VIEWPORT,
-                                      VK_DYNAMIC_STATE_SCISSOR,
-                                      VK_DYNAMIC_STATE_LINE_WIDTH};
+  // Dynamic state, set by every command buffer drawing with the pipeline
+  const u32 dynamic_state_count = 2;
+  VkDynamicState dynamic_states[dynamic_state_count] = {
+      VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
 
   VkPipelineDynamicStateCreateInfo dynamic_state_create_info = {};
   dynamic_state_create_info.sType =
@@ -98,17 +98,10 @@ bool vulkan_graphics_pipeline_create(
   dynamic_state_create_info.pDynamicStates = dynamic_states;
 
   // Vertex input
-  VkVertexInputBindingDescription binding_description;
-  binding_description.binding = 0; // Binding index
-  binding_description.stride = sizeof(vertex_3d);
-  binding_description.inputRate =
-      VK_VERTEX_INPUT_RATE_VERTEX; // Move to next data entry for each vertex.
-
-  // Attributes
   VkPipelineVertexInputStateCreateInfo vertex_input_info = {
       VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
-  vertex_input_info.vertexBindingDescriptionCount = 1;
-  vertex_input_info.pVertexBindingDescriptions = &binding_description;
+  vertex_input_info.vertexBindingDescriptionCount = binding_count;
+  vertex_input_info.pVertexBindingDescriptions = bindings;
   vertex_input_info.vertexAttributeDescriptionCount = attribute_count;
   vertex_input_info.pVertexAttributeDescriptions = attributes;
 
@@ -124,33 +117,21 @@ bool vulkan_graphics_pipeline_create(
   pipeline_layout_create_info.sType =
       VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 
-  // Push constants
-  // if (push_constant_range_count > 0) {
-  //   if (push_constant_range_count > 32) {
-  //     LAI_LOG_ERROR("vulkan_graphics_pipeline_create: cannot have more than
-  //     32 push "
-  //            "constant ranges. Passed count: %i",
-  //            push_constant_range_count);
-  //     return false;
-  //   }
-
-  //   // NOTE: 32 is the max number of ranges we can ever have, since spec only
-  //   // guarantees 128 bytes with 4-byte alignment.
-  //   VkPushConstantRange ranges[32];
-  //   kzero_memory(ranges, sizeof(VkPushConstantRange) * 32);
-  //   for (u32 i = 0; i < push_constant_range_count; ++i) {
-  //     ranges[i].stageFlags =
-  //         VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-  //     ranges[i].offset = push_constant_ranges[i].offset;
-  //     ranges[i].size = push_constant_ranges[i].size;
-  //   }
-  //   pipeline_layout_create_info.pushConstantRangeCount =
-  //       push_constant_range_count;
-  //   pipeline_layout_create_info.pPushConstantRanges = ranges;
-  // } else {
-  //   pipeline_layout_create_info.pushConstantRangeCount = 0;
-  //   pipeline_layout_create_info.pPushConstantRanges = 0;
-  // }
+  // Push constants, the spec guarantees 128 bytes.
+  if (push_constant_size > VULKAN_MAX_PUSH_CONSTANT_SIZE) {
+    LAI_LOG_ERROR("vulkan_graphics_pipeline_create: cannot have more than %u "
+                  "bytes of push constants, %u requested",
+                  VULKAN_MAX_PUSH_CONSTANT_SIZE, push_constant_size);
+    return false;
+  }
+  VkPushConstantRange push_constant_range;
+  push_constant_range.stageFlags =
+      VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+  push_constant_range.offset = 0;
+  push_constant_range.size = push_constant_size;
+  pipeline_layout_create_info.pushConstantRangeCount =
+      push_constant_size > 0 ? 1 : 0;
+  pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
 
   // Descriptor set layouts
   pipeline_layout_create_info.setLayoutCount = descriptor_set_layout_count;
@@ -185,8 +166,8 @@ bool vulkan_graphics_pipeline_create(
   pipeline_create_info.basePipelineIndex = -1;
 
   VkResult result = vkCreateGraphicsPipelines(
-      context->device.logical_device, VK_NULL_HANDLE, 1, &pipeline_create_info,
-      context->allocator, &out_pipeline->handle);
+      context->device.logical_device, context->pipeline_cache, 1,
+      &pipeline_create_info, context->allocator, &out_pipeline->handle);
 
   if (vulkan_result_is_success(result)) {
     LAI_LOG_INFO("Graphics pipeline created!");
@@ -198,6 +179,48 @@ bool vulkan_graphics_pipeline_create(
   return false;
 }
 
+bool vulkan_compute_pipeline_create(
+    vulkan_context *context, u32 descriptor_set_layout_count,
+    VkDescriptorSetLayout *descriptor_set_layouts, u32 push_constant_size,
+    VkPipelineShaderStageCreateInfo stage, vulkan_pipeline *out_pipeline) {
+  VkPushConstantRange push_constant_range;
+  push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  push_constant_range.offset = 0;
+  push_constant_range.size = push_constant_size;
+
+  VkPipelineLayoutCreateInfo pipeline_layout_create_info = {
+      VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+  pipeline_layout_create_info.setLayoutCount = descriptor_set_layout_count;
+  pipeline_layout_create_info.pSetLayouts = descriptor_set_layouts;
+  pipeline_layout_create_info.pushConstantRangeCount =
+      push_constant_size > 0 ? 1 : 0;
+  pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+  VK_CHECK(vkCreatePipelineLayout(context->device.logical_device,
+                                  &pipeline_layout_create_info,
+                                  context->allocator, &out_pipeline->layout));
+
+  VkComputePipelineCreateInfo pipeline_create_info = {
+      VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+  pipeline_create_info.stage = stage;
+  pipeline_create_info.layout = out_pipeline->layout;
+  pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+  pipeline_create_info.basePipelineIndex = -1;
+
+  VkResult result = vkCreateComputePipelines(
+      context->device.logical_device, context->pipeline_cache, 1,
+      &pipeline_create_info, context->allocator, &out_pipeline->handle);
+
+  if (vulkan_result_is_success(result)) {
+    LAI_LOG_INFO("Compute pipeline created!");
+    return true;
+  }
+
+  LAI_LOG_ERROR("vkCreateComputePipelines failed with %s.",
+                vulkan_result_string(result, true));
+  return false;
+}
+
 void vulkan_pipeline_destroy(vulkan_context *context,
                              vulkan_pipeline *pipeline) {
   if (pipeline) {
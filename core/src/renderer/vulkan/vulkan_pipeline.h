@@ -2,13 +2,23 @@
 
 #include "renderer/vulkan/vulkan_types.inl"
 
+// push_constant_size bytes of push constants are visible to the vertex and
+// fragment stages, 0 for none. At most VULKAN_MAX_PUSH_CONSTANT_SIZE.
 bool vulkan_graphics_pipeline_create(
-    vulkan_context *context, vulkan_renderpass *renderpass, u32 attribute_count,
+    vulkan_context *context, vulkan_renderpass *renderpass, u32 binding_count,
+    VkVertexInputBindingDescription *bindings, u32 attribute_count,
     VkVertexInputAttributeDescription *attributes,
     u32 descriptor_set_layout_count,
-    VkDescriptorSetLayout *descriptor_set_layouts, u32 stage_count,
-    VkPipelineShaderStageCreateInfo *stages, VkViewport viewport,
-    VkRect2D scissor, bool is_wireframe, vulkan_pipeline *out_pipeline);
+    VkDescriptorSetLayout *descriptor_set_layouts, u32 push_constant_size,
+    u32 stage_count, VkPipelineShaderStageCreateInfo *stages,
+    bool is_wireframe, vulkan_pipeline *out_pipeline);
+
+// push_constant_size bytes of push constants are visible to the shader, 0 for
+// none
+bool vulkan_compute_pipeline_create(
+    vulkan_context *context, u32 descriptor_set_layout_count,
+    VkDescriptorSetLayout *descriptor_set_layouts, u32 push_constant_size,
+    VkPipelineShaderStageCreateInfo stage, vulkan_pipeline *out_pipeline);
 
 void vulkan_pipeline_destroy(vulkan_context *context,
                              vulkan_pipeline *pipeline);
@@ -0,0 +1,178 @@
+#include "renderer/vulkan/vulkan_pipeline_cache.h"
+#include "renderer/vulkan/vulkan_utils.h"
+
+#include "base/lai_memory.h"
+#include "base/log.h"
+
+#include "platform/filesystem.h"
+
+#define VULKAN_PIPELINE_CACHE_MAGIC 0x4341504c // "LPAC"
+#define VULKAN_PIPELINE_CACHE_VERSION 1
+
+// Precedes the driver's data in the file. Drivers reject foreign data on their
+// own, but not all of them do it gracefully.
+struct vulkan_pipeline_cache_header {
+  u32 magic;
+  u32 version;
+  u32 vendor_id;
+  u32 device_id;
+  u32 driver_version;
+  u8 uuid[VK_UUID_SIZE];
+  u64 data_size;
+};
+
+static void fill_header(vulkan_context *context, u64 data_size,
+                        vulkan_pipeline_cache_header *out_header) {
+  // Zeroed so the padding written to disk is deterministic
+  lai_zero_memory(out_header, sizeof(vulkan_pipeline_cache_header));
+  VkPhysicalDeviceProperties *properties = &context->device.properties;
+  out_header->magic = VULKAN_PIPELINE_CACHE_MAGIC;
+  out_header->version = VULKAN_PIPELINE_CACHE_VERSION;
+  out_header->vendor_id = properties->vendorID;
+  out_header->device_id = properties->deviceID;
+  out_header->driver_version = properties->driverVersion;
+  lai_copy_memory(out_header->uuid, properties->pipelineCacheUUID,
+                  VK_UUID_SIZE);
+  out_header->data_size = data_size;
+}
+
+// Returns the driver data in bytes when the file matches this device, or null
+static const u8 *validate_file(vulkan_context *context, const u8 *bytes,
+                               u64 size, u64 *out_data_size) {
+  if (size < sizeof(vulkan_pipeline_cache_header)) {
+    return nullptr;
+  }
+
+  vulkan_pipeline_cache_header file_header;
+  lai_copy_memory(&file_header, bytes, sizeof(vulkan_pipeline_cache_header));
+  vulkan_pipeline_cache_header expected;
+  fill_header(context, size - sizeof(vulkan_pipeline_cache_header), &expected);
+
+  if (file_header.magic != expected.magic ||
+      file_header.version != expected.version ||
+      file_header.vendor_id != expected.vendor_id ||
+      file_header.device_id != expected.device_id ||
+      file_header.driver_version != expected.driver_version ||
+      file_header.data_size != expected.data_size) {
+    return nullptr;
+  }
+  for (u32 i = 0; i < VK_UUID_SIZE; ++i) {
+    if (file_header.uuid[i] != expected.uuid[i]) {
+      return nullptr;
+    }
+  }
+
+  *out_data_size = file_header.data_size;
+  return bytes + sizeof(vulkan_pipeline_cache_header);
+}
+
+bool vulkan_pipeline_cache_create(vulkan_context *context, const char *path,
+                                  VkPipelineCache *out_cache) {
+  *out_cache = nullptr;
+
+  u8 *file_bytes = nullptr;
+  u64 file_size = 0;
+  if (filesystem_exists(path)) {
+    file_handle handle;
+    if (filesystem_open(path, FILE_MODE_READ, true, &handle)) {
+      if (!filesystem_read_all_bytes(&handle, &file_bytes, &file_size)) {
+        LAI_LOG_WARN("Could not read the pipeline cache: %s", path);
+        file_size = 0;
+      }
+      filesystem_close(&handle);
+    }
+  }
+
+  VkPipelineCacheCreateInfo create_info = {
+      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+  u64 data_size = 0;
+  const u8 *data = validate_file(context, file_bytes, file_size, &data_size);
+  if (data) {
+    create_info.initialDataSize = data_size;
+    create_info.pInitialData = data;
+  } else if (file_size > 0) {
+    LAI_LOG_INFO("Pipeline cache %s is stale or from another device, "
+                 "starting empty",
+                 path);
+  }
+
+  VkResult result =
+      vkCreatePipelineCache(context->device.logical_device, &create_info,
+                            context->allocator, out_cache);
+  if (!vulkan_result_is_success(result) && data) {
+    // The driver may still refuse the data, an empty cache is better than none.
+    create_info.initialDataSize = 0;
+    create_info.pInitialData = nullptr;
+    result = vkCreatePipelineCache(context->device.logical_device, &create_info,
+                                   context->allocator, out_cache);
+  }
+
+  if (file_bytes) {
+    lai_free(file_bytes, sizeof(u8) * file_size, MEMORY_TAG_STRING);
+  }
+
+  if (!vulkan_result_is_success(result)) {
+    LAI_LOG_ERROR("vkCreatePipelineCache failed with %s.",
+                  vulkan_result_string(result, true));
+    *out_cache = nullptr;
+    return false;
+  }
+
+  LAI_LOG_INFO("Pipeline cache created, %llu bytes loaded", data_size);
+  return true;
+}
+
+bool vulkan_pipeline_cache_save(vulkan_context *context, const char *path,
+                                VkPipelineCache cache) {
+  if (!cache) {
+    return false;
+  }
+
+  size_t data_size = 0;
+  VK_CHECK(vkGetPipelineCacheData(context->device.logical_device, cache,
+                                  &data_size, nullptr));
+  if (data_size == 0) {
+    return true;
+  }
+
+  u64 file_size = sizeof(vulkan_pipeline_cache_header) + data_size;
+  u8 *file_bytes = (u8 *)lai_allocate(file_size, MEMORY_TAG_RENDERER);
+  fill_header(context, data_size,
+              (vulkan_pipeline_cache_header *)file_bytes);
+
+  bool success = false;
+  // The size may shrink between the two calls, never grow past the first.
+  VkResult result = vkGetPipelineCacheData(
+      context->device.logical_device, cache, &data_size,
+      file_bytes + sizeof(vulkan_pipeline_cache_header));
+  if (vulkan_result_is_success(result)) {
+    ((vulkan_pipeline_cache_header *)file_bytes)->data_size = data_size;
+    u64 write_size = sizeof(vulkan_pipeline_cache_header) + data_size;
+
+    file_handle handle;
+    if (filesystem_open(path, FILE_MODE_WRITE, true, &handle)) {
+      u64 written = 0;
+      success = filesystem_write(&handle, write_size, file_bytes, &written) &&
+                written == write_size;
+      filesystem_close(&handle);
+    }
+  }
+
+  lai_free(file_bytes, file_size, MEMORY_TAG_RENDERER);
+
+  if (!success) {
+    LAI_LOG_WARN("Could not save the pipeline cache: %s", path);
+    return false;
+  }
+  LAI_LOG_INFO("Pipeline cache saved, %llu bytes", (u64)data_size);
+  return true;
+}
+
+void vulkan_pipeline_cache_destroy(vulkan_context *context,
+                                   VkPipelineCache *cache) {
+  if (*cache) {
+    vkDestroyPipelineCache(context->device.logical_device, *cache,
+                           context->allocator);
+    *cache = nullptr;
+  }
+}
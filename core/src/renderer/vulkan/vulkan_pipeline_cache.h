@@ -0,0 +1,19 @@
+#pragma once
+
+#include "renderer/vulkan/vulkan_types.inl"
+
+// Relative to the working directory, like the shader assets
+#define VULKAN_PIPELINE_CACHE_PATH "vulkan_pipeline_cache.bin"
+
+// Seeds the cache with the file at path when it was written by the same
+// device and driver, otherwise starts empty. out_cache is null on failure,
+// pipelines are then created without a cache.
+bool vulkan_pipeline_cache_create(vulkan_context *context, const char *path,
+                                  VkPipelineCache *out_cache);
+
+// Writes the cache to path so the next run can reuse it
+bool vulkan_pipeline_cache_save(vulkan_context *context, const char *path,
+                                VkPipelineCache cache);
+
+void vulkan_pipeline_cache_destroy(vulkan_context *context,
+                                   VkPipelineCache *cache);
@@ -0,0 +1,162 @@
+#include "renderer/vulkan/vulkan_record_workers.h"
+#include "renderer/vulkan/vulkan_command_buffer.h"
+
+#include "base/lai_memory.h"
+#include "base/log.h"
+
+#include "containers/darray.h"
+
+static u32 record_worker_main(void *params) {
+  vulkan_record_worker *worker = (vulkan_record_worker *)params;
+  vulkan_record_workers *owner = worker->owner;
+
+  while (true) {
+    platform_semaphore_wait(&worker->start);
+    if (owner->quit) {
+      break;
+    }
+
+    vulkan_command_buffer_begin_secondary(
+        worker->command_buffer, owner->renderpass, owner->framebuffer);
+    owner->record(worker->command_buffer, worker->first_item,
+                  worker->item_count, owner->user_data);
+    vulkan_command_buffer_end(worker->command_buffer);
+
+    platform_semaphore_signal(&owner->done);
+  }
+  return 0;
+}
+
+bool vulkan_record_workers_create(vulkan_context *context, u32 worker_count,
+                                  vulkan_record_workers *out_workers) {
+  lai_zero_memory(out_workers, sizeof(vulkan_record_workers));
+  if (worker_count == 0) {
+    return true;
+  }
+  if (worker_count > VULKAN_MAX_RECORD_WORKERS) {
+    worker_count = VULKAN_MAX_RECORD_WORKERS;
+  }
+
+  if (!platform_semaphore_create(0, &out_workers->done)) {
+    LAI_LOG_ERROR("Failed to create the record workers' semaphore");
+    return false;
+  }
+
+  u32 frame_count = context->swapchain.max_frames_in_flight;
+  out_workers->workers = darray_reserve(vulkan_record_worker, worker_count);
+  for (u32 i = 0; i < worker_count; ++i) {
+    vulkan_record_worker *worker = &out_workers->workers[i];
+    lai_zero_memory(worker, sizeof(vulkan_record_worker));
+    worker->owner = out_workers;
+
+    worker->command_pools = darray_reserve(VkCommandPool, frame_count);
+    worker->command_buffers =
+        darray_reserve(vulkan_command_buffer, frame_count);
+    for (u32 frame = 0; frame < frame_count; ++frame) {
+      vulkan_command_pool_create(context, context->device.graphics_queue_index,
+                                 VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                                 &worker->command_pools[frame]);
+      vulkan_command_buffer_allocate(context, worker->command_pools[frame],
+                                     false, &worker->command_buffers[frame]);
+    }
+
+    if (!platform_semaphore_create(0, &worker->start) ||
+        !platform_thread_create(record_worker_main, worker, &worker->thread)) {
+      LAI_LOG_ERROR("Failed to start record worker %u", i);
+      vulkan_record_workers_destroy(context, out_workers);
+      return false;
+    }
+    // Only running workers are joined on destroy.
+    out_workers->worker_count++;
+  }
+
+  LAI_LOG_INFO("Vulkan record workers created: %u", worker_count);
+  return true;
+}
+
+void vulkan_record_workers_destroy(vulkan_context *context,
+                                   vulkan_record_workers *workers) {
+  if (!workers->workers) {
+    return;
+  }
+
+  workers->quit = true;
+  for (u32 i = 0; i < workers->worker_count; ++i) {
+    platform_semaphore_signal(&workers->workers[i].start);
+    platform_thread_join(&workers->workers[i].thread);
+  }
+
+  // Also covers a worker whose thread failed to start.
+  u32 allocated_count = darray_capacity(workers->workers);
+  for (u32 i = 0; i < allocated_count; ++i) {
+    vulkan_record_worker *worker = &workers->workers[i];
+    if (worker->start.internal_data) {
+      platform_semaphore_destroy(&worker->start);
+    }
+    if (worker->command_pools) {
+      u32 pool_count = darray_capacity(worker->command_pools);
+      for (u32 frame = 0; frame < pool_count; ++frame) {
+        vulkan_command_pool_destroy(context, &worker->command_pools[frame]);
+      }
+      darray_destroy(worker->command_pools);
+    }
+    if (worker->command_buffers) {
+      darray_destroy(worker->command_buffers);
+    }
+  }
+  darray_destroy(workers->workers);
+  platform_semaphore_destroy(&workers->done);
+  lai_zero_memory(workers, sizeof(vulkan_record_workers));
+}
+
+u32 vulkan_record_workers_worker_count_for(vulkan_record_workers *workers,
+                                           u32 item_count) {
+  u32 count = item_count / VULKAN_RECORD_MIN_ITEMS_PER_WORKER;
+  count = count < workers->worker_count ? count : workers->worker_count;
+  // A single worker would only add a hand-off.
+  return count > 1 ? count : 0;
+}
+
+u32 vulkan_record_workers_record(vulkan_context *context,
+                                 vulkan_record_workers *workers,
+                                 VkRenderPass renderpass,
+                                 VkFramebuffer framebuffer, u32 item_count,
+                                 PFN_vulkan_record_items record,
+                                 void *user_data,
+                                 VkCommandBuffer *out_command_buffers) {
+  u32 worker_count =
+      vulkan_record_workers_worker_count_for(workers, item_count);
+  if (worker_count == 0) {
+    return 0;
+  }
+
+  workers->record = record;
+  workers->user_data = user_data;
+  workers->renderpass = renderpass;
+  workers->framebuffer = framebuffer;
+
+  // Contiguous shares keep the draw order when executed in worker order.
+  u32 share = (item_count + worker_count - 1) / worker_count;
+  u32 first_item = 0;
+  u32 used_count = 0;
+  for (u32 i = 0; i < worker_count && first_item < item_count; ++i) {
+    vulkan_record_worker *worker = &workers->workers[i];
+    // The frame was waited on, its buffers are no longer pending.
+    vulkan_command_pool_reset(context,
+                              worker->command_pools[context->current_frame]);
+    worker->command_buffer = &worker->command_buffers[context->current_frame];
+    vulkan_command_buffer_reset(worker->command_buffer);
+    worker->first_item = first_item;
+    worker->item_count =
+        item_count - first_item < share ? item_count - first_item : share;
+    first_item += worker->item_count;
+
+    out_command_buffers[used_count++] = worker->command_buffer->handle;
+    platform_semaphore_signal(&worker->start);
+  }
+
+  for (u32 i = 0; i < used_count; ++i) {
+    platform_semaphore_wait(&workers->done);
+  }
+  return used_count;
+}
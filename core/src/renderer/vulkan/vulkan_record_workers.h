@@ -0,0 +1,35 @@
+#pragma once
+
+#include "renderer/vulkan/vulkan_types.inl"
+
+// Fewer items than this per worker are not worth a thread
+#define VULKAN_RECORD_MIN_ITEMS_PER_WORKER 128
+
+// Upper bound of worker threads
+#define VULKAN_MAX_RECORD_WORKERS 8
+
+// With a worker_count of 0 nothing is created and every record call has to
+// be done inline.
+bool vulkan_record_workers_create(vulkan_context *context, u32 worker_count,
+                                  vulkan_record_workers *out_workers);
+
+// The device must be idle
+void vulkan_record_workers_destroy(vulkan_context *context,
+                                   vulkan_record_workers *workers);
+
+// Number of workers item_count items would be split across, 0 when they are
+// better recorded inline
+u32 vulkan_record_workers_worker_count_for(vulkan_record_workers *workers,
+                                           u32 item_count);
+
+// Splits the items across the workers, each records its share into the
+// current frame's secondary command buffer. Blocks until all are recorded and
+// returns the handles to execute in order from the primary command buffer,
+// which has to be inside renderpass with secondary command buffer contents.
+u32 vulkan_record_workers_record(vulkan_context *context,
+                                 vulkan_record_workers *workers,
+                                 VkRenderPass renderpass,
+                                 VkFramebuffer framebuffer, u32 item_count,
+                                 PFN_vulkan_record_items record,
+                                 void *user_data,
+                                 VkCommandBuffer *out_command_buffers);
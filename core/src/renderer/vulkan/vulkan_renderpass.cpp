@@ -36,7 +36,10 @@ void vulkan_renderpass_create(vulkan_context *context,
   color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
   color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
   color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  // Headless frames are never presented, at most copied from.
+  color_attachment.finalLayout = context->headless
+                                     ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                                     : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
   color_attachment.flags = 0;
 
   attachment_descriptions[0] = color_attachment;
@@ -96,6 +99,17 @@ void vulkan_renderpass_create(vulkan_context *context,
                              VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
   dependency.dependencyFlags = 0;
 
+  // Headless frames may be copied out right after the pass.
+  VkSubpassDependency dependencies[2];
+  dependencies[0] = dependency;
+  dependencies[1].srcSubpass = 0;
+  dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+  dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  dependencies[1].dependencyFlags = 0;
+
   // Renderpass create
   VkRenderPassCreateInfo renderpass_create_info = {};
   renderpass_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -103,8 +117,8 @@ void vulkan_renderpass_create(vulkan_context *context,
   renderpass_create_info.pAttachments = attachment_descriptions;
   renderpass_create_info.subpassCount = 1;
   renderpass_create_info.pSubpasses = &subpass;
-  renderpass_create_info.dependencyCount = 1;
-  renderpass_create_info.pDependencies = &dependency;
+  renderpass_create_info.dependencyCount = context->headless ? 2 : 1;
+  renderpass_create_info.pDependencies = dependencies;
   renderpass_create_info.pNext = nullptr;
   renderpass_create_info.flags = 0;
 
@@ -124,7 +138,8 @@ void vulkan_renderpass_destroy(vulkan_context *context,
 
 void vulkan_renderpass_begin(vulkan_command_buffer *command_buffer,
                              vulkan_renderpass *renderpass,
-                             VkFramebuffer frame_buffer) {
+                             VkFramebuffer frame_buffer,
+                             VkSubpassContents contents) {
   VkRenderPassBeginInfo begin_info = {};
   begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
   begin_info.renderPass = renderpass->handle;
@@ -146,8 +161,7 @@ void vulkan_renderpass_begin(vulkan_command_buffer *command_buffer,
   begin_info.clearValueCount = 2;
   begin_info.pClearValues = clear_values;
 
-  vkCmdBeginRenderPass(command_buffer->handle, &begin_info,
-                       VK_SUBPASS_CONTENTS_INLINE);
+  vkCmdBeginRenderPass(command_buffer->handle, &begin_info, contents);
   command_buffer->state = COMMAND_BUFFER_STATE_IN_RENDERPASS;
 }
 
@@ -0,0 +1,412 @@
+#include "renderer/vulkan/vulkan_staging.h"
+#include "renderer/vulkan/vulkan_buffer.h"
+#include "renderer/vulkan/vulkan_command_buffer.h"
+#include "renderer/vulkan/vulkan_utils.h"
+
+#include "base/lai_memory.h"
+#include "base/log.h"
+
+#include "containers/darray.h"
+
+// Keeps every copy source suitably aligned for any texel size
+#define VULKAN_STAGING_ALIGNMENT 16
+
+#define VULKAN_STAGING_CONSUMER_ACCESS                                         \
+  (VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |            \
+   VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT |                    \
+   VK_ACCESS_TRANSFER_READ_BIT)
+
+static u64 align_up(u64 value, u64 alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static bool wait_for_region(vulkan_context *context, vulkan_staging_ring *ring,
+                            vulkan_staging_region *region) {
+  if (region->timeline_value == 0) {
+    return true;
+  }
+
+  VkSemaphoreWaitInfo wait_info = {VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+  wait_info.semaphoreCount = 1;
+  wait_info.pSemaphores = &ring->timeline;
+  wait_info.pValues = &region->timeline_value;
+
+  VkResult result =
+      vkWaitSemaphores(context->device.logical_device, &wait_info, UINT64_MAX);
+  if (!vulkan_result_is_success(result)) {
+    LAI_LOG_ERROR("Staging region wait failed with result: '%s'",
+                  vulkan_result_string(result, true));
+    return false;
+  }
+  return true;
+}
+
+bool vulkan_staging_create(vulkan_context *context, u64 region_size,
+                           u32 region_count, vulkan_staging_ring *out_ring) {
+  lai_zero_memory(out_ring, sizeof(vulkan_staging_ring));
+  out_ring->region_size = align_up(region_size, VULKAN_STAGING_ALIGNMENT);
+  out_ring->region_count = region_count > 0 ? region_count : 1;
+  out_ring->ownership_transfer = context->device.transfer_queue_index !=
+                                 context->device.graphics_queue_index;
+
+  u32 memory_property_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                              VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  if (!vulkan_buffer_create(context,
+                            out_ring->region_size * out_ring->region_count,
+                            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                            memory_property_flags, true, &out_ring->buffer)) {
+    LAI_LOG_ERROR("Failed to create the staging buffer");
+    return false;
+  }
+
+  VkSemaphoreTypeCreateInfo type_create_info = {
+      VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+  type_create_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  type_create_info.initialValue = 0;
+
+  VkSemaphoreCreateInfo semaphore_create_info = {
+      VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+  semaphore_create_info.pNext = &type_create_info;
+  VK_CHECK(vkCreateSemaphore(context->device.logical_device,
+                             &semaphore_create_info, context->allocator,
+                             &out_ring->timeline));
+
+  out_ring->regions =
+      darray_reserve(vulkan_staging_region, out_ring->region_count);
+  for (u32 i = 0; i < out_ring->region_count; ++i) {
+    vulkan_staging_region *region = &out_ring->regions[i];
+    lai_zero_memory(region, sizeof(vulkan_staging_region));
+    vulkan_command_pool_create(context, context->device.transfer_queue_index,
+                               VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                               &region->command_pool);
+    vulkan_command_buffer_allocate(context, region->command_pool, true,
+                                   &region->command_buffer);
+  }
+
+  out_ring->release_barriers = darray_create(VkBufferMemoryBarrier);
+  out_ring->acquire_barriers = darray_create(VkBufferMemoryBarrier);
+  out_ring->image_acquire_barriers = darray_create(VkImageMemoryBarrier);
+
+  LAI_LOG_INFO("Vulkan staging ring created: %u regions of %llu bytes%s",
+               out_ring->region_count, out_ring->region_size,
+               out_ring->ownership_transfer ? ", dedicated transfer queue"
+                                            : "");
+  return true;
+}
+
+void vulkan_staging_destroy(vulkan_context *context,
+                            vulkan_staging_ring *ring) {
+  if (ring->regions) {
+    for (u32 i = 0; i < ring->region_count; ++i) {
+      vulkan_command_pool_destroy(context, &ring->regions[i].command_pool);
+    }
+    darray_destroy(ring->regions);
+    ring->regions = nullptr;
+  }
+
+  if (ring->release_barriers) {
+    darray_destroy(ring->release_barriers);
+  }
+  if (ring->acquire_barriers) {
+    darray_destroy(ring->acquire_barriers);
+  }
+  if (ring->image_acquire_barriers) {
+    darray_destroy(ring->image_acquire_barriers);
+  }
+
+  if (ring->timeline) {
+    vkDestroySemaphore(context->device.logical_device, ring->timeline,
+                       context->allocator);
+  }
+
+  vulkan_buffer_destroy(context, &ring->buffer);
+  lai_zero_memory(ring, sizeof(vulkan_staging_ring));
+}
+
+bool vulkan_staging_upload(vulkan_context *context, vulkan_staging_ring *ring,
+                           vulkan_buffer *dest, u64 dest_offset, u64 size,
+                           const void *data) {
+  u8 *mapped = (u8 *)ring->buffer.allocation.mapped;
+  if (!mapped) {
+    LAI_LOG_ERROR("vulkan_staging_upload called before the ring was created");
+    return false;
+  }
+
+  const u8 *source = (const u8 *)data;
+  while (size > 0) {
+    vulkan_staging_region *region = &ring->regions[ring->current_region];
+    u64 offset = align_up(region->used, VULKAN_STAGING_ALIGNMENT);
+    if (offset >= ring->region_size) {
+      // Full, hand it to the gpu and continue in the next region.
+      if (!vulkan_staging_flush(context, ring)) {
+        return false;
+      }
+      continue;
+    }
+
+    u64 chunk = ring->region_size - offset;
+    chunk = chunk < size ? chunk : size;
+
+    if (region->copy_count == 0) {
+      vulkan_command_buffer_begin(&region->command_buffer, true, false, false);
+    }
+
+    u64 ring_offset = ring->region_size * ring->current_region + offset;
+    lai_copy_memory(mapped + ring_offset, source, chunk);
+
+    VkBufferCopy copy_region;
+    copy_region.srcOffset = ring_offset;
+    copy_region.dstOffset = dest_offset;
+    copy_region.size = chunk;
+    vkCmdCopyBuffer(region->command_buffer.handle, ring->buffer.handle,
+                    dest->handle, 1, &copy_region);
+
+    if (ring->ownership_transfer) {
+      VkBufferMemoryBarrier barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+      barrier.srcQueueFamilyIndex = context->device.transfer_queue_index;
+      barrier.dstQueueFamilyIndex = context->device.graphics_queue_index;
+      barrier.buffer = dest->handle;
+      barrier.offset = dest_offset;
+      barrier.size = chunk;
+      darray_push(ring->release_barriers, barrier);
+    }
+
+    region->used = offset + chunk;
+    region->copy_count++;
+
+    source += chunk;
+    dest_offset += chunk;
+    size -= chunk;
+  }
+
+  return true;
+}
+
+bool vulkan_staging_upload_image(vulkan_context *context,
+                                 vulkan_staging_ring *ring, vulkan_image *dest,
+                                 u32 mip_level, u32 width, u32 height,
+                                 u32 texel_size, const void *data) {
+  u8 *mapped = (u8 *)ring->buffer.allocation.mapped;
+  if (!mapped) {
+    LAI_LOG_ERROR(
+        "vulkan_staging_upload_image called before the ring was created");
+    return false;
+  }
+
+  u64 row_size = (u64)width * texel_size;
+  if (row_size > ring->region_size) {
+    LAI_LOG_ERROR("Image row of %llu bytes does not fit in a staging region "
+                  "of %llu bytes",
+                  row_size, ring->region_size);
+    return false;
+  }
+
+  VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = dest->handle;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = mip_level;
+  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+
+  // Levels larger than a region are copied in bands of rows. The level stays
+  // in TRANSFER_DST_OPTIMAL until the last band, regions are submitted to the
+  // transfer queue in order.
+  const u8 *source = (const u8 *)data;
+  u32 first_row = 0;
+  while (first_row < height) {
+    vulkan_staging_region *region = &ring->regions[ring->current_region];
+    u64 offset = align_up(region->used, VULKAN_STAGING_ALIGNMENT);
+    if (offset + row_size > ring->region_size) {
+      if (!vulkan_staging_flush(context, ring)) {
+        return false;
+      }
+      continue;
+    }
+
+    u32 row_count = (u32)((ring->region_size - offset) / row_size);
+    row_count = row_count < height - first_row ? row_count : height - first_row;
+    u64 size = row_size * row_count;
+
+    if (region->copy_count == 0) {
+      vulkan_command_buffer_begin(&region->command_buffer, true, false, false);
+    }
+
+    u64 ring_offset = ring->region_size * ring->current_region + offset;
+    lai_copy_memory(mapped + ring_offset, source, size);
+
+    if (first_row == 0) {
+      barrier.srcAccessMask = 0;
+      barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      vkCmdPipelineBarrier(region->command_buffer.handle,
+                           VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                           nullptr, 1, &barrier);
+    }
+
+    VkBufferImageCopy copy_region;
+    lai_zero_memory(&copy_region, sizeof(VkBufferImageCopy));
+    copy_region.bufferOffset = ring_offset;
+    copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy_region.imageSubresource.mipLevel = mip_level;
+    copy_region.imageSubresource.baseArrayLayer = 0;
+    copy_region.imageSubresource.layerCount = 1;
+    copy_region.imageOffset.y = (i32)first_row;
+    copy_region.imageExtent.width = width;
+    copy_region.imageExtent.height = row_count;
+    copy_region.imageExtent.depth = 1;
+    vkCmdCopyBufferToImage(region->command_buffer.handle, ring->buffer.handle,
+                           dest->handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           1, &copy_region);
+
+    region->used = offset + size;
+    region->copy_count++;
+    source += size;
+    first_row += row_count;
+
+    if (first_row < height) {
+      continue;
+    }
+
+    // Released with the last band, the level is not written again before
+    // the acquire.
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    if (ring->ownership_transfer) {
+      barrier.srcQueueFamilyIndex = context->device.transfer_queue_index;
+      barrier.dstQueueFamilyIndex = context->device.graphics_queue_index;
+    }
+    vkCmdPipelineBarrier(region->command_buffer.handle,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                         0, nullptr, 1, &barrier);
+    if (ring->ownership_transfer) {
+      darray_push(ring->image_acquire_barriers, barrier);
+    }
+  }
+
+  return true;
+}
+
+bool vulkan_staging_flush(vulkan_context *context, vulkan_staging_ring *ring) {
+  vulkan_staging_region *region = &ring->regions[ring->current_region];
+  if (region->copy_count == 0) {
+    // Nothing was recorded, the region can simply be reused.
+    region->used = 0;
+    return true;
+  }
+
+  u32 release_count = darray_length(ring->release_barriers);
+  if (release_count > 0) {
+    // Release half of the ownership transfer, the graphics queue acquires.
+    for (u32 i = 0; i < release_count; ++i) {
+      ring->release_barriers[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      ring->release_barriers[i].dstAccessMask = 0;
+    }
+    vkCmdPipelineBarrier(region->command_buffer.handle,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                         release_count, ring->release_barriers, 0, nullptr);
+    for (u32 i = 0; i < release_count; ++i) {
+      darray_push(ring->acquire_barriers, ring->release_barriers[i]);
+    }
+    darray_clear(ring->release_barriers);
+  }
+
+  vulkan_command_buffer_end(&region->command_buffer);
+
+  region->timeline_value = ++ring->timeline_value;
+
+  VkTimelineSemaphoreSubmitInfo timeline_info = {
+      VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+  timeline_info.signalSemaphoreValueCount = 1;
+  timeline_info.pSignalSemaphoreValues = &region->timeline_value;
+
+  VkSubmitInfo submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+  submit_info.pNext = &timeline_info;
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &region->command_buffer.handle;
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &ring->timeline;
+
+  VkResult result =
+      vkQueueSubmit(context->device.transfer_queue, 1, &submit_info, 0);
+  if (result != VK_SUCCESS) {
+    LAI_LOG_ERROR("Staging vkQueueSubmit failed with result: '%s'",
+                  vulkan_result_string(result, true));
+    return false;
+  }
+  vulkan_command_buffer_update_submitted(&region->command_buffer);
+  ring->wait_value = region->timeline_value;
+
+  // Reclaim the next region once the gpu has consumed it.
+  ring->current_region = (ring->current_region + 1) % ring->region_count;
+  vulkan_staging_region *next = &ring->regions[ring->current_region];
+  if (!wait_for_region(context, ring, next)) {
+    return false;
+  }
+  vulkan_command_pool_reset(context, next->command_pool);
+  vulkan_command_buffer_reset(&next->command_buffer);
+  next->used = 0;
+  next->copy_count = 0;
+
+  return true;
+}
+
+bool vulkan_staging_wait_idle(vulkan_context *context,
+                              vulkan_staging_ring *ring) {
+  if (ring->timeline_value == 0) {
+    return true;
+  }
+
+  VkSemaphoreWaitInfo wait_info = {VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+  wait_info.semaphoreCount = 1;
+  wait_info.pSemaphores = &ring->timeline;
+  wait_info.pValues = &ring->timeline_value;
+
+  VkResult result =
+      vkWaitSemaphores(context->device.logical_device, &wait_info, UINT64_MAX);
+  if (!vulkan_result_is_success(result)) {
+    LAI_LOG_ERROR("Staging wait failed with result: '%s'",
+                  vulkan_result_string(result, true));
+    return false;
+  }
+  return true;
+}
+
+void vulkan_staging_acquire(vulkan_staging_ring *ring,
+                            vulkan_command_buffer *command_buffer,
+                            u64 *out_wait_value) {
+  *out_wait_value = ring->wait_value;
+  ring->wait_value = 0;
+
+  u32 acquire_count = darray_length(ring->acquire_barriers);
+  u32 image_acquire_count = darray_length(ring->image_acquire_barriers);
+  if (acquire_count == 0 && image_acquire_count == 0) {
+    return;
+  }
+
+  for (u32 i = 0; i < acquire_count; ++i) {
+    ring->acquire_barriers[i].srcAccessMask = 0;
+    ring->acquire_barriers[i].dstAccessMask = VULKAN_STAGING_CONSUMER_ACCESS;
+  }
+  // Same layouts as the release, the transition happens once.
+  for (u32 i = 0; i < image_acquire_count; ++i) {
+    ring->image_acquire_barriers[i].srcAccessMask = 0;
+    ring->image_acquire_barriers[i].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  }
+  // The submission waits on the timeline at the consumer stages, which this
+  // barrier chains onto.
+  vkCmdPipelineBarrier(command_buffer->handle, VULKAN_STAGING_CONSUMER_STAGES,
+                       VULKAN_STAGING_CONSUMER_STAGES, 0, 0, nullptr,
+                       acquire_count, ring->acquire_barriers,
+                       image_acquire_count, ring->image_acquire_barriers);
+  darray_clear(ring->acquire_barriers);
+  darray_clear(ring->image_acquire_barriers);
+}
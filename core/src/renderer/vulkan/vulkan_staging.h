@@ -0,0 +1,45 @@
+#pragma once
+
+#include "renderer/vulkan/vulkan_types.inl"
+
+// Stages where uploaded data is consumed on the graphics queue
+#define VULKAN_STAGING_CONSUMER_STAGES                                         \
+  (VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |  \
+   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT)
+
+bool vulkan_staging_create(vulkan_context *context, u64 region_size,
+                           u32 region_count, vulkan_staging_ring *out_ring);
+
+// The device must be idle
+void vulkan_staging_destroy(vulkan_context *context, vulkan_staging_ring *ring);
+
+// Copies data into the ring and records a copy into dest. Nothing is executed
+// until the next vulkan_staging_flush. Uploads larger than a region are split.
+bool vulkan_staging_upload(vulkan_context *context, vulkan_staging_ring *ring,
+                           vulkan_buffer *dest, u64 dest_offset, u64 size,
+                           const void *data);
+
+// Copies width * height texels of texel_size bytes into the ring and records
+// a copy into the level of the image, which then is in
+// SHADER_READ_ONLY_OPTIMAL. The previous contents of the level are discarded.
+// Levels larger than a region are split into bands of rows.
+bool vulkan_staging_upload_image(vulkan_context *context,
+                                 vulkan_staging_ring *ring, vulkan_image *dest,
+                                 u32 mip_level, u32 width, u32 height,
+                                 u32 texel_size, const void *data);
+
+// Submits the copies recorded in the current region to the transfer queue and
+// moves on to the next region, waiting for the gpu to be done with it first.
+bool vulkan_staging_flush(vulkan_context *context, vulkan_staging_ring *ring);
+
+// Blocks until every copy flushed so far has executed
+bool vulkan_staging_wait_idle(vulkan_context *context,
+                              vulkan_staging_ring *ring);
+
+// Records the queue family acquire of everything flushed so far into a
+// graphics command buffer. The submission of that command buffer has to wait
+// on ring->timeline for out_wait_value, which is 0 when there is nothing to
+// wait for.
+void vulkan_staging_acquire(vulkan_staging_ring *ring,
+                            vulkan_command_buffer *command_buffer,
+                            u64 *out_wait_value);
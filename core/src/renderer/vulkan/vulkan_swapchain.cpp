@@ -1,23 +1,65 @@
 #include "renderer/vulkan/vulkan_swapchain.h"
+#include "renderer/vulkan/vulkan_deletion_queue.h"
 #include "renderer/vulkan/vulkan_device.h"
 #include "renderer/vulkan/vulkan_image.h"
 
 #include "base/lai_memory.h"
 #include "base/log.h"
 
+// Headless swapchains are offscreen images, one per frame in flight
+#define VULKAN_HEADLESS_FRAMES_IN_FLIGHT 2
+
 void create(vulkan_context *context, u32 width, u32 height,
-            vulkan_swapchain *swapchain);
+            VkSwapchainKHR old_swapchain, vulkan_swapchain *swapchain);
 void destroy(vulkan_context *context, vulkan_swapchain *swapchain);
 
+// Hands everything to the deletion queue, frames in flight may still use it.
+static void retire(vulkan_context *context, vulkan_swapchain *swapchain) {
+  vulkan_deletion_queue *queue = &context->deletion_queue;
+  vulkan_deletion_queue_push_image(context, queue,
+                                   &swapchain->depth_attachment);
+
+  if (context->headless) {
+    // Their views are the swapchain's views.
+    for (u32 i = 0; i < swapchain->image_count; ++i) {
+      vulkan_deletion_queue_push_image(context, queue,
+                                       &swapchain->offscreen_images[i]);
+    }
+  } else {
+    for (u32 i = 0; i < swapchain->image_count; ++i) {
+      vulkan_deletion_queue_push_image_view(context, queue,
+                                            swapchain->views[i]);
+    }
+    vulkan_deletion_queue_push_swapchain(context, queue, swapchain->handle);
+  }
+
+  // The new swapchain may have a different number of images.
+  lai_free(swapchain->images, sizeof(VkImage) * swapchain->image_count,
+           MEMORY_TAG_RENDERER);
+  swapchain->images = nullptr;
+  lai_free(swapchain->views, sizeof(VkImageView) * swapchain->image_count,
+           MEMORY_TAG_RENDERER);
+  swapchain->views = nullptr;
+  if (swapchain->offscreen_images) {
+    lai_free(swapchain->offscreen_images,
+             sizeof(vulkan_image) * swapchain->image_count,
+             MEMORY_TAG_RENDERER);
+    swapchain->offscreen_images = nullptr;
+  }
+}
+
 void vulkan_swapchain_create(vulkan_context *context, u32 width, u32 height,
                              vulkan_swapchain *out_swapchain) {
-  create(context, width, height, out_swapchain);
+  create(context, width, height, nullptr, out_swapchain);
 }
 
 void vulkan_swapchain_recreate(vulkan_context *context, u32 width, u32 height,
                                vulkan_swapchain *out_swapchain) {
-  destroy(context, out_swapchain);
-  create(context, width, height, out_swapchain);
+  // Still valid until the deletion queue gets to it, so it can be handed
+  // over to its successor.
+  VkSwapchainKHR old_swapchain = out_swapchain->handle;
+  retire(context, out_swapchain);
+  create(context, width, height, old_swapchain, out_swapchain);
 }
 
 void vulkan_swapchain_destroy(vulkan_context *context,
@@ -30,13 +72,18 @@ bool vulkan_swapchain_acquire_next_image_index(
     VkSemaphore image_available_semaphore, VkFence fence,
     u32 *out_image_index) {
 
+  if (context->headless) {
+    // The frame was waited on, so its image is free.
+    *out_image_index = context->current_frame;
+    return true;
+  }
+
   VkResult result = vkAcquireNextImageKHR(
       context->device.logical_device, swapchain->handle, timeout_ns,
       image_available_semaphore, fence, out_image_index);
 
   if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-    vulkan_swapchain_recreate(context, context->framebuffer_width,
-                              context->framebuffer_height, swapchain);
+    context->swapchain_out_of_date = true;
     return false;
   } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
     LAI_LOG_FATAL("Failed to acquire swapchain image");
@@ -50,6 +97,11 @@ void vulkan_swapchain_present(vulkan_context *context,
                               VkQueue graphics_queue, VkQueue present_queue,
                               VkSemaphore render_complete_semaphore,
                               u32 present_image_index) {
+  if (context->headless) {
+    context->current_frame =
+        (context->current_frame + 1) % swapchain->max_frames_in_flight;
+    return;
+  }
 
   VkPresentInfoKHR present_info = {};
   present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -62,8 +114,8 @@ void vulkan_swapchain_present(vulkan_context *context,
 
   VkResult result = vkQueuePresentKHR(present_queue, &present_info);
   if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-    vulkan_swapchain_recreate(context, context->framebuffer_width,
-                              context->framebuffer_height, swapchain);
+    // Recreated at the start of the next frame
+    context->swapchain_out_of_date = true;
   } else if (result != VK_SUCCESS) {
     LAI_LOG_FATAL("Failed to present swapchain image");
   }
@@ -72,8 +124,73 @@ void vulkan_swapchain_present(vulkan_context *context,
       (context->current_frame + 1) % swapchain->max_frames_in_flight;
 }
 
+static void create_depth_attachment(vulkan_context *context, u32 width,
+                                    u32 height, vulkan_swapchain *swapchain) {
+  if (!vulkan_device_detect_depth_format(&context->device)) {
+    context->device.depth_format = VK_FORMAT_UNDEFINED;
+    LAI_LOG_FATAL("Failed to find a supported depth format");
+  }
+
+  // Depth view
+  vulkan_image_create(context, VK_IMAGE_TYPE_2D, width, height, 1,
+                      context->device.depth_format, VK_IMAGE_TILING_OPTIMAL,
+                      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true,
+                      VK_IMAGE_ASPECT_DEPTH_BIT, &swapchain->depth_attachment);
+}
+
+static void create_offscreen(vulkan_context *context, u32 width, u32 height,
+                             vulkan_swapchain *swapchain) {
+  // What the windowed path prefers, so both render the same
+  swapchain->image_format.format = VK_FORMAT_B8G8R8A8_UNORM;
+  swapchain->image_format.colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+  if (swapchain->max_frames_in_flight == 0) {
+    swapchain->max_frames_in_flight = VULKAN_HEADLESS_FRAMES_IN_FLIGHT;
+  }
+  // One image per frame in flight, frames never wait on each other's image.
+  swapchain->image_count = swapchain->max_frames_in_flight;
+  swapchain->handle = nullptr;
+
+  context->current_frame = 0;
+
+  if (!swapchain->images) {
+    swapchain->images = (VkImage *)lai_allocate(
+        sizeof(VkImage) * swapchain->image_count, MEMORY_TAG_RENDERER);
+  }
+  if (!swapchain->views) {
+    swapchain->views = (VkImageView *)lai_allocate(
+        sizeof(VkImageView) * swapchain->image_count, MEMORY_TAG_RENDERER);
+  }
+  if (!swapchain->offscreen_images) {
+    swapchain->offscreen_images = (vulkan_image *)lai_allocate(
+        sizeof(vulkan_image) * swapchain->image_count, MEMORY_TAG_RENDERER);
+  }
+
+  for (u32 i = 0; i < swapchain->image_count; ++i) {
+    vulkan_image *image = &swapchain->offscreen_images[i];
+    // Copied from for readback
+    vulkan_image_create(
+        context, VK_IMAGE_TYPE_2D, width, height, 1,
+        swapchain->image_format.format, VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true, VK_IMAGE_ASPECT_COLOR_BIT,
+        image);
+    swapchain->images[i] = image->handle;
+    swapchain->views[i] = image->view;
+  }
+
+  create_depth_attachment(context, width, height, swapchain);
+
+  LAI_LOG_INFO("Offscreen swapchain created: %ux%u", width, height);
+}
+
 void create(vulkan_context *context, u32 width, u32 height,
-            vulkan_swapchain *swapchain) {
+            VkSwapchainKHR old_swapchain, vulkan_swapchain *swapchain) {
+  if (context->headless) {
+    create_offscreen(context, width, height, swapchain);
+    return;
+  }
+
   VkExtent2D swapchain_extent = {};
   swapchain_extent.width = width;
   swapchain_extent.height = height;
@@ -125,13 +242,22 @@ void create(vulkan_context *context, u32 width, u32 height,
 
   u32 image_count =
       context->device.swapchain_support.capabilities.minImageCount + 1;
+  // Enough images for the configured frames to be in flight at once, plus
+  // the one being presented.
+  if (swapchain->max_frames_in_flight + 1u > image_count) {
+    image_count = swapchain->max_frames_in_flight + 1u;
+  }
   if (context->device.swapchain_support.capabilities.maxImageCount > 0 &&
       image_count >
           context->device.swapchain_support.capabilities.maxImageCount) {
     image_count = context->device.swapchain_support.capabilities.maxImageCount;
   }
 
-  swapchain->max_frames_in_flight = image_count - 1;
+  // Per frame resources are sized at the first creation and kept after.
+  if (swapchain->max_frames_in_flight == 0) {
+    swapchain->max_frames_in_flight =
+        image_count > 1 ? (u8)(image_count - 1) : 1;
+  }
 
   VkSwapchainCreateInfoKHR swapchain_create_info = {};
   swapchain_create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -162,7 +288,8 @@ void create(vulkan_context *context, u32 width, u32 height,
   swapchain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
   swapchain_create_info.presentMode = present_mode;
   swapchain_create_info.clipped = VK_TRUE;
-  swapchain_create_info.oldSwapchain = 0;
+  // Lets the presentation engine hand over images still being presented
+  swapchain_create_info.oldSwapchain = old_swapchain;
 
   VK_CHECK(vkCreateSwapchainKHR(context->device.logical_device,
                                 &swapchain_create_info, context->allocator,
@@ -204,18 +331,8 @@ void create(vulkan_context *context, u32 width, u32 height,
                                context->allocator, &swapchain->views[i]));
   }
 
-  if (!vulkan_device_detect_depth_format(&context->device)) {
-    context->device.depth_format = VK_FORMAT_UNDEFINED;
-    LAI_LOG_FATAL("Failed to find a supported depth format");
-  }
-
-  // Depth view
-  vulkan_image_create(context, VK_IMAGE_TYPE_2D, swapchain_extent.width,
-                      swapchain_extent.height, context->device.depth_format,
-                      VK_IMAGE_TILING_OPTIMAL,
-                      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true,
-                      VK_IMAGE_ASPECT_DEPTH_BIT, &swapchain->depth_attachment);
+  create_depth_attachment(context, swapchain_extent.width,
+                          swapchain_extent.height, swapchain);
 
   LAI_LOG_INFO("Swapchain created!");
 }
@@ -226,6 +343,14 @@ void destroy(vulkan_context *context, vulkan_swapchain *swapchain) {
   LAI_LOG_INFO("Destroying swapchain...");
   vulkan_image_destroy(context, &swapchain->depth_attachment);
 
+  if (context->headless) {
+    // Their views are the swapchain's views.
+    for (u32 i = 0; i < swapchain->image_count; ++i) {
+      vulkan_image_destroy(context, &swapchain->offscreen_images[i]);
+    }
+    return;
+  }
+
   for (u32 i = 0; i < swapchain->image_count; ++i) {
     vkDestroyImageView(context->device.logical_device, swapchain->views[i],
                        context->allocator);
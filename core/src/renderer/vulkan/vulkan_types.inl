@@ -2,18 +2,53 @@
 
 #include "base/asserts.h"
 #include "defines.h"
+#include "math/math_types.h"
+#include "memory/freelist.h"
+#include "platform/platform.h"
+#include "renderer/geometry_ranges.h"
+#include "renderer/renderer_types.inl"
 
 #include <vulkan/vulkan.h>
 
 #define VK_CHECK(expression)                                                   \
   { LAI_ASSERT(expression == VK_SUCCESS); }
 
+struct vulkan_memory_block {
+  VkDeviceMemory memory;
+  u64 size;
+  u32 memory_type_index;
+  // Buffers and linear images never share a block with optimal images, which
+  // keeps them bufferImageGranularity apart.
+  bool linear;
+  // Holds a single large allocation and is freed with it
+  bool dedicated;
+  // Host visible blocks stay mapped for their whole lifetime
+  void *mapped;
+  freelist free_ranges;
+};
+
+struct vulkan_allocation {
+  vulkan_memory_block *block;
+  VkDeviceMemory memory;
+  u64 offset;
+  u64 size;
+  // Null unless the memory is host visible
+  void *mapped;
+};
+
+struct vulkan_memory_allocator {
+  vulkan_memory_block **blocks;
+  u64 heap_used[VK_MAX_MEMORY_HEAPS];
+  u64 heap_reserved[VK_MAX_MEMORY_HEAPS];
+  u64 allocation_count;
+};
+
 struct vulkan_buffer {
   u64 total_size;
   VkBuffer handle;
   VkBufferUsageFlagBits usage;
   bool is_locked;
-  VkDeviceMemory memory;
+  vulkan_allocation allocation;
   i32 memory_index;
   u32 memory_property_flags;
 };
@@ -39,21 +74,61 @@ struct vulkan_device {
   VkQueue present_queue;
   VkQueue transfer_queue;
 
+  // Transient, for one-shot command buffers
   VkCommandPool graphics_command_pool;
 
   VkPhysicalDeviceProperties properties;
   VkPhysicalDeviceFeatures features;
   VkPhysicalDeviceMemoryProperties memory;
+  // Vulkan 1.2 drawIndirectCount, needed for gpu culling
+  bool supports_draw_indirect_count;
 
   VkFormat depth_format;
 };
 
 struct vulkan_image {
   VkImage handle;
-  VkDeviceMemory memory;
+  vulkan_allocation allocation;
   VkImageView view;
   u32 width;
   u32 height;
+  u32 mip_levels;
+};
+
+enum vulkan_deletion_type {
+  VULKAN_DELETION_TYPE_SWAPCHAIN,
+  VULKAN_DELETION_TYPE_FRAMEBUFFER,
+  VULKAN_DELETION_TYPE_IMAGE_VIEW,
+  VULKAN_DELETION_TYPE_IMAGE,
+  VULKAN_DELETION_TYPE_BUFFER,
+  VULKAN_DELETION_TYPE_GEOMETRY_RANGES,
+  VULKAN_DELETION_TYPE_TEXTURE_SLOT,
+  VULKAN_DELETION_TYPE_COMMAND_BUFFER
+};
+
+// A handle the cpu is done with, destroyed once the gpu is done with it too
+struct vulkan_deletion_entry {
+  vulkan_deletion_type type;
+  // Destroyed once this frame number has completed
+  u64 frame_number;
+  union {
+    VkSwapchainKHR swapchain;
+    VkFramebuffer framebuffer;
+    VkImageView image_view;
+    vulkan_image image;
+    vulkan_buffer buffer;
+    // Returned to the geometry ranges instead of being destroyed
+    geometry_range geometry_ranges;
+    // Index into the bindless texture array, reusable once freed
+    u32 texture_slot;
+    // From the device's graphics command pool
+    VkCommandBuffer command_buffer;
+  };
+};
+
+struct vulkan_deletion_queue {
+  // darray, in retirement order and so by frame number
+  vulkan_deletion_entry *entries;
 };
 
 enum vulkan_renderpass_state {
@@ -83,8 +158,12 @@ struct vulkan_framebuffer {
   vulkan_renderpass *renderpass;
 };
 
+// Upper bound of the configurable frames in flight
+#define VULKAN_MAX_FRAMES_IN_FLIGHT 4
+
 struct vulkan_swapchain {
   VkSurfaceFormatKHR image_format;
+  // Frames the cpu may record ahead of the gpu, fixed at the first creation
   u8 max_frames_in_flight;
   VkSwapchainKHR handle;
   u32 image_count;
@@ -94,6 +173,10 @@ struct vulkan_swapchain {
   vulkan_image depth_attachment;
 
   vulkan_framebuffer *framebuffers;
+
+  // Headless only, rendered into in place of presentable images. images and
+  // views point at these.
+  vulkan_image *offscreen_images;
 };
 
 enum vulkan_command_buffer_state {
@@ -111,9 +194,114 @@ struct vulkan_command_buffer {
   vulkan_command_buffer_state state;
 };
 
-struct vulkan_fence {
-  VkFence handle;
-  bool is_signaled;
+// One region per frame in flight. A region is written by the cpu while
+// recording copies and reclaimed once the timeline reaches its value.
+struct vulkan_staging_region {
+  // Transfer queue family, reset as a whole when the region is reclaimed
+  VkCommandPool command_pool;
+  vulkan_command_buffer command_buffer;
+  u64 timeline_value;
+  u64 used;
+  u32 copy_count;
+};
+
+// Persistently mapped ring of staging memory, copies are batched into one
+// transfer queue command buffer per region.
+struct vulkan_staging_ring {
+  vulkan_buffer buffer;
+  u64 region_size;
+  u32 region_count;
+  u32 current_region;
+  vulkan_staging_region *regions;
+
+  // Signaled by the transfer queue as regions complete
+  VkSemaphore timeline;
+  u64 timeline_value;
+  // Value the next graphics submission has to wait for, 0 when none
+  u64 wait_value;
+
+  // True when the transfer and graphics queue families differ, buffers then
+  // have to be released by one and acquired by the other.
+  bool ownership_transfer;
+  // Ranges written by the current region
+  VkBufferMemoryBarrier *release_barriers;
+  // Ranges submitted but not yet acquired by the graphics queue
+  VkBufferMemoryBarrier *acquire_barriers;
+  // Image levels released with their copy, not yet acquired
+  VkImageMemoryBarrier *image_acquire_barriers;
+};
+
+// Records a share of items into a secondary command buffer continuing the
+// main render pass. Called from the worker threads.
+typedef void (*PFN_vulkan_record_items)(vulkan_command_buffer *command_buffer,
+                                        u32 first_item, u32 item_count,
+                                        void *user_data);
+
+// Timestamp queries of a scope, indices into its frame's query pool
+struct vulkan_gpu_scope {
+  const char *name;
+  u32 depth;
+  u32 begin_query;
+  u32 end_query;
+};
+
+struct vulkan_gpu_profiler_frame {
+  VkQueryPool query_pool;
+  u32 query_count;
+  u32 scope_count;
+  vulkan_gpu_scope scopes[GPU_TIMINGS_MAX_SCOPES];
+};
+
+struct vulkan_gpu_profiler {
+  // False when the graphics queue can't write timestamps, scopes then only
+  // emit debug labels.
+  bool enabled;
+  // Seconds per timestamp tick
+  f64 timestamp_period;
+  // Bits of a timestamp that are valid, the rest is garbage
+  u64 timestamp_mask;
+  // darray, one per frame in flight
+  vulkan_gpu_profiler_frame *frames;
+  // Frame being recorded, null between frames
+  vulkan_gpu_profiler_frame *recording;
+  u32 depth;
+  u32 frame_scope;
+
+  // Results of the last frame resolved
+  gpu_timings timings;
+
+  // Null unless VK_EXT_debug_utils is enabled
+  PFN_vkCmdBeginDebugUtilsLabelEXT cmd_begin_label;
+  PFN_vkCmdEndDebugUtilsLabelEXT cmd_end_label;
+};
+
+// A thread with its own command pool, pools are not thread safe.
+struct vulkan_record_worker {
+  platform_thread thread;
+  platform_semaphore start;
+  // darrays, one pool and secondary command buffer per frame in flight
+  VkCommandPool *command_pools;
+  vulkan_command_buffer *command_buffers;
+  struct vulkan_record_workers *owner;
+
+  // Share of the current job
+  vulkan_command_buffer *command_buffer;
+  u32 first_item;
+  u32 item_count;
+};
+
+struct vulkan_record_workers {
+  u32 worker_count;
+  // darray, never resized as the threads hold pointers into it
+  vulkan_record_worker *workers;
+  platform_semaphore done;
+  bool quit;
+
+  // Current job, shared by all workers
+  PFN_vulkan_record_items record;
+  void *user_data;
+  VkRenderPass renderpass;
+  VkFramebuffer framebuffer;
 };
 
 struct vulkan_shader_stage {
@@ -127,9 +315,179 @@ struct vulkan_pipeline {
   VkPipelineLayout layout;
 };
 
+// Bindings a cached descriptor set layout can have
+#define VULKAN_MAX_DESCRIPTOR_BINDINGS 16
+
+struct vulkan_descriptor_layout_entry {
+  u64 hash;
+  u32 binding_count;
+  VkDescriptorSetLayoutBinding bindings[VULKAN_MAX_DESCRIPTOR_BINDINGS];
+  VkDescriptorBindingFlags binding_flags[VULKAN_MAX_DESCRIPTOR_BINDINGS];
+  VkDescriptorSetLayout layout;
+};
+
+// Owns every descriptor set layout, equal bindings share one layout.
+struct vulkan_descriptor_layout_cache {
+  // darray
+  vulkan_descriptor_layout_entry *entries;
+};
+
+// Allocates sets from pools created as the previous ones fill up. Sets are
+// never freed one by one, a reset returns all of them at once.
+struct vulkan_descriptor_allocator {
+  // darrays, sets are allocated from the last used pool
+  VkDescriptorPool *used_pools;
+  VkDescriptorPool *free_pools;
+  // Sets of the next pool created, doubles with each one
+  u32 sets_per_pool;
+};
+
+// Host visible and persistently mapped, one region per frame in flight.
+// Uniforms are copied in and bound with dynamic offsets, so per draw data
+// needs no descriptor writes.
+struct vulkan_uniform_ring {
+  vulkan_buffer buffer;
+  u64 region_size;
+  // Every allocation starts at a valid dynamic offset
+  u64 alignment;
+  // Region of the current frame and how much of it is taken
+  u64 region_offset;
+  u64 used;
+};
+
+// Size of each frame's region of the uniform ring
+#define VULKAN_UNIFORM_RING_REGION_SIZE (1024 * 1024)
+
+// Where a geometry lives in the shared vertex and index buffers, offsets and
+// counts are in elements.
+struct vulkan_geometry_data {
+  u32 id;
+  u32 generation;
+  u32 vertex_count;
+  u32 vertex_offset;
+  u32 index_count;
+  u32 index_offset;
+  // Bounding sphere in local space, center in xyz and radius in w
+  vec4 bounds;
+};
+
+// Max number of geometries the backend can hold at once
+#define VULKAN_MAX_GEOMETRY_COUNT 4096
+
+// Instances, and so batches, each frame in flight can draw
+#define VULKAN_MAX_INSTANCES_PER_FRAME (64 * 1024)
+
+// Input of the culling compute shader for one instance, std430 layout
+struct vulkan_cull_object {
+  vec4 bounds;
+  u32 index_count;
+  u32 first_index;
+  i32 vertex_offset;
+  u32 instance_index;
+};
+
+// Frustum culls instances and appends an indirect draw for each visible one
+struct vulkan_cull_shader {
+  vulkan_shader_stage stage;
+  // Owned by the context's layout cache
+  VkDescriptorSetLayout descriptor_set_layout;
+  vulkan_pipeline pipeline;
+
+  // One region per frame in flight, host visible
+  vulkan_buffer object_buffer;
+  vulkan_buffer draw_count_buffer;
+  u64 draw_count_stride;
+};
+
+// std140 uniform of the object shader, bound with a dynamic offset into the
+// uniform ring
+struct vulkan_global_uniform {
+  mat4 projection;
+  mat4 view;
+  // Added to material indices, selects the frame's materials
+  u32 material_base;
+  u32 padding[3];
+};
+
+// Slots of the bindless texture array and the material buffer
+#define VULKAN_MAX_TEXTURE_COUNT 1024
+#define VULKAN_MAX_MATERIAL_COUNT 1024
+
+// White, sampled by materials without a diffuse map and by textures with
+// nothing resident yet
+#define VULKAN_DEFAULT_TEXTURE_SLOT 0
+// Past the last material, drawn for geometry without a material
+#define VULKAN_DEFAULT_MATERIAL_SLOT VULKAN_MAX_MATERIAL_COUNT
+
+struct vulkan_texture_data {
+  vulkan_image image;
+  // Set from creation until the frames that may sample it have completed
+  bool in_use;
+};
+
+// One entry of the material buffer, std430 layout
+struct vulkan_material_data {
+  vec4 diffuse_color;
+  u32 diffuse_texture_index;
+  u32 padding[3];
+};
+
+// A single descriptor set holding every texture and material. It is bound
+// once per command buffer and draws select their material by index, so
+// texture changes neither break batches nor rebind descriptors.
+struct vulkan_bindless {
+  // Owned by the context's layout cache
+  VkDescriptorSetLayout descriptor_set_layout;
+  // Created for update after bind, slots are written while frames that
+  // don't use them are pending.
+  VkDescriptorPool descriptor_pool;
+  VkDescriptorSet descriptor_set;
+  VkSampler sampler;
+
+  // Host visible, one region per frame in flight, each holding
+  // VULKAN_MAX_MATERIAL_COUNT materials and the default one. Regions are
+  // refreshed from materials as their frames begin.
+  vulkan_buffer material_buffer;
+  u32 region_count;
+  // Regions still holding materials from before the last write
+  u32 stale_region_count;
+  // Index of the current frame's first material in material_buffer
+  u32 frame_material_base;
+  // diffuse_texture_index holds a texture handle here, translated to the
+  // handle's slot as regions are refreshed
+  vulkan_material_data materials[VULKAN_MAX_MATERIAL_COUNT + 1];
+
+  // Slots of the texture array
+  vulkan_texture_data textures[VULKAN_MAX_TEXTURE_COUNT];
+  // Texture handles, the slot each one samples, INVALID_ID when free. A
+  // handle moves to a new slot whenever its resident mips change, slots in
+  // use by frames in flight are never rewritten.
+  u32 handle_slots[VULKAN_MAX_TEXTURE_COUNT];
+};
+
+// Push constant bytes every device supports
+#define VULKAN_MAX_PUSH_CONSTANT_SIZE 128
+
+// Pushed before each draw of frames with few instances, which then skip the
+// instance buffer. std430 layout.
+struct vulkan_object_push_constants {
+  mat4 model;
+  // Non-zero when model replaces the instance's matrix
+  u32 use_push_model;
+  // INVALID_ID when the geometry has no material
+  u32 material_index;
+};
+
+// Frames with up to this many instances push their model matrices
+#define VULKAN_PUSH_CONSTANT_MAX_INSTANCES 64
+
 #define OBJECT_SHADER_STAGE_COUNT 2 // vertex and fragment
 struct vulkan_object_shader {
   vulkan_shader_stage stages[OBJECT_SHADER_STAGE_COUNT];
+  // Owned by the context's layout cache
+  VkDescriptorSetLayout descriptor_set_layout;
+  // Points at the uniform ring, written once. Set 1 is the bindless set.
+  VkDescriptorSet descriptor_set;
   vulkan_pipeline pipeline;
 };
 
@@ -140,6 +498,7 @@ struct vulkan_context {
   u64 framebuffer_size_last_generation;
   VkInstance instance;
   VkAllocationCallbacks *allocator;
+  // Null when headless
   VkSurfaceKHR surface;
 
 #ifdef LAI_DEBUG
@@ -148,30 +507,101 @@ struct vulkan_context {
 
   vulkan_device device;
 
+  vulkan_memory_allocator memory_allocator;
+
   vulkan_swapchain swapchain;
   vulkan_renderpass main_renderpass;
 
+  // Shared by all pipeline creation, persisted between runs. May be null.
+  VkPipelineCache pipeline_cache;
+
   vulkan_buffer object_vertex_buffer;
   vulkan_buffer object_index_buffer;
 
+  // Host visible, one region per frame in flight holding the model matrices
+  // and indirect draw commands of that frame's batches.
+  vulkan_buffer instance_buffer;
+  vulkan_buffer indirect_buffer;
+  // Host visible, the material slot of each instance, laid out like
+  // instance_buffer
+  vulkan_buffer instance_material_buffer;
+
+  vulkan_staging_ring staging;
+  // Timeline value of the uploads the current frame waits for
+  u64 upload_wait_value;
+
+  vulkan_descriptor_layout_cache descriptor_layout_cache;
+  // Sets that live as long as the backend
+  vulkan_descriptor_allocator descriptor_allocator;
+  // One per frame in flight for sets written every frame, reset once the
+  // frame has completed
+  vulkan_descriptor_allocator *frame_descriptor_allocators;
+
+  vulkan_uniform_ring uniform_ring;
+  // Dynamic offset of the current frame's global uniform
+  u32 global_uniform_offset;
+  // Of the current frame's camera, culls on the gpu
+  frustum view_frustum;
+
+  vulkan_bindless bindless;
+
+  // darrays, one pool and primary command buffer per frame in flight. The
+  // pool is reset as a whole once the frame has completed.
+  VkCommandPool *graphics_command_pools;
   vulkan_command_buffer *graphics_command_buffers;
 
+  // Record draws in parallel into secondary command buffers
+  vulkan_record_workers record_workers;
+
+  // Timestamps and debug labels of the frame's scopes
+  vulkan_gpu_profiler gpu_profiler;
+  // Open from the main render pass begin until end_frame ends it
+  u32 main_pass_scope;
+
   VkSemaphore *image_available_semaphores;
   VkSemaphore *queue_complete_semaphores;
 
-  u32 in_flight_fence_count;
-  vulkan_fence *in_flight_fences;
-  vulkan_fence **images_in_flight;
+  // Signaled with its frame number by each frame's submission
+  VkSemaphore frame_timeline;
 
   u32 image_index;
   u32 current_frame;
 
+  // Frames are numbered from 1 in submission order.
+  u64 submitted_frame_number;
+  // Every frame up to this one has completed on the gpu
+  u64 completed_frame_number;
+  // darray, number of the frame last submitted from each frame in flight
+  u64 *in_flight_frame_numbers;
+
+  // Handles retired while frames in flight may still use them
+  vulkan_deletion_queue deletion_queue;
+
   bool recreating_swapchain;
+  // Set by acquire or present, the swapchain is recreated on the next frame.
+  bool swapchain_out_of_date;
+
+  // No surface, the swapchain is made of offscreen images that are never
+  // presented.
+  bool headless;
+  // Headless frames are copied into readback_buffer, one region per frame in
+  // flight.
+  bool readback;
+  vulkan_buffer readback_buffer;
+  u64 readback_region_size;
+  // Frame in flight holding the last submitted frame, -1 when there is none
+  i32 readback_frame;
 
   vulkan_object_shader object_shader;
 
-  u64 geometry_vertex_offset;
-  u64 geometry_index_offset;
+  // Set when gpu culling was requested and the device supports it
+  bool gpu_culling;
+  vulkan_cull_shader cull_shader;
+
+  // Free ranges of object_vertex_buffer and object_index_buffer, in vertices
+  // and indices.
+  geometry_range_allocator geometry_ranges;
+  vulkan_geometry_data geometries[VULKAN_MAX_GEOMETRY_COUNT];
 
   i32 (*find_memory_index)(u32 type_filter, u32 property_flags);
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "renderer/vulkan/vulkan_uniform_ring.h"
+#include "renderer/vulkan/vulkan_buffer.h"
+
+#include "base/lai_memory.h"
+#include "base/log.h"
+
+bool vulkan_uniform_ring_create(vulkan_context *context, u64 region_size,
+                                u32 region_count,
+                                vulkan_uniform_ring *out_ring) {
+  lai_zero_memory(out_ring, sizeof(vulkan_uniform_ring));
+
+  u64 alignment =
+      context->device.properties.limits.minUniformBufferOffsetAlignment;
+  out_ring->alignment = alignment > 0 ? alignment : 1;
+  // Regions start at a valid offset too.
+  out_ring->region_size = (region_size + out_ring->alignment - 1) &
+                          ~(out_ring->alignment - 1);
+
+  if (!vulkan_buffer_create(context, out_ring->region_size * region_count,
+                            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            true, &out_ring->buffer)) {
+    LAI_LOG_ERROR("Error creating the uniform ring buffer");
+    return false;
+  }
+  return true;
+}
+
+void vulkan_uniform_ring_destroy(vulkan_context *context,
+                                 vulkan_uniform_ring *ring) {
+  vulkan_buffer_destroy(context, &ring->buffer);
+  lai_zero_memory(ring, sizeof(vulkan_uniform_ring));
+}
+
+void vulkan_uniform_ring_begin_frame(vulkan_uniform_ring *ring,
+                                     u32 frame_index) {
+  ring->region_offset = ring->region_size * frame_index;
+  ring->used = 0;
+}
+
+bool vulkan_uniform_ring_push(vulkan_uniform_ring *ring, u64 size,
+                              const void *data, u32 *out_offset) {
+  // The alignment is a power of two.
+  u64 offset = (ring->used + ring->alignment - 1) & ~(ring->alignment - 1);
+  if (offset + size > ring->region_size) {
+    return false;
+  }
+
+  ring->used = offset + size;
+  offset += ring->region_offset;
+  lai_copy_memory((u8 *)ring->buffer.allocation.mapped + offset, data, size);
+  *out_offset = (u32)offset;
+  return true;
+}
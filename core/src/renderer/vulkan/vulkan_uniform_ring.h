@@ -0,0 +1,21 @@
+#pragma once
+
+#include "renderer/vulkan/vulkan_types.inl"
+
+bool vulkan_uniform_ring_create(vulkan_context *context, u64 region_size,
+                                u32 region_count,
+                                vulkan_uniform_ring *out_ring);
+
+// The device must be idle
+void vulkan_uniform_ring_destroy(vulkan_context *context,
+                                 vulkan_uniform_ring *ring);
+
+// Starts over in the region of the frame in flight, which has to have
+// completed.
+void vulkan_uniform_ring_begin_frame(vulkan_uniform_ring *ring,
+                                     u32 frame_index);
+
+// Copies size bytes into the current region. out_offset is the dynamic offset
+// to bind them with, false when the region is full.
+bool vulkan_uniform_ring_push(vulkan_uniform_ring *ring, u64 size,
+                              const void *data, u32 *out_offset);
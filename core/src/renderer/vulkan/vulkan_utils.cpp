@@ -1,5 +1,9 @@
 #include "renderer/vulkan/vulkan_utils.h"
 
+#include "base/lai_string.h"
+
+#include "containers/darray.h"
+
 const char *vulkan_result_string(VkResult result, bool get_extended) {
   // From:
   // https://www.khronos.org/registry/vulkan/specs/1.2-extensions/man/html/VkResult.html
@@ -241,4 +245,44 @@ bool vulkan_result_is_success(VkResult result) {
   case VK_ERROR_UNKNOWN:
     return false;
   }
-}
\ No newline at end of file
+}
+
+static bool extensions_contain(const VkExtensionProperties *extensions,
+                               u32 extension_count,
+                               const char *extension_name) {
+  for (u32 i = 0; i < extension_count; ++i) {
+    if (strings_equal(extension_name, extensions[i].extensionName)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool vulkan_instance_supports_extension(const char *extension_name) {
+  u32 extension_count = 0;
+  VK_CHECK(vkEnumerateInstanceExtensionProperties(nullptr, &extension_count,
+                                                  nullptr));
+  VkExtensionProperties *extensions =
+      darray_reserve(VkExtensionProperties, extension_count);
+  VK_CHECK(vkEnumerateInstanceExtensionProperties(nullptr, &extension_count,
+                                                  extensions));
+
+  bool found = extensions_contain(extensions, extension_count, extension_name);
+  darray_destroy(extensions);
+  return found;
+}
+
+bool vulkan_device_supports_extension(VkPhysicalDevice device,
+                                      const char *extension_name) {
+  u32 extension_count = 0;
+  VK_CHECK(vkEnumerateDeviceExtensionProperties(device, nullptr,
+                                                &extension_count, nullptr));
+  VkExtensionProperties *extensions =
+      darray_reserve(VkExtensionProperties, extension_count);
+  VK_CHECK(vkEnumerateDeviceExtensionProperties(device, nullptr,
+                                                &extension_count, extensions));
+
+  bool found = extensions_contain(extensions, extension_count, extension_name);
+  darray_destroy(extensions);
+  return found;
+}
@@ -4,4 +4,8 @@
 
 const char *vulkan_result_string(VkResult result, bool get_extended);
 
-bool vulkan_result_is_success(VkResult result);
\ No newline at end of file
+bool vulkan_result_is_success(VkResult result);
+
+bool vulkan_instance_supports_extension(const char *extension_name);
+bool vulkan_device_supports_extension(VkPhysicalDevice device,
+                                      const char *extension_name);
@@ -0,0 +1,184 @@
+#include "systems/geometry_system.h"
+
+#include "base/lai_memory.h"
+#include "base/lai_string.h"
+#include "base/log.h"
+#include "platform/filesystem.h"
+#include "renderer/mesh_format.h"
+#include "renderer/renderer_frontend.h"
+
+struct geometry_reference {
+  u64 reference_count;
+  struct geometry geometry;
+  bool auto_release;
+};
+
+struct geometry_system_state {
+  geometry_system_config config;
+  // Lives right after the state in the same block
+  geometry_reference *registered_geometries;
+};
+
+static geometry_system_state *state_ptr;
+
+static void destroy_geometry(geometry *geometry) {
+  renderer_destroy_geometry(geometry);
+  geometry->id = INVALID_ID;
+  geometry->internal_id = INVALID_ID;
+  // The generation is kept, it keeps counting when the slot is reused.
+  lai_zero_memory(geometry->name, GEOMETRY_NAME_MAX_LENGTH);
+}
+
+bool geometry_system_initialize(u64 *memory_requirement, void *state,
+                                geometry_system_config config) {
+  if (config.max_geometry_count == 0) {
+    LAI_LOG_FATAL("geometry_system_initialize - config.max_geometry_count "
+                  "must be > 0");
+    return false;
+  }
+
+  u64 struct_requirement = sizeof(geometry_system_state);
+  u64 array_requirement =
+      sizeof(geometry_reference) * config.max_geometry_count;
+  *memory_requirement = struct_requirement + array_requirement;
+
+  if (!state) {
+    return true;
+  }
+
+  state_ptr = (geometry_system_state *)state;
+  state_ptr->config = config;
+  state_ptr->registered_geometries =
+      (geometry_reference *)((u8 *)state + struct_requirement);
+
+  for (u32 i = 0; i < config.max_geometry_count; ++i) {
+    geometry_reference *ref = &state_ptr->registered_geometries[i];
+    ref->reference_count = 0;
+    ref->auto_release = false;
+    ref->geometry.id = INVALID_ID;
+    ref->geometry.internal_id = INVALID_ID;
+    ref->geometry.generation = INVALID_ID;
+    lai_zero_memory(ref->geometry.name, GEOMETRY_NAME_MAX_LENGTH);
+  }
+
+  return true;
+}
+
+void geometry_system_shutdown(void *state) {
+  if (!state_ptr) {
+    return;
+  }
+
+  // Geometries still referenced are unloaded with the system.
+  for (u32 i = 0; i < state_ptr->config.max_geometry_count; ++i) {
+    geometry_reference *ref = &state_ptr->registered_geometries[i];
+    if (ref->geometry.id != INVALID_ID) {
+      destroy_geometry(&ref->geometry);
+    }
+  }
+  state_ptr = nullptr;
+}
+
+geometry *geometry_system_acquire_by_id(u32 id) {
+  if (id != INVALID_ID && id < state_ptr->config.max_geometry_count &&
+      state_ptr->registered_geometries[id].geometry.id != INVALID_ID) {
+    state_ptr->registered_geometries[id].reference_count++;
+    return &state_ptr->registered_geometries[id].geometry;
+  }
+
+  LAI_LOG_ERROR("geometry_system_acquire_by_id cannot load invalid geometry "
+                "id %u",
+                id);
+  return nullptr;
+}
+
+geometry *geometry_system_acquire_from_config(geometry_config config,
+                                              bool auto_release) {
+  geometry_reference *ref = nullptr;
+  u32 id = INVALID_ID;
+  for (u32 i = 0; i < state_ptr->config.max_geometry_count; ++i) {
+    if (state_ptr->registered_geometries[i].geometry.id == INVALID_ID) {
+      id = i;
+      ref = &state_ptr->registered_geometries[i];
+      break;
+    }
+  }
+
+  if (!ref) {
+    LAI_LOG_ERROR("Unable to obtain a free slot for geometry, adjust "
+                  "max_geometry_count");
+    return nullptr;
+  }
+
+  geometry *g = &ref->geometry;
+  g->id = id;
+  g->internal_id = INVALID_ID;
+  string_ncopy(g->name, config.name, GEOMETRY_NAME_MAX_LENGTH);
+
+  if (!renderer_create_geometry(g, config.vertex_count, config.vertices,
+                                config.index_count, config.indices)) {
+    LAI_LOG_ERROR("Failed to create geometry '%s'", g->name);
+    destroy_geometry(g);
+    return nullptr;
+  }
+  g->generation = g->generation == INVALID_ID ? 0 : g->generation + 1;
+
+  ref->reference_count = 1;
+  ref->auto_release = auto_release;
+  return g;
+}
+
+geometry *geometry_system_acquire_from_file(const char *path, u32 lod,
+                                            bool auto_release) {
+  file_mapping mapping;
+  if (!filesystem_map(path, &mapping)) {
+    return nullptr;
+  }
+  if (!mesh_file_validate(mapping.data, mapping.size)) {
+    LAI_LOG_ERROR("Failed to load mesh file '%s'", path);
+    filesystem_unmap(&mapping);
+    return nullptr;
+  }
+
+  const mesh_file_header *header = (const mesh_file_header *)mapping.data;
+  if (lod >= header->lod_count) {
+    lod = header->lod_count - 1;
+  }
+  mesh_file_lod_view view;
+  mesh_file_get_lod(mapping.data, lod, &view);
+
+  // The arrays are copied to the staging ring right from the mapping, the
+  // file is read as they are.
+  geometry_config config;
+  config.vertex_count = view.lod->vertex_count;
+  config.vertices = view.vertices;
+  config.index_count = view.lod->index_count;
+  config.indices = view.indices;
+  string_ncopy(config.name, path, GEOMETRY_NAME_MAX_LENGTH);
+  geometry *g = geometry_system_acquire_from_config(config, auto_release);
+
+  filesystem_unmap(&mapping);
+  return g;
+}
+
+void geometry_system_release(geometry *geometry) {
+  if (!geometry || geometry->id == INVALID_ID) {
+    LAI_LOG_WARN("geometry_system_release called with an invalid geometry");
+    return;
+  }
+
+  geometry_reference *ref = &state_ptr->registered_geometries[geometry->id];
+  if (ref->geometry.id != geometry->id) {
+    LAI_LOG_FATAL("Geometry id mismatch, check registration logic");
+    return;
+  }
+
+  if (ref->reference_count > 0) {
+    ref->reference_count--;
+  }
+
+  if (ref->reference_count == 0 && ref->auto_release) {
+    destroy_geometry(&ref->geometry);
+    ref->auto_release = false;
+  }
+}
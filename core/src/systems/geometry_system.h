@@ -0,0 +1,36 @@
+#pragma once
+
+#include "renderer/renderer_types.inl"
+
+struct geometry_system_config {
+  // Max number of geometries that can be loaded at once
+  u32 max_geometry_count;
+};
+
+struct geometry_config {
+  u32 vertex_count;
+  const vertex_3d *vertices;
+  // Optional, the geometry is drawn non-indexed when 0
+  u32 index_count;
+  const u32 *indices;
+  char name[GEOMETRY_NAME_MAX_LENGTH];
+};
+
+bool geometry_system_initialize(u64 *memory_requirement, void *state,
+                                geometry_system_config config);
+void geometry_system_shutdown(void *state);
+
+// Adds a reference to an already loaded geometry
+geometry *geometry_system_acquire_by_id(u32 id);
+
+// Loads a geometry and uploads its data. With auto_release it is unloaded
+// when its last reference is released.
+geometry *geometry_system_acquire_from_config(geometry_config config,
+                                              bool auto_release);
+
+// Loads one lod of a mesh file cooked by mesh_cooker, uploading it straight
+// from a mapping of the file. Lods past the coarsest load the coarsest.
+geometry *geometry_system_acquire_from_file(const char *path, u32 lod,
+                                            bool auto_release);
+
+void geometry_system_release(geometry *geometry);
@@ -0,0 +1,181 @@
+#include "systems/material_system.h"
+#include "systems/texture_system.h"
+
+#include "base/lai_memory.h"
+#include "base/lai_string.h"
+#include "base/log.h"
+#include "containers/darray.h"
+#include "renderer/renderer_frontend.h"
+#include "renderer/texture_streaming.h"
+
+struct material_reference {
+  u64 reference_count;
+  struct material material;
+  bool auto_release;
+};
+
+struct material_system_state {
+  material_system_config config;
+  // Lives right after the state in the same block
+  material_reference *registered_materials;
+};
+
+static material_system_state *state_ptr;
+
+static void destroy_material(material *material) {
+  if (material->diffuse_map) {
+    texture_system_release(material->diffuse_map);
+    material->diffuse_map = nullptr;
+  }
+  // The gpu data stays until the id is loaded again, nothing draws with it.
+  material->id = INVALID_ID;
+  // The generation is kept, it keeps counting when the slot is reused.
+  lai_zero_memory(material->name, MATERIAL_NAME_MAX_LENGTH);
+}
+
+bool material_system_initialize(u64 *memory_requirement, void *state,
+                                material_system_config config) {
+  if (config.max_material_count == 0) {
+    LAI_LOG_FATAL("material_system_initialize - config.max_material_count "
+                  "must be > 0");
+    return false;
+  }
+
+  u64 struct_requirement = sizeof(material_system_state);
+  u64 array_requirement =
+      sizeof(material_reference) * config.max_material_count;
+  *memory_requirement = struct_requirement + array_requirement;
+
+  if (!state) {
+    return true;
+  }
+
+  state_ptr = (material_system_state *)state;
+  state_ptr->config = config;
+  state_ptr->registered_materials =
+      (material_reference *)((u8 *)state + struct_requirement);
+
+  for (u32 i = 0; i < config.max_material_count; ++i) {
+    material_reference *ref = &state_ptr->registered_materials[i];
+    lai_zero_memory(ref, sizeof(material_reference));
+    ref->material.id = INVALID_ID;
+    ref->material.generation = INVALID_ID;
+  }
+
+  return true;
+}
+
+void material_system_shutdown(void *state) {
+  if (!state_ptr) {
+    return;
+  }
+
+  // Materials still referenced are unloaded with the system.
+  for (u32 i = 0; i < state_ptr->config.max_material_count; ++i) {
+    material_reference *ref = &state_ptr->registered_materials[i];
+    if (ref->material.id != INVALID_ID) {
+      destroy_material(&ref->material);
+    }
+  }
+  state_ptr = nullptr;
+}
+
+material *material_system_acquire(const char *name) {
+  for (u32 i = 0; i < state_ptr->config.max_material_count; ++i) {
+    material_reference *ref = &state_ptr->registered_materials[i];
+    if (ref->material.id != INVALID_ID &&
+        strings_equal(ref->material.name, name)) {
+      ref->reference_count++;
+      return &ref->material;
+    }
+  }
+  return nullptr;
+}
+
+material *material_system_acquire_from_config(material_config config,
+                                              bool auto_release) {
+  material_reference *ref = nullptr;
+  u32 id = INVALID_ID;
+  for (u32 i = 0; i < state_ptr->config.max_material_count; ++i) {
+    if (state_ptr->registered_materials[i].material.id == INVALID_ID) {
+      id = i;
+      ref = &state_ptr->registered_materials[i];
+      break;
+    }
+  }
+
+  if (!ref) {
+    LAI_LOG_ERROR("Unable to obtain a free slot for material, adjust "
+                  "max_material_count");
+    return nullptr;
+  }
+
+  material *m = &ref->material;
+  m->id = id;
+  string_ncopy(m->name, config.name, MATERIAL_NAME_MAX_LENGTH);
+  m->diffuse_color = config.diffuse_color;
+  m->diffuse_map = nullptr;
+  if (config.diffuse_map_name[0] != 0) {
+    m->diffuse_map = texture_system_acquire(config.diffuse_map_name);
+    if (!m->diffuse_map) {
+      LAI_LOG_WARN("Material '%s' has no texture '%s', using its color only",
+                   m->name, config.diffuse_map_name);
+    }
+  }
+
+  if (!renderer_update_material(m)) {
+    LAI_LOG_ERROR("Failed to create material '%s'", m->name);
+    destroy_material(m);
+    return nullptr;
+  }
+  m->generation = m->generation == INVALID_ID ? 0 : m->generation + 1;
+
+  ref->reference_count = 1;
+  ref->auto_release = auto_release;
+  return m;
+}
+
+void material_system_release(material *material) {
+  if (!material || material->id == INVALID_ID) {
+    LAI_LOG_WARN("material_system_release called with an invalid material");
+    return;
+  }
+
+  material_reference *ref = &state_ptr->registered_materials[material->id];
+  if (ref->reference_count > 0) {
+    ref->reference_count--;
+  }
+
+  if (ref->reference_count == 0 && ref->auto_release) {
+    destroy_material(&ref->material);
+    ref->auto_release = false;
+  }
+}
+
+bool material_system_update(material *material) {
+  if (!material || material->id == INVALID_ID) {
+    LAI_LOG_WARN("material_system_update called with an invalid material");
+    return false;
+  }
+  return renderer_update_material(material);
+}
+
+void material_system_mark_texture_usage(const render_packet *packet,
+                                        u32 viewport_height) {
+  u32 draw_count = darray_length(packet->geometries);
+  for (u32 i = 0; i < draw_count; ++i) {
+    const geometry_render_data *draw = &packet->geometries[i];
+    if (!draw->geometry || draw->geometry->id == INVALID_ID ||
+        draw->material_id >= state_ptr->config.max_material_count) {
+      continue;
+    }
+    material *m = &state_ptr->registered_materials[draw->material_id].material;
+    if (m->id == INVALID_ID || !m->diffuse_map) {
+      continue;
+    }
+    f32 screen_size = texture_streaming_screen_size(
+        draw->geometry->bounds, draw->model, packet->view, packet->projection,
+        viewport_height);
+    texture_system_mark_used(m->diffuse_map, screen_size);
+  }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "renderer/renderer_types.inl"
+
+struct material_system_config {
+  // Max number of materials that can be loaded at once, material ids stay
+  // below it
+  u32 max_material_count;
+};
+
+struct material_config {
+  char name[MATERIAL_NAME_MAX_LENGTH];
+  vec4 diffuse_color;
+  // A texture loaded by the texture system, empty for a plain color
+  char diffuse_map_name[TEXTURE_NAME_MAX_LENGTH];
+};
+
+bool material_system_initialize(u64 *memory_requirement, void *state,
+                                material_system_config config);
+void material_system_shutdown(void *state);
+
+// Adds a reference to the loaded material called name, null when there is
+// none
+material *material_system_acquire(const char *name);
+
+// Loads a material and uploads its data. The diffuse map is referenced for as
+// long as the material is loaded. With auto_release the material is unloaded
+// when its last reference is released.
+material *material_system_acquire_from_config(material_config config,
+                                              bool auto_release);
+
+void material_system_release(material *material);
+
+// Uploads the material again after its color or map changed
+bool material_system_update(material *material);
+
+// Marks the diffuse maps of the packet's draws as used at the size they are
+// drawn at, for texture streaming. viewport_height is in pixels.
+void material_system_mark_texture_usage(const render_packet *packet,
+                                        u32 viewport_height);
@@ -0,0 +1,408 @@
+#include "systems/texture_system.h"
+
+#include "base/lai_memory.h"
+#include "base/lai_string.h"
+#include "base/log.h"
+#include "containers/darray.h"
+#include "platform/platform.h"
+#include "renderer/renderer_frontend.h"
+#include "renderer/texture_streaming.h"
+
+struct texture_reference {
+  u64 reference_count;
+  struct texture texture;
+  bool auto_release;
+  // The full mip chain, level after level in one block. Finer levels are
+  // streamed from it, so it lives as long as the texture.
+  u8 *mip_data;
+  u64 mip_data_size;
+  u8 *mip_pixels[TEXTURE_MAX_MIP_COUNT];
+  // Set while the loader builds the chain. The slot is not reused before it
+  // is done, even when the texture is destroyed meanwhile.
+  bool loading;
+};
+
+struct texture_system_state {
+  texture_system_config config;
+  // Lives right after the state in the same block
+  texture_reference *registered_textures;
+  // Indexed like registered_textures, after it in the block
+  texture_streaming_entry *streaming_entries;
+  // max_uploads_per_frame entries, after streaming_entries in the block
+  u32 *changed_entries;
+  u64 frame_number;
+
+  // Builds mip chains off the main thread, without it they are built on
+  // acquire.
+  bool has_loader;
+  volatile bool loader_running;
+  platform_thread loader;
+  // Counts the ids in load_queue
+  platform_semaphore load_requests;
+  // Guards the queues, darrays of texture ids
+  platform_mutex queue_mutex;
+  u32 *load_queue;
+  u32 *loaded_queue;
+};
+
+static texture_system_state *state_ptr;
+
+static void free_mip_data(texture_reference *ref) {
+  if (ref->mip_data) {
+    lai_free(ref->mip_data, ref->mip_data_size, MEMORY_TAG_TEXTURE);
+    ref->mip_data = nullptr;
+    ref->mip_data_size = 0;
+  }
+}
+
+static void destroy_texture(texture_reference *ref) {
+  texture *texture = &ref->texture;
+  state_ptr->streaming_entries[texture->id].streamable = false;
+  renderer_destroy_texture(texture);
+  texture->id = INVALID_ID;
+  texture->internal_id = INVALID_ID;
+  // The generation is kept, it keeps counting when the slot is reused.
+  lai_zero_memory(texture->name, TEXTURE_NAME_MAX_LENGTH);
+  // The loader frees a chain it is still building once it is done.
+  if (!ref->loading) {
+    free_mip_data(ref);
+  }
+}
+
+static void build_mip_chain(texture_reference *ref) {
+  u32 width = ref->texture.width;
+  u32 height = ref->texture.height;
+  for (u32 level = 1; level < ref->texture.mip_count; ++level) {
+    texture_generate_mip(width, height, ref->mip_pixels[level - 1],
+                         ref->mip_pixels[level]);
+    width = width > 1 ? width / 2 : 1;
+    height = height > 1 ? height / 2 : 1;
+  }
+}
+
+static u32 loader_main(void *params) {
+  for (;;) {
+    platform_semaphore_wait(&state_ptr->load_requests);
+    if (!state_ptr->loader_running) {
+      break;
+    }
+
+    u32 id;
+    platform_mutex_lock(&state_ptr->queue_mutex);
+    darray_pop_at(state_ptr->load_queue, 0, &id);
+    platform_mutex_unlock(&state_ptr->queue_mutex);
+
+    // Only the loader touches the chain while the texture is loading.
+    build_mip_chain(&state_ptr->registered_textures[id]);
+
+    platform_mutex_lock(&state_ptr->queue_mutex);
+    darray_push(state_ptr->loaded_queue, id);
+    platform_mutex_unlock(&state_ptr->queue_mutex);
+  }
+  return 0;
+}
+
+static bool start_loader() {
+  if (!platform_mutex_create(&state_ptr->queue_mutex)) {
+    return false;
+  }
+  if (!platform_semaphore_create(0, &state_ptr->load_requests)) {
+    platform_mutex_destroy(&state_ptr->queue_mutex);
+    return false;
+  }
+  state_ptr->load_queue = darray_create(u32);
+  state_ptr->loaded_queue = darray_create(u32);
+
+  state_ptr->loader_running = true;
+  if (!platform_thread_create(loader_main, nullptr, &state_ptr->loader)) {
+    state_ptr->loader_running = false;
+    darray_destroy(state_ptr->loaded_queue);
+    darray_destroy(state_ptr->load_queue);
+    platform_semaphore_destroy(&state_ptr->load_requests);
+    platform_mutex_destroy(&state_ptr->queue_mutex);
+    return false;
+  }
+  return true;
+}
+
+static void stop_loader() {
+  // Chains still queued are dropped, the extra signal wakes the loader if
+  // it is waiting for one.
+  state_ptr->loader_running = false;
+  platform_semaphore_signal(&state_ptr->load_requests);
+  platform_thread_join(&state_ptr->loader);
+
+  platform_semaphore_destroy(&state_ptr->load_requests);
+  platform_mutex_destroy(&state_ptr->queue_mutex);
+  darray_destroy(state_ptr->load_queue);
+  darray_destroy(state_ptr->loaded_queue);
+  state_ptr->load_queue = nullptr;
+  state_ptr->loaded_queue = nullptr;
+}
+
+bool texture_system_initialize(u64 *memory_requirement, void *state,
+                               texture_system_config config) {
+  if (config.max_texture_count == 0) {
+    LAI_LOG_FATAL("texture_system_initialize - config.max_texture_count "
+                  "must be > 0");
+    return false;
+  }
+  if (config.max_uploads_per_frame == 0) {
+    LAI_LOG_FATAL("texture_system_initialize - "
+                  "config.max_uploads_per_frame must be > 0");
+    return false;
+  }
+
+  u64 struct_requirement = sizeof(texture_system_state);
+  u64 array_requirement = sizeof(texture_reference) * config.max_texture_count;
+  u64 entries_requirement =
+      sizeof(texture_streaming_entry) * config.max_texture_count;
+  u64 changed_requirement = sizeof(u32) * config.max_uploads_per_frame;
+  *memory_requirement = struct_requirement + array_requirement +
+                        entries_requirement + changed_requirement;
+
+  if (!state) {
+    return true;
+  }
+
+  state_ptr = (texture_system_state *)state;
+  lai_zero_memory(state_ptr, sizeof(texture_system_state));
+  state_ptr->config = config;
+  state_ptr->registered_textures =
+      (texture_reference *)((u8 *)state + struct_requirement);
+  state_ptr->streaming_entries =
+      (texture_streaming_entry *)((u8 *)state_ptr->registered_textures +
+                                  array_requirement);
+  state_ptr->changed_entries =
+      (u32 *)((u8 *)state_ptr->streaming_entries + entries_requirement);
+
+  for (u32 i = 0; i < config.max_texture_count; ++i) {
+    texture_reference *ref = &state_ptr->registered_textures[i];
+    lai_zero_memory(ref, sizeof(texture_reference));
+    ref->texture.id = INVALID_ID;
+    ref->texture.internal_id = INVALID_ID;
+    ref->texture.generation = INVALID_ID;
+    lai_zero_memory(&state_ptr->streaming_entries[i],
+                    sizeof(texture_streaming_entry));
+  }
+
+  state_ptr->has_loader = start_loader();
+  if (!state_ptr->has_loader) {
+    LAI_LOG_WARN("Failed to start the texture loader, building mip chains "
+                 "on acquire");
+  }
+
+  return true;
+}
+
+void texture_system_shutdown(void *state) {
+  if (!state_ptr) {
+    return;
+  }
+
+  if (state_ptr->has_loader) {
+    stop_loader();
+  }
+
+  // Textures still referenced are unloaded with the system.
+  for (u32 i = 0; i < state_ptr->config.max_texture_count; ++i) {
+    texture_reference *ref = &state_ptr->registered_textures[i];
+    ref->loading = false;
+    if (ref->texture.id != INVALID_ID) {
+      destroy_texture(ref);
+    }
+    free_mip_data(ref);
+  }
+  state_ptr = nullptr;
+}
+
+texture *texture_system_acquire(const char *name) {
+  for (u32 i = 0; i < state_ptr->config.max_texture_count; ++i) {
+    texture_reference *ref = &state_ptr->registered_textures[i];
+    if (ref->texture.id != INVALID_ID &&
+        strings_equal(ref->texture.name, name)) {
+      ref->reference_count++;
+      return &ref->texture;
+    }
+  }
+  return nullptr;
+}
+
+texture *texture_system_acquire_from_pixels(const char *name, u32 width,
+                                            u32 height, const u8 *pixels,
+                                            bool auto_release) {
+  texture_reference *ref = nullptr;
+  u32 id = INVALID_ID;
+  for (u32 i = 0; i < state_ptr->config.max_texture_count; ++i) {
+    if (state_ptr->registered_textures[i].texture.id == INVALID_ID &&
+        !state_ptr->registered_textures[i].loading) {
+      id = i;
+      ref = &state_ptr->registered_textures[i];
+      break;
+    }
+  }
+
+  if (!ref) {
+    LAI_LOG_ERROR("Unable to obtain a free slot for texture, adjust "
+                  "max_texture_count");
+    return nullptr;
+  }
+
+  texture *t = &ref->texture;
+  t->id = id;
+  t->internal_id = INVALID_ID;
+  t->width = width;
+  t->height = height;
+  t->mip_count = texture_mip_count(width, height);
+  string_ncopy(t->name, name, TEXTURE_NAME_MAX_LENGTH);
+
+  t->has_transparency = false;
+  u64 texel_count = (u64)width * height;
+  for (u64 i = 0; i < texel_count; ++i) {
+    if (pixels[i * 4 + 3] < 255) {
+      t->has_transparency = true;
+      break;
+    }
+  }
+
+  ref->mip_data_size = texture_levels_size(width, height, t->mip_count, 0);
+  ref->mip_data =
+      (u8 *)lai_allocate(ref->mip_data_size, MEMORY_TAG_TEXTURE);
+  u64 offset = 0;
+  for (u32 level = 0; level < t->mip_count; ++level) {
+    ref->mip_pixels[level] = ref->mip_data + offset;
+    offset += texture_mip_size(width, height, level);
+  }
+  lai_copy_memory(ref->mip_pixels[0], pixels, texel_count * 4);
+
+  if (!renderer_create_texture(t)) {
+    LAI_LOG_ERROR("Failed to create texture '%s'", t->name);
+    destroy_texture(ref);
+    return nullptr;
+  }
+  t->generation = t->generation == INVALID_ID ? 0 : t->generation + 1;
+
+  // Nothing is resident until the chain is built.
+  texture_streaming_entry *entry = &state_ptr->streaming_entries[id];
+  entry->width = width;
+  entry->height = height;
+  entry->mip_count = t->mip_count;
+  entry->resident_mip = t->mip_count;
+  entry->desired_mip = t->mip_count - 1;
+  entry->last_used_frame = state_ptr->frame_number;
+  entry->streamable = false;
+
+  if (state_ptr->has_loader) {
+    ref->loading = true;
+    platform_mutex_lock(&state_ptr->queue_mutex);
+    darray_push(state_ptr->load_queue, id);
+    platform_mutex_unlock(&state_ptr->queue_mutex);
+    platform_semaphore_signal(&state_ptr->load_requests);
+  } else {
+    build_mip_chain(ref);
+    entry->streamable = true;
+  }
+
+  ref->reference_count = 1;
+  ref->auto_release = auto_release;
+  return t;
+}
+
+void texture_system_release(texture *texture) {
+  if (!texture || texture->id == INVALID_ID) {
+    LAI_LOG_WARN("texture_system_release called with an invalid texture");
+    return;
+  }
+
+  texture_reference *ref = &state_ptr->registered_textures[texture->id];
+  if (ref->reference_count > 0) {
+    ref->reference_count--;
+  }
+
+  if (ref->reference_count == 0 && ref->auto_release) {
+    destroy_texture(ref);
+    ref->auto_release = false;
+  }
+}
+
+void texture_system_mark_used(texture *texture, f32 screen_size) {
+  if (!texture || texture->id == INVALID_ID) {
+    return;
+  }
+
+  texture_streaming_entry *entry = &state_ptr->streaming_entries[texture->id];
+  u32 desired_mip = texture_streaming_desired_mip(
+      texture->width, texture->height, texture->mip_count, screen_size);
+  // The largest size the texture is drawn at in the frame wins.
+  if (entry->last_used_frame != state_ptr->frame_number ||
+      desired_mip < entry->desired_mip) {
+    entry->desired_mip = desired_mip;
+  }
+  entry->last_used_frame = state_ptr->frame_number;
+}
+
+void texture_system_update() {
+  if (state_ptr->has_loader) {
+    platform_mutex_lock(&state_ptr->queue_mutex);
+    u32 loaded_count = darray_length(state_ptr->loaded_queue);
+    for (u32 i = 0; i < loaded_count; ++i) {
+      u32 id = state_ptr->loaded_queue[i];
+      texture_reference *ref = &state_ptr->registered_textures[id];
+      ref->loading = false;
+      if (ref->texture.id == INVALID_ID) {
+        // Destroyed while its chain was built
+        free_mip_data(ref);
+      } else {
+        state_ptr->streaming_entries[id].streamable = true;
+      }
+    }
+    darray_clear(state_ptr->loaded_queue);
+    platform_mutex_unlock(&state_ptr->queue_mutex);
+  }
+
+  // The planner took the levels of a failed upload as resident. Putting back
+  // what the gpu holds has them planned again.
+  const u32 failure_batch_count = 16;
+  texture_upload_failure failures[failure_batch_count];
+  u32 failure_count;
+  do {
+    failure_count =
+        renderer_take_texture_upload_failures(failure_batch_count, failures);
+    for (u32 i = 0; i < failure_count; ++i) {
+      u32 id = failures[i].texture->id;
+      if (id != INVALID_ID) {
+        state_ptr->streaming_entries[id].resident_mip =
+            failures[i].uploaded_mip;
+      }
+    }
+  } while (failure_count == failure_batch_count);
+
+  // Textures not drawn this frame need no more than their tail, their finer
+  // levels are the first to go when room is needed.
+  u32 texture_count = state_ptr->config.max_texture_count;
+  for (u32 i = 0; i < texture_count; ++i) {
+    texture_streaming_entry *entry = &state_ptr->streaming_entries[i];
+    if (entry->streamable &&
+        entry->last_used_frame != state_ptr->frame_number) {
+      entry->desired_mip = entry->mip_count - 1;
+    }
+  }
+
+  u32 changed_count = texture_streaming_plan(
+      state_ptr->streaming_entries, texture_count,
+      state_ptr->config.streaming_budget,
+      state_ptr->config.max_uploads_per_frame, state_ptr->changed_entries);
+
+  // Dropping levels uploads the remaining ones as well, the backend cannot
+  // release single levels of an image. The uploads are made on the thread
+  // drawing frames, before the next one.
+  for (u32 i = 0; i < changed_count; ++i) {
+    u32 id = state_ptr->changed_entries[i];
+    texture_reference *ref = &state_ptr->registered_textures[id];
+    renderer_upload_texture_levels(
+        &ref->texture, state_ptr->streaming_entries[id].resident_mip,
+        ref->mip_pixels);
+  }
+
+  state_ptr->frame_number++;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "renderer/renderer_types.inl"
+
+struct texture_system_config {
+  // Max number of textures that can be loaded at once
+  u32 max_texture_count;
+  // Bytes the resident levels of all textures are kept within. Tails, the
+  // coarse levels uploaded as soon as a texture is loaded, may exceed it.
+  u64 streaming_budget;
+  // Textures whose resident levels may change in a frame, each change
+  // uploads the texture's new levels
+  u32 max_uploads_per_frame;
+};
+
+bool texture_system_initialize(u64 *memory_requirement, void *state,
+                               texture_system_config config);
+void texture_system_shutdown(void *state);
+
+// Adds a reference to the loaded texture called name, null when there is none
+texture *texture_system_acquire(const char *name);
+
+// Loads a texture from width * height texels of 4 bytes. Its mip chain is
+// built in the background, it samples as white until its tail is uploaded
+// and its finer levels are streamed in by texture_system_update. With
+// auto_release it is unloaded when its last reference is released.
+texture *texture_system_acquire_from_pixels(const char *name, u32 width,
+                                            u32 height, const u8 *pixels,
+                                            bool auto_release);
+
+void texture_system_release(texture *texture);
+
+// Notes that texture is drawn this frame screen_size pixels across, see
+// texture_streaming_screen_size.
+void texture_system_mark_used(texture *texture, f32 screen_size);
+
+// Once per frame after the textures drawn in it were marked. Queues the
+// uploads of the tails of textures whose chains were built and moves the
+// resident levels toward the ones the marked sizes ask for.
+void texture_system_update();
@@ -0,0 +1,36 @@
+project "core_bench"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "off"
+
+	targetdir ("%{wks.location}/build/bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("%{wks.location}/build/bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"src/**.h",
+		"src/**.cpp"
+	}
+
+	includedirs
+	{
+		"src",
+		"%{wks.location}/core/src",
+	}
+
+	links
+	{
+		"core"
+	}
+
+	filter "configurations:Debug"
+		defines "LAI_DEBUG"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines "LAI_RELEASE"
+		runtime "Release"
+		optimize "on"
+		symbols "off"
@@ -0,0 +1,43 @@
+#include "base/event_bench.h"
+#include "bench_manager.h"
+
+#include <base/event.h>
+
+#define EVENT_BENCH_CODE 0x100
+#define EVENT_BENCH_LISTENER_COUNT 8
+
+static u64 listener_ids[EVENT_BENCH_LISTENER_COUNT];
+static u64 handled_count;
+
+bool event_bench_on_event(u16 code, void *sender, void *listener_instance,
+                          event_context data) {
+  handled_count += data.data.u64[0];
+  // Not handled, so every listener is called
+  return false;
+}
+
+void event_bench_setup() {
+  for (u32 i = 0; i < EVENT_BENCH_LISTENER_COUNT; ++i) {
+    event_register(EVENT_BENCH_CODE, &listener_ids[i], event_bench_on_event);
+  }
+}
+
+void event_bench_teardown() {
+  for (u32 i = 0; i < EVENT_BENCH_LISTENER_COUNT; ++i) {
+    event_unregister(EVENT_BENCH_CODE, &listener_ids[i], event_bench_on_event);
+  }
+}
+
+void event_fire_bench(u64 operations) {
+  event_context context = {};
+  context.data.u64[0] = 1;
+  for (u64 i = 0; i < operations; ++i) {
+    event_fire(EVENT_BENCH_CODE, nullptr, context);
+  }
+  bench_do_not_optimize(&handled_count);
+}
+
+void event_register_benches() {
+  bench_manager_register("event_fire_8_listeners", 100000, event_fire_bench,
+                         event_bench_setup, event_bench_teardown);
+}
@@ -0,0 +1,21 @@
+#include "base/log_bench.h"
+#include "bench_manager.h"
+
+#include <base/log.h>
+
+// Console output would dominate and flood the results, so only formatting
+// and the log file append are measured.
+void log_bench_setup() { log_set_console_output(false); }
+
+void log_bench_teardown() { log_set_console_output(true); }
+
+void log_output_bench(u64 operations) {
+  for (u64 i = 0; i < operations; ++i) {
+    log_output(LOG_LEVEL_INFO, "bench message %llu of %llu", i, operations);
+  }
+}
+
+void log_register_benches() {
+  bench_manager_register("log_output", 1000, log_output_bench,
+                         log_bench_setup, log_bench_teardown);
+}
@@ -0,0 +1,28 @@
+#include "base/string_bench.h"
+#include "bench_manager.h"
+
+#include <base/lai_memory.h>
+#include <base/lai_string.h>
+
+void string_format_bench(u64 operations) {
+  char buffer[256];
+  for (u64 i = 0; i < operations; ++i) {
+    string_format(buffer, "frame %llu took %.3f ms in %s", i, 16.6, "render");
+    bench_do_not_optimize(buffer);
+  }
+}
+
+void string_duplicate_bench(u64 operations) {
+  for (u64 i = 0; i < operations; ++i) {
+    char *copy = string_duplicate("Builtin.ObjectShader");
+    bench_do_not_optimize(copy);
+    lai_free(copy, string_length(copy) + 1, MEMORY_TAG_STRING);
+  }
+}
+
+void string_register_benches() {
+  bench_manager_register("string_format", 10000, string_format_bench, nullptr,
+                         nullptr);
+  bench_manager_register("string_duplicate", 10000, string_duplicate_bench,
+                         nullptr, nullptr);
+}
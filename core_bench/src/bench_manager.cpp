@@ -0,0 +1,328 @@
+#include "bench_manager.h"
+
+#include <base/lai_memory.h>
+#include <base/lai_string.h>
+#include <base/log.h>
+#include <containers/darray.h>
+#include <platform/filesystem.h>
+#include <platform/platform.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_MAX_NAME_LENGTH 128
+#define BENCH_DEFAULT_WARMUP_ITERATIONS 3
+#define BENCH_DEFAULT_ITERATIONS 20
+#define BENCH_DEFAULT_REGRESSION_THRESHOLD 0.10
+
+struct bench_entry {
+  const char *name;
+  u64 operations;
+  PFN_bench func;
+  PFN_bench_setup setup;
+  PFN_bench_teardown teardown;
+};
+
+// All times are in nanoseconds per operation
+struct bench_result {
+  const char *name;
+  u64 operations;
+  u32 iterations;
+  f64 mean;
+  f64 median;
+  f64 stddev;
+  f64 min;
+  f64 max;
+  f64 p95;
+};
+
+struct bench_baseline_entry {
+  char name[BENCH_MAX_NAME_LENGTH];
+  f64 median;
+};
+
+static bench_entry *benches;
+
+static int compare_f64(const void *a, const void *b) {
+  f64 left = *(const f64 *)a;
+  f64 right = *(const f64 *)b;
+  return (left > right) - (left < right);
+}
+
+void bench_manager_init() { benches = darray_create(bench_entry); }
+
+void bench_manager_shutdown() {
+  if (benches) {
+    darray_destroy(benches);
+    benches = nullptr;
+  }
+}
+
+void bench_manager_register(const char *name, u64 operations, PFN_bench func,
+                            PFN_bench_setup setup,
+                            PFN_bench_teardown teardown) {
+  bench_entry e;
+  e.name = name;
+  e.operations = operations > 0 ? operations : 1;
+  e.func = func;
+  e.setup = setup;
+  e.teardown = teardown;
+
+  darray_push(benches, e);
+}
+
+void bench_manager_default_options(bench_options *out_options) {
+  lai_zero_memory(out_options, sizeof(bench_options));
+  out_options->warmup_iterations = BENCH_DEFAULT_WARMUP_ITERATIONS;
+  out_options->iterations = BENCH_DEFAULT_ITERATIONS;
+  out_options->regression_threshold = BENCH_DEFAULT_REGRESSION_THRESHOLD;
+}
+
+static void print_usage() {
+  LAI_LOG_INFO("Usage: core_bench [--filter <text>] [--iterations <n>] "
+               "[--warmup <n>] [--json <path>] [--baseline <path>] "
+               "[--threshold <fraction>]");
+}
+
+bool bench_manager_parse_arguments(i32 argc, char **argv,
+                                   bench_options *out_options) {
+  bench_manager_default_options(out_options);
+
+  for (i32 i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+    bool valid = value != nullptr;
+    if (strings_equal(arg, "--filter")) {
+      out_options->filter = value;
+    } else if (strings_equal(arg, "--json")) {
+      out_options->json_path = value;
+    } else if (strings_equal(arg, "--baseline")) {
+      out_options->baseline_path = value;
+    } else if (strings_equal(arg, "--iterations")) {
+      valid = string_to_u32(value, &out_options->iterations) &&
+              out_options->iterations > 0;
+    } else if (strings_equal(arg, "--warmup")) {
+      valid = string_to_u32(value, &out_options->warmup_iterations);
+    } else if (strings_equal(arg, "--threshold")) {
+      valid = string_to_f64(value, &out_options->regression_threshold);
+    } else {
+      LAI_LOG_ERROR("Unknown argument: %s", arg);
+      print_usage();
+      return false;
+    }
+
+    if (!valid) {
+      LAI_LOG_ERROR("Missing or invalid value for %s", arg);
+      print_usage();
+      return false;
+    }
+    ++i;
+  }
+
+  return true;
+}
+
+static f64 percentile(const f64 *sorted, u32 count, f64 fraction) {
+  // Nearest-rank
+  u32 rank = (u32)ceil(fraction * count);
+  rank = LAI_CLAMP(rank, 1, count);
+  return sorted[rank - 1];
+}
+
+static void run_bench(const bench_entry *bench, const bench_options *options,
+                      f64 *samples, bench_result *out_result) {
+  if (bench->setup) {
+    bench->setup();
+  }
+
+  for (u32 i = 0; i < options->warmup_iterations; ++i) {
+    bench->func(bench->operations);
+  }
+
+  for (u32 i = 0; i < options->iterations; ++i) {
+    f64 start_time = platform_get_absolute_time();
+    bench->func(bench->operations);
+    f64 elapsed = platform_get_absolute_time() - start_time;
+    samples[i] = elapsed * 1000000000.0 / bench->operations;
+  }
+
+  if (bench->teardown) {
+    bench->teardown();
+  }
+
+  u32 count = options->iterations;
+  qsort(samples, count, sizeof(f64), compare_f64);
+
+  f64 sum = 0;
+  for (u32 i = 0; i < count; ++i) {
+    sum += samples[i];
+  }
+  f64 mean = sum / count;
+
+  f64 variance = 0;
+  for (u32 i = 0; i < count; ++i) {
+    variance += (samples[i] - mean) * (samples[i] - mean);
+  }
+  variance = count > 1 ? variance / (count - 1) : 0;
+
+  out_result->name = bench->name;
+  out_result->operations = bench->operations;
+  out_result->iterations = count;
+  out_result->mean = mean;
+  out_result->median = percentile(samples, count, 0.50);
+  out_result->stddev = sqrt(variance);
+  out_result->min = samples[0];
+  out_result->max = samples[count - 1];
+  out_result->p95 = percentile(samples, count, 0.95);
+}
+
+static bool write_json(const char *path, const bench_result *results,
+                       u32 count) {
+  file_handle file;
+  if (!filesystem_open(path, FILE_MODE_WRITE, false, &file)) {
+    return false;
+  }
+
+  // One benchmark per line, the baseline reader depends on it.
+  char line[512];
+  filesystem_write_line(&file, "{");
+  filesystem_write_line(&file, "  \"benchmarks\": [");
+  for (u32 i = 0; i < count; ++i) {
+    const bench_result *r = &results[i];
+    string_format(line,
+                  "    {\"name\": \"%s\", \"operations\": %llu, "
+                  "\"iterations\": %u, \"mean_ns\": %.3f, \"median_ns\": "
+                  "%.3f, \"stddev_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": "
+                  "%.3f, \"p95_ns\": %.3f}%s",
+                  r->name, r->operations, r->iterations, r->mean, r->median,
+                  r->stddev, r->min, r->max, r->p95,
+                  i + 1 < count ? "," : "");
+    filesystem_write_line(&file, line);
+  }
+  filesystem_write_line(&file, "  ]");
+  filesystem_write_line(&file, "}");
+
+  filesystem_close(&file);
+  return true;
+}
+
+static bool parse_baseline_line(const char *line,
+                                bench_baseline_entry *out_entry) {
+  const char *name_key = "\"name\": \"";
+  const char *median_key = "\"median_ns\": ";
+
+  const char *name = strstr(line, name_key);
+  const char *median = strstr(line, median_key);
+  if (!name || !median) {
+    return false;
+  }
+
+  name += string_length(name_key);
+  const char *name_end = strchr(name, '"');
+  if (!name_end || name_end - name >= BENCH_MAX_NAME_LENGTH) {
+    return false;
+  }
+
+  lai_zero_memory(out_entry->name, BENCH_MAX_NAME_LENGTH);
+  lai_copy_memory(out_entry->name, name, name_end - name);
+  out_entry->median = strtod(median + string_length(median_key), nullptr);
+  return true;
+}
+
+static bench_baseline_entry *load_baseline(const char *path) {
+  file_handle file;
+  if (!filesystem_open(path, FILE_MODE_READ, false, &file)) {
+    return nullptr;
+  }
+
+  bench_baseline_entry *entries = darray_create(bench_baseline_entry);
+  char *line = nullptr;
+  while (filesystem_read_line(&file, &line)) {
+    bench_baseline_entry entry;
+    if (parse_baseline_line(line, &entry)) {
+      darray_push(entries, entry);
+    }
+    lai_free(line, string_length(line) + 1, MEMORY_TAG_STRING);
+    line = nullptr;
+  }
+
+  filesystem_close(&file);
+  return entries;
+}
+
+static const bench_baseline_entry *
+find_baseline(const bench_baseline_entry *entries, const char *name) {
+  u64 count = darray_length(entries);
+  for (u64 i = 0; i < count; ++i) {
+    if (strings_equal(entries[i].name, name)) {
+      return &entries[i];
+    }
+  }
+  return nullptr;
+}
+
+bool bench_manager_run(const bench_options *options) {
+  bench_baseline_entry *baseline = nullptr;
+  if (options->baseline_path) {
+    baseline = load_baseline(options->baseline_path);
+    if (!baseline) {
+      LAI_LOG_WARN("Could not load baseline %s", options->baseline_path);
+    }
+  }
+
+  u32 count = darray_length(benches);
+  bench_result *results = (bench_result *)lai_allocate(
+      sizeof(bench_result) * count, MEMORY_TAG_APPLICATION);
+  f64 *samples = (f64 *)lai_allocate(sizeof(f64) * options->iterations,
+                                     MEMORY_TAG_APPLICATION);
+
+  u32 result_count = 0;
+  u32 regressed = 0;
+  for (u32 i = 0; i < count; ++i) {
+    if (options->filter &&
+        !string_contains(benches[i].name, options->filter)) {
+      continue;
+    }
+
+    bench_result *r = &results[result_count++];
+    run_bench(&benches[i], options, samples, r);
+
+    LAI_LOG_INFO("%-32s median %10.2f ns/op, mean %10.2f, stddev %8.2f, "
+                 "min %10.2f, max %10.2f, p95 %10.2f",
+                 r->name, r->median, r->mean, r->stddev, r->min, r->max,
+                 r->p95);
+
+    const bench_baseline_entry *base =
+        baseline ? find_baseline(baseline, r->name) : nullptr;
+    if (base && base->median > 0) {
+      f64 change = (r->median - base->median) / base->median;
+      if (change > options->regression_threshold) {
+        LAI_LOG_ERROR("[REGRESSED]: %s %.2f -> %.2f ns/op (%+.1f%%)", r->name,
+                      base->median, r->median, change * 100.0);
+        ++regressed;
+      } else {
+        LAI_LOG_INFO("  vs baseline %.2f ns/op (%+.1f%%)", base->median,
+                     change * 100.0);
+      }
+    }
+  }
+
+  if (options->json_path &&
+      !write_json(options->json_path, results, result_count)) {
+    LAI_LOG_ERROR("Failed to write results to %s", options->json_path);
+  }
+
+  LAI_LOG_INFO("Ran %u of %u benchmarks, %u regressed.", result_count, count,
+               regressed);
+
+  lai_free(samples, sizeof(f64) * options->iterations,
+           MEMORY_TAG_APPLICATION);
+  lai_free(results, sizeof(bench_result) * count, MEMORY_TAG_APPLICATION);
+  if (baseline) {
+    darray_destroy(baseline);
+  }
+
+  return regressed == 0;
+}
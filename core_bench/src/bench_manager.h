@@ -0,0 +1,41 @@
+#pragma once
+
+#include <defines.h>
+
+// Runs `operations` times the operation being measured
+typedef void (*PFN_bench)(u64 operations);
+// Optional, called outside of the timed region
+typedef void (*PFN_bench_setup)();
+typedef void (*PFN_bench_teardown)();
+
+struct bench_options {
+  // Only run benchmarks whose name contains this
+  const char *filter;
+  // Write results as JSON to this path
+  const char *json_path;
+  // Compare against results previously written with json_path
+  const char *baseline_path;
+  u32 warmup_iterations;
+  u32 iterations;
+  // Median slowdown relative to the baseline reported as a regression
+  f64 regression_threshold;
+};
+
+// Keeps the compiler from optimizing away a result
+static inline void bench_do_not_optimize(const void *value) {
+  __asm__ volatile("" : : "r"(value) : "memory");
+}
+
+void bench_manager_init();
+void bench_manager_shutdown();
+
+void bench_manager_register(const char *name, u64 operations, PFN_bench func,
+                            PFN_bench_setup setup,
+                            PFN_bench_teardown teardown);
+
+void bench_manager_default_options(bench_options *out_options);
+bool bench_manager_parse_arguments(i32 argc, char **argv,
+                                   bench_options *out_options);
+
+// Return false if a benchmark regressed against the baseline
+bool bench_manager_run(const bench_options *options);
@@ -0,0 +1,45 @@
+#include "containers/darray_bench.h"
+#include "bench_manager.h"
+
+#include <containers/darray.h>
+
+void darray_push_bench(u64 operations) {
+  u64 *array = darray_create(u64);
+  for (u64 i = 0; i < operations; ++i) {
+    darray_push(array, i);
+  }
+  bench_do_not_optimize(array);
+  darray_destroy(array);
+}
+
+void darray_push_reserved_bench(u64 operations) {
+  u64 *array = darray_reserve(u64, operations);
+  for (u64 i = 0; i < operations; ++i) {
+    darray_push(array, i);
+  }
+  bench_do_not_optimize(array);
+  darray_destroy(array);
+}
+
+void darray_pop_bench(u64 operations) {
+  u64 *array = darray_reserve(u64, operations);
+  for (u64 i = 0; i < operations; ++i) {
+    darray_push(array, i);
+  }
+
+  u64 value = 0;
+  for (u64 i = 0; i < operations; ++i) {
+    darray_pop(array, &value);
+  }
+  bench_do_not_optimize(&value);
+  darray_destroy(array);
+}
+
+void darray_register_benches() {
+  bench_manager_register("darray_push", 100000, darray_push_bench, nullptr,
+                         nullptr);
+  bench_manager_register("darray_push_reserved", 100000,
+                         darray_push_reserved_bench, nullptr, nullptr);
+  bench_manager_register("darray_push_pop", 100000, darray_pop_bench,
+                         nullptr, nullptr);
+}
@@ -0,0 +1,64 @@
+#include "base/event_bench.h"
+#include "base/log_bench.h"
+#include "base/string_bench.h"
+#include "bench_manager.h"
+#include "containers/darray_bench.h"
+#include "math/math_bench.h"
+#include "memory/memory_bench.h"
+#include "renderer/mesh_format_bench.h"
+
+#include <base/event.h>
+#include <base/lai_memory.h>
+#include <base/log.h>
+#include <memory/linear_allocator.h>
+
+int main(int argc, char **argv) {
+  bench_options options;
+  if (!bench_manager_parse_arguments(argc, argv, &options)) {
+    return 2;
+  }
+
+  // Benchmarks run against initialized systems, like the engine does.
+  linear_allocator systems_allocator;
+  linear_allocator_create(1024 * 1024, nullptr, &systems_allocator);
+
+  u64 memory_requirement = 0;
+  initialize_memory(&memory_requirement, nullptr);
+  void *memory_state =
+      linear_allocator_allocate(&systems_allocator, memory_requirement);
+  initialize_memory(&memory_requirement, memory_state);
+
+  u64 log_requirement = 0;
+  initialize_logging(&log_requirement, nullptr);
+  void *log_state =
+      linear_allocator_allocate(&systems_allocator, log_requirement);
+  initialize_logging(&log_requirement, log_state);
+
+  u64 event_requirement = 0;
+  event_initialize(&event_requirement, nullptr);
+  void *event_state =
+      linear_allocator_allocate(&systems_allocator, event_requirement);
+  event_initialize(&event_requirement, event_state);
+
+  bench_manager_init();
+
+  // Register benches
+  darray_register_benches();
+  memory_register_benches();
+  event_register_benches();
+  math_register_benches();
+  string_register_benches();
+  log_register_benches();
+  mesh_format_register_benches();
+
+  bool passed = bench_manager_run(&options);
+
+  bench_manager_shutdown();
+
+  event_shutdown(event_state);
+  shutdown_logging(log_state);
+  shutdown_memory(memory_state);
+  linear_allocator_destroy(&systems_allocator);
+
+  return passed ? 0 : 1;
+}
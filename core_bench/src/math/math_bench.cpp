@@ -0,0 +1,41 @@
+#include "math/math_bench.h"
+#include "bench_manager.h"
+
+#include <math/lai_math.h>
+
+void mat4_mul_bench(u64 operations) {
+  mat4 result = mat4_identity();
+  mat4 rotation = mat4_euler_xyz(0.1f, 0.2f, 0.3f);
+  for (u64 i = 0; i < operations; ++i) {
+    result = mat4_mul(result, rotation);
+    bench_do_not_optimize(&result);
+  }
+}
+
+void mat4_inverse_bench(u64 operations) {
+  mat4 matrix = mat4_mul(mat4_euler_xyz(0.1f, 0.2f, 0.3f),
+                         mat4_translation(vec3_create(1.0f, 2.0f, 3.0f)));
+  for (u64 i = 0; i < operations; ++i) {
+    mat4 result = mat4_inverse(matrix);
+    bench_do_not_optimize(&result);
+  }
+}
+
+void vec3_normalize_cross_bench(u64 operations) {
+  vec3 a = vec3_create(1.0f, 2.0f, 3.0f);
+  vec3 b = vec3_create(-3.0f, 0.5f, 2.0f);
+  for (u64 i = 0; i < operations; ++i) {
+    vec3 result = vec3_normalized(vec3_cross(a, b));
+    bench_do_not_optimize(&result);
+    a.x += 0.001f;
+  }
+}
+
+void math_register_benches() {
+  bench_manager_register("mat4_mul", 100000, mat4_mul_bench, nullptr,
+                         nullptr);
+  bench_manager_register("mat4_inverse", 100000, mat4_inverse_bench, nullptr,
+                         nullptr);
+  bench_manager_register("vec3_normalize_cross", 100000,
+                         vec3_normalize_cross_bench, nullptr, nullptr);
+}
@@ -0,0 +1,64 @@
+#include "memory/memory_bench.h"
+#include "bench_manager.h"
+
+#include <base/lai_memory.h>
+#include <memory/linear_allocator.h>
+
+#define MEMORY_BENCH_ALLOCATION_SIZE 64
+#define MEMORY_BENCH_ALLOCATIONS 10000
+#define MEMORY_BENCH_FREE_ALL_OPERATIONS 100
+
+static linear_allocator allocator;
+static void *blocks[MEMORY_BENCH_ALLOCATIONS];
+
+void linear_allocator_bench_setup() {
+  linear_allocator_create(MEMORY_BENCH_ALLOCATION_SIZE *
+                              MEMORY_BENCH_ALLOCATIONS,
+                          nullptr, &allocator);
+}
+
+void linear_allocator_bench_teardown() {
+  linear_allocator_destroy(&allocator);
+}
+
+void linear_allocator_allocate_bench(u64 operations) {
+  for (u64 i = 0; i < operations; ++i) {
+    void *block =
+        linear_allocator_allocate(&allocator, MEMORY_BENCH_ALLOCATION_SIZE);
+    bench_do_not_optimize(block);
+  }
+  // Rewinds for the next run without free_all, whose clear of the whole
+  // allocator would dominate the timing. It is benched on its own.
+  allocator.allocated = 0;
+}
+
+void linear_allocator_free_all_bench(u64 operations) {
+  for (u64 i = 0; i < operations; ++i) {
+    linear_allocator_free_all(&allocator);
+    bench_do_not_optimize(allocator.memory);
+  }
+}
+
+void lai_allocate_bench(u64 operations) {
+  for (u64 i = 0; i < operations; ++i) {
+    blocks[i] =
+        lai_allocate(MEMORY_BENCH_ALLOCATION_SIZE, MEMORY_TAG_APPLICATION);
+  }
+  for (u64 i = 0; i < operations; ++i) {
+    lai_free(blocks[i], MEMORY_BENCH_ALLOCATION_SIZE, MEMORY_TAG_APPLICATION);
+  }
+}
+
+void memory_register_benches() {
+  bench_manager_register("linear_allocator_allocate", MEMORY_BENCH_ALLOCATIONS,
+                         linear_allocator_allocate_bench,
+                         linear_allocator_bench_setup,
+                         linear_allocator_bench_teardown);
+  bench_manager_register("linear_allocator_free_all",
+                         MEMORY_BENCH_FREE_ALL_OPERATIONS,
+                         linear_allocator_free_all_bench,
+                         linear_allocator_bench_setup,
+                         linear_allocator_bench_teardown);
+  bench_manager_register("lai_allocate_free", MEMORY_BENCH_ALLOCATIONS,
+                         lai_allocate_bench, nullptr, nullptr);
+}
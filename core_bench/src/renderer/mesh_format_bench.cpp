@@ -0,0 +1,88 @@
+#include "renderer/mesh_format_bench.h"
+#include "bench_manager.h"
+
+#include <base/log.h>
+#include <containers/darray.h>
+#include <math/lai_math.h>
+#include <platform/filesystem.h>
+#include <renderer/mesh_cook.h>
+
+// Quads along each side of the cooked grid
+#define MESH_FORMAT_BENCH_GRID_SIZE 128
+#define MESH_FORMAT_BENCH_LOADS 100
+#define MESH_FORMAT_BENCH_PATH "mesh_format_bench.mesh"
+
+// Cooks a flat grid to MESH_FORMAT_BENCH_PATH
+void mesh_file_load_bench_setup() {
+  const u32 size = MESH_FORMAT_BENCH_GRID_SIZE;
+  vertex_3d *vertices = darray_create(vertex_3d);
+  u32 *indices = darray_create(u32);
+  for (u32 y = 0; y <= size; ++y) {
+    for (u32 x = 0; x <= size; ++x) {
+      vertex_3d vertex;
+      vertex.position = vec3_create((f32)x, (f32)y, 0.0f);
+      vertex.texcoord = vec2_create((f32)x / size, (f32)y / size);
+      darray_push(vertices, vertex);
+    }
+  }
+  for (u32 y = 0; y < size; ++y) {
+    for (u32 x = 0; x < size; ++x) {
+      u32 corner = y * (size + 1) + x;
+      u32 quad[6] = {corner, corner + 1, corner + size + 2,
+                     corner, corner + size + 2, corner + size + 1};
+      for (u32 i = 0; i < 6; ++i) {
+        darray_push(indices, quad[i]);
+      }
+    }
+  }
+
+  u8 *data;
+  u64 data_size;
+  if (mesh_cook(vertices, (u32)darray_length(vertices), indices,
+                (u32)darray_length(indices), MESH_FILE_MAX_LODS, &data,
+                &data_size)) {
+    file_handle file;
+    u64 written = 0;
+    if (filesystem_open(MESH_FORMAT_BENCH_PATH, FILE_MODE_WRITE, true,
+                        &file)) {
+      filesystem_write(&file, data_size, data, &written);
+      filesystem_close(&file);
+    }
+    mesh_cook_free(data, data_size);
+  }
+  darray_destroy(vertices);
+  darray_destroy(indices);
+}
+
+void mesh_file_load_bench_teardown() {
+  filesystem_delete(MESH_FORMAT_BENCH_PATH);
+}
+
+// What geometry_system_acquire_from_file does besides the upload: map,
+// validate and read the finest lod, whose pages are faulted in here by
+// summing its indices instead of by the copy to staging.
+void mesh_file_load_bench(u64 operations) {
+  for (u64 i = 0; i < operations; ++i) {
+    file_mapping mapping;
+    if (!filesystem_map(MESH_FORMAT_BENCH_PATH, &mapping)) {
+      LAI_LOG_ERROR("The cooked bench mesh is missing");
+      return;
+    }
+    if (mesh_file_validate(mapping.data, mapping.size)) {
+      mesh_file_lod_view view;
+      mesh_file_get_lod(mapping.data, 0, &view);
+      u64 index_sum = 0;
+      for (u32 index = 0; index < view.lod->index_count; ++index) {
+        index_sum += view.indices[index];
+      }
+      bench_do_not_optimize(&index_sum);
+    }
+    filesystem_unmap(&mapping);
+  }
+}
+
+void mesh_format_register_benches() {
+  bench_manager_register("mesh_file_map_validate", MESH_FORMAT_BENCH_LOADS,
+                         mesh_file_load_bench, mesh_file_load_bench_setup,
+                         mesh_file_load_bench_teardown);
+}
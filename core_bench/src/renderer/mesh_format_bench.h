@@ -0,0 +1,3 @@
+#pragma once
+
+void mesh_format_register_benches();
@@ -17,9 +17,24 @@ project "core_tests"
 	{
     "src",
 		"%{wks.location}/core/src",
+		"%{IncludeDir.VulkanSDK}",
 	}
 
 	links
 	{
 		"core"
-	}
\ No newline at end of file
+	}
+
+	-- The gpu tests create their own vulkan device
+	filter "system:macosx"
+		defines "LAI_PLATFORM_MACOSX"
+
+		libdirs
+		{
+			"%{LibraryDir.VulkanSDK}",
+		}
+
+		links
+		{
+			"%{Library.Vulkan_MacOSX}",
+		}
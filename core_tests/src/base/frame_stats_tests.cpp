@@ -0,0 +1,118 @@
+#include "base/frame_stats_tests.h"
+#include "expect.h"
+#include "test_manager.h"
+
+#include <base/frame_stats.h>
+#include <base/lai_string.h>
+#include <defines.h>
+
+u8 frame_stats_should_create_and_destroy() {
+  frame_stats_recorder recorder;
+  frame_stats_create(0, &recorder);
+
+  expect_should_not_be(nullptr, recorder.frame_times);
+  expect_should_be(FRAME_STATS_DEFAULT_WINDOW, recorder.window);
+  expect_should_be(0, recorder.sample_count);
+
+  frame_stats_destroy(&recorder);
+  expect_should_be(nullptr, recorder.frame_times);
+  expect_should_be(0, recorder.window);
+
+  return true;
+}
+
+u8 frame_stats_should_summarize_partial_window() {
+  frame_stats_recorder recorder;
+  frame_stats_create(8, &recorder);
+
+  f64 phases[FRAME_PHASE_MAX_PHASES] = {};
+  for (u32 i = 1; i <= 4; ++i) {
+    phases[FRAME_PHASE_GAME_UPDATE] = i * 0.5;
+    frame_stats_record(&recorder, (f64)i, phases);
+  }
+
+  frame_stats stats;
+  frame_stats_compute(&recorder, &stats);
+
+  expect_should_be(4, stats.sample_count);
+  expect_should_be(4, stats.frame_count);
+  expect_float_to_be(2.5, stats.frame_time.average);
+  expect_float_to_be(1.0, stats.frame_time.min);
+  expect_float_to_be(4.0, stats.frame_time.max);
+  expect_float_to_be(2.0, stats.frame_time.p50);
+  expect_float_to_be(4.0, stats.frame_time.p99);
+  expect_float_to_be(1.25, stats.phases[FRAME_PHASE_GAME_UPDATE].average);
+  expect_float_to_be(0.0, stats.phases[FRAME_PHASE_INPUT_UPDATE].max);
+
+  frame_stats_destroy(&recorder);
+
+  return true;
+}
+
+u8 frame_stats_should_only_keep_window() {
+  frame_stats_recorder recorder;
+  frame_stats_create(100, &recorder);
+
+  // First window of slow frames is evicted by the second
+  for (u32 i = 0; i < 100; ++i) {
+    frame_stats_record(&recorder, 10.0, nullptr);
+  }
+  for (u32 i = 1; i <= 100; ++i) {
+    frame_stats_record(&recorder, (f64)i, nullptr);
+  }
+
+  frame_stats stats;
+  frame_stats_compute(&recorder, &stats);
+
+  expect_should_be(100, stats.sample_count);
+  expect_should_be(200, stats.frame_count);
+  expect_float_to_be(50.5, stats.frame_time.average);
+  expect_float_to_be(1.0, stats.frame_time.min);
+  expect_float_to_be(100.0, stats.frame_time.max);
+  expect_float_to_be(50.0, stats.frame_time.p50);
+  expect_float_to_be(95.0, stats.frame_time.p95);
+  expect_float_to_be(99.0, stats.frame_time.p99);
+
+  frame_stats_destroy(&recorder);
+
+  return true;
+}
+
+u8 frame_stats_should_reset() {
+  frame_stats_recorder recorder;
+  frame_stats_create(4, &recorder);
+
+  frame_stats_record(&recorder, 1.0, nullptr);
+  frame_stats_reset(&recorder);
+
+  frame_stats stats;
+  frame_stats_compute(&recorder, &stats);
+  expect_should_be(0, stats.sample_count);
+  expect_float_to_be(0.0, stats.frame_time.max);
+
+  frame_stats_destroy(&recorder);
+
+  return true;
+}
+
+u8 frame_stats_should_name_every_phase() {
+  const char *gpu_name = frame_phase_name(FRAME_PHASE_GPU_FRAME);
+  expect_should_be(true, strings_equal("gpu_frame", gpu_name));
+  const char *unknown_name = frame_phase_name(FRAME_PHASE_MAX_PHASES);
+  expect_should_be(true, strings_equal("unknown", unknown_name));
+
+  return true;
+}
+
+void frame_stats_register_tests() {
+  test_manager_register_test(frame_stats_should_create_and_destroy,
+                             "frame_stats_should_create_and_destroy");
+  test_manager_register_test(frame_stats_should_summarize_partial_window,
+                             "frame_stats_should_summarize_partial_window");
+  test_manager_register_test(frame_stats_should_only_keep_window,
+                             "frame_stats_should_only_keep_window");
+  test_manager_register_test(frame_stats_should_reset,
+                             "frame_stats_should_reset");
+  test_manager_register_test(frame_stats_should_name_every_phase,
+                             "frame_stats_should_name_every_phase");
+}
@@ -0,0 +1,72 @@
+#include "base/lai_string_tests.h"
+#include "expect.h"
+#include "test_manager.h"
+
+#include <base/lai_string.h>
+#include <defines.h>
+
+u8 string_should_find_substring() {
+  expect_should_be(true, string_contains("darray_push", "push"));
+  expect_should_be(true, string_contains("darray_push", ""));
+  expect_should_be(false, string_contains("darray_push", "pop"));
+
+  return true;
+}
+
+u8 string_should_parse_u32() {
+  u32 value = 0;
+  expect_should_be(true, string_to_u32("4096", &value));
+  expect_should_be(4096, value);
+  expect_should_be(true, string_to_u32("4294967295", &value));
+  expect_should_be(4294967295u, value);
+
+  value = 7;
+  expect_should_be(false, string_to_u32("4294967296", &value));
+  expect_should_be(false, string_to_u32("-1", &value));
+  expect_should_be(false, string_to_u32("12abc", &value));
+  expect_should_be(false, string_to_u32("", &value));
+  expect_should_be(false, string_to_u32(nullptr, &value));
+  expect_should_be(7, value);
+
+  return true;
+}
+
+u8 string_should_parse_f64() {
+  f64 value = 0;
+  expect_should_be(true, string_to_f64("0.25", &value));
+  expect_float_to_be(0.25, value);
+  expect_should_be(true, string_to_f64("-3", &value));
+  expect_float_to_be(-3.0, value);
+
+  expect_should_be(false, string_to_f64("0.25x", &value));
+  expect_should_be(false, string_to_f64("", &value));
+  expect_float_to_be(-3.0, value);
+
+  return true;
+}
+
+u8 string_ncopy_should_truncate_and_terminate() {
+  char buffer[8];
+  string_ncopy(buffer, "quad", sizeof(buffer));
+  expect_should_be(true, strings_equal(buffer, "quad"));
+
+  string_ncopy(buffer, "geometry_name", sizeof(buffer));
+  expect_should_be(7, string_length(buffer));
+  expect_should_be(true, strings_equal(buffer, "geometr"));
+
+  string_ncopy(buffer, nullptr, sizeof(buffer));
+  expect_should_be(0, string_length(buffer));
+
+  return true;
+}
+
+void lai_string_register_tests() {
+  test_manager_register_test(string_should_find_substring,
+                             "string_should_find_substring");
+  test_manager_register_test(string_should_parse_u32,
+                             "string_should_parse_u32");
+  test_manager_register_test(string_should_parse_f64,
+                             "string_should_parse_f64");
+  test_manager_register_test(string_ncopy_should_truncate_and_terminate,
+                             "string_ncopy_should_truncate_and_terminate");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void lai_string_register_tests();
@@ -1,16 +1,43 @@
+#include "base/frame_stats_tests.h"
+#include "base/lai_string_tests.h"
+#include "math/lai_math_tests.h"
+#include "memory/freelist_tests.h"
 #include "memory/linear_allocator_tests.h"
+#include "renderer/geometry_ranges_tests.h"
+#include "renderer/mesh_cook_tests.h"
+#include "renderer/render_batch_tests.h"
+#include "renderer/texture_streaming_tests.h"
+#include "renderer/vulkan/shaders/vulkan_cull_shader_tests.h"
+#include "renderer/vulkan/vulkan_backend_tests.h"
+#include "renderer/vulkan/vulkan_memory_allocator_tests.h"
 #include "test_manager.h"
 
 #include <base/log.h>
 
-int main() {
+int main(int argc, char **argv) {
+  test_options options;
+  if (!test_manager_parse_arguments(argc, argv, &options)) {
+    return 2;
+  }
+
   LAI_LOG_DEBUG("Starting tests...");
   test_manager_init();
 
   // Register tests
   linear_allocator_register_tests();
+  frame_stats_register_tests();
+  lai_string_register_tests();
+  freelist_register_tests();
+  render_batch_register_tests();
+  geometry_ranges_register_tests();
+  texture_streaming_register_tests();
+  mesh_cook_register_tests();
+  vulkan_memory_allocator_register_tests();
+  vulkan_cull_shader_register_tests();
+  vulkan_backend_register_tests();
+  lai_math_register_tests();
 
-  test_manager_run_tests();
+  bool passed = test_manager_run_tests(&options);
 
-  return 0;
+  return passed ? 0 : 1;
 }
\ No newline at end of file
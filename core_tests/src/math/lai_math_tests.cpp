@@ -0,0 +1,86 @@
+#include "math/lai_math_tests.h"
+#include "expect.h"
+#include "test_manager.h"
+
+#include <defines.h>
+#include <math/lai_math.h>
+
+u8 frustum_should_match_clip_volume_of_identity() {
+  frustum f = frustum_from_matrix(mat4_identity());
+
+  // left, right, bottom, top, near, far
+  f32 expected[6][4] = {{1, 0, 0, 1}, {-1, 0, 0, 1}, {0, 1, 0, 1},
+                        {0, -1, 0, 1}, {0, 0, 1, 0},  {0, 0, -1, 1}};
+  for (u32 i = 0; i < 6; ++i) {
+    for (u32 j = 0; j < 4; ++j) {
+      expect_float_to_be(expected[i][j], f.planes[i].elements[j]);
+    }
+  }
+  return true;
+}
+
+u8 frustum_should_cull_spheres_outside_any_plane() {
+  frustum f = frustum_from_matrix(mat4_identity());
+
+  expect_should_be(true, frustum_intersects_sphere(
+                             &f, vec3_create(0.0f, 0.0f, 0.5f), 0.1f));
+  // Straddling the right plane
+  expect_should_be(true, frustum_intersects_sphere(
+                             &f, vec3_create(1.05f, 0.0f, 0.5f), 0.1f));
+  expect_should_be(false, frustum_intersects_sphere(
+                              &f, vec3_create(1.2f, 0.0f, 0.5f), 0.1f));
+  expect_should_be(false, frustum_intersects_sphere(
+                              &f, vec3_create(0.0f, -1.5f, 0.5f), 0.1f));
+  // Behind the near plane and past the far plane
+  expect_should_be(false, frustum_intersects_sphere(
+                              &f, vec3_create(0.0f, 0.0f, -0.5f), 0.1f));
+  expect_should_be(false, frustum_intersects_sphere(
+                              &f, vec3_create(0.0f, 0.0f, 1.5f), 0.1f));
+  return true;
+}
+
+u8 frustum_should_normalize_planes_of_scaled_matrix() {
+  // Maps x and y from -10..10 into the clip volume.
+  mat4 scale = mat4_identity();
+  scale.data[0] = 0.1f;
+  scale.data[5] = 0.1f;
+  frustum f = frustum_from_matrix(scale);
+
+  expect_float_to_be(1.0f, f.planes[0].x);
+  expect_float_to_be(10.0f, f.planes[0].w);
+  expect_should_be(true, frustum_intersects_sphere(
+                             &f, vec3_create(-9.5f, 9.5f, 0.5f), 0.1f));
+  expect_should_be(false, frustum_intersects_sphere(
+                              &f, vec3_create(-10.5f, 0.0f, 0.5f), 0.1f));
+  return true;
+}
+
+u8 mat4_mul_should_apply_the_first_matrix_first() {
+  mat4 translation = mat4_identity();
+  translation.data[12] = 2.0f;
+  mat4 scale = mat4_identity();
+  scale.data[0] = 3.0f;
+
+  // Translated then scaled, so the translation is scaled too
+  mat4 result = mat4_mul(translation, scale);
+  expect_float_to_be(3.0f, result.data[0]);
+  expect_float_to_be(6.0f, result.data[12]);
+  expect_float_to_be(1.0f, result.data[15]);
+
+  result = mat4_mul(scale, translation);
+  expect_float_to_be(3.0f, result.data[0]);
+  expect_float_to_be(2.0f, result.data[12]);
+  return true;
+}
+
+void lai_math_register_tests() {
+  test_manager_register_test(frustum_should_match_clip_volume_of_identity,
+                             "frustum_should_match_clip_volume_of_identity");
+  test_manager_register_test(frustum_should_cull_spheres_outside_any_plane,
+                             "frustum_should_cull_spheres_outside_any_plane");
+  test_manager_register_test(
+      frustum_should_normalize_planes_of_scaled_matrix,
+      "frustum_should_normalize_planes_of_scaled_matrix");
+  test_manager_register_test(mat4_mul_should_apply_the_first_matrix_first,
+                             "mat4_mul_should_apply_the_first_matrix_first");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void lai_math_register_tests();
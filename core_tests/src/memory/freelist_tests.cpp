@@ -0,0 +1,152 @@
+#include "memory/freelist_tests.h"
+#include "expect.h"
+#include "test_manager.h"
+
+#include <defines.h>
+#include <memory/freelist.h>
+
+u8 freelist_should_create_and_destroy() {
+  freelist list;
+  freelist_create(512, &list);
+
+  expect_should_not_be(nullptr, list.nodes);
+  expect_should_be(512, list.total_size);
+  expect_should_be(512, freelist_free_space(&list));
+  expect_should_be(1, list.node_count);
+
+  freelist_destroy(&list);
+  expect_should_be(nullptr, list.nodes);
+  expect_should_be(0, list.total_size);
+
+  return true;
+}
+
+u8 freelist_should_allocate_all_space_and_fail_over_allocate() {
+  freelist list;
+  freelist_create(512, &list);
+
+  u64 offset = 1;
+  expect_should_be(true, freelist_allocate(&list, 512, &offset));
+  expect_should_be(0, offset);
+  expect_should_be(0, freelist_free_space(&list));
+  expect_should_be(0, list.node_count);
+
+  expect_should_be(false, freelist_allocate(&list, 1, &offset));
+
+  expect_should_be(true, freelist_free(&list, 512, 0));
+  expect_should_be(512, freelist_free_space(&list));
+  expect_should_be(1, list.node_count);
+
+  freelist_destroy(&list);
+
+  return true;
+}
+
+u8 freelist_should_align_allocations() {
+  freelist list;
+  freelist_create(1024, &list);
+
+  u64 first = 0;
+  u64 second = 0;
+  expect_should_be(true, freelist_allocate(&list, 10, &first));
+  expect_should_be(true, freelist_allocate_aligned(&list, 100, 256, &second));
+  expect_should_be(0, first);
+  expect_should_be(256, second);
+  expect_should_be(1024 - 110, freelist_free_space(&list));
+
+  // The padding in front of the aligned allocation is still usable
+  u64 third = 0;
+  expect_should_be(true, freelist_allocate(&list, 200, &third));
+  expect_should_be(10, third);
+
+  freelist_destroy(&list);
+
+  return true;
+}
+
+u8 freelist_should_coalesce_freed_ranges() {
+  freelist list;
+  freelist_create(300, &list);
+
+  u64 offsets[3];
+  for (u32 i = 0; i < 3; ++i) {
+    expect_should_be(true, freelist_allocate(&list, 100, &offsets[i]));
+  }
+
+  expect_should_be(true, freelist_free(&list, 100, offsets[0]));
+  expect_should_be(true, freelist_free(&list, 100, offsets[2]));
+  expect_should_be(2, list.node_count);
+
+  // Merges with both neighbours
+  expect_should_be(true, freelist_free(&list, 100, offsets[1]));
+  expect_should_be(1, list.node_count);
+  expect_should_be(300, list.nodes[0].size);
+
+  u64 offset = 0;
+  expect_should_be(true, freelist_allocate(&list, 300, &offset));
+
+  freelist_destroy(&list);
+
+  return true;
+}
+
+u8 freelist_should_reject_double_free() {
+  freelist list;
+  freelist_create(256, &list);
+
+  u64 offset = 0;
+  expect_should_be(true, freelist_allocate(&list, 64, &offset));
+  expect_should_be(true, freelist_free(&list, 64, offset));
+
+  LAI_LOG_DEBUG("Note: the following errors are caused by this test!");
+  expect_should_be(false, freelist_free(&list, 64, offset));
+  expect_should_be(false, freelist_free(&list, 64, 250));
+  expect_should_be(256, freelist_free_space(&list));
+
+  freelist_destroy(&list);
+
+  return true;
+}
+
+u8 freelist_should_grow_many_nodes_and_resize() {
+  freelist list;
+  freelist_create(64 * 100, &list);
+
+  // Every other range freed, forces the node array to grow
+  u64 offset = 0;
+  for (u32 i = 0; i < 100; ++i) {
+    expect_should_be(true, freelist_allocate(&list, 64, &offset));
+  }
+  for (u32 i = 0; i < 100; i += 2) {
+    expect_should_be(true, freelist_free(&list, 64, i * 64));
+  }
+  expect_should_be(50, list.node_count);
+
+  expect_should_be(true, freelist_resize(&list, 64 * 101));
+  expect_should_be(51, list.node_count);
+  expect_should_be(true, freelist_free(&list, 64, 99 * 64));
+  expect_should_be(50, list.node_count);
+  expect_should_be(64 * 52, freelist_free_space(&list));
+
+  expect_should_be(false, freelist_resize(&list, 64));
+
+  freelist_destroy(&list);
+
+  return true;
+}
+
+void freelist_register_tests() {
+  test_manager_register_test(freelist_should_create_and_destroy,
+                             "freelist_should_create_and_destroy");
+  test_manager_register_test(
+      freelist_should_allocate_all_space_and_fail_over_allocate,
+      "freelist_should_allocate_all_space_and_fail_over_allocate");
+  test_manager_register_test(freelist_should_align_allocations,
+                             "freelist_should_align_allocations");
+  test_manager_register_test(freelist_should_coalesce_freed_ranges,
+                             "freelist_should_coalesce_freed_ranges");
+  test_manager_register_test(freelist_should_reject_double_free,
+                             "freelist_should_reject_double_free");
+  test_manager_register_test(freelist_should_grow_many_nodes_and_resize,
+                             "freelist_should_grow_many_nodes_and_resize");
+}
@@ -0,0 +1,109 @@
+#include "renderer/geometry_ranges_tests.h"
+#include "expect.h"
+#include "test_manager.h"
+
+#include <defines.h>
+#include <renderer/geometry_ranges.h>
+
+static geometry_range make_range(u32 vertex_count, u32 index_count) {
+  geometry_range range = {};
+  range.vertex_count = vertex_count;
+  range.index_count = index_count;
+  return range;
+}
+
+u8 geometry_ranges_should_reuse_freed_ranges() {
+  geometry_range_allocator allocator;
+  geometry_range_allocator_create(300, 900, &allocator);
+
+  geometry_range ranges[3];
+  for (u32 i = 0; i < 3; ++i) {
+    ranges[i] = make_range(100, 300);
+    expect_should_be(true, geometry_range_allocate(&allocator, &ranges[i]));
+    expect_should_be(i * 100, ranges[i].vertex_offset);
+    expect_should_be(i * 300, ranges[i].index_offset);
+  }
+
+  // Full, the freed middle range is the only place left.
+  geometry_range extra = make_range(50, 60);
+  expect_should_be(false, geometry_range_allocate(&allocator, &extra));
+  geometry_range_free(&allocator, &ranges[1]);
+  expect_should_be(true, geometry_range_allocate(&allocator, &extra));
+  expect_should_be(100, extra.vertex_offset);
+  expect_should_be(300, extra.index_offset);
+
+  // Without indices only vertices are taken.
+  geometry_range vertices_only = make_range(50, 0);
+  expect_should_be(true, geometry_range_allocate(&allocator, &vertices_only));
+  expect_should_be(150, vertices_only.vertex_offset);
+  expect_should_be(900 - 300 * 2 - 60, freelist_free_space(&allocator.indices));
+
+  geometry_range_allocator_destroy(&allocator);
+
+  return true;
+}
+
+u8 geometry_ranges_should_not_leak_vertices_when_indices_are_full() {
+  geometry_range_allocator allocator;
+  geometry_range_allocator_create(100, 10, &allocator);
+
+  geometry_range range = make_range(40, 20);
+  expect_should_be(false, geometry_range_allocate(&allocator, &range));
+  expect_should_be(100, freelist_free_space(&allocator.vertices));
+  expect_should_be(10, freelist_free_space(&allocator.indices));
+
+  geometry_range_allocator_destroy(&allocator);
+
+  return true;
+}
+
+u8 geometry_ranges_should_compact_fragmented_ranges() {
+  geometry_range_allocator allocator;
+  geometry_range_allocator_create(400, 400, &allocator);
+
+  geometry_range ranges[4];
+  for (u32 i = 0; i < 4; ++i) {
+    ranges[i] = make_range(100, 100);
+    expect_should_be(true, geometry_range_allocate(&allocator, &ranges[i]));
+  }
+  geometry_range_free(&allocator, &ranges[0]);
+  geometry_range_free(&allocator, &ranges[2]);
+
+  // 200 free in two holes of 100
+  geometry_range large = make_range(150, 150);
+  expect_should_be(false, geometry_range_allocate(&allocator, &large));
+  expect_should_be(true,
+                   geometry_range_fits_compacted(&allocator, 150, 150));
+  expect_should_be(false,
+                   geometry_range_fits_compacted(&allocator, 250, 150));
+
+  // The live ranges move to the front in order.
+  geometry_range_allocator_clear(&allocator);
+  expect_should_be(true, geometry_range_allocate(&allocator, &ranges[1]));
+  expect_should_be(true, geometry_range_allocate(&allocator, &ranges[3]));
+  expect_should_be(0, ranges[1].vertex_offset);
+  expect_should_be(0, ranges[1].index_offset);
+  expect_should_be(100, ranges[3].vertex_offset);
+  expect_should_be(100, ranges[3].index_offset);
+
+  expect_should_be(true, geometry_range_allocate(&allocator, &large));
+  expect_should_be(200, large.vertex_offset);
+  expect_should_be(200, large.index_offset);
+  expect_should_be(1, allocator.vertices.node_count);
+  expect_should_be(50, freelist_free_space(&allocator.vertices));
+
+  geometry_range_allocator_destroy(&allocator);
+
+  return true;
+}
+
+void geometry_ranges_register_tests() {
+  test_manager_register_test(geometry_ranges_should_reuse_freed_ranges,
+                             "geometry_ranges_should_reuse_freed_ranges");
+  test_manager_register_test(
+      geometry_ranges_should_not_leak_vertices_when_indices_are_full,
+      "geometry_ranges_should_not_leak_vertices_when_indices_are_full");
+  test_manager_register_test(
+      geometry_ranges_should_compact_fragmented_ranges,
+      "geometry_ranges_should_compact_fragmented_ranges");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void geometry_ranges_register_tests();
@@ -0,0 +1,231 @@
+#include "renderer/mesh_cook_tests.h"
+#include "expect.h"
+#include "test_manager.h"
+
+#include <base/lai_memory.h>
+#include <base/lai_string.h>
+#include <base/log.h>
+#include <containers/darray.h>
+#include <defines.h>
+#include <math/lai_math.h>
+#include <platform/filesystem.h>
+#include <renderer/mesh_cook.h>
+
+// A flat grid of size * size quads, two triangles each
+static void make_grid(u32 size, vertex_3d **out_vertices, u32 **out_indices) {
+  *out_vertices = darray_create(vertex_3d);
+  *out_indices = darray_create(u32);
+  for (u32 y = 0; y <= size; ++y) {
+    for (u32 x = 0; x <= size; ++x) {
+      vertex_3d vertex;
+      vertex.position = vec3_create((f32)x, (f32)y, 0.0f);
+      vertex.texcoord = vec2_create((f32)x / size, (f32)y / size);
+      darray_push(*out_vertices, vertex);
+    }
+  }
+  for (u32 y = 0; y < size; ++y) {
+    for (u32 x = 0; x < size; ++x) {
+      u32 corner = y * (size + 1) + x;
+      u32 quad[6] = {corner, corner + 1, corner + size + 2,
+                     corner, corner + size + 2, corner + size + 1};
+      for (u32 i = 0; i < 6; ++i) {
+        darray_push(*out_indices, quad[i]);
+      }
+    }
+  }
+}
+
+u8 mesh_cook_should_parse_obj_faces() {
+  const char *obj = "# quad\n"
+                    "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+                    "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+                    "vn 0 0 1\n"
+                    "f 1/1/1 2/2/1 3/3/1 -1/-1/1\n"
+                    "f 1/1 3/3 4/4\n";
+  vertex_3d *vertices;
+  u32 *indices;
+  expect_should_be(true, mesh_cook_parse_obj(obj, string_length(obj),
+                                             &vertices, &indices));
+  // Corners with the same position and texcoord share a vertex.
+  expect_should_be(4, darray_length(vertices));
+  expect_should_be(9, darray_length(indices));
+  expect_should_be(0, indices[3]);
+  expect_should_be(2, indices[4]);
+  expect_should_be(3, indices[5]);
+  expect_float_to_be(1.0f, vertices[1].position.x);
+  // Texcoords are flipped to start at the top.
+  expect_float_to_be(1.0f, vertices[0].texcoord.y);
+  expect_float_to_be(0.0f, vertices[2].texcoord.y);
+  darray_destroy(vertices);
+  darray_destroy(indices);
+
+  // A texcoord with only u has a v of 0, the bottom of the image.
+  const char *one_component = "v 0 0 0\nv 1 0 0\nv 1 1 0\n"
+                              "vt 0.25\nvt 0.5 0.5 0\n"
+                              "f 1/1 2/2 3/1\n";
+  expect_should_be(true, mesh_cook_parse_obj(one_component,
+                                             string_length(one_component),
+                                             &vertices, &indices));
+  expect_float_to_be(0.25f, vertices[0].texcoord.x);
+  expect_float_to_be(1.0f, vertices[0].texcoord.y);
+  expect_float_to_be(0.5f, vertices[1].texcoord.y);
+  darray_destroy(vertices);
+  darray_destroy(indices);
+
+  const char *broken = "v 0 0 0\nf 1 2 3\n";
+  LAI_LOG_DEBUG("Note: the following error is caused by this test!");
+  expect_should_be(false, mesh_cook_parse_obj(broken, string_length(broken),
+                                              &vertices, &indices));
+  return true;
+}
+
+u8 mesh_cook_should_limit_meshlet_size() {
+  // Triangles sharing no vertices fill meshlets by vertex count.
+  const u32 triangle_count = 200;
+  vertex_3d *vertices = darray_create(vertex_3d);
+  u32 *indices = darray_create(u32);
+  for (u32 i = 0; i < triangle_count * 3; ++i) {
+    vertex_3d vertex;
+    vertex.position = vec3_create((f32)i, 0.0f, 0.0f);
+    vertex.texcoord = vec2_create(0.0f, 0.0f);
+    darray_push(vertices, vertex);
+    darray_push(indices, i);
+  }
+
+  mesh_file_meshlet *meshlets;
+  u32 *meshlet_vertices;
+  u8 *meshlet_triangles;
+  mesh_cook_build_meshlets(vertices, triangle_count * 3, indices,
+                           triangle_count * 3, &meshlets, &meshlet_vertices,
+                           &meshlet_triangles);
+  // 21 triangles use 63 of the 64 vertices a meshlet can have.
+  expect_should_be(10, darray_length(meshlets));
+  expect_should_be(63, meshlets[0].vertex_count);
+  expect_should_be(21, meshlets[0].triangle_count);
+  expect_should_be(21, meshlets[1].triangle_offset);
+  expect_should_be(200 - 9 * 21, meshlets[9].triangle_count);
+  expect_should_be(triangle_count * 3, darray_length(meshlet_triangles));
+  // The first meshlet spans x 0 to 62.
+  expect_float_to_be(31.0f, meshlets[0].bounds[0]);
+  expect_float_to_be(31.0f, meshlets[0].bounds[3]);
+
+  darray_destroy(meshlets);
+  darray_destroy(meshlet_vertices);
+  darray_destroy(meshlet_triangles);
+  darray_destroy(vertices);
+  darray_destroy(indices);
+  return true;
+}
+
+u8 mesh_cook_should_write_loadable_lods() {
+  vertex_3d *vertices;
+  u32 *indices;
+  make_grid(32, &vertices, &indices);
+  u32 vertex_count = (u32)darray_length(vertices);
+  u32 index_count = (u32)darray_length(indices);
+
+  u8 *data;
+  u64 size;
+  expect_should_be(true, mesh_cook(vertices, vertex_count, indices,
+                                   index_count, MESH_FILE_MAX_LODS, &data,
+                                   &size));
+  expect_should_be(true, mesh_file_validate(data, size));
+
+  const mesh_file_header *header = (const mesh_file_header *)data;
+  expect_should_be(true, header->lod_count > 1);
+  expect_float_to_be(16.0f, header->bounds[0]);
+
+  mesh_file_lod_view view;
+  mesh_file_get_lod(data, 0, &view);
+  expect_should_be(vertex_count, view.lod->vertex_count);
+  expect_should_be(index_count, view.lod->index_count);
+  expect_should_be(indices[5], view.indices[5]);
+  expect_float_to_be(vertices[7].position.x, view.vertices[7].position.x);
+  expect_float_to_be(0.0f, view.lod->error);
+
+  u32 previous_triangles = index_count / 3;
+  for (u32 i = 0; i < header->lod_count; ++i) {
+    mesh_file_get_lod(data, i, &view);
+    u32 triangles = view.lod->index_count / 3;
+    if (i > 0) {
+      expect_should_be(true, triangles <= previous_triangles / 2);
+      expect_should_be(true, view.lod->error > 0.0f);
+    }
+    previous_triangles = triangles;
+
+    // Every triangle is in exactly one meshlet.
+    u32 meshlet_triangles = 0;
+    for (u32 m = 0; m < view.lod->meshlet_count; ++m) {
+      expect_should_be(true, view.meshlets[m].vertex_count <=
+                                 MESH_FILE_MAX_MESHLET_VERTICES);
+      meshlet_triangles += view.meshlets[m].triangle_count;
+    }
+    expect_should_be(triangles, meshlet_triangles);
+    expect_should_be(triangles, view.lod->meshlet_triangle_count);
+  }
+
+  // Truncated files and files of another format are refused.
+  LAI_LOG_DEBUG("Note: the following errors are caused by this test!");
+  expect_should_be(false, mesh_file_validate(data, size - 4));
+  u32 magic = header->magic;
+  ((mesh_file_header *)data)->magic = 0;
+  expect_should_be(false, mesh_file_validate(data, size));
+  ((mesh_file_header *)data)->magic = magic;
+
+  mesh_cook_free(data, size);
+  darray_destroy(vertices);
+  darray_destroy(indices);
+  return true;
+}
+
+u8 mesh_cook_should_map_cooked_files() {
+  vertex_3d *vertices;
+  u32 *indices;
+  make_grid(8, &vertices, &indices);
+  u32 vertex_count = (u32)darray_length(vertices);
+  u32 index_count = (u32)darray_length(indices);
+
+  u8 *data;
+  u64 size;
+  expect_should_be(true, mesh_cook(vertices, vertex_count, indices,
+                                   index_count, MESH_FILE_MAX_LODS, &data,
+                                   &size));
+  const char *path = "mesh_cook_test.mesh";
+  file_handle file;
+  u64 written = 0;
+  expect_should_be(true, filesystem_open(path, FILE_MODE_WRITE, true, &file));
+  expect_should_be(true, filesystem_write(&file, size, data, &written));
+  filesystem_close(&file);
+  mesh_cook_free(data, size);
+
+  // Loading maps the file and reads the arrays in place.
+  file_mapping mapping;
+  expect_should_be(true, filesystem_map(path, &mapping));
+  expect_should_be(size, mapping.size);
+  expect_should_be(true, mesh_file_validate(mapping.data, mapping.size));
+
+  mesh_file_lod_view view;
+  mesh_file_get_lod(mapping.data, 0, &view);
+  expect_should_be(vertex_count, view.lod->vertex_count);
+  expect_should_be(index_count, view.lod->index_count);
+  expect_should_be(indices[index_count - 1], view.indices[index_count - 1]);
+  expect_float_to_be(vertices[vertex_count - 1].position.y,
+                     view.vertices[vertex_count - 1].position.y);
+
+  filesystem_unmap(&mapping);
+  expect_should_be(true, filesystem_delete(path));
+  darray_destroy(vertices);
+  darray_destroy(indices);
+  return true;
+}
+
+void mesh_cook_register_tests() {
+  test_manager_register_test(mesh_cook_should_parse_obj_faces,
+                             "mesh_cook_should_parse_obj_faces");
+  test_manager_register_test(mesh_cook_should_limit_meshlet_size,
+                             "mesh_cook_should_limit_meshlet_size");
+  test_manager_register_test(mesh_cook_should_write_loadable_lods,
+                             "mesh_cook_should_write_loadable_lods");
+  test_manager_register_test(mesh_cook_should_map_cooked_files,
+                             "mesh_cook_should_map_cooked_files");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void mesh_cook_register_tests();
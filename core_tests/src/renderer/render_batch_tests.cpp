@@ -0,0 +1,132 @@
+#include "renderer/render_batch_tests.h"
+#include "expect.h"
+#include "test_manager.h"
+
+#include <containers/darray.h>
+#include <defines.h>
+#include <renderer/render_batch.h>
+
+static geometry make_geometry(u32 id) {
+  geometry g;
+  g.id = id;
+  g.internal_id = id;
+  g.generation = 0;
+  g.name[0] = 0;
+  return g;
+}
+
+static geometry_render_data make_draw(geometry *g, u32 material_id,
+                                      f32 marker) {
+  geometry_render_data draw;
+  for (u32 i = 0; i < 16; ++i) {
+    draw.model.data[i] = 0.0f;
+  }
+  // Tags the draw so its transform can be found after sorting.
+  draw.model.data[12] = marker;
+  draw.geometry = g;
+  draw.material_id = material_id;
+  return draw;
+}
+
+u8 render_batch_should_order_keys_by_pipeline_material_geometry() {
+  u64 base = render_batch_sort_key(0, 0, 0);
+  expect_should_be(true, base < render_batch_sort_key(0, 0, 1));
+  expect_should_be(true, render_batch_sort_key(0, 0, 0xFFFFFFFF) <
+                             render_batch_sort_key(0, 1, 0));
+  expect_should_be(true, render_batch_sort_key(0, 0xFFFFFF, 0xFFFFFFFF) <
+                             render_batch_sort_key(1, 0, 0));
+  return true;
+}
+
+u8 render_batch_should_merge_draws_of_same_geometry() {
+  geometry a = make_geometry(1);
+  geometry b = make_geometry(2);
+
+  geometry_render_data draws[5] = {
+      make_draw(&b, INVALID_ID, 0.0f), make_draw(&a, INVALID_ID, 1.0f),
+      make_draw(&b, INVALID_ID, 2.0f), make_draw(&a, INVALID_ID, 3.0f),
+      make_draw(&a, INVALID_ID, 4.0f)};
+
+  render_batch_list list;
+  render_batch_list_create(&list);
+  render_batch_list_build(&list, draws, 5);
+
+  expect_should_be(2, darray_length(list.batches));
+  expect_should_be(5, darray_length(list.transforms));
+
+  expect_should_be(&a, list.batches[0].geometry);
+  expect_should_be(0, list.batches[0].first_instance);
+  expect_should_be(3, list.batches[0].instance_count);
+  expect_should_be(&b, list.batches[1].geometry);
+  expect_should_be(3, list.batches[1].first_instance);
+  expect_should_be(2, list.batches[1].instance_count);
+
+  // Submission order is kept within a batch.
+  f32 expected[5] = {1.0f, 3.0f, 4.0f, 0.0f, 2.0f};
+  for (u32 i = 0; i < 5; ++i) {
+    expect_float_to_be(expected[i], list.transforms[i].data[12]);
+  }
+
+  render_batch_list_destroy(&list);
+  return true;
+}
+
+u8 render_batch_should_split_batches_by_material() {
+  geometry a = make_geometry(1);
+
+  geometry_render_data draws[3] = {make_draw(&a, 7, 0.0f),
+                                   make_draw(&a, 3, 1.0f),
+                                   make_draw(&a, 7, 2.0f)};
+
+  render_batch_list list;
+  render_batch_list_create(&list);
+  render_batch_list_build(&list, draws, 3);
+
+  expect_should_be(2, darray_length(list.batches));
+  expect_should_be(3, list.batches[0].material_id);
+  expect_should_be(1, list.batches[0].instance_count);
+  expect_should_be(7, list.batches[1].material_id);
+  expect_should_be(2, list.batches[1].instance_count);
+
+  render_batch_list_destroy(&list);
+  return true;
+}
+
+u8 render_batch_should_skip_unloaded_geometry_and_reuse_lists() {
+  geometry a = make_geometry(1);
+  geometry unloaded = make_geometry(2);
+  unloaded.internal_id = INVALID_ID;
+
+  geometry_render_data draws[3] = {make_draw(nullptr, INVALID_ID, 0.0f),
+                                   make_draw(&unloaded, INVALID_ID, 1.0f),
+                                   make_draw(&a, INVALID_ID, 2.0f)};
+
+  render_batch_list list;
+  render_batch_list_create(&list);
+  render_batch_list_build(&list, draws, 3);
+  expect_should_be(1, darray_length(list.batches));
+  expect_should_be(1, darray_length(list.transforms));
+
+  // A second frame replaces the first one's contents.
+  render_batch_list_build(&list, draws, 0);
+  expect_should_be(0, darray_length(list.batches));
+  expect_should_be(0, darray_length(list.transforms));
+
+  render_batch_list_destroy(&list);
+  expect_should_be(nullptr, list.batches);
+  return true;
+}
+
+void render_batch_register_tests() {
+  test_manager_register_test(
+      render_batch_should_order_keys_by_pipeline_material_geometry,
+      "render_batch_should_order_keys_by_pipeline_material_geometry");
+  test_manager_register_test(
+      render_batch_should_merge_draws_of_same_geometry,
+      "render_batch_should_merge_draws_of_same_geometry");
+  test_manager_register_test(render_batch_should_split_batches_by_material,
+                             "render_batch_should_split_batches_by_material");
+  test_manager_register_test(
+      render_batch_should_skip_unloaded_geometry_and_reuse_lists,
+      "render_batch_should_skip_unloaded_geometry_and_reuse_lists");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void render_batch_register_tests();
@@ -0,0 +1,164 @@
+#include "renderer/texture_streaming_tests.h"
+#include "expect.h"
+#include "test_manager.h"
+
+#include <defines.h>
+#include <math/lai_math.h>
+#include <renderer/texture_streaming.h>
+
+// Bytes of the levels of a 256 * 256 texture from its tail, 64 * 64, down
+#define TAIL_SIZE_256 21844
+
+static texture_streaming_entry make_entry(u32 size, u32 resident_mip,
+                                          u32 desired_mip,
+                                          u64 last_used_frame) {
+  texture_streaming_entry entry;
+  entry.width = size;
+  entry.height = size;
+  entry.mip_count = texture_mip_count(size, size);
+  entry.resident_mip = resident_mip;
+  entry.desired_mip = desired_mip;
+  entry.last_used_frame = last_used_frame;
+  entry.streamable = true;
+  return entry;
+}
+
+u8 texture_streaming_should_size_mip_chains() {
+  expect_should_be(9, texture_mip_count(256, 64));
+  expect_should_be(1, texture_mip_count(1, 1));
+  expect_should_be(256 * 64 * 4, texture_mip_size(256, 64, 0));
+  // The shorter side stops at 1.
+  expect_should_be(4 * 1 * 4, texture_mip_size(256, 64, 6));
+  expect_should_be(4, texture_mip_size(256, 64, 8));
+  expect_should_be(TAIL_SIZE_256, texture_levels_size(256, 256, 9, 2));
+  expect_should_be(0, texture_levels_size(256, 256, 9, 9));
+  expect_should_be(2, texture_tail_mip(256, 256, 9));
+  expect_should_be(0, texture_tail_mip(64, 16, 7));
+  return true;
+}
+
+u8 texture_streaming_should_average_texels_into_next_mip() {
+  u8 square[16] = {0, 0, 0, 255,   100, 0, 0, 255,
+                   200, 0, 0, 255, 100, 40, 0, 255};
+  u8 dst[4];
+  texture_generate_mip(2, 2, square, dst);
+  expect_should_be(100, dst[0]);
+  expect_should_be(10, dst[1]);
+  expect_should_be(255, dst[3]);
+
+  // An odd side leaves its last texel out, a side of 1 stays 1.
+  u8 row[12] = {10, 0, 0, 0, 30, 0, 0, 0, 250, 0, 0, 0};
+  texture_generate_mip(3, 1, row, dst);
+  expect_should_be(20, dst[0]);
+  return true;
+}
+
+u8 texture_streaming_should_pick_mip_from_screen_size() {
+  mat4 projection = mat4_perspective(LAI_HALF_PI, 1.0f, 0.1f, 100.0f);
+  mat4 model = mat4_translation(vec3_create(0.0f, 0.0f, -10.0f));
+  vec4 bounds = vec4_create(0.0f, 0.0f, 0.0f, 1.0f);
+  f32 size = texture_streaming_screen_size(bounds, model, mat4_identity(),
+                                           projection, 1000);
+  expect_float_to_be(100.0f, size);
+
+  // Behind the camera nothing is seen.
+  model = mat4_translation(vec3_create(0.0f, 0.0f, 10.0f));
+  expect_float_to_be(0.0f, texture_streaming_screen_size(
+                               bounds, model, mat4_identity(), projection,
+                               1000));
+
+  expect_should_be(0, texture_streaming_desired_mip(256, 256, 9, 300.0f));
+  expect_should_be(1, texture_streaming_desired_mip(256, 256, 9, 100.0f));
+  expect_should_be(8, texture_streaming_desired_mip(256, 256, 9, 0.0f));
+  return true;
+}
+
+u8 texture_streaming_should_load_tails_first() {
+  texture_streaming_entry entries[2] = {make_entry(256, 9, 0, 1),
+                                        make_entry(256, 9, 0, 1)};
+  u32 changed[2];
+  // The tails go past a budget of nothing, the finer levels do not.
+  u32 count = texture_streaming_plan(entries, 2, 0, 2, changed);
+  expect_should_be(2, count);
+  expect_should_be(2, entries[0].resident_mip);
+  expect_should_be(2, entries[1].resident_mip);
+  return true;
+}
+
+u8 texture_streaming_should_upgrade_coarsest_levels_first() {
+  texture_streaming_entry entries[2] = {make_entry(256, 2, 0, 5),
+                                        make_entry(256, 2, 0, 6)};
+  u32 changed[2];
+  u64 budget = 2 * TAIL_SIZE_256 + 2 * 65536;
+  u32 count = texture_streaming_plan(entries, 2, budget, 2, changed);
+  expect_should_be(2, count);
+  expect_should_be(1, entries[0].resident_mip);
+  expect_should_be(1, entries[1].resident_mip);
+
+  // The most recently used gets the one level 0 there is room for.
+  budget += 256 * 256 * 4;
+  count = texture_streaming_plan(entries, 2, budget, 2, changed);
+  expect_should_be(1, count);
+  expect_should_be(1, changed[0]);
+  expect_should_be(1, entries[0].resident_mip);
+  expect_should_be(0, entries[1].resident_mip);
+  return true;
+}
+
+u8 texture_streaming_should_evict_least_recently_used() {
+  u64 budget = TAIL_SIZE_256 * 2 + 65536 + 256 * 256 * 4;
+  texture_streaming_entry entries[2] = {make_entry(256, 0, 0, 1),
+                                        make_entry(256, 2, 0, 2)};
+  u32 changed[2];
+  u32 count = texture_streaming_plan(entries, 2, budget, 2, changed);
+  expect_should_be(2, count);
+  expect_should_be(2, entries[0].resident_mip);
+  expect_should_be(0, entries[1].resident_mip);
+
+  // A texture used later than the others keeps its levels.
+  entries[0] = make_entry(256, 0, 0, 2);
+  entries[1] = make_entry(256, 2, 0, 1);
+  count = texture_streaming_plan(entries, 2, budget, 2, changed);
+  expect_should_be(0, count);
+  expect_should_be(0, entries[0].resident_mip);
+  expect_should_be(2, entries[1].resident_mip);
+  return true;
+}
+
+u8 texture_streaming_should_limit_changes() {
+  texture_streaming_entry entries[3] = {make_entry(256, 9, 0, 1),
+                                        make_entry(256, 9, 0, 1),
+                                        make_entry(256, 9, 0, 1)};
+  u32 changed[2];
+  u32 count = texture_streaming_plan(entries, 3, 0, 2, changed);
+  expect_should_be(2, count);
+  expect_should_be(9, entries[2].resident_mip);
+
+  // Entries not streamable yet are left alone.
+  entries[2].streamable = false;
+  count = texture_streaming_plan(entries, 3, 0, 2, changed);
+  expect_should_be(0, count);
+  expect_should_be(9, entries[2].resident_mip);
+  return true;
+}
+
+void texture_streaming_register_tests() {
+  test_manager_register_test(texture_streaming_should_size_mip_chains,
+                             "texture_streaming_should_size_mip_chains");
+  test_manager_register_test(
+      texture_streaming_should_average_texels_into_next_mip,
+      "texture_streaming_should_average_texels_into_next_mip");
+  test_manager_register_test(
+      texture_streaming_should_pick_mip_from_screen_size,
+      "texture_streaming_should_pick_mip_from_screen_size");
+  test_manager_register_test(texture_streaming_should_load_tails_first,
+                             "texture_streaming_should_load_tails_first");
+  test_manager_register_test(
+      texture_streaming_should_upgrade_coarsest_levels_first,
+      "texture_streaming_should_upgrade_coarsest_levels_first");
+  test_manager_register_test(
+      texture_streaming_should_evict_least_recently_used,
+      "texture_streaming_should_evict_least_recently_used");
+  test_manager_register_test(texture_streaming_should_limit_changes,
+                             "texture_streaming_should_limit_changes");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void texture_streaming_register_tests();
@@ -0,0 +1,171 @@
+#include "renderer/vulkan/shaders/vulkan_cull_shader_tests.h"
+#include "expect.h"
+#include "renderer/vulkan/vulkan_test_device.h"
+#include "test_manager.h"
+
+#include <base/lai_memory.h>
+#include <defines.h>
+#include <math/lai_math.h>
+#include <renderer/vulkan/shaders/vulkan_cull_shader.h>
+#include <renderer/vulkan/vulkan_buffer.h>
+#include <renderer/vulkan/vulkan_command_buffer.h>
+#include <renderer/vulkan/vulkan_descriptor.h>
+#include <renderer/vulkan/vulkan_memory_allocator.h>
+
+static void destroy_cull_context(vulkan_context *context) {
+  vkDeviceWaitIdle(context->device.logical_device);
+  vulkan_cull_shader_destroy(context, &context->cull_shader);
+  vulkan_buffer_destroy(context, &context->instance_buffer);
+  vulkan_buffer_destroy(context, &context->indirect_buffer);
+  vulkan_descriptor_allocator_destroy(context,
+                                      context->frame_descriptor_allocators);
+  lai_free(context->frame_descriptor_allocators,
+           sizeof(vulkan_descriptor_allocator), MEMORY_TAG_RENDERER);
+  vulkan_descriptor_layout_cache_destroy(context,
+                                         &context->descriptor_layout_cache);
+  vulkan_memory_allocator_destroy(context, &context->memory_allocator);
+  vulkan_test_device_destroy(context);
+}
+
+// The parts of the backend the cull shader uses, one frame in flight. False
+// without a device or the compiled shader.
+static bool create_cull_context(vulkan_context *context) {
+  if (!vulkan_test_device_create(context)) {
+    return false;
+  }
+  context->swapchain.max_frames_in_flight = 1;
+  context->current_frame = 0;
+  vulkan_memory_allocator_create(context, &context->memory_allocator);
+  vulkan_descriptor_layout_cache_create(&context->descriptor_layout_cache);
+  context->frame_descriptor_allocators =
+      (vulkan_descriptor_allocator *)lai_allocate(
+          sizeof(vulkan_descriptor_allocator), MEMORY_TAG_RENDERER);
+  vulkan_descriptor_allocator_create(4, context->frame_descriptor_allocators);
+
+  // Host visible like the backend's, so the results can be read back.
+  u32 host_memory_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  bool created =
+      vulkan_buffer_create(context,
+                           sizeof(mat4) * VULKAN_MAX_INSTANCES_PER_FRAME,
+                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                           host_memory_flags, true,
+                           &context->instance_buffer) &&
+      vulkan_buffer_create(context,
+                           sizeof(VkDrawIndexedIndirectCommand) *
+                               VULKAN_MAX_INSTANCES_PER_FRAME,
+                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                           host_memory_flags, true,
+                           &context->indirect_buffer) &&
+      vulkan_cull_shader_create(context, &context->cull_shader);
+  if (!created) {
+    LAI_LOG_WARN("Could not create the cull shader, skipping gpu test");
+    destroy_cull_context(context);
+    return false;
+  }
+  return true;
+}
+
+// The box from -10 to 10 along every axis
+static frustum make_box_frustum() {
+  frustum box;
+  box.planes[0] = vec4_create(1.0f, 0.0f, 0.0f, 10.0f);
+  box.planes[1] = vec4_create(-1.0f, 0.0f, 0.0f, 10.0f);
+  box.planes[2] = vec4_create(0.0f, 1.0f, 0.0f, 10.0f);
+  box.planes[3] = vec4_create(0.0f, -1.0f, 0.0f, 10.0f);
+  box.planes[4] = vec4_create(0.0f, 0.0f, 1.0f, 10.0f);
+  box.planes[5] = vec4_create(0.0f, 0.0f, -1.0f, 10.0f);
+  return box;
+}
+
+u8 vulkan_cull_shader_should_write_draws_of_visible_spheres() {
+  vulkan_context context;
+  if (!create_cull_context(&context)) {
+    return BYPASS;
+  }
+
+  // Sphere bounds, model translations and scales, whether it is visible
+  const u32 object_count = 5;
+  vec4 bounds[object_count] = {
+      vec4_create(0.0f, 0.0f, 0.0f, 1.0f),
+      vec4_create(20.0f, 0.0f, 0.0f, 1.0f),
+      // Crosses the right plane
+      vec4_create(11.0f, 0.0f, 0.0f, 2.0f),
+      vec4_create(0.0f, 0.0f, 0.0f, 1.0f),
+      vec4_create(0.0f, 0.0f, 0.0f, 1.0f),
+  };
+  vec3 translations[object_count] = {
+      vec3_zero(), vec3_zero(), vec3_zero(), vec3_create(0.0f, -15.0f, 0.0f),
+      vec3_create(0.0f, 15.0f, 0.0f)};
+  // Grows the last radius to 6, which reaches into the box.
+  f32 scales[object_count] = {1.0f, 1.0f, 1.0f, 1.0f, 6.0f};
+  bool visible[object_count] = {true, false, true, false, true};
+
+  vulkan_cull_object *objects =
+      (vulkan_cull_object *)context.cull_shader.object_buffer.allocation
+          .mapped;
+  mat4 *models = (mat4 *)context.instance_buffer.allocation.mapped;
+  for (u32 i = 0; i < object_count; ++i) {
+    objects[i].bounds = bounds[i];
+    objects[i].index_count = 3 * (i + 1);
+    objects[i].first_index = 100 * i;
+    objects[i].vertex_offset = (i32)(10 * i);
+    objects[i].instance_index = i;
+
+    models[i] = mat4_translation(translations[i]);
+    models[i].data[0] = scales[i];
+    models[i].data[5] = scales[i];
+    models[i].data[10] = scales[i];
+  }
+
+  frustum box = make_box_frustum();
+  vulkan_command_buffer command_buffer;
+  vulkan_command_buffer_allocate_and_begin_single_use(
+      &context, context.device.graphics_command_pool, &command_buffer);
+  vulkan_cull_shader_dispatch(&context, &context.cull_shader, &command_buffer,
+                              object_count, &box);
+  VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(command_buffer.handle,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr,
+                       0, nullptr);
+  // Waits for the queue to be idle
+  vulkan_command_buffer_end_single_use(&context,
+                                       context.device.graphics_command_pool,
+                                       &command_buffer,
+                                       context.device.graphics_queue);
+
+  u32 draw_count =
+      *(u32 *)context.cull_shader.draw_count_buffer.allocation.mapped;
+  expect_should_be(3, draw_count);
+
+  // Slots are taken atomically, the order is not fixed.
+  const VkDrawIndexedIndirectCommand *commands =
+      (const VkDrawIndexedIndirectCommand *)context.indirect_buffer.allocation
+          .mapped;
+  u32 drawn_mask = 0;
+  for (u32 i = 0; i < draw_count; ++i) {
+    const VkDrawIndexedIndirectCommand *command = &commands[i];
+    u32 object = command->firstInstance;
+    expect_should_be(true, object < object_count);
+    expect_should_be(true, visible[object]);
+    expect_should_be(objects[object].index_count, command->indexCount);
+    expect_should_be(1, command->instanceCount);
+    expect_should_be(objects[object].first_index, command->firstIndex);
+    expect_should_be(objects[object].vertex_offset, command->vertexOffset);
+    drawn_mask |= 1 << object;
+  }
+  expect_should_be((1 << 0) | (1 << 2) | (1 << 4), drawn_mask);
+
+  destroy_cull_context(&context);
+
+  return true;
+}
+
+void vulkan_cull_shader_register_tests() {
+  test_manager_register_serial_test(
+      vulkan_cull_shader_should_write_draws_of_visible_spheres,
+      "vulkan_cull_shader_should_write_draws_of_visible_spheres");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void vulkan_cull_shader_register_tests();
@@ -0,0 +1,89 @@
+#include "renderer/vulkan/vulkan_backend_tests.h"
+#include "expect.h"
+#include "renderer/vulkan/vulkan_test_device.h"
+#include "test_manager.h"
+
+#include <base/lai_memory.h>
+#include <defines.h>
+#include <math/lai_math.h>
+#include <platform/filesystem.h>
+#include <renderer/renderer_frontend.h>
+
+// The clear color of the main render pass in the 8 bit BGRA of the frame
+#define CLEAR_BLUE 51
+#define CLEAR_ALPHA 255
+
+// Whether a headless renderer can be created at all. The backend treats a
+// missing device or shader as fatal, the test is skipped before that.
+static bool can_create_renderer() {
+  if (!filesystem_exists("assets/shaders/Builtin.ObjectShader.vert.spv") ||
+      !filesystem_exists("assets/shaders/Builtin.ObjectShader.frag.spv")) {
+    LAI_LOG_WARN("Shaders are not compiled, skipping gpu test");
+    return false;
+  }
+  vulkan_context context;
+  if (!vulkan_test_device_create(&context)) {
+    return false;
+  }
+  vulkan_test_device_destroy(&context);
+  return true;
+}
+
+static bool pixel_is_clear_color(const u8 *pixel) {
+  // Conversions to 8 bit may round either way.
+  return pixel[0] + 1 >= CLEAR_BLUE && pixel[0] <= CLEAR_BLUE + 1 &&
+         pixel[1] <= 1 && pixel[2] <= 1 && pixel[3] == CLEAR_ALPHA;
+}
+
+u8 vulkan_backend_should_read_back_headless_frames() {
+  if (!can_create_renderer()) {
+    return BYPASS;
+  }
+
+  renderer_config config = {};
+  config.application_name = "core_tests";
+  config.headless = true;
+  config.readback = true;
+  u64 memory_requirement = 0;
+  renderer_initialize(&memory_requirement, nullptr, nullptr);
+  void *state = lai_allocate(memory_requirement, MEMORY_TAG_RENDERER);
+  expect_should_be(true,
+                   renderer_initialize(&memory_requirement, state, &config));
+
+  u32 width = 0;
+  u32 height = 0;
+  const void *pixels = nullptr;
+  // Nothing has been drawn yet.
+  expect_should_be(false, renderer_read_frame(&width, &height, &pixels));
+
+  render_packet packet = {};
+  packet.projection = mat4_identity();
+  packet.view = mat4_identity();
+  expect_should_be(true, renderer_draw_frame(&packet));
+  expect_should_be(true, renderer_read_frame(&width, &height, &pixels));
+
+  // Without an application the backend picks its default size.
+  expect_should_be(800, width);
+  expect_should_be(600, height);
+  expect_should_not_be(nullptr, pixels);
+
+  // Corners and center of the cleared frame
+  const u8 *bytes = (const u8 *)pixels;
+  u64 row = (u64)width * 4;
+  u64 samples[5] = {0, row - 4, row * (height - 1), row * height - 4,
+                    row * (height / 2) + (width / 2) * 4};
+  for (u32 i = 0; i < 5; ++i) {
+    expect_should_be(true, pixel_is_clear_color(bytes + samples[i]));
+  }
+
+  renderer_shutdown(state);
+  lai_free(state, memory_requirement, MEMORY_TAG_RENDERER);
+
+  return true;
+}
+
+void vulkan_backend_register_tests() {
+  test_manager_register_serial_test(
+      vulkan_backend_should_read_back_headless_frames,
+      "vulkan_backend_should_read_back_headless_frames");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void vulkan_backend_register_tests();
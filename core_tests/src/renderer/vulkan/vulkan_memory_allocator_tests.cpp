@@ -0,0 +1,194 @@
+#include "renderer/vulkan/vulkan_memory_allocator_tests.h"
+#include "expect.h"
+#include "renderer/vulkan/vulkan_test_device.h"
+#include "test_manager.h"
+
+#include <containers/darray.h>
+#include <defines.h>
+#include <renderer/vulkan/vulkan_memory_allocator.h>
+
+// Device local memory, sizes are not rounded to the non coherent atom.
+#define TEST_MEMORY_FLAGS VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+
+static bool create_allocator(vulkan_context *context) {
+  if (!vulkan_test_device_create(context)) {
+    return false;
+  }
+  vulkan_memory_allocator_create(context, &context->memory_allocator);
+  return true;
+}
+
+static void destroy_allocator(vulkan_context *context) {
+  vulkan_memory_allocator_destroy(context, &context->memory_allocator);
+  vulkan_test_device_destroy(context);
+}
+
+static VkMemoryRequirements make_requirements(u64 size, u64 alignment) {
+  VkMemoryRequirements requirements = {};
+  requirements.size = size;
+  requirements.alignment = alignment;
+  requirements.memoryTypeBits = ~0u;
+  return requirements;
+}
+
+static u32 test_heap_index(vulkan_context *context) {
+  i32 type_index = context->find_memory_index(~0u, TEST_MEMORY_FLAGS);
+  return context->device.memory.memoryTypes[type_index].heapIndex;
+}
+
+u8 vulkan_memory_allocator_should_reuse_blocks() {
+  vulkan_context context;
+  if (!create_allocator(&context)) {
+    return BYPASS;
+  }
+  vulkan_memory_allocator *allocator = &context.memory_allocator;
+
+  VkMemoryRequirements requirements = make_requirements(1024, 16);
+  vulkan_allocation first;
+  vulkan_allocation second;
+  expect_should_be(true, vulkan_memory_allocate(&context, &requirements,
+                                                TEST_MEMORY_FLAGS, true,
+                                                &first));
+  expect_should_be(true, vulkan_memory_allocate(&context, &requirements,
+                                                TEST_MEMORY_FLAGS, true,
+                                                &second));
+  expect_should_be(1, darray_length(allocator->blocks));
+  expect_should_be(first.block, second.block);
+  expect_should_be(first.memory, second.memory);
+  expect_should_not_be(first.offset, second.offset);
+
+  // Freed ranges are handed out again, the empty block is kept.
+  u64 first_offset = first.offset;
+  vulkan_memory_free(&context, &first);
+  vulkan_memory_free(&context, &second);
+  expect_should_be(1, darray_length(allocator->blocks));
+  expect_should_be(true, vulkan_memory_allocate(&context, &requirements,
+                                                TEST_MEMORY_FLAGS, true,
+                                                &first));
+  expect_should_be(1, darray_length(allocator->blocks));
+  expect_should_be(first_offset, first.offset);
+
+  // Images that are not linear don't share blocks with buffers.
+  expect_should_be(true, vulkan_memory_allocate(&context, &requirements,
+                                                TEST_MEMORY_FLAGS, false,
+                                                &second));
+  expect_should_be(2, darray_length(allocator->blocks));
+  expect_should_not_be(first.block, second.block);
+
+  vulkan_memory_free(&context, &first);
+  vulkan_memory_free(&context, &second);
+  destroy_allocator(&context);
+
+  return true;
+}
+
+u8 vulkan_memory_allocator_should_use_dedicated_blocks() {
+  vulkan_context context;
+  if (!create_allocator(&context)) {
+    return BYPASS;
+  }
+  vulkan_memory_allocator *allocator = &context.memory_allocator;
+  u32 heap_index = test_heap_index(&context);
+
+  // Larger than half of any block
+  u64 heap_size = context.device.memory.memoryHeaps[heap_index].size;
+  u64 size = heap_size / 8 < 64ull * 1024 * 1024 ? heap_size / 8
+                                                 : 64ull * 1024 * 1024;
+  VkMemoryRequirements requirements = make_requirements(size, 256);
+  vulkan_allocation allocation;
+  expect_should_be(true, vulkan_memory_allocate(&context, &requirements,
+                                                TEST_MEMORY_FLAGS, true,
+                                                &allocation));
+  expect_should_be(1, darray_length(allocator->blocks));
+  expect_should_be(true, allocation.block->dedicated);
+  expect_should_be(size, allocation.block->size);
+  expect_should_be(0, allocation.offset);
+  expect_should_be(size, allocator->heap_reserved[heap_index]);
+
+  // Dedicated blocks go with their allocation.
+  vulkan_memory_free(&context, &allocation);
+  expect_should_be(0, darray_length(allocator->blocks));
+  expect_should_be(0, allocator->heap_reserved[heap_index]);
+
+  destroy_allocator(&context);
+
+  return true;
+}
+
+u8 vulkan_memory_allocator_should_align_sub_allocations() {
+  vulkan_context context;
+  if (!create_allocator(&context)) {
+    return BYPASS;
+  }
+
+  VkMemoryRequirements small = make_requirements(10, 1);
+  VkMemoryRequirements aligned = make_requirements(100, 256);
+  vulkan_allocation first;
+  vulkan_allocation second;
+  expect_should_be(true, vulkan_memory_allocate(&context, &small,
+                                                TEST_MEMORY_FLAGS, true,
+                                                &first));
+  expect_should_be(true, vulkan_memory_allocate(&context, &aligned,
+                                                TEST_MEMORY_FLAGS, true,
+                                                &second));
+  expect_should_be(first.block, second.block);
+  expect_should_be(0, second.offset % 256);
+  expect_should_be(100, second.size);
+
+  vulkan_memory_free(&context, &first);
+  vulkan_memory_free(&context, &second);
+  destroy_allocator(&context);
+
+  return true;
+}
+
+u8 vulkan_memory_allocator_should_account_heap_usage() {
+  vulkan_context context;
+  if (!create_allocator(&context)) {
+    return BYPASS;
+  }
+  vulkan_memory_allocator *allocator = &context.memory_allocator;
+  u32 heap_index = test_heap_index(&context);
+
+  VkMemoryRequirements first_requirements = make_requirements(4096, 16);
+  VkMemoryRequirements second_requirements = make_requirements(512, 16);
+  vulkan_allocation first;
+  vulkan_allocation second;
+  expect_should_be(true, vulkan_memory_allocate(&context, &first_requirements,
+                                                TEST_MEMORY_FLAGS, true,
+                                                &first));
+  expect_should_be(true, vulkan_memory_allocate(&context,
+                                                &second_requirements,
+                                                TEST_MEMORY_FLAGS, true,
+                                                &second));
+  expect_should_be(2, allocator->allocation_count);
+  expect_should_be(4096 + 512, allocator->heap_used[heap_index]);
+  expect_should_be(first.block->size, allocator->heap_reserved[heap_index]);
+
+  vulkan_memory_free(&context, &first);
+  expect_should_be(1, allocator->allocation_count);
+  expect_should_be(512, allocator->heap_used[heap_index]);
+
+  vulkan_memory_free(&context, &second);
+  expect_should_be(0, allocator->allocation_count);
+  expect_should_be(0, allocator->heap_used[heap_index]);
+
+  destroy_allocator(&context);
+
+  return true;
+}
+
+void vulkan_memory_allocator_register_tests() {
+  test_manager_register_serial_test(
+      vulkan_memory_allocator_should_reuse_blocks,
+      "vulkan_memory_allocator_should_reuse_blocks");
+  test_manager_register_serial_test(
+      vulkan_memory_allocator_should_use_dedicated_blocks,
+      "vulkan_memory_allocator_should_use_dedicated_blocks");
+  test_manager_register_serial_test(
+      vulkan_memory_allocator_should_align_sub_allocations,
+      "vulkan_memory_allocator_should_align_sub_allocations");
+  test_manager_register_serial_test(
+      vulkan_memory_allocator_should_account_heap_usage,
+      "vulkan_memory_allocator_should_account_heap_usage");
+}
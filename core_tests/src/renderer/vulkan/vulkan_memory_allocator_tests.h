@@ -0,0 +1,3 @@
+#pragma once
+
+void vulkan_memory_allocator_register_tests();
@@ -0,0 +1,66 @@
+#include "renderer/vulkan/vulkan_test_device.h"
+
+#include <base/lai_memory.h>
+#include <base/log.h>
+#include <renderer/vulkan/vulkan_device.h>
+#include <renderer/vulkan/vulkan_utils.h>
+
+// find_memory_index has no context parameter, tests run one at a time.
+static vulkan_context *test_context = nullptr;
+
+static i32 test_find_memory_index(u32 type_filter, u32 property_flags) {
+  const VkPhysicalDeviceMemoryProperties *memory =
+      &test_context->device.memory;
+  for (u32 i = 0; i < memory->memoryTypeCount; ++i) {
+    if (type_filter & (1 << i) &&
+        (memory->memoryTypes[i].propertyFlags & property_flags) ==
+            property_flags) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool vulkan_test_device_create(vulkan_context *out_context) {
+  lai_zero_memory(out_context, sizeof(vulkan_context));
+  out_context->headless = true;
+  out_context->find_memory_index = test_find_memory_index;
+
+  VkApplicationInfo app_info = {VK_STRUCTURE_TYPE_APPLICATION_INFO};
+  app_info.apiVersion = VK_API_VERSION_1_2;
+  app_info.pApplicationName = "core_tests";
+
+  VkInstanceCreateInfo create_info = {VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
+  create_info.pApplicationInfo = &app_info;
+  const char *portability = "VK_KHR_portability_enumeration";
+  if (vulkan_instance_supports_extension(portability)) {
+    create_info.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+    create_info.enabledExtensionCount = 1;
+    create_info.ppEnabledExtensionNames = &portability;
+  }
+
+  if (vkCreateInstance(&create_info, nullptr, &out_context->instance) !=
+      VK_SUCCESS) {
+    LAI_LOG_WARN("No vulkan instance, skipping gpu test");
+    return false;
+  }
+
+  u32 device_count = 0;
+  vkEnumeratePhysicalDevices(out_context->instance, &device_count, nullptr);
+  if (device_count == 0 || !vulkan_device_create(out_context)) {
+    LAI_LOG_WARN("No usable vulkan device, skipping gpu test");
+    vkDestroyInstance(out_context->instance, nullptr);
+    out_context->instance = nullptr;
+    return false;
+  }
+
+  test_context = out_context;
+  return true;
+}
+
+void vulkan_test_device_destroy(vulkan_context *context) {
+  vulkan_device_destroy(context);
+  vkDestroyInstance(context->instance, nullptr);
+  test_context = nullptr;
+  lai_zero_memory(context, sizeof(vulkan_context));
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <renderer/vulkan/vulkan_types.inl>
+
+// Creates an instance and a headless device in out_context, enough for the
+// vulkan modules that don't draw. False when no device is available, gpu
+// tests return BYPASS then. Tests using it must be registered as serial.
+bool vulkan_test_device_create(vulkan_context *out_context);
+void vulkan_test_device_destroy(vulkan_context *context);
@@ -1,50 +1,282 @@
 #include "test_manager.h"
 
+#include <base/lai_memory.h>
 #include <base/lai_string.h>
 #include <base/log.h>
 #include <containers/darray.h>
+#include <platform/platform.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_DEFAULT_SLOW_THRESHOLD_MS 100.0
+#define TEST_MAX_REPORTED_SLOW_TESTS 10
 
 struct test_entry {
   PFN_test func;
   char *description;
+  bool serial;
+};
+
+struct test_run {
+  u32 test_index;
+  u8 result;
+  f64 elapsed_ms;
+};
+
+struct test_worker_queue {
+  test_run *runs;
+  u32 count;
+  u32 next;
+  platform_mutex mutex;
 };
 
 static test_entry *tests;
 
 void test_manager_init() { tests = darray_create(test_entry); }
 
-void test_manager_register_test(u8 (*PFN_test)(), char *description) {
+static void register_test(PFN_test func, char *description, bool serial) {
   test_entry e;
-  e.func = PFN_test;
+  e.func = func;
   e.description = description;
+  e.serial = serial;
 
   darray_push(tests, e);
 }
 
-void test_manager_run_tests() {
+void test_manager_register_test(u8 (*PFN_test)(), char *description) {
+  register_test(PFN_test, description, false);
+}
+
+void test_manager_register_serial_test(u8 (*PFN_test)(), char *description) {
+  register_test(PFN_test, description, true);
+}
+
+void test_manager_default_options(test_options *out_options) {
+  lai_zero_memory(out_options, sizeof(test_options));
+  out_options->shard_index = 0;
+  out_options->shard_count = 1;
+  out_options->jobs = 1;
+  out_options->slow_threshold_ms = TEST_DEFAULT_SLOW_THRESHOLD_MS;
+}
+
+static void print_usage() {
+  LAI_LOG_INFO("Usage: core_tests [--filter <text>] [--shard <index>/<count>] "
+               "[--jobs <n>] [--slow-threshold <ms>]");
+}
+
+static bool parse_shard(const char *value, test_options *out_options) {
+  // <index>/<count>, index starting at 0
+  char buffer[32];
+  u64 length = value ? string_length(value) : 0;
+  if (length == 0 || length >= sizeof(buffer)) {
+    return false;
+  }
+  lai_copy_memory(buffer, value, length + 1);
+
+  char *separator = strchr(buffer, '/');
+  if (!separator) {
+    return false;
+  }
+  *separator = 0;
+
+  return string_to_u32(buffer, &out_options->shard_index) &&
+         string_to_u32(separator + 1, &out_options->shard_count) &&
+         out_options->shard_count > 0 &&
+         out_options->shard_index < out_options->shard_count;
+}
+
+bool test_manager_parse_arguments(i32 argc, char **argv,
+                                  test_options *out_options) {
+  test_manager_default_options(out_options);
+
+  for (i32 i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+    bool valid = value != nullptr;
+    if (strings_equal(arg, "--filter")) {
+      out_options->filter = value;
+    } else if (strings_equal(arg, "--shard")) {
+      valid = parse_shard(value, out_options);
+    } else if (strings_equal(arg, "--jobs")) {
+      valid = string_to_u32(value, &out_options->jobs);
+    } else if (strings_equal(arg, "--slow-threshold")) {
+      valid = string_to_f64(value, &out_options->slow_threshold_ms);
+    } else {
+      LAI_LOG_ERROR("Unknown argument: %s", arg);
+      print_usage();
+      return false;
+    }
+
+    if (!valid) {
+      LAI_LOG_ERROR("Missing or invalid value for %s", arg);
+      print_usage();
+      return false;
+    }
+    ++i;
+  }
+
+  return true;
+}
+
+static void run_test(test_run *run) {
+  f64 start_time = platform_get_absolute_time();
+  run->result = tests[run->test_index].func();
+  run->elapsed_ms = (platform_get_absolute_time() - start_time) * 1000.0;
+}
+
+static u32 test_worker_main(void *params) {
+  test_worker_queue *queue = (test_worker_queue *)params;
+
+  for (;;) {
+    platform_mutex_lock(&queue->mutex);
+    u32 index = queue->next < queue->count ? queue->next++ : queue->count;
+    platform_mutex_unlock(&queue->mutex);
+
+    if (index == queue->count) {
+      return 0;
+    }
+    run_test(&queue->runs[index]);
+  }
+}
+
+static void run_parallel(test_run *runs, u32 count, u32 jobs) {
+  test_worker_queue queue;
+  queue.runs = runs;
+  queue.count = count;
+  queue.next = 0;
+  if (!platform_mutex_create(&queue.mutex)) {
+    jobs = 1;
+  }
+
+  // The calling thread works too, so one less thread is started.
+  u32 thread_count = 0;
+  platform_thread *threads = nullptr;
+  if (jobs > 1) {
+    threads = (platform_thread *)lai_allocate(
+        sizeof(platform_thread) * (jobs - 1), MEMORY_TAG_APPLICATION);
+    for (; thread_count < jobs - 1; ++thread_count) {
+      if (!platform_thread_create(test_worker_main, &queue,
+                                  &threads[thread_count])) {
+        break;
+      }
+    }
+  }
+
+  if (queue.mutex.internal_data) {
+    test_worker_main(&queue);
+  } else {
+    for (u32 i = 0; i < count; ++i) {
+      run_test(&runs[i]);
+    }
+  }
+
+  for (u32 i = 0; i < thread_count; ++i) {
+    platform_thread_join(&threads[i]);
+  }
+  if (threads) {
+    lai_free(threads, sizeof(platform_thread) * (jobs - 1),
+             MEMORY_TAG_APPLICATION);
+  }
+  platform_mutex_destroy(&queue.mutex);
+}
+
+static int compare_slowest_first(const void *a, const void *b) {
+  f64 left = (*(const test_run **)a)->elapsed_ms;
+  f64 right = (*(const test_run **)b)->elapsed_ms;
+  return (left < right) - (left > right);
+}
+
+static void report_slow_tests(test_run *runs, u32 count, f64 threshold_ms) {
+  test_run **slow = darray_create(test_run *);
+  for (u32 i = 0; i < count; ++i) {
+    if (runs[i].elapsed_ms > threshold_ms) {
+      darray_push(slow, &runs[i]);
+    }
+  }
+
+  u32 slow_count = darray_length(slow);
+  if (slow_count > 0) {
+    qsort(slow, slow_count, sizeof(test_run *), compare_slowest_first);
+    LAI_LOG_WARN("%d tests slower than %.1f ms:", slow_count, threshold_ms);
+    for (u32 i = 0; i < slow_count && i < TEST_MAX_REPORTED_SLOW_TESTS; ++i) {
+      LAI_LOG_WARN("  %10.3f ms %s", slow[i]->elapsed_ms,
+                   tests[slow[i]->test_index].description);
+    }
+  }
+
+  darray_destroy(slow);
+}
+
+bool test_manager_run_tests(const test_options *options) {
   u32 passed = 0;
   u32 failed = 0;
   u32 skipped = 0;
 
-  u32 count = darray_length(tests);
+  u32 total = darray_length(tests);
+
+  // Parallel tests first, then serial ones, both in registration order.
+  test_run *runs = (test_run *)lai_allocate(sizeof(test_run) * (total + 1),
+                                            MEMORY_TAG_APPLICATION);
+  u32 count = 0;
+  u32 parallel_count = 0;
+  for (u32 pass = 0; pass < 2; ++pass) {
+    u32 selected = 0;
+    for (u32 i = 0; i < total; ++i) {
+      if (options->filter &&
+          !string_contains(tests[i].description, options->filter)) {
+        continue;
+      }
+      // Shards are taken over the filtered list so they stay balanced.
+      bool in_shard =
+          selected++ % options->shard_count == options->shard_index;
+      if (in_shard && tests[i].serial == (pass == 1)) {
+        runs[count++].test_index = i;
+      }
+    }
+    if (pass == 0) {
+      parallel_count = count;
+    }
+  }
+
+  u32 jobs =
+      options->jobs > 0 ? options->jobs : platform_get_processor_count();
+
+  f64 start_time = platform_get_absolute_time();
+  run_parallel(runs, parallel_count, jobs);
+  for (u32 i = parallel_count; i < count; ++i) {
+    run_test(&runs[i]);
+  }
+  f64 elapsed_ms = (platform_get_absolute_time() - start_time) * 1000.0;
 
   for (u32 i = 0; i < count; ++i) {
-    u8 result = tests[i].func();
+    const test_entry *test = &tests[runs[i].test_index];
+    u8 result = runs[i].result;
 
     if (result == true) {
       ++passed;
     } else if (result == BYPASS) {
-      LAI_LOG_WARN("[SKIPPED]: %s", tests[i].description);
+      LAI_LOG_WARN("[SKIPPED]: %s", test->description);
       ++skipped;
     } else {
-      LAI_LOG_ERROR("[FAILED]: %s", tests[i].description);
+      LAI_LOG_ERROR("[FAILED]: %s", test->description);
       ++failed;
     }
-    char status[20];
+    char status[32];
     string_format(status, failed ? "*** %d FAILED ***" : "SUCCESS", failed);
-    LAI_LOG_INFO("Executed %d of %d", i + 1, count, skipped, status);
+    LAI_LOG_INFO("Executed %d of %d (%d skipped) %s, %.3f ms: %s", i + 1,
+                 count, skipped, status, runs[i].elapsed_ms,
+                 test->description);
   }
 
-  LAI_LOG_INFO("Results: %d passed, %d failed, %d skipped.", passed, failed,
-               skipped);
-}
\ No newline at end of file
+  report_slow_tests(runs, count, options->slow_threshold_ms);
+
+  LAI_LOG_INFO("Results: %d passed, %d failed, %d skipped. %d of %d tests "
+               "run in %.3f ms.",
+               passed, failed, skipped, count, total, elapsed_ms);
+
+  lai_free(runs, sizeof(test_run) * (total + 1), MEMORY_TAG_APPLICATION);
+
+  return failed == 0;
+}
@@ -6,6 +6,26 @@
 
 typedef u8 (*PFN_test)();
 
+struct test_options {
+  // Only run tests whose description contains this
+  const char *filter;
+  // Run every shard_count-th test starting at shard_index
+  u32 shard_index;
+  u32 shard_count;
+  // Worker threads for tests not registered as serial, 0 for one per core
+  u32 jobs;
+  // Tests slower than this are listed after the run
+  f64 slow_threshold_ms;
+};
+
 void test_manager_init();
 void test_manager_register_test(PFN_test, char *description);
-void test_manager_run_tests();
\ No newline at end of file
+// For tests that touch global state and can't run alongside others
+void test_manager_register_serial_test(PFN_test, char *description);
+
+void test_manager_default_options(test_options *out_options);
+bool test_manager_parse_arguments(i32 argc, char **argv,
+                                  test_options *out_options);
+
+// Return false if any test failed
+bool test_manager_run_tests(const test_options *options);
@@ -0,0 +1,111 @@
+#include <base/lai_memory.h>
+#include <base/lai_string.h>
+#include <base/log.h>
+#include <containers/darray.h>
+#include <memory/linear_allocator.h>
+#include <platform/filesystem.h>
+#include <renderer/mesh_cook.h>
+
+// Cooks OBJ meshes into the mesh files geometry_system_acquire_from_file
+// maps, so the engine never parses source meshes.
+
+static bool has_extension(const char *path, const char *extension) {
+  u64 path_length = string_length(path);
+  u64 extension_length = string_length(extension);
+  return path_length >= extension_length &&
+         strings_equal(path + path_length - extension_length, extension);
+}
+
+static bool cook_file(const char *input_path, const char *output_path,
+                      u32 max_lod_count) {
+  if (has_extension(input_path, ".gltf") || has_extension(input_path, ".glb")) {
+    LAI_LOG_ERROR("glTF sources are not supported yet, export '%s' as OBJ",
+                  input_path);
+    return false;
+  }
+
+  file_mapping source;
+  if (!filesystem_map(input_path, &source)) {
+    return false;
+  }
+  vertex_3d *vertices;
+  u32 *indices;
+  bool parsed = mesh_cook_parse_obj((const char *)source.data, source.size,
+                                    &vertices, &indices);
+  filesystem_unmap(&source);
+  if (!parsed) {
+    LAI_LOG_ERROR("Failed to parse '%s'", input_path);
+    return false;
+  }
+
+  u8 *data;
+  u64 size;
+  bool cooked = mesh_cook(vertices, (u32)darray_length(vertices), indices,
+                          (u32)darray_length(indices), max_lod_count, &data,
+                          &size);
+  darray_destroy(vertices);
+  darray_destroy(indices);
+  if (!cooked) {
+    LAI_LOG_ERROR("Failed to cook '%s'", input_path);
+    return false;
+  }
+
+  file_handle file;
+  u64 written = 0;
+  bool success = filesystem_open(output_path, FILE_MODE_WRITE, true, &file);
+  if (success) {
+    success = filesystem_write(&file, size, data, &written);
+    filesystem_close(&file);
+  }
+  if (success) {
+    const mesh_file_header *header = (const mesh_file_header *)data;
+    LAI_LOG_INFO("Cooked '%s' into '%s', %u lods in %llu bytes", input_path,
+                 output_path, header->lod_count, size);
+    for (u32 i = 0; i < header->lod_count; ++i) {
+      const mesh_file_lod *lod = &header->lods[i];
+      LAI_LOG_INFO("  lod %u: %u vertices, %u triangles, %u meshlets, error "
+                   "%f",
+                   i, lod->vertex_count, lod->index_count / 3,
+                   lod->meshlet_count, lod->error);
+    }
+  } else {
+    LAI_LOG_ERROR("Failed to write '%s'", output_path);
+  }
+
+  mesh_cook_free(data, size);
+  return success;
+}
+
+int main(int argc, char **argv) {
+  linear_allocator systems_allocator;
+  linear_allocator_create(1024 * 1024, nullptr, &systems_allocator);
+
+  u64 memory_requirement = 0;
+  initialize_memory(&memory_requirement, nullptr);
+  void *memory_state =
+      linear_allocator_allocate(&systems_allocator, memory_requirement);
+  initialize_memory(&memory_requirement, memory_state);
+
+  u64 log_requirement = 0;
+  initialize_logging(&log_requirement, nullptr);
+  void *log_state =
+      linear_allocator_allocate(&systems_allocator, log_requirement);
+  initialize_logging(&log_requirement, log_state);
+
+  int result = 0;
+  u32 max_lod_count = MESH_FILE_MAX_LODS;
+  if (argc < 3 || argc > 4 ||
+      (argc == 4 && !string_to_u32(argv[3], &max_lod_count))) {
+    LAI_LOG_INFO("Usage: mesh_cooker <source.obj> <output.mesh> "
+                 "[max_lod_count]");
+    result = 2;
+  } else if (!cook_file(argv[1], argv[2], max_lod_count)) {
+    result = 1;
+  }
+
+  shutdown_logging(log_state);
+  shutdown_memory(memory_state);
+  linear_allocator_destroy(&systems_allocator);
+
+  return result;
+}
@@ -28,4 +28,6 @@ Library["Vulkan_MacOSX"] = "%{LibraryDir.VulkanSDK}/vulkan.1"
 
 include "core"
 include "core_tests"
+include "core_bench"
+include "mesh_cooker"
 include "sandbox"
\ No newline at end of file
@@ -1,11 +1,86 @@
 #include "game.h"
 
+#include <base/application.h>
 #include <base/input.h>
 #include <base/lai_memory.h>
+#include <base/lai_string.h>
 #include <base/log.h>
 
+#include <containers/darray.h>
+#include <math/lai_math.h>
+#include <systems/geometry_system.h>
+#include <systems/material_system.h>
+#include <systems/texture_system.h>
+
 bool game_initialize(game *game_inst) {
   LAI_LOG_DEBUG("Game initialize called!");
+  game_state *state = (game_state *)game_inst->state;
+
+  // The scene, a quad facing the camera
+  const u32 vert_count = 4;
+  vertex_3d verts[vert_count];
+  lai_zero_memory(verts, sizeof(vertex_3d) * vert_count);
+
+  verts[0].position = vec3_create(0.0f, -0.5f, 0.0f);
+  verts[1].position = vec3_create(0.5f, 0.5f, 0.0f);
+  verts[2].position = vec3_create(0.0f, 0.5f, 0.0f);
+  verts[3].position = vec3_create(0.5f, -0.5f, 0.0f);
+  verts[0].texcoord = vec2_create(0.0f, 0.0f);
+  verts[1].texcoord = vec2_create(1.0f, 1.0f);
+  verts[2].texcoord = vec2_create(0.0f, 1.0f);
+  verts[3].texcoord = vec2_create(1.0f, 0.0f);
+
+  const u32 index_count = 6;
+  u32 indices[index_count] = {0, 1, 2, 0, 3, 1};
+
+  geometry_config config;
+  lai_zero_memory(&config, sizeof(geometry_config));
+  config.vertex_count = vert_count;
+  config.vertices = verts;
+  config.index_count = index_count;
+  config.indices = indices;
+  string_ncopy(config.name, "test_quad", GEOMETRY_NAME_MAX_LENGTH);
+
+  state->test_geometry = geometry_system_acquire_from_config(config, true);
+  if (!state->test_geometry) {
+    LAI_LOG_ERROR("Failed to create the test geometry");
+    return false;
+  }
+
+  // A checkerboard until textures load from files
+  const u32 texture_size = 64;
+  const u32 tile_size = 8;
+  u8 pixels[texture_size * texture_size * 4];
+  for (u32 y = 0; y < texture_size; ++y) {
+    for (u32 x = 0; x < texture_size; ++x) {
+      u8 value = ((x / tile_size) + (y / tile_size)) % 2 ? 255 : 64;
+      u8 *texel = &pixels[(y * texture_size + x) * 4];
+      texel[0] = value;
+      texel[1] = value;
+      texel[2] = value;
+      texel[3] = 255;
+    }
+  }
+  state->test_texture = texture_system_acquire_from_pixels(
+      "test_checker", texture_size, texture_size, pixels, true);
+  if (!state->test_texture) {
+    LAI_LOG_ERROR("Failed to create the test texture");
+    return false;
+  }
+
+  material_config material_config;
+  lai_zero_memory(&material_config, sizeof(material_config));
+  string_ncopy(material_config.name, "test_material",
+               MATERIAL_NAME_MAX_LENGTH);
+  material_config.diffuse_color = vec4_create(1.0f, 0.5f, 0.2f, 1.0f);
+  string_ncopy(material_config.diffuse_map_name, "test_checker",
+               TEXTURE_NAME_MAX_LENGTH);
+  state->test_material =
+      material_system_acquire_from_config(material_config, true);
+  if (!state->test_material) {
+    LAI_LOG_ERROR("Failed to create the test material");
+    return false;
+  }
   return true;
 }
 
@@ -14,11 +89,59 @@ bool game_update(game *game_inst, f32 delta_time) {
     LAI_LOG_DEBUG("%s", get_memory_usage());
   }
 
+  if (input_is_key_up(KEY_F) && input_was_key_down(KEY_F)) {
+    frame_stats stats;
+    if (application_get_frame_stats(&stats)) {
+      LAI_LOG_DEBUG("Frame time over %u frames: avg %.3fms, min %.3fms, max "
+                    "%.3fms, p50 %.3fms, p95 %.3fms, p99 %.3fms",
+                    stats.sample_count, stats.frame_time.average * 1000,
+                    stats.frame_time.min * 1000, stats.frame_time.max * 1000,
+                    stats.frame_time.p50 * 1000, stats.frame_time.p95 * 1000,
+                    stats.frame_time.p99 * 1000);
+      for (u32 i = 0; i < FRAME_PHASE_MAX_PHASES; ++i) {
+        LAI_LOG_DEBUG("  %s: avg %.3fms, p99 %.3fms",
+                      frame_phase_name((frame_phase)i),
+                      stats.phases[i].average * 1000,
+                      stats.phases[i].p99 * 1000);
+      }
+    }
+
+    gpu_timings timings;
+    if (application_get_gpu_timings(&timings)) {
+      LAI_LOG_DEBUG("Gpu scopes of frame %llu:", timings.frame_number);
+      for (u32 i = 0; i < timings.scope_count; ++i) {
+        LAI_LOG_DEBUG("  %*s%s: %.3fms", timings.scopes[i].depth * 2, "",
+                      timings.scopes[i].name, timings.scopes[i].time * 1000);
+      }
+    }
+  }
+
   return true;
 }
 
-bool game_render(game *game_inst, f32 delta_time) { return true; }
+bool game_render(game *game_inst, f32 delta_time, f32 interpolation_alpha,
+                 render_packet *packet) {
+  game_state *state = (game_state *)game_inst->state;
+
+  geometry_render_data data;
+  data.model = mat4_identity();
+  data.geometry = state->test_geometry;
+  data.material_id = state->test_material->id;
+  darray_push(packet->geometries, data);
+  return true;
+}
 
 void game_on_resize(game *game_inst, u32 width, u32 height) {
   LAI_LOG_DEBUG("Game on resize called!");
 }
+
+void game_shutdown(game *game_inst) {
+  game_state *state = (game_state *)game_inst->state;
+  // The material holds its own reference to the texture.
+  material_system_release(state->test_material);
+  texture_system_release(state->test_texture);
+  geometry_system_release(state->test_geometry);
+  state->test_material = nullptr;
+  state->test_texture = nullptr;
+  state->test_geometry = nullptr;
+}
@@ -5,9 +5,14 @@
 
 struct game_state {
   f32 delta_time;
+  geometry *test_geometry;
+  texture *test_texture;
+  material *test_material;
 };
 
 bool game_initialize(game *game_inst);
 bool game_update(game *game_inst, f32 delta_time);
-bool game_render(game *game_inst, f32 delta_time);
-void game_on_resize(game *game_inst, u32 width, u32 height);
\ No newline at end of file
+bool game_render(game *game_inst, f32 delta_time, f32 interpolation_alpha,
+                 render_packet *packet);
+void game_on_resize(game *game_inst, u32 width, u32 height);
+void game_shutdown(game *game_inst);
\ No newline at end of file
@@ -9,11 +9,21 @@ bool create_game(game *out_game) {
   out_game->app_config.start_width = 1600;
   out_game->app_config.start_height = 900;
   out_game->app_config.name = "LAI";
+  out_game->app_config.frame_stats_window = 300;
+  out_game->app_config.target_frame_rate = 0;
+  out_game->app_config.fixed_timestep = false;
+  out_game->app_config.fixed_update_rate = 60;
+  out_game->app_config.pipelined_rendering = false;
+  out_game->app_config.gpu_culling = true;
+  out_game->app_config.headless = false;
+  out_game->app_config.headless_readback = false;
+  out_game->app_config.frames_in_flight = 0;
 
   out_game->update = game_update;
   out_game->render = game_render;
   out_game->initialize = game_initialize;
   out_game->on_resize = game_on_resize;
+  out_game->shutdown = game_shutdown;
 
   out_game->state = lai_allocate(sizeof(game_state), MEMORY_TAG_GAME);
   out_game->application_state = nullptr;